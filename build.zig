@@ -37,6 +37,10 @@ pub fn build(b: *std.Build) !void {
 
     // std.debug.print("files: {s}\n", .{files.items});
 
+    // -Dsingle-precision=true builds the vector math with floats
+    const single_precision = b.option(bool, "single-precision",
+        "Use float instead of double for Vec3, Ray and AABB") orelse false;
+
     const flags = [_][]const u8 {"-std=c++11", 
                                 "-pedantic-errors", 
                                 "-Wall", "-Wextra",
@@ -44,8 +48,16 @@ pub fn build(b: *std.Build) !void {
     const debug_flags = [_][]const u8 {"-g", ""};
     const release_flags = [_][]const u8 {"-DNDEBUG", "-O3"};
 
-    const final_flags = flags ++ 
-    if (optimize == .Debug) debug_flags else release_flags;
+    var final_flags = std.ArrayList([]const u8).init(b.allocator);
+    defer final_flags.deinit();
+
+    try final_flags.appendSlice(&flags);
+    try final_flags.appendSlice(
+        if (optimize == .Debug) &debug_flags else &release_flags);
+
+    if (single_precision) {
+        try final_flags.append("-DRT_SINGLE_PRECISION");
+    }
 
     // std.debug.print("c++ flags: {s}", .{final_flags});
 
@@ -56,7 +68,7 @@ pub fn build(b: *std.Build) !void {
     });
     exe.addCSourceFiles(.{
         .files = files.items,
-        .flags = &final_flags ,
+        .flags = final_flags.items,
     });
     exe.linkLibC();
     exe.linkLibCpp();
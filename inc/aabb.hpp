@@ -5,6 +5,7 @@
 #include "interval.hpp"
 #include "vec3.hpp"
 #include "ray.hpp"
+#include "simd_vec3.hpp"
 
 namespace RayTracing {
 
@@ -19,14 +20,18 @@ public:
 
     Interval AxisInterval(Axis axi) const;
     bool Hit(const Ray& ray, Interval ray_t) const;
+    // t_enter: distance along the ray where it enters the box (clipped to ray_t)
+    bool Hit(const Ray& ray, Interval ray_t, double& t_enter) const;
     Axis LongestAxis() const;
+    Point3 Centroid() const;
+    double SurfaceArea() const;
 
     static const AABB EMPTY, UNIVERSE;
 
 private:
     Interval m_x, m_y, m_z;
 
-    static Interval ValidInterval(double a, double b);
+    static Interval ValidInterval(Real a, Real b);
     static Interval PadToMinimum(const Interval& inter);
 };
 
@@ -46,7 +51,7 @@ m_y(box0.AxisInterval(Axis::Y), box1.AxisInterval(Axis::Y)),
 m_z(box0.AxisInterval(Axis::Z), box1.AxisInterval(Axis::Z))
 {}
 
-inline Interval AABB::ValidInterval(double a, double b) {
+inline Interval AABB::ValidInterval(Real a, Real b) {
     return ((a <= b) ? Interval(a, b) : Interval(b, a));
 }
 
@@ -71,42 +76,35 @@ inline Interval AABB::AxisInterval(Axis axi) const {
 }
 
 inline bool AABB::Hit(const Ray& ray, Interval ray_t) const {
-    const Point3 ray_orig = ray.GetOrigin();
-    const Vec3 ray_dir = ray.GetDirection();
-    bool is_hit = true;
-
-    for (unsigned int axis = 0; (axis < Axis::NUM_OF_AXIS) && is_hit; ++axis) {
-        const Interval ax = AxisInterval(static_cast<Axis>(axis));
-        
-        Vec3::Cord cord = static_cast<Vec3::Cord>(axis); 
-        const double adinv = 1.0 / ray_dir[cord];
-
-        double t0 = (ax.GetMin() - ray_orig[cord]) * adinv;
-        double t1 = (ax.GetMax() - ray_orig[cord]) * adinv;
-
-        if (t0 < t1) {
-            if (t0 > ray_t.GetMin()) {
-                ray_t.SetMin(t0);
-            }
-            if (t1 < ray_t.GetMax()) {
-                ray_t.SetMax(t1);
-            }
-        }
-        else {
-            if (t1 > ray_t.GetMin()) {
-                ray_t.SetMin(t1);
-            }
-            if (t0 < ray_t.GetMax()) {
-                ray_t.SetMax(t0);
-            }
-        }
-
-        if (ray_t.GetMax() <= ray_t.GetMin()) {
-            is_hit = false;
-        }
+    double t_enter = 0.0;
+
+    return Hit(ray, ray_t, t_enter);
+}
+
+// Slab test of all three axes at once. The near and far distances are
+// picked so that a NaN distance (ray origin on a slab of an axis the ray
+// is parallel to) leaves the interval unchanged.
+inline bool AABB::Hit(const Ray& ray, Interval ray_t, double& t_enter) const {
+    SimdVec3 origin(ray.GetOrigin());
+    SimdVec3 inv_dir = SimdVec3::Broadcast(1) / SimdVec3(ray.GetDirection());
+    SimdVec3 box_min(m_x.GetMin(), m_y.GetMin(), m_z.GetMin());
+    SimdVec3 box_max(m_x.GetMax(), m_y.GetMax(), m_z.GetMax());
+
+    SimdVec3 t0 = (box_min - origin) * inv_dir;
+    SimdVec3 t1 = (box_max - origin) * inv_dir;
+    SimdVec3 t_near = Max(Min(t0, t1), SimdVec3::Broadcast(ray_t.GetMin()));
+    SimdVec3 t_far = Min(Max(t1, t0), SimdVec3::Broadcast(ray_t.GetMax()));
+
+    Real t_min = t_near.MaxComponent();
+    Real t_max = t_far.MinComponent();
+
+    if (t_max <= t_min) {
+        return false;
     }
 
-    return is_hit;
+    t_enter = t_min;
+
+    return true;
 }
 
 inline AABB::Axis AABB::LongestAxis() const {
@@ -115,8 +113,22 @@ inline AABB::Axis AABB::LongestAxis() const {
             ((m_y.Size() > m_z.Size()) ? Axis::Y : Axis::Z));
 }
 
+inline Point3 AABB::Centroid() const {
+    return Point3(0.5 * (m_x.GetMin() + m_x.GetMax()),
+                0.5 * (m_y.GetMin() + m_y.GetMax()),
+                0.5 * (m_z.GetMin() + m_z.GetMax()));
+}
+
+inline double AABB::SurfaceArea() const {
+    double dx = m_x.Size();
+    double dy = m_y.Size();
+    double dz = m_z.Size();
+
+    return (2.0 * (dx * dy + dy * dz + dz * dx));
+}
+
 inline Interval AABB::PadToMinimum(const Interval& inter) {
-    static constexpr double delta = 0.0001;
+    static constexpr Real delta = static_cast<Real>(0.0001);
 
     return ((inter.Size() < delta) ? inter.Expand(delta) : inter);
 }
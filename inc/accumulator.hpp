@@ -0,0 +1,109 @@
+#ifndef ACCUMULATOR_HPP
+#define ACCUMULATOR_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "color.hpp"
+#include "framebuffer.hpp"
+
+namespace RayTracing {
+
+// Running sums of the radiance samples of every pixel, of their squared
+// luminance and their counts. Progressive renders add passes to it, 
+// Resolve turns it into an image and Save / Load checkpoint it so a render
+// can be resumed later.
+class Accumulator {
+public:
+    Accumulator();
+
+    // Resizes and clears all samples.
+    void Resize(uint32_t width, uint32_t height);
+
+    uint32_t GetWidth() const;
+    uint32_t GetHeight() const;
+    const Color& GetSum(uint32_t i, uint32_t j) const;
+    uint32_t GetSampleCount(uint32_t i, uint32_t j) const;
+    uint32_t GetMinSampleCount() const;
+    uint64_t GetTotalSampleCount() const;
+    // Standard error of the pixel's mean luminance relative to the mean,
+    // means below MIN_LUMINANCE count as MIN_LUMINANCE. Infinite with less
+    // than two samples.
+    double GetRelativeError(uint32_t i, uint32_t j) const;
+
+    void AddSamples(uint32_t i, uint32_t j, const Color& sum, 
+                    double luminance_squares, uint32_t count);
+
+    // Mean of every pixel, black for pixels without samples.
+    void Resolve(Framebuffer& framebuffer) const;
+    // Gray image of the sample counts divided by max_count.
+    void ResolveSampleCounts(Framebuffer& framebuffer, uint32_t max_count) const;
+
+    // Raw host endian dump, written to a temporary file that then replaces
+    // filename, so an interrupted save keeps the previous checkpoint.
+    bool Save(const std::string& filename) const;
+    // Returns false without a message if the file can not be opened,
+    // reports files that are not a checkpoint. The file's size has to match
+    // the dimensions in its header before anything is allocated.
+    bool Load(const std::string& filename);
+
+    // keeps dark pixels from needing huge sample counts
+    static constexpr double MIN_LUMINANCE = 0.01;
+
+private:
+    static constexpr char MAGIC[8] = {'R', 'T', 'A', 'C', 'C', 'U', 'M', '2'};
+    // bytes of MAGIC, width and height, then bytes of every pixel
+    static constexpr size_t HEADER_SIZE = sizeof(MAGIC) + 2 * sizeof(uint32_t);
+    static constexpr size_t PIXEL_SIZE = 4 * sizeof(double) + sizeof(uint32_t);
+
+    uint32_t m_width;
+    uint32_t m_height;
+    std::vector<Color> m_sums;
+    std::vector<double> m_luminance_squares;
+    std::vector<uint32_t> m_counts;
+};
+
+inline Accumulator::Accumulator() : m_width(0), m_height(0)
+{}
+
+inline void Accumulator::Resize(uint32_t width, uint32_t height) {
+    size_t size = static_cast<size_t>(width) * height;
+
+    m_width = width;
+    m_height = height;
+    m_sums.assign(size, Color(0.0, 0.0, 0.0));
+    m_luminance_squares.assign(size, 0.0);
+    m_counts.assign(size, 0);
+}
+
+inline uint32_t Accumulator::GetWidth() const {
+    return m_width;
+}
+
+inline uint32_t Accumulator::GetHeight() const {
+    return m_height;
+}
+
+inline const Color& Accumulator::GetSum(uint32_t i, uint32_t j) const {
+    return m_sums[static_cast<size_t>(j) * m_width + i];
+}
+
+inline uint32_t Accumulator::GetSampleCount(uint32_t i, uint32_t j) const {
+    return m_counts[static_cast<size_t>(j) * m_width + i];
+}
+
+inline void Accumulator::AddSamples(uint32_t i, uint32_t j, 
+                                    const Color& sum, 
+                                    double luminance_squares,
+                                    uint32_t count) {
+    size_t index = static_cast<size_t>(j) * m_width + i;
+
+    m_sums[index] += sum;
+    m_luminance_squares[index] += luminance_squares;
+    m_counts[index] += count;
+}
+
+}
+
+#endif // ACCUMULATOR_HPP
@@ -0,0 +1,68 @@
+#ifndef ALIAS_TABLE_HPP
+#define ALIAS_TABLE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "utils.hpp"
+
+namespace RayTracing {
+
+// Samples indices in proportion to their weights in constant time
+// (Walker's alias method, built with Vose's algorithm). Every index has a
+// bin of probability 1 / n that holds it below its threshold and its alias
+// above.
+class AliasTable {
+public:
+    AliasTable() = default;
+    // Negative weights count as 0, all 0 weights are sampled uniformly.
+    explicit AliasTable(const std::vector<double>& weights);
+
+    // Index for a uniform sample u in [0, 1). What is left of u within the
+    // chosen part of its bin is returned in u_remapped, also in [0, 1).
+    size_t Sample(double u, double& u_remapped) const;
+    double GetProbability(size_t index) const;
+    size_t GetSize() const;
+
+private:
+    struct Bin {
+        double threshold;
+        uint32_t alias;
+    };
+
+    std::vector<Bin> m_bins;
+    std::vector<double> m_probabilities;
+};
+
+inline size_t AliasTable::Sample(double u, double& u_remapped) const {
+    size_t n = m_bins.size();
+    double scaled = u * n;
+    size_t index = std::min(static_cast<size_t>(scaled), n - 1);
+    double frac = scaled - index;
+    const Bin& bin = m_bins[index];
+
+    if (frac < bin.threshold) {
+        u_remapped = frac / bin.threshold;
+
+        return index;
+    }
+
+    u_remapped = std::min((frac - bin.threshold) / (1.0 - bin.threshold),
+                        ONE_MINUS_EPSILON);
+
+    return bin.alias;
+}
+
+inline double AliasTable::GetProbability(size_t index) const {
+    return m_probabilities[index];
+}
+
+inline size_t AliasTable::GetSize() const {
+    return m_bins.size();
+}
+
+}
+
+#endif // ALIAS_TABLE_HPP
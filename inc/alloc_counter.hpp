@@ -0,0 +1,15 @@
+#ifndef ALLOC_COUNTER_HPP
+#define ALLOC_COUNTER_HPP
+
+#include <cstdint>
+
+namespace RayTracing {
+
+// Number of heap allocations made by the program so far. The global
+// operator new is replaced to count them, which lets benchmarks check
+// that a code path does not allocate.
+uint64_t HeapAllocationCount();
+
+}
+
+#endif // ALLOC_COUNTER_HPP
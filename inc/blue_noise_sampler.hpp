@@ -0,0 +1,53 @@
+#ifndef BLUE_NOISE_SAMPLER_HPP
+#define BLUE_NOISE_SAMPLER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "sampler.hpp"
+
+namespace RayTracing {
+
+// Blue noise dithered sampling (Georgiev and Fajardo 2016): all pixels use
+// the same Owen scrambled Sobol points, shifted toroidally by the values of
+// a blue noise mask at the pixel. Neighbouring pixels get opposite errors,
+// so at low sample counts the noise is of high frequency only, looks finer
+// than white noise and disappears under any blur. The mask is shifted by a
+// hash of the dimension, so every dimension is dithered differently.
+class BlueNoiseSampler : public Sampler {
+public:
+    static constexpr uint32_t MASK_SIZE = 64;
+
+    BlueNoiseSampler();
+
+    double Get1D(const PixelSample& sample, 
+                uint32_t dimension) const override;
+    void Get2D(const PixelSample& sample, 
+                uint32_t dimension,
+                double& u, double& v) const override;
+
+    // Tileable MASK_SIZE x MASK_SIZE void and cluster mask, the ranks of 
+    // its pixels mapped to [0, 1). Generated on first use.
+    static const std::vector<double>& Mask();
+
+private:
+    const std::vector<double>& m_mask;
+
+    double MaskValue(const PixelSample& sample, 
+                    uint32_t dimension, uint32_t channel) const;
+    static double Shift(double value, double offset);
+    static std::vector<double> GenerateMask();
+};
+
+inline BlueNoiseSampler::BlueNoiseSampler() : m_mask(Mask())
+{}
+
+inline double BlueNoiseSampler::Shift(double value, double offset) {
+    double shifted = value + offset;
+
+    return ((shifted < 1.0) ? shifted : (shifted - 1.0));
+}
+
+}
+
+#endif // BLUE_NOISE_SAMPLER_HPP
@@ -1,46 +1,47 @@
-
 #ifndef BVH_HPP
 #define BVH_HPP
 
-#include <functional>
-
 #include "hittable.hpp"
 #include "hittable_list.hpp"
+#include "bvh_builder.hpp"
 
 namespace RayTracing {
 
 class BVHNode : public Hittable {
 public:
-    explicit BVHNode(HittableList list);
+    using SplitMethod = BVHBuilder::SplitMethod;
+
+    explicit BVHNode(HittableList list, 
+                    SplitMethod method = SplitMethod::SAH);
     BVHNode(std::vector<std::shared_ptr<Hittable>>& objects,
-            size_t start, size_t end);
+            size_t start, size_t end,
+            SplitMethod method = SplitMethod::SAH);
 
     bool Hit(const Ray& ray, 
             const Interval& ray_t, 
             HitRecord& rec) const override;
+    bool Occluded(const Ray& ray, const Interval& ray_t) const override;
     AABB BoundingBox() const override;
 
 private:
     AABB m_bbox;
     std::shared_ptr<Hittable> m_left;
-    std::shared_ptr<Hittable> m_right;
-
-    static bool BoxCompare(const std::shared_ptr<Hittable>& a,
-                        const std::shared_ptr<Hittable>& b, 
-                        AABB::Axis axis_index);
-    static bool BoxCompareX(const std::shared_ptr<Hittable>& a,
-                        const std::shared_ptr<Hittable>& b);
-    static bool BoxCompareY(const std::shared_ptr<Hittable>& a,
-                        const std::shared_ptr<Hittable>& b);
-    static bool BoxCompareZ(const std::shared_ptr<Hittable>& a,
-                        const std::shared_ptr<Hittable>& b);
-    static std::function<bool(const std::shared_ptr<Hittable>&,
-                        const std::shared_ptr<Hittable>&)> 
-            ChoseCompare(AABB::Axis axis_index);
+    std::shared_ptr<Hittable> m_right;      // nullptr in single child leaves
+    AABB::Axis m_axis;                      // axis the children were split on
+
+    BVHNode(const std::vector<std::shared_ptr<Hittable>>& objects,
+            std::vector<BVHPrimitive>& prims,
+            size_t start, size_t end,
+            SplitMethod method);
+    
+    void Build(const std::vector<std::shared_ptr<Hittable>>& objects,
+            std::vector<BVHPrimitive>& prims,
+            size_t start, size_t end,
+            SplitMethod method);
 };
 
-inline BVHNode::BVHNode(HittableList list) :
-BVHNode(list.GetObjects(), 0, list.GetSize())
+inline BVHNode::BVHNode(HittableList list, SplitMethod method) :
+BVHNode(list.GetObjects(), 0, list.GetSize(), method)
 {}
 
 inline AABB BVHNode::BoundingBox() const {
@@ -49,4 +50,4 @@ inline AABB BVHNode::BoundingBox() const {
 
 }
 
-#endif // BVH_HPP
\ No newline at end of file
+#endif // BVH_HPP
@@ -0,0 +1,186 @@
+#ifndef BVH_BUILDER_HPP
+#define BVH_BUILDER_HPP
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "aabb.hpp"
+#include "hittable.hpp"
+#include "thread_pool.hpp"
+
+namespace RayTracing {
+
+// What the builder knows about a primitive, `index` refers back to the
+// caller's object array.
+struct BVHPrimitive {
+    AABB bbox;
+    Point3 centroid;
+    size_t index;
+    uint32_t morton_code;   // only set for SplitMethod::MORTON
+};
+
+// Node of a flattened binary BVH in depth-first order: the first child of an
+// interior node directly follows it, the second one is at second_child.
+struct BVHBuildNode {
+    AABB bbox;
+    size_t second_child;
+    size_t first_prim;      // leaves hold prims[first_prim, first_prim + prim_count)
+    size_t prim_count;      // 0 for interior nodes
+    AABB::Axis axis;        // split axis of interior nodes
+};
+
+// Cost and quality of a finished build, used to pick a split method
+// per scene.
+struct BVHBuildStats {
+    double build_ms;
+    double sah_cost;        // expected cost of a ray query, see SAHCost
+    size_t node_count;
+    size_t leaf_count;
+};
+
+class BVHBuilder {
+public:
+    // MORTON builds a linear BVH (LBVH): primitives are sorted by the
+    // Morton code of their centroid and split at the highest differing bit.
+    // Fastest to build, lowest tree quality.
+    enum SplitMethod : unsigned int {SAH, MEDIAN, MORTON};
+
+    // relative costs of a node traversal step and a primitive intersection
+    static constexpr double TRAVERSAL_COST = 1.0;
+    static constexpr double INTERSECT_COST = 1.0;
+
+    static constexpr size_t SAH_BINS = 16;
+    static constexpr size_t MAX_LEAF_SIZE = 4;
+    // Below this depth ranges are split at the centroid median, which keeps
+    // the tree depth (and traversal stacks) under 64 levels.
+    static constexpr size_t BALANCED_DEPTH = 32;
+    // Builds of at least this many primitives run on a thread pool.
+    static constexpr size_t PARALLEL_BUILD_SIZE = 16384;
+    // Ranges of at least this many primitives are binned in parallel.
+    static constexpr size_t PARALLEL_BIN_SIZE = 65536;
+
+    static std::vector<BVHPrimitive> MakePrimitives(
+                    const std::vector<std::shared_ptr<Hittable>>& objects,
+                    size_t start, size_t end);
+
+    // Reorders prims[start, end) into two halves [start, mid) and [mid, end)
+    // split along `axis` and returns mid. 
+    // Returns end when the range should stay a leaf.
+    static size_t Partition(std::vector<BVHPrimitive>& prims,
+                            size_t start, size_t end,
+                            SplitMethod method,
+                            AABB::Axis& axis);
+
+    static AABB Bounds(const std::vector<BVHPrimitive>& prims,
+                        size_t start, size_t end);
+
+    // Sets the Morton codes and sorts prims by them, required before
+    // partitioning with SplitMethod::MORTON.
+    static void SortMorton(std::vector<BVHPrimitive>& prims);
+
+    // Builds the whole tree, leaves refer to the reordered prims.
+    // Large builds run on a temporary pool of hardware threads.
+    static std::vector<BVHBuildNode> Build(std::vector<BVHPrimitive>& prims,
+                                        SplitMethod method,
+                                        BVHBuildStats *stats = nullptr);
+    // Same as above, on the given pool.
+    static std::vector<BVHBuildNode> Build(std::vector<BVHPrimitive>& prims,
+                                        SplitMethod method,
+                                        ThreadPool& pool,
+                                        BVHBuildStats *stats = nullptr);
+
+    // Surface area heuristic cost of a tree: node and primitive test costs
+    // weighted by the probability of a random ray through the root hitting
+    // the node.
+    static double SAHCost(const std::vector<BVHBuildNode>& nodes);
+
+private:
+    struct SAHBin {
+        AABB bbox;
+        size_t count;
+    };
+
+    struct SAHBins {
+        SAHBin bins[AABB::Axis::NUM_OF_AXIS][SAH_BINS];
+    };
+
+    // Subtree left for a pool task by BuildTop.
+    struct Subtree {
+        size_t start;
+        size_t end;
+        size_t depth;
+        std::vector<BVHBuildNode> nodes;
+    };
+
+    // prim_count of a BuildTop placeholder node, its first_prim is the
+    // index of the Subtree
+    static constexpr size_t SUBTREE_PLACEHOLDER = SIZE_MAX;
+
+    static std::vector<BVHBuildNode> BuildTree(std::vector<BVHPrimitive>& prims,
+                                            SplitMethod method,
+                                            ThreadPool *pool,
+                                            BVHBuildStats *stats);
+    static size_t BuildTop(std::vector<BVHPrimitive>& prims,
+                        size_t start, size_t end,
+                        SplitMethod method,
+                        size_t depth,
+                        size_t subtree_size,
+                        ThreadPool& pool,
+                        std::vector<BVHBuildNode>& nodes,
+                        std::vector<Subtree>& subtrees);
+    static size_t Splice(const std::vector<BVHBuildNode>& top_nodes,
+                        size_t top_index,
+                        std::vector<Subtree>& subtrees,
+                        std::vector<BVHBuildNode>& nodes);
+    // Partitions one node of the tree, see Partition.
+    static size_t SplitNode(std::vector<BVHPrimitive>& prims,
+                            size_t start, size_t end,
+                            SplitMethod method,
+                            size_t depth,
+                            AABB::Axis& axis,
+                            ThreadPool *pool);
+    static size_t BuildRecursive(std::vector<BVHPrimitive>& prims,
+                                size_t start, size_t end,
+                                SplitMethod method,
+                                size_t depth,
+                                std::vector<BVHBuildNode>& nodes);
+    static size_t PartitionSAH(std::vector<BVHPrimitive>& prims,
+                                size_t start, size_t end,
+                                AABB::Axis& split_axis,
+                                ThreadPool *pool = nullptr);
+    static void BinPrimitives(const std::vector<BVHPrimitive>& prims,
+                            size_t start, size_t end,
+                            const AABB& centroid_bounds,
+                            SAHBins& bins);
+    static size_t BinIndex(double cord, const Interval& extent);
+    // Runs func(chunk, chunk_start, chunk_end) over num_chunks equal parts
+    // of [start, end), on the pool if one is given.
+    static void ForEachChunk(size_t start, size_t end,
+                            size_t num_chunks,
+                            ThreadPool *pool,
+                            const std::function<void(size_t chunk, 
+                                                    size_t chunk_start,
+                                                    size_t chunk_end)>& func);
+    static size_t PartitionMedian(std::vector<BVHPrimitive>& prims,
+                                size_t start, size_t end,
+                                AABB::Axis& axis);
+    static size_t PartitionCentroidMedian(std::vector<BVHPrimitive>& prims,
+                                        size_t start, size_t end,
+                                        AABB::Axis axis);
+    static size_t PartitionMorton(std::vector<BVHPrimitive>& prims,
+                                size_t start, size_t end,
+                                AABB::Axis& axis);
+    static AABB CentroidBounds(const std::vector<BVHPrimitive>& prims,
+                                size_t start, size_t end);
+    static void CentroidExtent(const std::vector<BVHPrimitive>& prims,
+                            size_t start, size_t end,
+                            Point3& min, Point3& max);
+    static uint32_t MortonCode(const Point3& p, const AABB& bounds);
+    static uint32_t ExpandBits(uint32_t v);
+};
+
+}
+
+#endif // BVH_BUILDER_HPP
@@ -2,14 +2,30 @@
 #ifndef CAMERA_HPP
 #define CAMERA_HPP
 
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "hittable.hpp"
 #include "color.hpp"
+#include "framebuffer.hpp"
+#include "accumulator.hpp"
+#include "thread_pool.hpp"
+#include "sampler.hpp"
+#include "sobol_sampler.hpp"
 #include "material.hpp"
+#include "wavefront_integrator.hpp"
 
 namespace RayTracing {
 
 class Camera {
 public:
+    // PATH traces every sample to its end before starting the next one,
+    // WAVEFRONT traces the samples of a tile together one bounce at a time
+    // (see WavefrontIntegrator). Both render the same image.
+    enum Integrator : unsigned int {PATH, WAVEFRONT};
+
     Camera(double aspect_ratio = 1.0,
         double vfov = 90.0,
         double defocus_angle = 0.0,
@@ -22,12 +38,63 @@ public:
         Vec3 vup = {0.0, 1.0, 0.0});
 
     void SetBackground(const Color& color);
+    void SetThreadCount(uint32_t num_threads);
+    void SetTileSize(uint32_t tile_size);
+    void SetFrame(uint32_t frame);
+    // Paths longer than depth bounces are randomly terminated 
+    // (Russian roulette) based on their throughput.
+    void SetRouletteDepth(uint32_t depth);
+    // Image file written after a render, the format follows the extension
+    // (.ppm, .pfm or .exr). An empty name skips writing.
+    void SetOutputFile(const std::string& filename);
+
+    // Progressive rendering: samples are added in passes of pass_samples
+    // per pixel until samples_per_pixel is reached. 0 renders all samples
+    // in a single pass, or in passes of BUDGET_PASS_SIZE with a time
+    // budget.
+    void SetPassSamples(uint32_t pass_samples);
+    // Stops a render after this many seconds, 0 - no limit. Only whole
+    // passes reach every pixel.
+    void SetTimeBudget(double seconds);
+    // Minimum time between two snapshots of a progressive render, 
+    // 0 - after every pass.
+    void SetSnapshotInterval(double seconds);
+    // Accumulated samples are saved here with every snapshot, a render
+    // resumes from the file if it exists. Empty - no checkpoints.
+    void SetCheckpointFile(const std::string& filename);
+    // Adaptive sampling: once a pixel has min_samples, it only gets more
+    // while the relative standard error of its luminance is above 
+    // max_error (see Accumulator::GetRelativeError). 0 - disabled.
+    void SetAdaptiveSampling(uint32_t min_samples, double max_error);
+    // Gray image of the samples spent per pixel relative to 
+    // the maximum, written with every snapshot. Empty - not written.
+    void SetSampleMapFile(const std::string& filename);
+
+    // Source of the pixel, lens, time and path sampling dimensions, 
+    // shared by all render threads. Owen scrambled Sobol by default.
+    void SetSampler(std::shared_ptr<Sampler> sampler);
+    void SetIntegrator(Integrator integrator);
+
+    // Linear radiance of the last render.
+    const Framebuffer& GetFramebuffer() const;
+    const Accumulator& GetAccumulator() const;
 
     void Render(const Hittable& world, const Hittable& lights);
     void Render(const Hittable& world, const Hittable& lights, bool parallel);
     // void Render(const Hittable& world, bool parallel);
 
 private:
+    using Clock = std::chrono::steady_clock;
+
+    // Most paths a wavefront batch holds, small enough for its queues to
+    // stay in the L2 cache. Tiles with more samples are traced in several
+    // batches of whole pixels, a pixel with a larger pass is a batch of
+    // its own.
+    static constexpr size_t WAVEFRONT_BATCH_SIZE = 4096;
+    // Pass size of a render with a time budget and no pass size, small so
+    // the first pass reaches every pixel before the deadline.
+    static constexpr uint32_t BUDGET_PASS_SIZE = 4;
+
     Point3 m_center;                    // Camera Center
     Point3 m_pixel00_loc;               // Location of pixel 0, 0
     Vec3 m_pixel_delta_u;               // Offset to pixel to the right
@@ -35,34 +102,74 @@ private:
     Vec3 m_u, m_v, m_w;                 // camera frame basis vectors
     Vec3 m_defocus_disk_u;              // defocus horizontal radius
     Vec3 m_defocus_disk_v;              // defocus vertical radius
+    double m_cone_spread;               // Angle of a pixel, spread of the rays' cones
     Point3 m_look_from;                 // point camera is loking from
     Point3 m_look_at;                   // point camera is loking at
     Vec3 m_vup;                         // camera relative "up" direction
     double m_aspect_ratio;              // Ratio of image width over height
-    double m_pixel_samples_scale;       // Color scale factor for a sum of pixel samples
-    uint32_t m_sqrt_spp;                // Squre root of number of samples per pixel
-    double m_recip_sqrt_spp;            // 1 / m_sqrt_spp
+    uint32_t m_pass_size;               // Samples per pixel of every pass
     double m_vfov;                      // vertical view angle
     double m_defocus_angle;             // Variation angle of rays through each pixel
     double m_focus_dist;                // Distance from camera lookfrom point to plane of perfect focus
     uint32_t m_image_width;             // Rendered image width in pixel count
     uint32_t m_image_height;            // Rendered image height
     uint32_t m_samples_per_pixel;       // Count of random samples for each pixel
+    uint32_t m_target_samples;          // Samples per pixel a render ends with
     uint32_t m_max_depth;               // Maximum number of ray bounces into scene
     Color m_background;                 // Scene background color
+    uint32_t m_num_threads;             // Render threads (0 - all hardware threads)
+    uint32_t m_tile_size;               // Side of the square image tiles handed to the render threads
+    uint32_t m_frame;                   // Frame index, part of every sample's random seed
+    uint32_t m_roulette_depth;          // Bounces before Russian roulette starts
+    std::string m_output_file;          // Image written after rendering
+    Framebuffer m_framebuffer;          // Averaged samples of the last render
+    Accumulator m_accumulator;          // Sample sums of the current render
+    uint32_t m_pass_samples;            // Samples per pixel of a progressive pass
+    double m_time_budget;               // Seconds a render may take, 0 - unlimited
+    double m_snapshot_interval;         // Seconds between progressive snapshots
+    std::string m_checkpoint_file;      // Accumulator saved with every snapshot
+    uint32_t m_adaptive_min_samples;    // Samples every pixel gets with adaptive sampling
+    double m_adaptive_max_error;        // Relative error of a converged pixel, 0 - not adaptive
+    std::string m_sample_map_file;      // Image of the per pixel sample counts
+    std::vector<uint8_t> m_active_pixels; // Pixels rendered by the next pass
+    std::shared_ptr<Sampler> m_sampler; // Uniform numbers of every pixel sample
+    Integrator m_integrator;            // How the samples of a tile are traced
 
     void Initialize();
+    void WriteImage() const;
+    void WriteSnapshot();
+    void ResumeFromCheckpoint();
+    size_t UpdateActivePixels();
+    // Samples the next pass adds to a pixel that has sample_count of them,
+    // the last pass of a pixel may be partial.
+    uint32_t PassSamples(uint32_t sample_count) const;
+    // integrators holds one WavefrontIntegrator per render thread for 
+    // Integrator::WAVEFRONT and is empty otherwise.
+    bool RenderPass(const Hittable& world, const Hittable& lights,
+                    ThreadPool *pool, Clock::time_point deadline,
+                    std::vector<WavefrontIntegrator>& integrators);
+    void RenderTile(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1,
+                    const Hittable& world, const Hittable& lights);
+    void RenderTileWavefront(uint32_t x0, uint32_t y0, 
+                            uint32_t x1, uint32_t y1,
+                            WavefrontIntegrator& integrator);
+    void AccumulateWavefront(const WavefrontIntegrator& integrator);
+    Color RenderPixel(uint32_t i, uint32_t j,
+                    uint32_t first_sample,
+                    uint32_t num_samples,
+                    const Hittable& world,
+                    const Hittable& lights,
+                    double& luminance_squares) const;
     Color RayColor(const Ray& ray, 
-                    uint32_t depth, 
                     const Hittable& world, 
-                    const Hittable& lights) const;
+                    const Hittable& lights,
+                    SampleSequence& sequence,
+                    RNG& rng) const;
     // Color RayColor(const Ray& ray, 
     //                 uint32_t depth, 
     //                 const Hittable& world) const;
-    Ray GetRay(int i, int j, int s_i, int s_j) const;
-    Point3 DefocusDiskSample() const;
-    static Vec3 SampleSqure();
-    Vec3 SampleSquareStratified(int s_i, int s_j) const;
+    Ray GetRay(uint32_t i, uint32_t j, SampleSequence& sequence) const;
+    Point3 DefocusDiskSample(double u, double v) const;
 
 };
 
@@ -86,13 +193,87 @@ m_focus_dist(focus_dist),
 m_image_width(image_width),
 m_samples_per_pixel(samples_per_pixel),
 m_max_depth(max_depth),
-m_background(Color(0.0, 0.0, 0.0))
+m_background(Color(0.0, 0.0, 0.0)),
+m_num_threads(0),
+m_tile_size(16),
+m_frame(0),
+m_roulette_depth(3),
+m_output_file("image.ppm"),
+m_pass_samples(0),
+m_time_budget(0.0),
+m_snapshot_interval(0.0),
+m_adaptive_min_samples(16),
+m_adaptive_max_error(0.0),
+m_sampler(std::make_shared<SobolSampler>()),
+m_integrator(Integrator::PATH)
  {}
 
 inline void Camera::SetBackground(const Color& color) {
     m_background = color;
 }
 
+inline void Camera::SetThreadCount(uint32_t num_threads) {
+    m_num_threads = num_threads;
+}
+
+inline void Camera::SetTileSize(uint32_t tile_size) {
+    m_tile_size = (tile_size < 1) ? 1 : tile_size;
+}
+
+inline void Camera::SetFrame(uint32_t frame) {
+    m_frame = frame;
+}
+
+inline void Camera::SetRouletteDepth(uint32_t depth) {
+    m_roulette_depth = depth;
+}
+
+inline void Camera::SetOutputFile(const std::string& filename) {
+    m_output_file = filename;
+}
+
+inline void Camera::SetPassSamples(uint32_t pass_samples) {
+    m_pass_samples = pass_samples;
+}
+
+inline void Camera::SetTimeBudget(double seconds) {
+    m_time_budget = seconds;
+}
+
+inline void Camera::SetSnapshotInterval(double seconds) {
+    m_snapshot_interval = seconds;
+}
+
+inline void Camera::SetCheckpointFile(const std::string& filename) {
+    m_checkpoint_file = filename;
+}
+
+inline void Camera::SetAdaptiveSampling(uint32_t min_samples, 
+                                        double max_error) {
+    m_adaptive_min_samples = (min_samples < 2) ? 2 : min_samples;
+    m_adaptive_max_error = max_error;
+}
+
+inline void Camera::SetSampleMapFile(const std::string& filename) {
+    m_sample_map_file = filename;
+}
+
+inline void Camera::SetSampler(std::shared_ptr<Sampler> sampler) {
+    m_sampler = sampler;
+}
+
+inline void Camera::SetIntegrator(Integrator integrator) {
+    m_integrator = integrator;
+}
+
+inline const Framebuffer& Camera::GetFramebuffer() const {
+    return m_framebuffer;
+}
+
+inline const Accumulator& Camera::GetAccumulator() const {
+    return m_accumulator;
+}
+
 }
 
 #endif // CAMERA_HPP
\ No newline at end of file
@@ -19,12 +19,16 @@ public:
                 const Color& c2);
 
     Color Value(double u, double v, const Point3& p) const override;
+    Color FilteredValue(double u, double v, const Point3& p,
+                        double uv_width) const override;
 
 private:
     double m_inv_scale;
     std::shared_ptr<Texture> m_even;
     std::shared_ptr<Texture> m_odd;
 
+    bool IsOdd(const Point3& p) const;
+
 };
 
 inline CheckerTexture::CheckerTexture(double scale, 
@@ -42,13 +46,21 @@ m_odd(std::make_shared<SolidColor>(c2))
 {}
 
 inline Color CheckerTexture::Value(double u, double v, const Point3& p) const {
+    return (IsOdd(p) ? m_odd->Value(u, v, p) : m_even->Value(u, v, p));
+}
+
+inline Color CheckerTexture::FilteredValue(double u, double v, const Point3& p,
+                                        double uv_width) const {
+    return (IsOdd(p) ? m_odd->FilteredValue(u, v, p, uv_width) :
+                        m_even->FilteredValue(u, v, p, uv_width));
+}
+
+inline bool CheckerTexture::IsOdd(const Point3& p) const {
     int x_int = static_cast<int>(std::floor(m_inv_scale * p.GetX()));
     int y_int = static_cast<int>(std::floor(m_inv_scale * p.GetY()));
     int z_int = static_cast<int>(std::floor(m_inv_scale * p.GetZ()));
 
-    bool is_odd = (x_int + y_int + z_int) & 1;
-
-    return (is_odd ? m_odd->Value(u, v, p) : m_even->Value(u, v, p));
+    return (((x_int + y_int + z_int) & 1) != 0);
 }
 
 }
@@ -2,6 +2,7 @@
 #ifndef COLOR_HPP
 #define COLOR_HPP
 
+#include <cstdint>
 #include <iostream>
 
 #include "vec3.hpp"
@@ -18,6 +19,8 @@ public:
     double GetR() const;
     double GetG() const;
     double GetB() const;
+    // Rec. 709 relative luminance
+    double Luminance() const;
 
     explicit operator Vec3() const;
     Color& operator+=(const Color& other);
@@ -46,6 +49,10 @@ inline double Color::GetB() const {
     return m_rgb.GetZ();
 }
 
+inline double Color::Luminance() const {
+    return (0.2126 * GetR() + 0.7152 * GetG() + 0.0722 * GetB());
+}
+
 inline Color::operator Vec3() const {
     return m_rgb;
 }
@@ -68,31 +75,22 @@ inline double LinearToGamma(double linear_component) {
     return ((linear_component > 0.0) ? std::sqrt(linear_component) : 0);
 }
 
-inline void WriteColor(std::ostream& out, const Color& pixel_color) {
-    double r = pixel_color.GetR();
-    double g = pixel_color.GetG();
-    double b = pixel_color.GetB();
+// Gamma corrected 8 bit value of a linear component, NaN maps to zero.
+inline uint8_t ComponentToByte(double linear_component) {
+    static const Interval intensity(0.000, 0.999);
 
-    // Replace NaN components with zero
-    if (r != r) {
-        r = 0.0;
-    }
-    if (g != g) {
-        g = 0.0;
-    }
-    if (b != b) {
-        b = 0.0;
+    if (linear_component != linear_component) {
+        linear_component = 0.0;
     }
-    
-    r = LinearToGamma(r);
-    g = LinearToGamma(g);
-    b = LinearToGamma(b);
 
-    static const Interval intensity(0.000, 0.999);
-    
-    int rbyte = static_cast<int>(256 * intensity.Clamp(r));
-    int gbyte = static_cast<int>(256 * intensity.Clamp(g));
-    int bbyte = static_cast<int>(256 * intensity.Clamp(b));
+    return static_cast<uint8_t>(
+                256 * intensity.Clamp(LinearToGamma(linear_component)));
+}
+
+inline void WriteColor(std::ostream& out, const Color& pixel_color) {
+    int rbyte = ComponentToByte(pixel_color.GetR());
+    int gbyte = ComponentToByte(pixel_color.GetG());
+    int bbyte = ComponentToByte(pixel_color.GetB());
     
     out << rbyte << ' ' << gbyte << ' ' << bbyte << '\n';
 }
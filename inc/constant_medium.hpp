@@ -95,7 +95,8 @@ inline bool ConstantMedium::Hit(const Ray& ray,
 
     rec.normal = Vec3(1.0, 0.0, 0.0); // arbitrary
     rec.front_face = true; // also arbitrary
-    rec.mat = m_phase_function;
+    rec.mat = m_phase_function.get();
+    rec.uv_density = 0.0;
 
     return true;
 }
@@ -12,7 +12,7 @@ public:
     CosinePDF(const Vec3& w);
 
     double Value(const Vec3& direction) const override;
-    Vec3 Generate() const override;
+    Vec3 Generate(double uc, double u, double v) const override;
 
 private:
     ONB m_uvw;
@@ -28,8 +28,10 @@ inline double CosinePDF::Value(const Vec3& direction) const {
     return std::fmax(0.0, cosine_theta / PI);
 }
 
-inline Vec3 CosinePDF::Generate() const {
-    return m_uvw.Transform(RandomCosineDirection());
+inline Vec3 CosinePDF::Generate(double uc, double u, double v) const {
+    (void)uc;
+
+    return m_uvw.Transform(RandomCosineDirection(u, v));
 }
 
 }
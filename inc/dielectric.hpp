@@ -12,7 +12,8 @@ public:
 
     bool Scatter(const Ray& ray_in,
                 const HitRecord& rec,
-                ScatterRecord& srec) const override;
+                ScatterRecord& srec,
+                RNG& rng) const override;
 
 private:
     // Refractive index in vacuum or air, or the ratio of the material's refractive index over
@@ -29,9 +30,9 @@ m_refraction_index(refraction_index)
 
 inline bool Dielectric::Scatter(const Ray& ray_in,
                 const HitRecord& rec,
-                ScatterRecord& srec) const {
+                ScatterRecord& srec,
+                RNG& rng) const {
     srec.attenuation = Color(1.0, 1.0, 1.0);
-    srec.pdf_ptr = nullptr;
     srec.skip_pdf = true;
     double ri = rec.front_face ? 
                 (1.0 / m_refraction_index) : m_refraction_index;
@@ -42,7 +43,7 @@ inline bool Dielectric::Scatter(const Ray& ray_in,
     bool cannot_refract = (ri * sin_theta) > 1.0;
 
     Vec3 direction;
-    if (cannot_refract || (Reflectance(cos_theta, ri) > RandomDouble())) {
+    if (cannot_refract || (Reflectance(cos_theta, ri) > RandomDouble(rng))) {
         direction = Reflect(unit_direction, rec.normal);
     }
     else {
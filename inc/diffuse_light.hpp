@@ -39,7 +39,8 @@ inline Color DiffuseLight::Emitted(const Ray& r_in,
                         const Point3& p) const {
     (void)r_in;
     
-    return (rec.front_face ? m_tex->Value(u, v, p) : Color(0.0, 0.0, 0.0));
+    return (rec.front_face ? m_tex->FilteredValue(u, v, p, rec.uv_width) :
+                            Color(0.0, 0.0, 0.0));
 }
 
 }
@@ -0,0 +1,73 @@
+#ifndef FRAMEBUFFER_HPP
+#define FRAMEBUFFER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "color.hpp"
+
+namespace RayTracing {
+
+// Linear radiance of a rendered image, row by row from the top left pixel.
+class Framebuffer {
+public:
+    Framebuffer();
+    Framebuffer(uint32_t width, uint32_t height);
+
+    // Resizes and clears to black.
+    void Resize(uint32_t width, uint32_t height);
+
+    uint32_t GetWidth() const;
+    uint32_t GetHeight() const;
+    const Color& GetPixel(uint32_t i, uint32_t j) const;
+    void SetPixel(uint32_t i, uint32_t j, const Color& color);
+    const std::vector<Color>& GetPixels() const;
+
+    // Writes the image in the format given by the extension of filename
+    // (see ImageWriter::ForFile).
+    bool Write(const std::string& filename) const;
+
+private:
+    uint32_t m_width;
+    uint32_t m_height;
+    std::vector<Color> m_pixels;
+};
+
+inline Framebuffer::Framebuffer() : m_width(0), m_height(0)
+{}
+
+inline Framebuffer::Framebuffer(uint32_t width, uint32_t height) :
+m_width(width), m_height(height),
+m_pixels(static_cast<size_t>(width) * height)
+{}
+
+inline void Framebuffer::Resize(uint32_t width, uint32_t height) {
+    m_width = width;
+    m_height = height;
+    m_pixels.assign(static_cast<size_t>(width) * height, Color());
+}
+
+inline uint32_t Framebuffer::GetWidth() const {
+    return m_width;
+}
+
+inline uint32_t Framebuffer::GetHeight() const {
+    return m_height;
+}
+
+inline const Color& Framebuffer::GetPixel(uint32_t i, uint32_t j) const {
+    return m_pixels[static_cast<size_t>(j) * m_width + i];
+}
+
+inline void Framebuffer::SetPixel(uint32_t i, uint32_t j, const Color& color) {
+    m_pixels[static_cast<size_t>(j) * m_width + i] = color;
+}
+
+inline const std::vector<Color>& Framebuffer::GetPixels() const {
+    return m_pixels;
+}
+
+}
+
+#endif // FRAMEBUFFER_HPP
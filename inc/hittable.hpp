@@ -2,30 +2,63 @@
 #ifndef HITTABLE_HPP
 #define HITTABLE_HPP
 
+#include <cstdint>
 #include <memory>
+#include <utility>
 
 #include "ray.hpp"
 #include "vec3.hpp"
 #include "interval.hpp"
 #include "aabb.hpp"
+#include "rng.hpp"
 
 namespace RayTracing {
 
 class Material;
+class Hittable;
 
 struct HitRecord {
     Point3 point;
     Vec3 normal;
-    std::shared_ptr<Material> mat;
+    const Material *mat;    // owned by the primitive that was hit
     double t;
     double u;
     double v;
+    // Texture space length per world space length at the hit, the square
+    // root of uv area over surface area, set by the primitive. uv_width is
+    // the ray's footprint in texture space, set by the integrator before
+    // shading (see ShadePathVertex). 0 means unfiltered.
+    double uv_density = 0.0;
+    double uv_width = 0.0;
     bool front_face;
 
     // NOTE: the parameter `outward_normal` is assumed to have unit length.
     void SetFaceNormal(const Ray& ray, const Vec3& outward_normal);
 };
 
+// Rays traced together by Hittable::HitPacket and OccludedPacket, 
+// bit k of a ray mask stands for rays[k]. All rays start at t_min, HitPacket
+// shrinks the t_max of a ray to its closest hit.
+// Media draw their distances from the thread's generator, rngs[k] is 
+// swapped in as the thread's one while ray k is tested (nullptr - the 
+// thread's own), so every ray can keep its path's generator.
+struct RayPacket {
+    static constexpr uint32_t MAX_SIZE = 8;
+
+    uint32_t size;
+    double t_min;
+    Ray rays[MAX_SIZE];
+    double t_max[MAX_SIZE];
+    RNG *rngs[MAX_SIZE];
+
+    // Single ray queries of ray k, with its generator. Hit only writes rec
+    // on a hit.
+    bool Hit(const Hittable& object, uint32_t k, HitRecord& rec);
+    bool Occluded(const Hittable& object, uint32_t k) const;
+    // Exchanges the generator of ray k with the thread's one.
+    void SwapRNG(uint32_t k) const;
+};
+
 inline void HitRecord::SetFaceNormal(const Ray& ray, const Vec3& outward_normal) {
     front_face = (Dot(ray.GetDirection(), outward_normal) < 0.0);
     normal = front_face ? outward_normal : (-1.0 * outward_normal);
@@ -39,11 +72,83 @@ public:
                     const Interval& ray_t, 
                     HitRecord& rec) const =0;
     virtual AABB BoundingBox() const =0;
+    // Any-hit query: is there a hit in ray_t at all. Cheaper than Hit for
+    // shadow rays since it can stop at the first hit and fills no record.
+    virtual bool Occluded(const Ray& ray, const Interval& ray_t) const;
+    // Closest hits of all rays of the packet. Returns the mask of the rays
+    // that hit something closer than their t_max, their records are 
+    // written to recs. Tests the rays one by one unless overridden.
+    virtual uint32_t HitPacket(RayPacket& packet, HitRecord *recs) const;
+    // Returns the mask of the rays of the packet that are occluded.
+    virtual uint32_t OccludedPacket(const RayPacket& packet) const;
     virtual double PDFValue(const Point3& origin, const Vec3& direction) const;
-    virtual Vec3 Random(const Point3& origin) const;
+    // Direction from origin to a random point of the object, for uniform
+    // samples uc, u, v in [0, 1) (see PDF::Generate).
+    virtual Vec3 Random(const Point3& origin, 
+                        double uc, double u, double v) const;
 };
 
 
+inline bool Hittable::Occluded(const Ray& ray, const Interval& ray_t) const {
+    HitRecord rec;
+
+    return Hit(ray, ray_t, rec);
+}
+
+inline uint32_t Hittable::HitPacket(RayPacket& packet, 
+                                    HitRecord *recs) const {
+    uint32_t mask = 0;
+
+    for (uint32_t k = 0; k < packet.size; ++k) {
+        if (packet.Hit(*this, k, recs[k])) {
+            mask |= (1u << k);
+        }
+    }
+
+    return mask;
+}
+
+inline uint32_t Hittable::OccludedPacket(const RayPacket& packet) const {
+    uint32_t mask = 0;
+
+    for (uint32_t k = 0; k < packet.size; ++k) {
+        if (packet.Occluded(*this, k)) {
+            mask |= (1u << k);
+        }
+    }
+
+    return mask;
+}
+
+inline bool RayPacket::Hit(const Hittable& object, uint32_t k, HitRecord& rec) {
+    HitRecord tmp_rec;
+
+    SwapRNG(k);
+    bool hit = object.Hit(rays[k], Interval(t_min, t_max[k]), tmp_rec);
+    SwapRNG(k);
+
+    if (hit) {
+        t_max[k] = tmp_rec.t;
+        rec = tmp_rec;
+    }
+
+    return hit;
+}
+
+inline bool RayPacket::Occluded(const Hittable& object, uint32_t k) const {
+    SwapRNG(k);
+    bool occluded = object.Occluded(rays[k], Interval(t_min, t_max[k]));
+    SwapRNG(k);
+
+    return occluded;
+}
+
+inline void RayPacket::SwapRNG(uint32_t k) const {
+    if (rngs[k] != nullptr) {
+        std::swap(ThreadRNG(), *rngs[k]);
+    }
+}
+
 inline double Hittable::PDFValue(const Point3& origin, 
                                 const Vec3& direction) const {
     (void)origin;
@@ -52,8 +157,12 @@ inline double Hittable::PDFValue(const Point3& origin,
     return 0.0;
 }
 
-inline Vec3 Hittable::Random(const Point3& origin) const {
+inline Vec3 Hittable::Random(const Point3& origin, 
+                            double uc, double u, double v) const {
     (void)origin;
+    (void)uc;
+    (void)u;
+    (void)v;
     
     return Vec3(1.0, 0.0, 0.0);
 }
@@ -2,6 +2,7 @@
 #ifndef HITTABLE_LIST_HPP
 #define HITTABLE_LIST_HPP
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -22,9 +23,13 @@ public:
     bool Hit(const Ray& ray, 
             const Interval& ray_t,
             HitRecord& rec) const override;
+    bool Occluded(const Ray& ray, const Interval& ray_t) const override;
+    uint32_t HitPacket(RayPacket& packet, HitRecord *recs) const override;
+    uint32_t OccludedPacket(const RayPacket& packet) const override;
     AABB BoundingBox() const override;
     double PDFValue(const Point3& origin, const Vec3& direction) const override;
-    Vec3 Random(const Point3& origin) const override;
+    Vec3 Random(const Point3& origin, 
+                double uc, double u, double v) const override;
 
 private:
     AABB m_bbox;
@@ -67,10 +72,14 @@ inline double HittableList::PDFValue(const Point3& origin,
     return sum;
 }
 
-inline Vec3 HittableList::Random(const Point3& origin) const {
-    int int_size = static_cast<int>(m_objects.size());
+// uc picks the object, what is left of it within the object's 
+// share of [0, 1) is passed on.
+inline Vec3 HittableList::Random(const Point3& origin, 
+                                double uc, double u, double v) const {
+    double scaled = uc * m_objects.size();
+    size_t index = std::min(static_cast<size_t>(scaled), m_objects.size() - 1);
 
-    return m_objects[RandomInt(0, int_size - 1)]->Random(origin);
+    return m_objects[index]->Random(origin, scaled - index, u, v);
 }
 
 }
@@ -1,50 +1,59 @@
-
 #ifndef IMAGE_TEXTURE_HPP
 #define IMAGE_TEXTURE_HPP
 
 #include "texture.hpp"
 #include "image_loader.hpp"
+#include "mipmap.hpp"
 
 namespace RayTracing {
 
+// Image mapped to [0, 1]^2, kept as a MipMap of float texels. Value is
+// the bilinear filtered image, FilteredValue blends the pyramid levels
+// that match the lookup's footprint. Images that fail to load are cyan.
 class ImageTexture : public Texture {
 public:
     ImageTexture(const char *filename);
 
     Color Value(double u, double v, const Point3& p) const override;
+    Color FilteredValue(double u, double v, const Point3& p,
+                        double uv_width) const override;
 
 
 private:
-    ImageLoad m_image;
+    MipMap m_mipmap;
 
 };
 
-inline ImageTexture::ImageTexture(const char *filename) : m_image(filename)
-{}
+inline ImageTexture::ImageTexture(const char *filename) {
+    ImageLoad image(filename);
+
+    m_mipmap = MipMap(image.Data(), static_cast<size_t>(image.Width()),
+                    static_cast<size_t>(image.Height()));
+}
 
 inline Color ImageTexture::Value(double u, double v, const Point3& p) const {
     (void)p;
 
-    if (m_image.Height() <= 0) {
+    if (m_mipmap.IsEmpty()) {
         return Color(0, 1, 1);
     }
 
-    u = Interval(0.0, 1.0).Clamp(u);
-    v = 1.0 - Interval(0.0, 1.0).Clamp(v);
+    return m_mipmap.Bilinear(0, u, v);
+}
 
-    int i = static_cast<int>(u * m_image.Width());
-    int j = static_cast<int>(v * m_image.Height());
-    const unsigned char *pixel = m_image.PixelData(i, j);
+inline Color ImageTexture::FilteredValue(double u, double v, const Point3& p,
+                                        double uv_width) const {
+    (void)p;
 
-    constexpr double color_scale = 1.0 / 255.0;
+    if (m_mipmap.IsEmpty()) {
+        return Color(0, 1, 1);
+    }
 
-    return Color(color_scale * pixel[0], 
-                color_scale * pixel[1], 
-                color_scale * pixel[2]);
+    return m_mipmap.Trilinear(u, v, uv_width);
 }
 
 } 
 
 
 
-#endif // IMAGE_TEXTURE_HPP
\ No newline at end of file
+#endif // IMAGE_TEXTURE_HPP
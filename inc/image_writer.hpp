@@ -0,0 +1,67 @@
+#ifndef IMAGE_WRITER_HPP
+#define IMAGE_WRITER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "framebuffer.hpp"
+
+namespace RayTracing {
+
+// Encodes a framebuffer into an image file. The whole file is built in
+// memory and written with a single fwrite.
+class ImageWriter {
+public:
+    virtual ~ImageWriter() = default;
+
+    virtual std::vector<uint8_t> Encode(const Framebuffer& framebuffer) const =0;
+
+    bool Write(const Framebuffer& framebuffer, 
+                const std::string& filename) const;
+
+    // Writer for the extension of filename: .pfm, .exr, 
+    // binary PPM for anything else.
+    static std::unique_ptr<ImageWriter> ForFile(const std::string& filename);
+};
+
+// Binary (P6) PPM, 8 bits per channel, gamma 2 like WriteColor.
+class PPMWriter : public ImageWriter {
+public:
+    std::vector<uint8_t> Encode(const Framebuffer& framebuffer) const override;
+};
+
+// Portable float map, linear 32 bit float RGB.
+class PFMWriter : public ImageWriter {
+public:
+    std::vector<uint8_t> Encode(const Framebuffer& framebuffer) const override;
+};
+
+// Scanline OpenEXR, linear half float RGB.
+class EXRWriter : public ImageWriter {
+public:
+    enum Compression : uint8_t {NONE = 0, RLE = 1};
+
+    explicit EXRWriter(Compression compression = Compression::RLE);
+
+    std::vector<uint8_t> Encode(const Framebuffer& framebuffer) const override;
+
+    static uint16_t FloatToHalf(float value);
+
+private:
+    Compression m_compression;
+
+    // OpenEXR RLE: bytes split into even/odd halves, delta encoded and
+    // run length encoded. Returns false if that does not make it smaller.
+    static bool CompressRLE(const std::vector<uint8_t>& raw, 
+                            std::vector<uint8_t>& compressed);
+};
+
+inline EXRWriter::EXRWriter(Compression compression) : 
+m_compression(compression)
+{}
+
+}
+
+#endif // IMAGE_WRITER_HPP
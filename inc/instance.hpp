@@ -0,0 +1,75 @@
+#ifndef INSTANCE_HPP
+#define INSTANCE_HPP
+
+#include <memory>
+
+#include "hittable.hpp"
+#include "transform.hpp"
+
+namespace RayTracing {
+
+// A shared object placed in the world by an affine transform. Rays are
+// brought into object space by the cached inverse, so any number of
+// instances share one object (usually a TriangleMesh or a BVH) and each
+// only costs its two matrices and its world space box. Replaces stacks of
+// Translate and RotateY with one object and one transform per ray.
+class Instance : public Hittable {
+public:
+    // A singular transform is reported and replaced by the identity.
+    Instance(std::shared_ptr<Hittable> object, const Transform& transform);
+
+    bool Hit(const Ray& ray,
+            const Interval& ray_t,
+            HitRecord& rec) const override;
+    bool Occluded(const Ray& ray, const Interval& ray_t) const override;
+    AABB BoundingBox() const override;
+
+    const Transform& GetTransform() const;
+    const std::shared_ptr<Hittable>& GetObject() const;
+
+private:
+    Transform m_object_to_world;
+    Transform m_world_to_object;
+    AABB m_bbox;
+    std::shared_ptr<Hittable> m_object;
+    // object to world factor of uv densities: the inverse of the
+    // transform's mean scale
+    double m_uv_scale;
+};
+
+// Distances are the same in both spaces since the object space direction
+// is not normalized, so the hit point is taken on the world space ray.
+// Normals go through the inverse transpose, which keeps the face side.
+inline bool Instance::Hit(const Ray& ray,
+                        const Interval& ray_t,
+                        HitRecord& rec) const {
+    if (!m_object->Hit(m_world_to_object.TransformRay(ray), ray_t, rec)) {
+        return false;
+    }
+
+    rec.point = ray.At(rec.t);
+    rec.normal = UnitVector(m_world_to_object.TransformNormal(rec.normal));
+    rec.uv_density *= m_uv_scale;
+
+    return true;
+}
+
+inline bool Instance::Occluded(const Ray& ray, const Interval& ray_t) const {
+    return m_object->Occluded(m_world_to_object.TransformRay(ray), ray_t);
+}
+
+inline AABB Instance::BoundingBox() const {
+    return m_bbox;
+}
+
+inline const Transform& Instance::GetTransform() const {
+    return m_object_to_world;
+}
+
+inline const std::shared_ptr<Hittable>& Instance::GetObject() const {
+    return m_object;
+}
+
+}
+
+#endif // INSTANCE_HPP
@@ -0,0 +1,67 @@
+#ifndef INSTANCE_BVH_HPP
+#define INSTANCE_BVH_HPP
+
+#include <vector>
+
+#include "hittable.hpp"
+#include "instance.hpp"
+#include "bvh_builder.hpp"
+#include "linear_bvh.hpp"
+
+namespace RayTracing {
+
+// Top level BVH over instances of shared objects (the bottom level BVHs).
+// The instances are kept by value in leaf order next to the nodes, so
+// 100k copies of a mesh cost the mesh once plus about 300 bytes per copy
+// for its instance and nodes, and the traversal goes straight from a leaf
+// into the instance's object.
+class InstanceBVH : public Hittable {
+public:
+    using SplitMethod = BVHBuilder::SplitMethod;
+
+    explicit InstanceBVH(std::vector<Instance> instances,
+                        SplitMethod method = SplitMethod::SAH);
+
+    bool Hit(const Ray& ray,
+            const Interval& ray_t,
+            HitRecord& rec) const override;
+    bool Occluded(const Ray& ray, const Interval& ray_t) const override;
+    AABB BoundingBox() const override;
+
+    size_t GetInstanceCount() const;
+    size_t GetNodeCount() const;
+    const BVHBuildStats& GetBuildStats() const;
+
+private:
+    static constexpr size_t STACK_SIZE = 64;
+
+    AABB m_bbox;
+    BVHBuildStats m_build_stats;
+    std::vector<LinearBVHNode> m_nodes;
+    std::vector<Instance> m_instances;  // in BVH leaf order
+
+    // Same traversal as LinearBVH::Traverse with the instances tested
+    // in place.
+    template <bool ANY_HIT>
+    bool Traverse(const Ray& ray, const Interval& ray_t, HitRecord *rec) const;
+};
+
+inline AABB InstanceBVH::BoundingBox() const {
+    return m_bbox;
+}
+
+inline size_t InstanceBVH::GetInstanceCount() const {
+    return m_instances.size();
+}
+
+inline size_t InstanceBVH::GetNodeCount() const {
+    return m_nodes.size();
+}
+
+inline const BVHBuildStats& InstanceBVH::GetBuildStats() const {
+    return m_build_stats;
+}
+
+}
+
+#endif // INSTANCE_BVH_HPP
@@ -2,6 +2,8 @@
 #ifndef INTERVAL_HPP
 #define INTERVAL_HPP
 
+#include <algorithm>
+
 #include "utils.hpp"
 
 namespace RayTracing {
@@ -11,29 +13,29 @@ public:
     static const Interval EMPTY, UNIVERSE;
 
     Interval();
-    Interval(double min, double max);
+    Interval(Real min, Real max);
     Interval(const Interval& a, const Interval& b);
 
-    double GetMin() const;
-    double GetMax() const;
-    void SetMin(double min);
-    void SetMax(double max);
+    Real GetMin() const;
+    Real GetMax() const;
+    void SetMin(Real min);
+    void SetMax(Real max);
     
-    double Size() const;
-    bool Contains(double x) const;
-    bool Surrounds(double x) const;
-    double Clamp(double x) const;
-    Interval Expand(double delta) const;
+    Real Size() const;
+    bool Contains(Real x) const;
+    bool Surrounds(Real x) const;
+    Real Clamp(Real x) const;
+    Interval Expand(Real delta) const;
 
 private:
-    double m_min;
-    double m_max;
+    Real m_min;
+    Real m_max;
 };
 
 inline Interval::Interval() : m_min(+INF), m_max(-INF) 
 {}
 
-inline Interval::Interval(double min, double max) : m_min(min), m_max(max)
+inline Interval::Interval(Real min, Real max) : m_min(min), m_max(max)
 {}
 
 inline Interval::Interval(const Interval& a, const Interval& b) :
@@ -41,49 +43,49 @@ m_min(std::min(a.GetMin(), b.GetMin())),
 m_max(std::max(a.GetMax(), b.GetMax())) 
 {}
 
-inline double Interval::GetMin() const {
+inline Real Interval::GetMin() const {
     return m_min;
 }
 
-inline double Interval::GetMax() const {
+inline Real Interval::GetMax() const {
     return m_max;
 }
 
-inline void Interval::SetMin(double min) {
+inline void Interval::SetMin(Real min) {
     m_min = min;
 }
 
-inline void Interval::SetMax(double max) {
+inline void Interval::SetMax(Real max) {
     m_max = max;
 }
 
-inline double Interval::Size() const {
+inline Real Interval::Size() const {
     return (m_max - m_min);
 }
 
-inline bool Interval::Contains(double x) const {
+inline bool Interval::Contains(Real x) const {
     return ((x >= m_min) && (x <= m_max));
 }
 
-inline bool Interval::Surrounds(double x) const {
+inline bool Interval::Surrounds(Real x) const {
     return ((x > m_min) && (x < m_max));
 }
 
-inline double Interval::Clamp(double x) const {
+inline Real Interval::Clamp(Real x) const {
     return ((x < m_min) ? m_min : ((x > m_max) ? m_max : x));
 }
 
-inline Interval Interval::Expand(double delta) const {
-    double padding = delta / 2;
+inline Interval Interval::Expand(Real delta) const {
+    Real padding = delta / 2;
 
     return Interval(m_min - padding, m_max + padding);
 }
 
-inline Interval operator+(const Interval& ival, double displacement) {
+inline Interval operator+(const Interval& ival, Real displacement) {
     return Interval(ival.GetMin() + displacement, ival.GetMax() + displacement);
 }
 
-inline Interval operator+(double displacement, const Interval& ival) {
+inline Interval operator+(Real displacement, const Interval& ival) {
     return (ival + displacement);
 }
 
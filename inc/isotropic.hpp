@@ -8,6 +8,7 @@
 #include "texture.hpp"
 #include "solid_color.hpp"
 #include "sphere_pdf.hpp"
+#include "scatter_pdf.hpp"
 
 namespace RayTracing {
 
@@ -18,7 +19,8 @@ public:
 
     bool Scatter(const Ray& ray_in,
                 const HitRecord& rec,
-                ScatterRecord& srec) const override;
+                ScatterRecord& srec,
+                RNG& rng) const override;
     double ScatteringPDF(const Ray& r_in,
                         const HitRecord& rec,
                         const Ray& scattered) const override;
@@ -37,9 +39,14 @@ m_tex(tex)
 
 inline bool Isotropic::Scatter(const Ray& ray_in,
                                 const HitRecord& rec,
-                                ScatterRecord& srec) const {
-    srec.attenuation = m_tex->Value(rec.u, rec.v, rec.point);
-    srec.pdf_ptr = std::make_shared<SpherePDF>();
+                                ScatterRecord& srec,
+                                RNG& rng) const {
+    (void)ray_in;
+    (void)rng;
+
+    srec.attenuation = m_tex->FilteredValue(rec.u, rec.v, rec.point,
+                                            rec.uv_width);
+    srec.pdf = ScatterPDF(SpherePDF());
     srec.skip_pdf = false;
 
     return true;
@@ -6,6 +6,7 @@
 #include "texture.hpp"
 #include "solid_color.hpp"
 #include "cosine_pdf.hpp"
+#include "scatter_pdf.hpp"
 
 namespace RayTracing {
 
@@ -16,7 +17,8 @@ public:
 
     bool Scatter(const Ray& ray_in,
                 const HitRecord& rec,
-                ScatterRecord& srec) const override;
+                ScatterRecord& srec,
+                RNG& rng) const override;
     double ScatteringPDF(const Ray& r_in,
                         const HitRecord& rec,
                         const Ray& scattered) const override;
@@ -35,9 +37,14 @@ m_tex(tex)
 
 inline bool Lambertian::Scatter(const Ray& ray_in,
                 const HitRecord& rec,
-                ScatterRecord& srec) const {
-    srec.attenuation = m_tex->Value(rec.u, rec.v, rec.point);
-    srec.pdf_ptr = std::make_shared<CosinePDF>(rec.normal);
+                ScatterRecord& srec,
+                RNG& rng) const {
+    (void)ray_in;
+    (void)rng;
+
+    srec.attenuation = m_tex->FilteredValue(rec.u, rec.v, rec.point,
+                                            rec.uv_width);
+    srec.pdf = ScatterPDF(CosinePDF(rec.normal));
     srec.skip_pdf = false;
 
     return true;
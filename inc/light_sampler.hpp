@@ -0,0 +1,119 @@
+#ifndef LIGHT_SAMPLER_HPP
+#define LIGHT_SAMPLER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "hittable.hpp"
+#include "alias_table.hpp"
+
+namespace RayTracing {
+
+// Light shapes for the light PDF of many-light scenes, passed to the
+// camera in place of a HittableList of lights. A light is picked by its
+// emitted power:
+//   POWER - from an alias table, in constant time, the same anywhere.
+//   SPATIAL - by walking down a BVH of the lights, at every node the child
+//             with more power / squared distance to its box is more likely
+//             to be taken, so near lights are sampled more than far ones.
+// PDFValue only asks the lights whose boxes the direction passes through
+// (found in the same BVH) for their PDF and weights them by the
+// probability of picking them: O(1) for POWER, O(log n) for SPATIAL.
+class LightSampler : public Hittable {
+public:
+    enum Strategy : unsigned int {POWER, SPATIAL};
+
+    // One power per light, lights with power 0 are never picked. Without
+    // any power the lights are picked uniformly.
+    LightSampler(const std::vector<std::shared_ptr<Hittable>>& lights,
+                const std::vector<double>& powers,
+                Strategy strategy = Strategy::POWER);
+
+    bool Hit(const Ray& ray,
+            const Interval& ray_t,
+            HitRecord& rec) const override;
+    bool Occluded(const Ray& ray, const Interval& ray_t) const override;
+    AABB BoundingBox() const override;
+    double PDFValue(const Point3& origin, const Vec3& direction) const override;
+    // uc picks the light, what is left of it is passed on.
+    Vec3 Random(const Point3& origin,
+                double uc, double u, double v) const override;
+
+    size_t GetSize() const;
+    Strategy GetStrategy() const;
+    // Probability of picking light `index` (in the order of the
+    // constructor) for a point at origin.
+    double GetProbability(const Point3& origin, size_t index) const;
+
+private:
+    static constexpr size_t STACK_SIZE = 64;
+
+    struct Node {
+        AABB bbox;
+        double power;
+        uint32_t parent;
+        uint32_t offset;        // leaf: first light, interior: second child
+        uint32_t light_count;   // 0 for interior nodes
+    };
+
+    Strategy m_strategy;
+    std::vector<Node> m_nodes;
+    // in BVH leaf order
+    std::vector<std::shared_ptr<Hittable>> m_lights;
+    std::vector<AABB> m_bboxes;
+    std::vector<double> m_powers;
+    std::vector<uint32_t> m_leaves;     // leaf node of every light
+    std::vector<uint32_t> m_order;      // leaf order index of every light
+    AliasTable m_alias_table;
+
+    // Probability of light `light` (leaf order) being picked.
+    double Probability(const Point3& origin, uint32_t light) const;
+    // SPATIAL: probability of an interior node's walk going on to its
+    // first child, and of a leaf's light being picked.
+    double FirstChildProbability(const Point3& origin, uint32_t node) const;
+    double LeafProbability(const Point3& origin, uint32_t light) const;
+    // Visits the lights whose boxes the ray passes through in ray_t,
+    // visit(light, t_max) may shrink t_max and returns true to stop.
+    template <typename Visitor>
+    bool Traverse(const Ray& ray, const Interval& ray_t,
+                Visitor visit) const;
+
+    static double Importance(const Point3& origin, const AABB& bbox,
+                            double power);
+};
+
+inline AABB LightSampler::BoundingBox() const {
+    return (m_nodes.empty() ? AABB::EMPTY : m_nodes[0].bbox);
+}
+
+inline size_t LightSampler::GetSize() const {
+    return m_lights.size();
+}
+
+inline LightSampler::Strategy LightSampler::GetStrategy() const {
+    return m_strategy;
+}
+
+inline double LightSampler::GetProbability(const Point3& origin,
+                                        size_t index) const {
+    return Probability(origin, m_order[index]);
+}
+
+// Power over the squared distance to the box's center, but not more than
+// over its squared half diagonal, for points close to or inside the box.
+inline double LightSampler::Importance(const Point3& origin, const AABB& bbox,
+                                    double power) {
+    Point3 center = bbox.Centroid();
+    Vec3 half_diagonal(0.5 * bbox.AxisInterval(AABB::Axis::X).Size(),
+                    0.5 * bbox.AxisInterval(AABB::Axis::Y).Size(),
+                    0.5 * bbox.AxisInterval(AABB::Axis::Z).Size());
+    double distance_squared = std::max((center - origin).LengthSquared(),
+                                    half_diagonal.LengthSquared());
+
+    return (power / distance_squared);
+}
+
+}
+
+#endif // LIGHT_SAMPLER_HPP
@@ -0,0 +1,108 @@
+#ifndef LINEAR_BVH_HPP
+#define LINEAR_BVH_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "hittable.hpp"
+#include "hittable_list.hpp"
+#include "bvh_builder.hpp"
+#include "simd_vec3.hpp"
+
+namespace RayTracing {
+
+// 32 byte node of a LinearBVH. Bounds are stored as floats rounded outwards,
+// so a node never misses a ray that hits its double precision box.
+struct LinearBVHNode {
+    float bounds_min[3];
+    float bounds_max[3];
+    uint32_t offset;        // leaf: first primitive, interior: second child
+    uint16_t prim_count;    // 0 for interior nodes
+    uint8_t axis;           // split axis of interior nodes
+    uint8_t pad;
+};
+
+// BVH flattened into one contiguous array in depth-first order.
+// Traversal is an iterative stack loop that only calls into the
+// primitives' Hit at the leaves.
+class LinearBVH : public Hittable {
+public:
+    using SplitMethod = BVHBuilder::SplitMethod;
+
+    explicit LinearBVH(HittableList list,
+                    SplitMethod method = SplitMethod::SAH);
+    explicit LinearBVH(const std::vector<std::shared_ptr<Hittable>>& objects,
+                    SplitMethod method = SplitMethod::SAH);
+
+    bool Hit(const Ray& ray, 
+            const Interval& ray_t, 
+            HitRecord& rec) const override;
+    bool Occluded(const Ray& ray, const Interval& ray_t) const override;
+    AABB BoundingBox() const override;
+
+    size_t GetNodeCount() const;
+    // Stats of the binary tree the nodes were built from.
+    const BVHBuildStats& GetBuildStats() const;
+
+    // Nodes of a built tree, and the slab test of a node against a ray
+    // with inverse direction inv_dir. Also used by the BVH of TriangleMesh.
+    static std::vector<LinearBVHNode> MakeNodes(
+                            const std::vector<BVHBuildNode>& build_nodes);
+    static bool HitNode(const LinearBVHNode& node,
+                        const SimdVec3& origin,
+                        const SimdVec3& inv_dir,
+                        double t_min, double t_max);
+
+private:
+    static constexpr size_t STACK_SIZE = 64;
+
+    AABB m_bbox;
+    BVHBuildStats m_build_stats;
+    std::vector<LinearBVHNode> m_nodes;
+    std::vector<std::shared_ptr<Hittable>> m_primitives;
+
+    // Shared traversal loop of Hit (ANY_HIT = false, rec is filled in)
+    // and Occluded (ANY_HIT = true, stops at the first hit).
+    template <bool ANY_HIT>
+    bool Traverse(const Ray& ray, const Interval& ray_t, HitRecord *rec) const;
+};
+
+static_assert(sizeof(LinearBVHNode) == 32, "LinearBVHNode must be 32 bytes");
+
+inline LinearBVH::LinearBVH(HittableList list, SplitMethod method) :
+LinearBVH(list.GetObjects(), method)
+{}
+
+inline AABB LinearBVH::BoundingBox() const {
+    return m_bbox;
+}
+
+inline size_t LinearBVH::GetNodeCount() const {
+    return m_nodes.size();
+}
+
+// Same slab test as AABB::Hit, on the node's float bounds.
+inline bool LinearBVH::HitNode(const LinearBVHNode& node,
+                            const SimdVec3& origin,
+                            const SimdVec3& inv_dir,
+                            double t_min, double t_max) {
+    SimdVec3 box_min(node.bounds_min[0], node.bounds_min[1],
+                    node.bounds_min[2]);
+    SimdVec3 box_max(node.bounds_max[0], node.bounds_max[1],
+                    node.bounds_max[2]);
+
+    SimdVec3 t0 = (box_min - origin) * inv_dir;
+    SimdVec3 t1 = (box_max - origin) * inv_dir;
+    SimdVec3 t_near = Max(Min(t0, t1), SimdVec3::Broadcast(t_min));
+    SimdVec3 t_far = Min(Max(t1, t0), SimdVec3::Broadcast(t_max));
+
+    return (t_near.MaxComponent() < t_far.MinComponent());
+}
+
+inline const BVHBuildStats& LinearBVH::GetBuildStats() const {
+    return m_build_stats;
+}
+
+}
+
+#endif // LINEAR_BVH_HPP
@@ -0,0 +1,68 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace RayTracing {
+
+// Read only view of a whole file. On POSIX systems the file is memory
+// mapped, elsewhere it is read into a buffer.
+class MappedFile {
+public:
+    MappedFile();
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile& operator=(const MappedFile& other) = delete;
+
+    // Returns false without a message if the file can not be opened.
+    bool Open(const std::string& filename);
+    void Close();
+
+    bool IsOpen() const;
+    const char *GetData() const;
+    size_t GetSize() const;
+
+    // Size and modification time of a file, false if it does not exist.
+    static bool Stat(const std::string& filename,
+                    uint64_t& size, int64_t& mtime);
+
+private:
+    const char *m_data;
+    size_t m_size;
+    bool m_mapped;
+    bool m_open;
+    std::vector<char> m_buffer;
+};
+
+inline MappedFile::MappedFile() :
+m_data(nullptr), m_size(0), m_mapped(false), m_open(false)
+{}
+
+inline MappedFile::MappedFile(const std::string& filename) : MappedFile() {
+    Open(filename);
+}
+
+inline MappedFile::~MappedFile() {
+    Close();
+}
+
+inline bool MappedFile::IsOpen() const {
+    return m_open;
+}
+
+inline const char *MappedFile::GetData() const {
+    return m_data;
+}
+
+inline size_t MappedFile::GetSize() const {
+    return m_size;
+}
+
+}
+
+#endif // MAPPED_FILE_HPP
@@ -5,6 +5,7 @@
 #include "ray.hpp"
 #include "color.hpp"
 #include "pdf.hpp"
+#include "scatter_pdf.hpp"
 
 namespace RayTracing {
 
@@ -13,7 +14,7 @@ struct HitRecord;
 struct ScatterRecord {
     Color attenuation;
     Ray skip_pdf_ray;
-    std::shared_ptr<PDF> pdf_ptr;
+    ScatterPDF pdf;         // unused when skip_pdf is set
     bool skip_pdf;
 };
 
@@ -23,7 +24,8 @@ public:
 
     virtual bool Scatter(const Ray& ray_in,
                         const HitRecord& rec,
-                        ScatterRecord& srec) const;
+                        ScatterRecord& srec,
+                        RNG& rng) const;
     virtual Color Emitted(const Ray& r_in, 
                         const HitRecord& rec, 
                         double u, double v, 
@@ -38,10 +40,12 @@ inline Material::~Material() {}
 
 inline bool Material::Scatter(const Ray& ray_in,
                         const HitRecord& rec,
-                        ScatterRecord& srec) const {
+                        ScatterRecord& srec,
+                        RNG& rng) const {
     (void)ray_in;
     (void)rec;
     (void)srec;
+    (void)rng;
     
     return false;
 }
@@ -0,0 +1,47 @@
+#ifndef MESH_LOADER_HPP
+#define MESH_LOADER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "triangle_mesh.hpp"
+
+namespace RayTracing {
+
+// Reads Wavefront OBJ and PLY (binary of either byte order, or ascii)
+// meshes into MeshData. Files are memory mapped and parsed in place
+// without iostreams, polygons are triangulated as fans.
+// Parsed meshes are saved next to the file in a binary cache (the file
+// name plus CACHE_EXTENSION) holding the MeshData buffers as they are in
+// memory, which later loads read with a single copy per buffer. A cache
+// is used while the size and modification time of the file match the
+// ones it was written for.
+class MeshLoader {
+public:
+    static constexpr const char *CACHE_EXTENSION = ".rtmesh";
+
+    // Mesh of an .obj or .ply file (by extension), through the cache if
+    // use_cache is set. Reports errors, data is left empty on failure.
+    static bool Load(const std::string& filename, MeshData& data,
+                    bool use_cache = true);
+
+    static bool ParseOBJ(const char *text, size_t size, MeshData& data);
+    static bool ParsePLY(const char *file, size_t size, MeshData& data);
+
+    // Host endian dump of data, tagged with the size and modification
+    // time of the file it was parsed from.
+    static bool SaveCache(const std::string& filename, const MeshData& data,
+                        uint64_t source_size, int64_t source_mtime);
+    // Returns false without a message if the cache is missing or was
+    // written for another version of the file.
+    static bool LoadCache(const std::string& filename, MeshData& data,
+                        uint64_t source_size, int64_t source_mtime);
+
+private:
+    static constexpr char MAGIC[8] = {'R', 'T', 'M', 'E', 'S', 'H', '0', '1'};
+};
+
+}
+
+#endif // MESH_LOADER_HPP
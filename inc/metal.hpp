@@ -12,7 +12,8 @@ public:
 
     bool Scatter(const Ray& ray_in,
             const HitRecord& rec,
-            ScatterRecord& srec) const override;
+            ScatterRecord& srec,
+            RNG& rng) const override;
 
 private:
     Color m_albedo;
@@ -25,13 +26,13 @@ m_albedo(albedo), m_fuzz((fuzz < 1.0) ? fuzz : 1.0)
 
 inline bool Metal::Scatter(const Ray& ray_in,
             const HitRecord& rec,
-            ScatterRecord& srec) const {
+            ScatterRecord& srec,
+            RNG& rng) const {
     Vec3 reflected = Reflect(ray_in.GetDirection(), rec.normal);
     
-    reflected = UnitVector(reflected) + (m_fuzz * RandomUnitVector());
+    reflected = UnitVector(reflected) + (m_fuzz * RandomUnitVector(rng));
     
     srec.attenuation = m_albedo;
-    srec.pdf_ptr = nullptr;
     srec.skip_pdf = true;
     srec.skip_pdf_ray = Ray(rec.point, reflected, ray_in.GetTime());
 
@@ -0,0 +1,68 @@
+#ifndef MIPMAP_HPP
+#define MIPMAP_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "color.hpp"
+
+namespace RayTracing {
+
+// Image pyramid of an RGB float image: level 0 is the image, every next
+// level halves its width and height (rounded up) down to 1 x 1 by
+// averaging blocks of 2 x 2 texels. Rows go top to bottom, v = 1 is the
+// top of the image. Lookups clamp to the border.
+class MipMap {
+public:
+    MipMap() = default;
+    // rgb holds width * height texels of 3 floats.
+    MipMap(const float *rgb, size_t width, size_t height);
+
+    bool IsEmpty() const;
+    size_t GetLevelCount() const;
+    size_t GetWidth(size_t level) const;
+    size_t GetHeight(size_t level) const;
+
+    // Bilinear filtered value of level at (u, v).
+    Color Bilinear(size_t level, double u, double v) const;
+    // Blend of the bilinear values of the two levels whose texel size is
+    // closest to uv_width, the footprint of the lookup in uv units (see
+    // HitRecord::uv_width). uv_width <= 0 looks up level 0.
+    Color Trilinear(double u, double v, double uv_width) const;
+
+private:
+    struct Level {
+        size_t width;
+        size_t height;
+        std::vector<float> texels;   // 3 floats per texel
+    };
+
+    std::vector<Level> m_levels;
+
+    static Level Downsample(const Level& level);
+    static const float *Texel(const Level& level, size_t x, size_t y);
+};
+
+inline bool MipMap::IsEmpty() const {
+    return m_levels.empty();
+}
+
+inline size_t MipMap::GetLevelCount() const {
+    return m_levels.size();
+}
+
+inline size_t MipMap::GetWidth(size_t level) const {
+    return m_levels[level].width;
+}
+
+inline size_t MipMap::GetHeight(size_t level) const {
+    return m_levels[level].height;
+}
+
+inline const float *MipMap::Texel(const Level& level, size_t x, size_t y) {
+    return &level.texels[3 * (y * level.width + x)];
+}
+
+}
+
+#endif // MIPMAP_HPP
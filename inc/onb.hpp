@@ -3,6 +3,7 @@
 #define ONB_HPP
 
 #include "vec3.hpp"
+#include "simd_vec3.hpp"
 
 namespace RayTracing {
 
@@ -44,9 +45,9 @@ inline Vec3 ONB::W() const {
 
 // Transform from basis coordinates to local space.
 inline Vec3 ONB::Transform(const Vec3& v) const {
-    return ((v.GetX() * m_axis[0]) +
-            (v.GetY() * m_axis[1]) +
-            (v.GetZ() * m_axis[2]));
+    return ((v.GetX() * SimdVec3(m_axis[0])) +
+            (v.GetY() * SimdVec3(m_axis[1])) +
+            (v.GetZ() * SimdVec3(m_axis[2]))).ToVec3();
 }
 
 }
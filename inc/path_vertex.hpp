@@ -0,0 +1,194 @@
+#ifndef PATH_VERTEX_HPP
+#define PATH_VERTEX_HPP
+
+#include <cmath>
+#include <cstdint>
+
+#include "hittable.hpp"
+#include "material.hpp"
+#include "sampler.hpp"
+#include "rng.hpp"
+
+namespace RayTracing {
+
+// What the shading of a path vertex needs to know about how the path got
+// there: the pdfs of the direction of the last bounce under BSDF and under
+// light sampling. Camera rays and specular bounces are only found by their
+// own direction, they start with {1, 0}.
+// The path also carries a ray cone (Akenine-Moller et al., "Texture Level
+// of Detail Strategies for Real-Time Ray Tracing"): its width at the last
+// vertex, 0 at a pinhole, and its spread angle, one pixel's angle for
+// camera rays. Textures are filtered over the cone's footprint.
+struct PathState {
+    double bsdf_pdf;
+    double light_pdf;
+    double cone_width;
+    double cone_spread;
+};
+
+// Smallest cosine between ray and normal used to widen a footprint, grazing
+// hits would otherwise look up a single texel of the coarsest level.
+constexpr double CONE_MIN_COSINE = 0.05;
+
+// Light sample of a path vertex (next event estimation). The caller traces
+// it with TraceShadowRay: whatever the ray sees, an emitter, a surface
+// that does not emit or the background, is added to the radiance times
+// weight.
+struct ShadowRay {
+    Ray ray;
+    Vec3 weight;
+};
+
+// Power heuristic (beta = 2) weight of a sample drawn with pdf `pdf`
+// that the other strategy draws with pdf `other_pdf`.
+inline double PowerHeuristic(double pdf, double other_pdf) {
+    double pdf_squared = pdf * pdf;
+    double sum = pdf_squared + other_pdf * other_pdf;
+
+    return ((sum > 0.0) ? (pdf_squared / sum) : 0.0);
+}
+
+// Shades the hit rec of a path at bounce depth. Sets rec.uv_width from the
+// path's ray cone, then adds the emission of the
+// hit to radiance, weighted by throughput and by the multiple importance
+// sampling weight of the last bounce's direction (see state). Materials
+// with a pdf then get two samples of the light they receive:
+// - a light sample toward lights, returned in shadow for the caller to
+//   trace;
+// - a BSDF sample that the path goes on with, in next_ray.
+// Both are weighted with the power heuristic. Specular materials only
+// continue the path. throughput is updated and state is set for the next
+// vertex. Paths past roulette_depth are randomly terminated based on their
+// throughput. Returns false when the path ends, has_shadow tells whether
+// shadow was set either way.
+// Camera::RayColor and the WavefrontIntegrator both shade with this, so
+// they consume the same sample dimensions and produce the same image.
+inline bool ShadePathVertex(const Ray& ray,
+                            HitRecord& rec,
+                            const Hittable& lights,
+                            uint32_t depth,
+                            uint32_t roulette_depth,
+                            SampleSequence& sequence,
+                            RNG& rng,
+                            Vec3& radiance,
+                            Vec3& throughput,
+                            PathState& state,
+                            Ray& next_ray,
+                            ShadowRay& shadow,
+                            bool& has_shadow) {
+    ScatterRecord srec;
+    // The cone keeps the camera's spread at every bounce, surface
+    // curvature is not accounted for. Its footprint is an ellipse, cone_width
+    // by cone_width / cosine, filtered as the circle of the same area.
+    Vec3 direction = ray.GetDirection();
+    double cone_width = state.cone_width + 
+                        state.cone_spread * rec.t * direction.Length();
+    double cosine = std::fabs(Dot(UnitVector(direction), rec.normal));
+
+    rec.uv_width = cone_width * rec.uv_density /
+                    std::sqrt(std::fmax(cosine, CONE_MIN_COSINE));
+    state.cone_width = cone_width;
+
+    Color color_from_emission = rec.mat->Emitted(ray, rec,
+                                                rec.u, rec.v, rec.point);
+    double emission_weight = PowerHeuristic(state.bsdf_pdf, state.light_pdf);
+    radiance += emission_weight * throughput *
+                static_cast<Vec3>(color_from_emission);
+    has_shadow = false;
+
+    if (!rec.mat->Scatter(ray, rec, srec, rng)) {
+        return false;
+    }
+
+    if (srec.skip_pdf) {
+        throughput = throughput * static_cast<Vec3>(srec.attenuation);
+        next_ray = srec.skip_pdf_ray;
+        state.bsdf_pdf = 1.0;
+        state.light_pdf = 0.0;
+    }
+    else {
+        Vec3 attenuation = static_cast<Vec3>(srec.attenuation);
+        double uc = sequence.Next1D();
+        double u = 0.0;
+        double v = 0.0;
+        sequence.Next2D(u, v);
+
+        Ray to_light(rec.point, lights.Random(rec.point, uc, u, v),
+                    ray.GetTime());
+        double light_pdf = lights.PDFValue(rec.point,
+                                        to_light.GetDirection());
+
+        if (light_pdf > 0.0) {
+            double scattering_pdf = rec.mat->ScatteringPDF(ray, rec, to_light);
+            double bsdf_pdf = srec.pdf.Value(to_light.GetDirection());
+
+            if (scattering_pdf > 0.0) {
+                shadow.ray = to_light;
+                shadow.weight = throughput * attenuation *
+                                (scattering_pdf *
+                                PowerHeuristic(light_pdf, bsdf_pdf) /
+                                light_pdf);
+                has_shadow = true;
+            }
+        }
+
+        uc = sequence.Next1D();
+        sequence.Next2D(u, v);
+
+        Ray scattered = Ray(rec.point, srec.pdf.Generate(uc, u, v),
+                            ray.GetTime());
+        double pdf_value = srec.pdf.Value(scattered.GetDirection());
+
+        if (pdf_value <= 0.0) {
+            return false;
+        }
+
+        double scattering_pdf = rec.mat->ScatteringPDF(ray, rec, scattered);
+
+        throughput = throughput * attenuation * scattering_pdf / pdf_value;
+        next_ray = scattered;
+        state.bsdf_pdf = pdf_value;
+        state.light_pdf = lights.PDFValue(rec.point, scattered.GetDirection());
+    }
+
+    // Russian roulette: continue with a probability that follows the
+    // throughput and divide the survivors by it, which keeps the
+    // estimate unbiased while dark paths end early.
+    if (depth + 1 >= roulette_depth) {
+        double continue_probability =
+                        std::fmin(Color(throughput).Luminance(), 1.0);
+
+        if (sequence.Next1D() >= continue_probability) {
+            return false;
+        }
+
+        throughput = throughput / continue_probability;
+    }
+
+    return true;
+}
+
+// Adds what the shadow ray of a path vertex sees: the emission of the
+// surface it hits, nothing for surfaces that only scatter (occluders, and
+// media scattering before the light), or the background. Media draw their
+// distances from the thread's generator.
+inline void TraceShadowRay(const Hittable& world,
+                        const Color& background,
+                        const ShadowRay& shadow,
+                        Vec3& radiance) {
+    HitRecord rec;
+
+    // Interval min = 0.001 - Fixing shadow acne
+    if (!world.Hit(shadow.ray, Interval(0.001, INF), rec)) {
+        radiance += shadow.weight * static_cast<Vec3>(background);
+
+        return;
+    }
+
+    Color emitted = rec.mat->Emitted(shadow.ray, rec, rec.u, rec.v, rec.point);
+    radiance += shadow.weight * static_cast<Vec3>(emitted);
+}
+
+}
+
+#endif // PATH_VERTEX_HPP
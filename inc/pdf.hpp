@@ -11,7 +11,10 @@ public:
     virtual ~PDF();
 
     virtual double Value(const Vec3& direction) const =0;
-    virtual Vec3 Generate() const =0;
+    // Maps uniform samples in [0, 1) to a direction: uc picks between 
+    // discrete choices (the PDFs of a mixture, the objects of a list), 
+    // u and v place the direction.
+    virtual Vec3 Generate(double uc, double u, double v) const =0;
 
 };
 
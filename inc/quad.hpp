@@ -4,6 +4,7 @@
 
 #include "hittable.hpp"
 #include "hittable_list.hpp"
+#include "simd_vec3.hpp"
 
 namespace RayTracing {
 
@@ -20,8 +21,10 @@ public:
     bool Hit(const Ray& ray,
             const Interval& ray_t,
             HitRecord& rec) const override;
+    bool Occluded(const Ray& ray, const Interval& ray_t) const override;
     double PDFValue(const Point3& origin, const Vec3& direction) const override;
-    Vec3 Random(const Point3& origin) const override;
+    Vec3 Random(const Point3& origin, 
+                double uc, double u, double v) const override;
 
     virtual bool IsInterior(double a, double b) const; 
 
@@ -36,6 +39,10 @@ private:
     double m_area;
     std::shared_ptr<Material> m_mat;
 
+    bool Intersect(const Ray& ray,
+                const Interval& ray_t,
+                double& t, double& alpha, double& beta) const;
+
     static Vec3 CalcPlaneNormal(const Vec3& u, const Vec3& v);
     static double CalcPlaneD(const Vec3& normal, const Point3& p);
     static Vec3 CalcW(const Vec3& u, const Vec3& v);
@@ -69,51 +76,83 @@ inline AABB Quad::BoundingBox() const {
 inline bool Quad::Hit(const Ray& ray,
             const Interval& ray_t,
             HitRecord& rec) const {
-    double denom = Dot(m_normal, ray.GetDirection());
+    double t = 0.0;
+    double alpha = 0.0;
+    double beta = 0.0;
 
-    if (std::fabs(denom) < 1e-8) {
+    if (!Intersect(ray, ray_t, t, alpha, beta)) {
         return false;
     }
 
-    double t = (m_D - Dot(m_normal, ray.GetOrigin())) / denom;
-    if (!ray_t.Contains(t)) {
+    rec.t = t;
+    rec.point = ray.At(t);
+    rec.mat = m_mat.get();
+    rec.SetFaceNormal(ray, m_normal);
+    rec.u = alpha;
+    rec.v = beta;
+    // the plane coordinates span the whole area once
+    rec.uv_density = 1.0 / std::sqrt(m_area);
+
+    return true;
+}
+
+inline bool Quad::Occluded(const Ray& ray, const Interval& ray_t) const {
+    double t = 0.0;
+    double alpha = 0.0;
+    double beta = 0.0;
+
+    return Intersect(ray, ray_t, t, alpha, beta);
+}
+
+// Ray / plane distance t and the plane coordinates alpha, beta of the hit point.
+inline bool Quad::Intersect(const Ray& ray,
+                        const Interval& ray_t,
+                        double& t, double& alpha, double& beta) const {
+    SimdVec3 normal(m_normal);
+    SimdVec3 origin(ray.GetOrigin());
+    SimdVec3 direction(ray.GetDirection());
+    double denom = Dot(normal, direction);
+
+    if (std::fabs(denom) < 1e-8) {
         return false;
     }
 
-    // Determine the hit point lies within the planar shape using its plane coordinates.
-    Point3 intersection = ray.At(t);
-    Vec3 planar_hitpt_vector = intersection - m_Q;
-    double alpha = Dot(m_w, Cross(planar_hitpt_vector, m_v));
-    double beta = Dot(m_w, Cross(m_u, planar_hitpt_vector));
-
-    if (!IsInterior(alpha, beta)) {
+    t = (m_D - Dot(normal, origin)) / denom;
+    if (!ray_t.Contains(t)) {
         return false;
     }
 
-    rec.t = t;
-    rec.point = intersection;
-    rec.mat = m_mat;
-    rec.SetFaceNormal(ray, m_normal);
-    rec.u = alpha;
-    rec.v = beta;
+    // Determine the hit point lies within the planar shape using its plane coordinates.
+    SimdVec3 intersection = origin + static_cast<Real>(t) * direction;
+    SimdVec3 planar_hitpt_vector = intersection - SimdVec3(m_Q);
+    SimdVec3 w(m_w);
+    alpha = Dot(w, Cross(planar_hitpt_vector, SimdVec3(m_v)));
+    beta = Dot(w, Cross(SimdVec3(m_u), planar_hitpt_vector));
 
-    return true;
+    return IsInterior(alpha, beta);
 }
 
 inline double Quad::PDFValue(const Point3& origin, const Vec3& direction) const {
-    HitRecord rec;
-    if (!this->Hit(Ray(origin, direction), Interval(0.001, INF), rec)) {
+    double t = 0.0;
+    double alpha = 0.0;
+    double beta = 0.0;
+
+    if (!Intersect(Ray(origin, direction), Interval(0.001, INF), 
+                t, alpha, beta)) {
         return 0.0;
     }
 
-    double distance_squared = rec.t * rec.t * direction.LengthSquared();
-    double cosine = std::fabs(Dot(direction, rec.normal) / direction.Length());
+    double distance_squared = t * t * direction.LengthSquared();
+    double cosine = std::fabs(Dot(direction, m_normal) / direction.Length());
 
     return (distance_squared / (cosine * m_area));
 }
 
-inline Vec3 Quad::Random(const Point3& origin) const {
-    Point3 p = m_Q + (RandomDouble() * m_u) + (RandomDouble() * m_v);
+inline Vec3 Quad::Random(const Point3& origin, 
+                        double uc, double u, double v) const {
+    (void)uc;
+
+    Point3 p = m_Q + (u * m_u) + (v * m_v);
 
     return (p - origin);
 }
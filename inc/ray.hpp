@@ -10,18 +10,18 @@ class Ray {
 public:
     Ray();
     Ray(const Point3& origin, const Vec3& direction);
-    Ray(const Point3& origin, const Vec3& direction, double time);
+    Ray(const Point3& origin, const Vec3& direction, Real time);
 
     Point3 GetOrigin() const;
     Vec3 GetDirection() const;
-    double GetTime() const;
+    Real GetTime() const;
 
     Point3 At(double t) const;
 
 private:
     Point3 m_origin;
     Vec3 m_direction;
-    double m_time;
+    Real m_time;
 };
 
 inline Ray::Ray(): m_origin(), m_direction()
@@ -31,7 +31,7 @@ inline Ray::Ray(const Point3& origin, const Vec3& direction):
 m_origin(origin), m_direction(direction), m_time(0.0)
 {}
 
-inline Ray::Ray(const Point3& origin, const Vec3& direction, double time) :
+inline Ray::Ray(const Point3& origin, const Vec3& direction, Real time) :
 m_origin(origin), m_direction(direction), m_time(time)
 {}
 
@@ -43,7 +43,7 @@ inline Vec3 Ray::GetDirection() const {
     return m_direction;
 }
 
-inline double Ray::GetTime() const {
+inline Real Ray::GetTime() const {
     return m_time;
 }
 
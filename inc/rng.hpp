@@ -0,0 +1,116 @@
+#ifndef RNG_HPP
+#define RNG_HPP
+
+#include <cstdint>
+
+namespace RayTracing {
+
+// PCG32 random number generator (O'Neill, pcg-random.org).
+// 16 bytes of state, cheap to seed, so every pixel sample can start its
+// own stream and renders do not depend on which thread took the sample.
+class RNG {
+public:
+    RNG();
+    explicit RNG(uint64_t seed);
+    RNG(uint64_t seed, uint64_t stream);
+
+    void Seed(uint64_t seed);
+    void Seed(uint64_t seed, uint64_t stream);
+
+    uint32_t NextUInt32();
+    // uniform in [0, 1)
+    double NextDouble();
+
+    // Returns an independent generator seeded from this one.
+    RNG Split();
+
+    // Well mixed 64 bit hash of the given values, used to derive seeds
+    // from (pixel, sample, frame) indices.
+    static uint64_t Hash(uint64_t a, uint64_t b = 0, uint64_t c = 0);
+
+private:
+    uint64_t m_state;
+    uint64_t m_inc;
+
+    static uint64_t MixBits(uint64_t v);
+};
+
+inline RNG::RNG() : RNG(0x853c49e6748fea9bULL, 0xda3e39cb94b95bdbULL)
+{}
+
+inline RNG::RNG(uint64_t seed) : m_state(0), m_inc(1) {
+    Seed(seed);
+}
+
+inline RNG::RNG(uint64_t seed, uint64_t stream) : m_state(0), m_inc(1) {
+    Seed(seed, stream);
+}
+
+inline void RNG::Seed(uint64_t seed) {
+    Seed(seed, MixBits(seed));
+}
+
+inline void RNG::Seed(uint64_t seed, uint64_t stream) {
+    m_state = 0;
+    m_inc = (stream << 1) | 1;
+    NextUInt32();
+    m_state += seed;
+    NextUInt32();
+}
+
+inline uint32_t RNG::NextUInt32() {
+    uint64_t old_state = m_state;
+    m_state = old_state * 6364136223846793005ULL + m_inc;
+
+    uint32_t xor_shifted = static_cast<uint32_t>(
+                            ((old_state >> 18) ^ old_state) >> 27);
+    uint32_t rot = static_cast<uint32_t>(old_state >> 59);
+
+    return ((xor_shifted >> rot) | (xor_shifted << ((~rot + 1) & 31)));
+}
+
+inline double RNG::NextDouble() {
+    // 2^-32, largest result is (2^32 - 1) / 2^32 < 1
+    constexpr double scale = 2.3283064365386963e-10;
+
+    return (NextUInt32() * scale);
+}
+
+inline RNG RNG::Split() {
+    uint64_t seed = (static_cast<uint64_t>(NextUInt32()) << 32) | NextUInt32();
+    uint64_t stream = (static_cast<uint64_t>(NextUInt32()) << 32) | NextUInt32();
+
+    return RNG(seed, stream);
+}
+
+inline uint64_t RNG::Hash(uint64_t a, uint64_t b, uint64_t c) {
+    uint64_t h = MixBits(a + 0x9e3779b97f4a7c15ULL);
+    h = MixBits(h ^ (b + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2)));
+    h = MixBits(h ^ (c + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2)));
+
+    return h;
+}
+
+// splitmix64 finalizer
+inline uint64_t RNG::MixBits(uint64_t v) {
+    v ^= (v >> 31);
+    v *= 0x7fb5d329728ea185ULL;
+    v ^= (v >> 27);
+    v *= 0x81dadef4bc2dd44dULL;
+    v ^= (v >> 33);
+
+    return v;
+}
+
+// Generator of the calling thread. The camera reseeds it at the start of
+// every pixel sample, code that has no generator passed in (e.g. volume
+// boundaries inside Hittable::Hit) draws from it.
+inline RNG& ThreadRNG() {
+    thread_local RNG rng;
+
+    return rng;
+}
+
+}
+
+#endif // RNG_HPP
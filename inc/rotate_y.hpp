@@ -14,6 +14,7 @@ public:
     bool Hit(const Ray& ray,
             const Interval& ray_t,
             HitRecord& rec) const override;
+    bool Occluded(const Ray& ray, const Interval& ray_t) const override;
     AABB BoundingBox() const override;
 
 private:
@@ -22,6 +23,8 @@ private:
     double m_sin_theta;
     double m_cos_theta;
 
+    Ray ToObjectSpace(const Ray& ray) const;
+
     static double CalcSinTheta(double angle);
     static double CalcCosTheta(double angle);
 
@@ -66,20 +69,7 @@ m_cos_theta(CalcCosTheta(angle))
 inline bool RotateY::Hit(const Ray& ray,
             const Interval& ray_t,
             HitRecord& rec) const {
-    Point3 origin = ray.GetOrigin();
-    Vec3 direction = ray.GetDirection();
-
-    origin[Vec3::Cord::X] = m_cos_theta * ray.GetOrigin().GetX() - 
-                            m_sin_theta * ray.GetOrigin().GetZ();
-    origin[Vec3::Cord::Z] = m_sin_theta * ray.GetOrigin().GetX() + 
-                            m_cos_theta * ray.GetOrigin().GetZ();
-    
-    direction[Vec3::Cord::X] = m_cos_theta * ray.GetDirection().GetX() - 
-                            m_sin_theta * ray.GetDirection().GetZ();
-    direction[Vec3::Cord::Z] = m_sin_theta * ray.GetDirection().GetX() + 
-                            m_cos_theta * ray.GetDirection().GetZ();
-
-    Ray rotated_r(origin, direction, ray.GetTime());
+    Ray rotated_r = ToObjectSpace(ray);
 
     if (!m_object->Hit(rotated_r, ray_t, rec)) {
         return false;
@@ -103,6 +93,27 @@ inline bool RotateY::Hit(const Ray& ray,
     return true;
 }
 
+inline bool RotateY::Occluded(const Ray& ray, const Interval& ray_t) const {
+    return m_object->Occluded(ToObjectSpace(ray), ray_t);
+}
+
+inline Ray RotateY::ToObjectSpace(const Ray& ray) const {
+    Point3 origin = ray.GetOrigin();
+    Vec3 direction = ray.GetDirection();
+
+    origin[Vec3::Cord::X] = m_cos_theta * ray.GetOrigin().GetX() - 
+                            m_sin_theta * ray.GetOrigin().GetZ();
+    origin[Vec3::Cord::Z] = m_sin_theta * ray.GetOrigin().GetX() + 
+                            m_cos_theta * ray.GetOrigin().GetZ();
+    
+    direction[Vec3::Cord::X] = m_cos_theta * ray.GetDirection().GetX() - 
+                            m_sin_theta * ray.GetDirection().GetZ();
+    direction[Vec3::Cord::Z] = m_sin_theta * ray.GetDirection().GetX() + 
+                            m_cos_theta * ray.GetDirection().GetZ();
+
+    return Ray(origin, direction, ray.GetTime());
+}
+
 inline AABB RotateY::BoundingBox() const {
     return m_bbox;
 }
@@ -0,0 +1,122 @@
+#ifndef SAMPLER_HPP
+#define SAMPLER_HPP
+
+#include <cstdint>
+
+#include "rng.hpp"
+
+namespace RayTracing {
+
+// One sample of one pixel. seed separates frames of an animation.
+struct PixelSample {
+    uint32_t x;
+    uint32_t y;
+    uint32_t index;
+    uint32_t seed;
+};
+
+// Source of the uniform numbers of a pixel sample. Every number is a pure
+// function of (pixel sample, dimension), so samplers are shared by all 
+// render threads, and a pixel's samples are well distributed in every
+// dimension on their own as well as in the consecutive pairs requested
+// with Get2D.
+class Sampler {
+public:
+    virtual ~Sampler() = default;
+
+    // uniform in [0, 1)
+    virtual double Get1D(const PixelSample& sample, 
+                        uint32_t dimension) const =0;
+    // Dimensions dimension and dimension + 1, stratified as a pair.
+    virtual void Get2D(const PixelSample& sample, 
+                        uint32_t dimension,
+                        double& u, double& v) const =0;
+
+    // [0, 1) double of the high 32 bits of a fixed point fraction.
+    static double ToUnit(uint32_t bits);
+};
+
+// Independent uniform numbers (white noise), hashed from the sample and
+// dimension.
+class IndependentSampler : public Sampler {
+public:
+    double Get1D(const PixelSample& sample, 
+                uint32_t dimension) const override;
+    void Get2D(const PixelSample& sample, 
+                uint32_t dimension,
+                double& u, double& v) const override;
+};
+
+// Hands out the dimensions of one pixel sample in order.
+class SampleSequence {
+public:
+    SampleSequence(const Sampler& sampler, const PixelSample& sample);
+    // Continues a sequence at the given dimension.
+    SampleSequence(const Sampler& sampler, const PixelSample& sample,
+                uint32_t dimension);
+
+    double Next1D();
+    void Next2D(double& u, double& v);
+
+    const PixelSample& GetSample() const;
+    // Next dimension drawn.
+    uint32_t GetDimension() const;
+
+private:
+    const Sampler& m_sampler;
+    PixelSample m_sample;
+    uint32_t m_dimension;
+};
+
+inline double Sampler::ToUnit(uint32_t bits) {
+    return (bits * (1.0 / 4294967296.0));
+}
+
+inline double IndependentSampler::Get1D(const PixelSample& sample, 
+                                        uint32_t dimension) const {
+    uint64_t pixel = (static_cast<uint64_t>(sample.y) << 32) | sample.x;
+    uint64_t h = RNG::Hash(pixel, 
+                        (static_cast<uint64_t>(sample.seed) << 32) | sample.index,
+                        dimension);
+
+    return ToUnit(static_cast<uint32_t>(h >> 32));
+}
+
+inline void IndependentSampler::Get2D(const PixelSample& sample, 
+                                    uint32_t dimension,
+                                    double& u, double& v) const {
+    u = Get1D(sample, dimension);
+    v = Get1D(sample, dimension + 1);
+}
+
+inline SampleSequence::SampleSequence(const Sampler& sampler, 
+                                    const PixelSample& sample) :
+m_sampler(sampler), m_sample(sample), m_dimension(0)
+{}
+
+inline SampleSequence::SampleSequence(const Sampler& sampler, 
+                                    const PixelSample& sample,
+                                    uint32_t dimension) :
+m_sampler(sampler), m_sample(sample), m_dimension(dimension)
+{}
+
+inline double SampleSequence::Next1D() {
+    return m_sampler.Get1D(m_sample, m_dimension++);
+}
+
+inline void SampleSequence::Next2D(double& u, double& v) {
+    m_sampler.Get2D(m_sample, m_dimension, u, v);
+    m_dimension += 2;
+}
+
+inline const PixelSample& SampleSequence::GetSample() const {
+    return m_sample;
+}
+
+inline uint32_t SampleSequence::GetDimension() const {
+    return m_dimension;
+}
+
+}
+
+#endif // SAMPLER_HPP
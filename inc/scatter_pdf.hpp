@@ -0,0 +1,62 @@
+#ifndef SCATTER_PDF_HPP
+#define SCATTER_PDF_HPP
+
+#include "pdf.hpp"
+#include "cosine_pdf.hpp"
+#include "sphere_pdf.hpp"
+
+namespace RayTracing {
+
+// PDF of a material's scattered direction, held by value in the
+// ScatterRecord so shading never allocates. Materials only need a cosine
+// lobe around the normal or the uniform sphere.
+class ScatterPDF : public PDF {
+public:
+    enum Type : unsigned int {COSINE, SPHERE};
+
+    ScatterPDF();
+    explicit ScatterPDF(const CosinePDF& cosine_pdf);
+    explicit ScatterPDF(const SpherePDF& sphere_pdf);
+
+    double Value(const Vec3& direction) const override;
+    Vec3 Generate(double uc, double u, double v) const override;
+
+    Type GetType() const;
+
+private:
+    Type m_type;
+    CosinePDF m_cosine_pdf;     // only valid for COSINE
+    SpherePDF m_sphere_pdf;
+};
+
+inline ScatterPDF::ScatterPDF() : ScatterPDF(SpherePDF())
+{}
+
+inline ScatterPDF::ScatterPDF(const CosinePDF& cosine_pdf) :
+m_type(Type::COSINE), m_cosine_pdf(cosine_pdf)
+{}
+
+inline ScatterPDF::ScatterPDF(const SpherePDF& sphere_pdf) :
+m_type(Type::SPHERE), m_cosine_pdf(Vec3(0.0, 0.0, 1.0)),
+m_sphere_pdf(sphere_pdf)
+{}
+
+inline double ScatterPDF::Value(const Vec3& direction) const {
+    return ((m_type == Type::COSINE) ?
+            m_cosine_pdf.CosinePDF::Value(direction) :
+            m_sphere_pdf.SpherePDF::Value(direction));
+}
+
+inline Vec3 ScatterPDF::Generate(double uc, double u, double v) const {
+    return ((m_type == Type::COSINE) ?
+            m_cosine_pdf.CosinePDF::Generate(uc, u, v) :
+            m_sphere_pdf.SpherePDF::Generate(uc, u, v));
+}
+
+inline ScatterPDF::Type ScatterPDF::GetType() const {
+    return m_type;
+}
+
+}
+
+#endif // SCATTER_PDF_HPP
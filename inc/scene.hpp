@@ -0,0 +1,82 @@
+#ifndef SCENE_HPP
+#define SCENE_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "scene_description.hpp"
+#include "hittable_list.hpp"
+#include "material.hpp"
+#include "texture.hpp"
+#include "camera.hpp"
+#include "transform.hpp"
+#include "light_sampler.hpp"
+
+namespace RayTracing {
+
+// Objects of a scene description: the world, the shapes lights are
+// sampled from and the camera. Every texture, material and object record
+// is built once and shared by everything using it. Objects and worlds of
+// at least BVH_MIN_OBJECTS shapes are put in a WideBVH, as many instances
+// in an InstanceBVH and as many plain spheres in a SphereSet.
+class Scene {
+public:
+    static constexpr size_t BVH_MIN_OBJECTS = 16;
+
+    // Relative mesh files are looked up in base_dir, the directory of the
+    // scene file. Reports meshes that can not be loaded, the scene is
+    // not valid then.
+    Scene(const SceneDescription& desc, const std::string& base_dir);
+
+    bool IsValid() const;
+    const HittableList& GetWorld() const;
+    // The light shapes in a LightSampler, weighted by the power of their
+    // emissive material.
+    const Hittable& GetLights() const;
+    // Camera with the view and render settings of the description.
+    Camera CreateCamera() const;
+
+private:
+    const SceneDescription& m_desc;
+    std::string m_base_dir;
+    bool m_valid;
+    std::vector<std::shared_ptr<Texture>> m_textures;
+    std::vector<std::shared_ptr<Material>> m_materials;
+    std::vector<std::shared_ptr<Hittable>> m_objects;
+    HittableList m_world;
+    std::shared_ptr<LightSampler> m_lights;
+
+    std::shared_ptr<Texture> BuildTexture(const SceneTexture& texture) const;
+    std::shared_ptr<Material> BuildMaterial(const SceneMaterial& material) const;
+    // nullptr if a mesh can not be loaded
+    std::shared_ptr<Hittable> BuildShape(const SceneShape& shape) const;
+    // Emissive material's luminance times the area of a light shape, 0
+    // for lights without one.
+    double LightPower(const SceneShape& shape) const;
+    // Stationary, untransformed spheres that are neither lights nor
+    // media, which a SphereSet can hold.
+    static bool IsPlainSphere(const SceneShape& shape);
+    // scale, then rotate_y, then translate
+    static Transform ShapeTransform(const SceneShape& shape);
+    // The shapes as one object, in a BVH if there are enough of them.
+    static std::shared_ptr<Hittable> Group(
+                const std::vector<std::shared_ptr<Hittable>>& shapes);
+};
+
+inline bool Scene::IsValid() const {
+    return m_valid;
+}
+
+inline const HittableList& Scene::GetWorld() const {
+    return m_world;
+}
+
+inline const Hittable& Scene::GetLights() const {
+    return *m_lights;
+}
+
+}
+
+#endif // SCENE_HPP
@@ -0,0 +1,144 @@
+#ifndef SCENE_DESCRIPTION_HPP
+#define SCENE_DESCRIPTION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace RayTracing {
+
+// Index of a record that is not there (no texture, no object, ...).
+constexpr uint32_t SCENE_NONE = UINT32_MAX;
+
+// Records of a scene description. They are plain data referring to each
+// other and to SceneDescription::strings by index, so a compiled scene is
+// the records as they are in memory.
+
+struct SceneCamera {
+    // how lights are picked, see LightSampler
+    enum LightSampling : uint32_t {POWER, BVH};
+    // where the numbers of the pixel samples come from, see Sampler
+    enum SamplerType : uint32_t {SOBOL, BLUE_NOISE, INDEPENDENT};
+
+    double aspect_ratio;
+    double vfov;
+    double defocus_angle;
+    double focus_dist;
+    double look_from[3];
+    double look_at[3];
+    double vup[3];
+    double background[3];
+    double adaptive_max_error;      // 0 - not adaptive
+    uint32_t image_width;
+    uint32_t samples_per_pixel;
+    uint32_t max_depth;
+    uint32_t roulette_depth;
+    uint32_t pass_samples;          // 0 - not progressive
+    uint32_t adaptive_min_samples;
+    uint32_t checkpoint_file;       // strings, SCENE_NONE - not written
+    uint32_t sample_map_file;
+    uint32_t light_sampling;
+    uint32_t sampler;
+};
+
+struct SceneTexture {
+    enum Type : uint32_t {SOLID, CHECKER, IMAGE, NOISE};
+
+    uint32_t type;
+    uint32_t even;                  // CHECKER textures, SCENE_NONE - color
+    uint32_t odd;                   // CHECKER textures, SCENE_NONE - color2
+    uint32_t file;                  // IMAGE, in strings
+    double scale;                   // CHECKER and NOISE
+    double color[3];                // SOLID, CHECKER even
+    double color2[3];               // CHECKER odd
+};
+
+struct SceneMaterial {
+    enum Type : uint32_t {LAMBERTIAN, METAL, DIELECTRIC, DIFFUSE_LIGHT,
+                        ISOTROPIC};
+
+    uint32_t type;
+    uint32_t texture;               // SCENE_NONE - color
+    double color[3];
+    double fuzz;                    // METAL
+    double refraction_index;        // DIELECTRIC
+};
+
+struct SceneShape {
+    enum Type : uint32_t {SPHERE, QUAD, TRIANGLE, DISK, BOX, MESH, INSTANCE};
+    enum Flags : uint32_t {LIGHT = 1, MOVING = 2, MEDIUM = 4};
+
+    uint32_t type;
+    uint32_t flags;
+    uint32_t material;              // SCENE_NONE for lights and media
+    uint32_t object;                // object it belongs to, SCENE_NONE - world
+    uint32_t target;                // MESH: file in strings, INSTANCE: object
+    uint32_t albedo_texture;        // MEDIUM, SCENE_NONE - albedo
+    double a[3];                    // center, Q or min
+    double b[3];                    // center2 (MOVING), u or max
+    double c[3];                    // v
+    double radius;
+    double scale[3];                // applied first
+    double rotate_y;                // degrees, applied before translate
+    double translate[3];
+    double density;                 // MEDIUM
+    double albedo[3];               // MEDIUM
+};
+
+// Everything a scene file says, ready to be built into objects by Scene.
+// Textures and materials that are defined the same way under different
+// names are stored once.
+struct SceneDescription {
+    SceneCamera camera;
+    std::vector<SceneTexture> textures;
+    std::vector<SceneMaterial> materials;
+    std::vector<SceneShape> shapes;
+    std::vector<uint32_t> objects;  // names in strings
+    std::vector<char> strings;      // null terminated
+
+    SceneDescription();
+
+    const char *GetString(uint32_t offset) const;
+    uint32_t AddString(const std::string& str);
+};
+
+// Reads scene descriptions from the text format or its compiled form.
+//
+// The text format has one statement per line, '#' starts a comment:
+//   camera look_from=x,y,z look_at=x,y,z vfov=40 width=600 spp=100 ...
+//   texture <name> solid|checker|image|noise key=value...
+//   material <name> lambertian|metal|dielectric|diffuse_light|isotropic ...
+//   sphere|quad|triangle|disk|box|mesh|instance key=value...
+//   light sphere|quad|triangle|disk ... (light sampling shapes)
+//   object <name> ... end (shapes that instances place)
+// The keys of every statement are listed in README.md.
+// The compiled form is the records as they are in memory after a MAGIC
+// and the record counts and sizes. It is only read by builds with the same
+// record layout.
+class SceneLoader {
+public:
+    static constexpr const char *COMPILED_EXTENSION = ".rtscene";
+
+    // Loads either form, a compiled scene is recognized by its MAGIC.
+    // Reports errors.
+    static bool Load(const std::string& filename, SceneDescription& desc);
+
+    static bool Parse(const char *text, size_t size, SceneDescription& desc);
+
+    static bool SaveCompiled(const std::string& filename,
+                            const SceneDescription& desc);
+    static bool LoadCompiled(const char *data, size_t size,
+                            SceneDescription& desc);
+
+private:
+    static constexpr char MAGIC[8] = {'R', 'T', 'S', 'C', 'E', 'N', 'E', '1'};
+};
+
+inline const char *SceneDescription::GetString(uint32_t offset) const {
+    return ((offset < strings.size()) ? &strings[offset] : "");
+}
+
+}
+
+#endif // SCENE_DESCRIPTION_HPP
@@ -0,0 +1,559 @@
+#ifndef SIMD_VEC3_HPP
+#define SIMD_VEC3_HPP
+
+#include <algorithm>
+#include <cmath>
+
+#include "vec3.hpp"
+
+// Backend of SimdVec3, picked from the instruction sets the compiler
+// targets. RT_NO_SIMD forces the scalar one. Doubles use two SSE2
+// registers unless RT_SIMD_AVX2 asks for one AVX2 register: assembling
+// and reducing the 256 bit register costs more than it saves on three
+// components (sphere hits measured 8% slower than with SSE2).
+#if defined(RT_NO_SIMD)
+#define SIMD_VEC3_SCALAR
+#elif defined(RT_SINGLE_PRECISION) && defined(__SSE2__)
+#define SIMD_VEC3_SSE_FLOAT
+#include <immintrin.h>
+#elif defined(RT_SINGLE_PRECISION) && defined(__ARM_NEON)
+#define SIMD_VEC3_NEON_FLOAT
+#include <arm_neon.h>
+#elif defined(RT_SIMD_AVX2) && defined(__AVX2__)
+#define SIMD_VEC3_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#define SIMD_VEC3_SSE2
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define SIMD_VEC3_NEON
+#include <arm_neon.h>
+#else
+#define SIMD_VEC3_SCALAR
+#endif
+
+namespace RayTracing {
+
+// Vec3 of Real in a 4 lane SIMD register (or two 2 lane ones), the
+// fourth lane is unused. For the hot geometry kernels: values are loaded
+// from Vec3s, computed on and read back. Dot sums (x + y) + z and all
+// other operations are per lane, so results equal those of Vec3 bit for
+// bit. Registers are over-aligned, keep SimdVec3s in locals and Vec3s
+// in objects that live on the heap.
+class SimdVec3 {
+public:
+    SimdVec3();
+    SimdVec3(Real x, Real y, Real z);
+    explicit SimdVec3(const Vec3& v);
+
+    static SimdVec3 Broadcast(Real s);
+
+    Real GetX() const;
+    Real GetY() const;
+    Real GetZ() const;
+    Vec3 ToVec3() const;
+
+    // Largest / smallest of x, y, z, for values without NaNs.
+    Real MaxComponent() const;
+    Real MinComponent() const;
+
+    friend SimdVec3 operator+(const SimdVec3& a, const SimdVec3& b);
+    friend SimdVec3 operator-(const SimdVec3& a, const SimdVec3& b);
+    friend SimdVec3 operator*(const SimdVec3& a, const SimdVec3& b);
+    friend SimdVec3 operator/(const SimdVec3& a, const SimdVec3& b);
+    // (a < b) ? a : b and (a > b) ? a : b per lane, like the SSE
+    // instructions: a NaN in a gives b.
+    friend SimdVec3 Min(const SimdVec3& a, const SimdVec3& b);
+    friend SimdVec3 Max(const SimdVec3& a, const SimdVec3& b);
+    friend Real Dot(const SimdVec3& a, const SimdVec3& b);
+    friend SimdVec3 Cross(const SimdVec3& a, const SimdVec3& b);
+
+private:
+#if defined(SIMD_VEC3_SSE_FLOAT)
+    __m128 m_v;
+
+    explicit SimdVec3(__m128 v);
+#elif defined(SIMD_VEC3_NEON_FLOAT)
+    float32x4_t m_v;
+
+    explicit SimdVec3(float32x4_t v);
+#elif defined(SIMD_VEC3_AVX2)
+    __m256d m_v;
+
+    explicit SimdVec3(__m256d v);
+#elif defined(SIMD_VEC3_SSE2)
+    __m128d m_xy;
+    __m128d m_zw;
+
+    SimdVec3(__m128d xy, __m128d zw);
+#elif defined(SIMD_VEC3_NEON)
+    float64x2_t m_xy;
+    float64x2_t m_zw;
+
+    SimdVec3(float64x2_t xy, float64x2_t zw);
+#else
+    Real m_e[4];
+#endif
+};
+
+inline SimdVec3::SimdVec3(const Vec3& v) :
+SimdVec3(v.GetX(), v.GetY(), v.GetZ())
+{}
+
+inline Vec3 SimdVec3::ToVec3() const {
+    return Vec3(GetX(), GetY(), GetZ());
+}
+
+inline Real SimdVec3::MaxComponent() const {
+    return std::max(std::max(GetX(), GetY()), GetZ());
+}
+
+inline Real SimdVec3::MinComponent() const {
+    return std::min(std::min(GetX(), GetY()), GetZ());
+}
+
+inline SimdVec3 operator*(Real s, const SimdVec3& v) {
+    return (SimdVec3::Broadcast(s) * v);
+}
+
+inline SimdVec3 UnitVector(const SimdVec3& v) {
+    return (SimdVec3::Broadcast(1 / std::sqrt(Dot(v, v))) * v);
+}
+
+#if defined(SIMD_VEC3_SSE_FLOAT)
+
+inline SimdVec3::SimdVec3() : m_v(_mm_setzero_ps()) {}
+
+inline SimdVec3::SimdVec3(__m128 v) : m_v(v) {}
+
+inline SimdVec3::SimdVec3(Real x, Real y, Real z) :
+m_v(_mm_set_ps(0.0f, z, y, x))
+{}
+
+inline SimdVec3 SimdVec3::Broadcast(Real s) {
+    return SimdVec3(_mm_set1_ps(s));
+}
+
+inline Real SimdVec3::GetX() const {
+    return _mm_cvtss_f32(m_v);
+}
+
+inline Real SimdVec3::GetY() const {
+    return _mm_cvtss_f32(_mm_shuffle_ps(m_v, m_v, _MM_SHUFFLE(1, 1, 1, 1)));
+}
+
+inline Real SimdVec3::GetZ() const {
+    return _mm_cvtss_f32(_mm_movehl_ps(m_v, m_v));
+}
+
+inline SimdVec3 operator+(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(_mm_add_ps(a.m_v, b.m_v));
+}
+
+inline SimdVec3 operator-(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(_mm_sub_ps(a.m_v, b.m_v));
+}
+
+inline SimdVec3 operator*(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(_mm_mul_ps(a.m_v, b.m_v));
+}
+
+inline SimdVec3 operator/(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(_mm_div_ps(a.m_v, b.m_v));
+}
+
+inline SimdVec3 Min(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(_mm_min_ps(a.m_v, b.m_v));
+}
+
+inline SimdVec3 Max(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(_mm_max_ps(a.m_v, b.m_v));
+}
+
+inline Real Dot(const SimdVec3& a, const SimdVec3& b) {
+    __m128 m = _mm_mul_ps(a.m_v, b.m_v);
+    __m128 sum = _mm_add_ss(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1)));
+
+    return _mm_cvtss_f32(_mm_add_ss(sum, _mm_movehl_ps(m, m)));
+}
+
+inline SimdVec3 Cross(const SimdVec3& a, const SimdVec3& b) {
+    __m128 a_yzx = _mm_shuffle_ps(a.m_v, a.m_v, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 a_zxy = _mm_shuffle_ps(a.m_v, a.m_v, _MM_SHUFFLE(3, 1, 0, 2));
+    __m128 b_yzx = _mm_shuffle_ps(b.m_v, b.m_v, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 b_zxy = _mm_shuffle_ps(b.m_v, b.m_v, _MM_SHUFFLE(3, 1, 0, 2));
+
+    return SimdVec3(_mm_sub_ps(_mm_mul_ps(a_yzx, b_zxy),
+                            _mm_mul_ps(a_zxy, b_yzx)));
+}
+
+#elif defined(SIMD_VEC3_NEON_FLOAT)
+
+inline SimdVec3::SimdVec3() : m_v(vdupq_n_f32(0.0f)) {}
+
+inline SimdVec3::SimdVec3(float32x4_t v) : m_v(v) {}
+
+inline SimdVec3::SimdVec3(Real x, Real y, Real z) : m_v(vdupq_n_f32(0.0f)) {
+    m_v = vsetq_lane_f32(x, m_v, 0);
+    m_v = vsetq_lane_f32(y, m_v, 1);
+    m_v = vsetq_lane_f32(z, m_v, 2);
+}
+
+inline SimdVec3 SimdVec3::Broadcast(Real s) {
+    return SimdVec3(vdupq_n_f32(s));
+}
+
+inline Real SimdVec3::GetX() const {
+    return vgetq_lane_f32(m_v, 0);
+}
+
+inline Real SimdVec3::GetY() const {
+    return vgetq_lane_f32(m_v, 1);
+}
+
+inline Real SimdVec3::GetZ() const {
+    return vgetq_lane_f32(m_v, 2);
+}
+
+inline SimdVec3 operator+(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(vaddq_f32(a.m_v, b.m_v));
+}
+
+inline SimdVec3 operator-(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(vsubq_f32(a.m_v, b.m_v));
+}
+
+inline SimdVec3 operator*(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(vmulq_f32(a.m_v, b.m_v));
+}
+
+inline SimdVec3 operator/(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(vdivq_f32(a.m_v, b.m_v));
+}
+
+// vminq / vmaxq return NaN for NaN inputs, selects keep the SSE rule
+inline SimdVec3 Min(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(vbslq_f32(vcltq_f32(a.m_v, b.m_v), a.m_v, b.m_v));
+}
+
+inline SimdVec3 Max(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(vbslq_f32(vcgtq_f32(a.m_v, b.m_v), a.m_v, b.m_v));
+}
+
+inline Real Dot(const SimdVec3& a, const SimdVec3& b) {
+    float32x4_t m = vmulq_f32(a.m_v, b.m_v);
+
+    return ((vgetq_lane_f32(m, 0) + vgetq_lane_f32(m, 1)) +
+            vgetq_lane_f32(m, 2));
+}
+
+// The fourth lane of the rotated vectors is not kept, it is unused.
+inline SimdVec3 Cross(const SimdVec3& a, const SimdVec3& b) {
+    float32x4_t a_yzx = vsetq_lane_f32(vgetq_lane_f32(a.m_v, 0),
+                                    vextq_f32(a.m_v, a.m_v, 1), 2);
+    float32x4_t a_zxy = vsetq_lane_f32(vgetq_lane_f32(a.m_v, 2),
+                                    vextq_f32(a.m_v, a.m_v, 3), 0);
+    float32x4_t b_yzx = vsetq_lane_f32(vgetq_lane_f32(b.m_v, 0),
+                                    vextq_f32(b.m_v, b.m_v, 1), 2);
+    float32x4_t b_zxy = vsetq_lane_f32(vgetq_lane_f32(b.m_v, 2),
+                                    vextq_f32(b.m_v, b.m_v, 3), 0);
+
+    return SimdVec3(vsubq_f32(vmulq_f32(a_yzx, b_zxy),
+                            vmulq_f32(a_zxy, b_yzx)));
+}
+
+#elif defined(SIMD_VEC3_AVX2)
+
+inline SimdVec3::SimdVec3() : m_v(_mm256_setzero_pd()) {}
+
+inline SimdVec3::SimdVec3(__m256d v) : m_v(v) {}
+
+inline SimdVec3::SimdVec3(Real x, Real y, Real z) :
+m_v(_mm256_set_pd(0.0, z, y, x))
+{}
+
+inline SimdVec3 SimdVec3::Broadcast(Real s) {
+    return SimdVec3(_mm256_set1_pd(s));
+}
+
+inline Real SimdVec3::GetX() const {
+    return _mm256_cvtsd_f64(m_v);
+}
+
+inline Real SimdVec3::GetY() const {
+    __m128d xy = _mm256_castpd256_pd128(m_v);
+
+    return _mm_cvtsd_f64(_mm_unpackhi_pd(xy, xy));
+}
+
+inline Real SimdVec3::GetZ() const {
+    return _mm_cvtsd_f64(_mm256_extractf128_pd(m_v, 1));
+}
+
+inline SimdVec3 operator+(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(_mm256_add_pd(a.m_v, b.m_v));
+}
+
+inline SimdVec3 operator-(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(_mm256_sub_pd(a.m_v, b.m_v));
+}
+
+inline SimdVec3 operator*(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(_mm256_mul_pd(a.m_v, b.m_v));
+}
+
+inline SimdVec3 operator/(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(_mm256_div_pd(a.m_v, b.m_v));
+}
+
+inline SimdVec3 Min(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(_mm256_min_pd(a.m_v, b.m_v));
+}
+
+inline SimdVec3 Max(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(_mm256_max_pd(a.m_v, b.m_v));
+}
+
+inline Real Dot(const SimdVec3& a, const SimdVec3& b) {
+    __m256d m = _mm256_mul_pd(a.m_v, b.m_v);
+    __m128d xy = _mm256_castpd256_pd128(m);
+    __m128d sum = _mm_add_sd(xy, _mm_unpackhi_pd(xy, xy));
+
+    return _mm_cvtsd_f64(_mm_add_sd(sum, _mm256_extractf128_pd(m, 1)));
+}
+
+inline SimdVec3 Cross(const SimdVec3& a, const SimdVec3& b) {
+    __m256d a_yzx = _mm256_permute4x64_pd(a.m_v, _MM_SHUFFLE(3, 0, 2, 1));
+    __m256d a_zxy = _mm256_permute4x64_pd(a.m_v, _MM_SHUFFLE(3, 1, 0, 2));
+    __m256d b_yzx = _mm256_permute4x64_pd(b.m_v, _MM_SHUFFLE(3, 0, 2, 1));
+    __m256d b_zxy = _mm256_permute4x64_pd(b.m_v, _MM_SHUFFLE(3, 1, 0, 2));
+
+    return SimdVec3(_mm256_sub_pd(_mm256_mul_pd(a_yzx, b_zxy),
+                                _mm256_mul_pd(a_zxy, b_yzx)));
+}
+
+#elif defined(SIMD_VEC3_SSE2)
+
+inline SimdVec3::SimdVec3() : m_xy(_mm_setzero_pd()), m_zw(_mm_setzero_pd())
+{}
+
+inline SimdVec3::SimdVec3(__m128d xy, __m128d zw) : m_xy(xy), m_zw(zw) {}
+
+inline SimdVec3::SimdVec3(Real x, Real y, Real z) :
+m_xy(_mm_set_pd(y, x)), m_zw(_mm_set_sd(z))
+{}
+
+inline SimdVec3 SimdVec3::Broadcast(Real s) {
+    __m128d v = _mm_set1_pd(s);
+
+    return SimdVec3(v, v);
+}
+
+inline Real SimdVec3::GetX() const {
+    return _mm_cvtsd_f64(m_xy);
+}
+
+inline Real SimdVec3::GetY() const {
+    return _mm_cvtsd_f64(_mm_unpackhi_pd(m_xy, m_xy));
+}
+
+inline Real SimdVec3::GetZ() const {
+    return _mm_cvtsd_f64(m_zw);
+}
+
+inline SimdVec3 operator+(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(_mm_add_pd(a.m_xy, b.m_xy), _mm_add_pd(a.m_zw, b.m_zw));
+}
+
+inline SimdVec3 operator-(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(_mm_sub_pd(a.m_xy, b.m_xy), _mm_sub_pd(a.m_zw, b.m_zw));
+}
+
+inline SimdVec3 operator*(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(_mm_mul_pd(a.m_xy, b.m_xy), _mm_mul_pd(a.m_zw, b.m_zw));
+}
+
+inline SimdVec3 operator/(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(_mm_div_pd(a.m_xy, b.m_xy), _mm_div_pd(a.m_zw, b.m_zw));
+}
+
+inline SimdVec3 Min(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(_mm_min_pd(a.m_xy, b.m_xy), _mm_min_pd(a.m_zw, b.m_zw));
+}
+
+inline SimdVec3 Max(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(_mm_max_pd(a.m_xy, b.m_xy), _mm_max_pd(a.m_zw, b.m_zw));
+}
+
+inline Real Dot(const SimdVec3& a, const SimdVec3& b) {
+    __m128d xy = _mm_mul_pd(a.m_xy, b.m_xy);
+    __m128d sum = _mm_add_sd(xy, _mm_unpackhi_pd(xy, xy));
+
+    return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_mul_sd(a.m_zw, b.m_zw)));
+}
+
+// Rotations across the two registers: yz|xw and zx|yw.
+inline SimdVec3 Cross(const SimdVec3& a, const SimdVec3& b) {
+    __m128d a_yz = _mm_shuffle_pd(a.m_xy, a.m_zw, 1);
+    __m128d a_xw = _mm_move_sd(a.m_zw, a.m_xy);
+    __m128d a_zx = _mm_unpacklo_pd(a.m_zw, a.m_xy);
+    __m128d a_yw = _mm_shuffle_pd(a.m_xy, a.m_zw, 3);
+    __m128d b_yz = _mm_shuffle_pd(b.m_xy, b.m_zw, 1);
+    __m128d b_xw = _mm_move_sd(b.m_zw, b.m_xy);
+    __m128d b_zx = _mm_unpacklo_pd(b.m_zw, b.m_xy);
+    __m128d b_yw = _mm_shuffle_pd(b.m_xy, b.m_zw, 3);
+
+    return SimdVec3(_mm_sub_pd(_mm_mul_pd(a_yz, b_zx), _mm_mul_pd(a_zx, b_yz)),
+                    _mm_sub_pd(_mm_mul_pd(a_xw, b_yw), _mm_mul_pd(a_yw, b_xw)));
+}
+
+#elif defined(SIMD_VEC3_NEON)
+
+inline SimdVec3::SimdVec3() : m_xy(vdupq_n_f64(0.0)), m_zw(vdupq_n_f64(0.0))
+{}
+
+inline SimdVec3::SimdVec3(float64x2_t xy, float64x2_t zw) :
+m_xy(xy), m_zw(zw)
+{}
+
+inline SimdVec3::SimdVec3(Real x, Real y, Real z) :
+m_xy(vsetq_lane_f64(y, vdupq_n_f64(x), 1)),
+m_zw(vsetq_lane_f64(z, vdupq_n_f64(0.0), 0))
+{}
+
+inline SimdVec3 SimdVec3::Broadcast(Real s) {
+    float64x2_t v = vdupq_n_f64(s);
+
+    return SimdVec3(v, v);
+}
+
+inline Real SimdVec3::GetX() const {
+    return vgetq_lane_f64(m_xy, 0);
+}
+
+inline Real SimdVec3::GetY() const {
+    return vgetq_lane_f64(m_xy, 1);
+}
+
+inline Real SimdVec3::GetZ() const {
+    return vgetq_lane_f64(m_zw, 0);
+}
+
+inline SimdVec3 operator+(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(vaddq_f64(a.m_xy, b.m_xy), vaddq_f64(a.m_zw, b.m_zw));
+}
+
+inline SimdVec3 operator-(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(vsubq_f64(a.m_xy, b.m_xy), vsubq_f64(a.m_zw, b.m_zw));
+}
+
+inline SimdVec3 operator*(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(vmulq_f64(a.m_xy, b.m_xy), vmulq_f64(a.m_zw, b.m_zw));
+}
+
+inline SimdVec3 operator/(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(vdivq_f64(a.m_xy, b.m_xy), vdivq_f64(a.m_zw, b.m_zw));
+}
+
+// vminq / vmaxq return NaN for NaN inputs, selects keep the SSE rule
+inline SimdVec3 Min(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(vbslq_f64(vcltq_f64(a.m_xy, b.m_xy), a.m_xy, b.m_xy),
+                    vbslq_f64(vcltq_f64(a.m_zw, b.m_zw), a.m_zw, b.m_zw));
+}
+
+inline SimdVec3 Max(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(vbslq_f64(vcgtq_f64(a.m_xy, b.m_xy), a.m_xy, b.m_xy),
+                    vbslq_f64(vcgtq_f64(a.m_zw, b.m_zw), a.m_zw, b.m_zw));
+}
+
+inline Real Dot(const SimdVec3& a, const SimdVec3& b) {
+    float64x2_t xy = vmulq_f64(a.m_xy, b.m_xy);
+
+    return ((vgetq_lane_f64(xy, 0) + vgetq_lane_f64(xy, 1)) +
+            vgetq_lane_f64(a.m_zw, 0) * vgetq_lane_f64(b.m_zw, 0));
+}
+
+// Rotations across the two registers: yz|xw and zx|yw.
+inline SimdVec3 Cross(const SimdVec3& a, const SimdVec3& b) {
+    float64x2_t a_yz = vextq_f64(a.m_xy, a.m_zw, 1);
+    float64x2_t a_xw = vsetq_lane_f64(vgetq_lane_f64(a.m_xy, 0), a.m_zw, 0);
+    float64x2_t a_zx = vzip1q_f64(a.m_zw, a.m_xy);
+    float64x2_t a_yw = vzip2q_f64(a.m_xy, a.m_zw);
+    float64x2_t b_yz = vextq_f64(b.m_xy, b.m_zw, 1);
+    float64x2_t b_xw = vsetq_lane_f64(vgetq_lane_f64(b.m_xy, 0), b.m_zw, 0);
+    float64x2_t b_zx = vzip1q_f64(b.m_zw, b.m_xy);
+    float64x2_t b_yw = vzip2q_f64(b.m_xy, b.m_zw);
+
+    return SimdVec3(vsubq_f64(vmulq_f64(a_yz, b_zx), vmulq_f64(a_zx, b_yz)),
+                    vsubq_f64(vmulq_f64(a_xw, b_yw), vmulq_f64(a_yw, b_xw)));
+}
+
+#else
+
+inline SimdVec3::SimdVec3() : m_e{0, 0, 0, 0} {}
+
+inline SimdVec3::SimdVec3(Real x, Real y, Real z) : m_e{x, y, z, 0} {}
+
+inline SimdVec3 SimdVec3::Broadcast(Real s) {
+    return SimdVec3(s, s, s);
+}
+
+inline Real SimdVec3::GetX() const {
+    return m_e[0];
+}
+
+inline Real SimdVec3::GetY() const {
+    return m_e[1];
+}
+
+inline Real SimdVec3::GetZ() const {
+    return m_e[2];
+}
+
+inline SimdVec3 operator+(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(a.m_e[0] + b.m_e[0], a.m_e[1] + b.m_e[1],
+                    a.m_e[2] + b.m_e[2]);
+}
+
+inline SimdVec3 operator-(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(a.m_e[0] - b.m_e[0], a.m_e[1] - b.m_e[1],
+                    a.m_e[2] - b.m_e[2]);
+}
+
+inline SimdVec3 operator*(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(a.m_e[0] * b.m_e[0], a.m_e[1] * b.m_e[1],
+                    a.m_e[2] * b.m_e[2]);
+}
+
+inline SimdVec3 operator/(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(a.m_e[0] / b.m_e[0], a.m_e[1] / b.m_e[1],
+                    a.m_e[2] / b.m_e[2]);
+}
+
+inline SimdVec3 Min(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3((a.m_e[0] < b.m_e[0]) ? a.m_e[0] : b.m_e[0],
+                    (a.m_e[1] < b.m_e[1]) ? a.m_e[1] : b.m_e[1],
+                    (a.m_e[2] < b.m_e[2]) ? a.m_e[2] : b.m_e[2]);
+}
+
+inline SimdVec3 Max(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3((a.m_e[0] > b.m_e[0]) ? a.m_e[0] : b.m_e[0],
+                    (a.m_e[1] > b.m_e[1]) ? a.m_e[1] : b.m_e[1],
+                    (a.m_e[2] > b.m_e[2]) ? a.m_e[2] : b.m_e[2]);
+}
+
+inline Real Dot(const SimdVec3& a, const SimdVec3& b) {
+    return (a.m_e[0] * b.m_e[0] + a.m_e[1] * b.m_e[1] + a.m_e[2] * b.m_e[2]);
+}
+
+inline SimdVec3 Cross(const SimdVec3& a, const SimdVec3& b) {
+    return SimdVec3(a.m_e[1] * b.m_e[2] - a.m_e[2] * b.m_e[1],
+                    a.m_e[2] * b.m_e[0] - a.m_e[0] * b.m_e[2],
+                    a.m_e[0] * b.m_e[1] - a.m_e[1] * b.m_e[0]);
+}
+
+#endif
+
+}
+
+#endif // SIMD_VEC3_HPP
@@ -0,0 +1,125 @@
+#ifndef SOBOL_SAMPLER_HPP
+#define SOBOL_SAMPLER_HPP
+
+#include <cstdint>
+
+#include "sampler.hpp"
+
+namespace RayTracing {
+
+// Owen scrambled Sobol points, hash based (Burley 2020, "Practical 
+// Hash-based Owen Scrambling"). Every pair of dimensions is made of the
+// first two Sobol dimensions, a (0, 2) sequence. Per (pixel, dimension)
+// hashes shuffle the sample index and scramble the bits of the points, so
+// pairs are decorrelated from each other and from other pixels while every
+// power of two prefix of a pixel's samples stays stratified. Sample counts
+// do not have to be squares (or powers of two).
+class SobolSampler : public Sampler {
+public:
+    double Get1D(const PixelSample& sample, 
+                uint32_t dimension) const override;
+    void Get2D(const PixelSample& sample, 
+                uint32_t dimension,
+                double& u, double& v) const override;
+
+    // Point index of the first one or two Sobol dimensions, with the index
+    // shuffled and the point Owen scrambled by seed.
+    static double ScrambledSobol1D(uint32_t index, uint32_t seed);
+    static void ScrambledSobol2D(uint32_t index, uint32_t seed,
+                                double& u, double& v);
+
+private:
+    // The second dimension is linear over XOR in the index bits, so it is
+    // the XOR of one table entry per index byte. Entries are bit reversed,
+    // which is the order the scrambling works in.
+    struct SecondDimensionTable {
+        uint32_t bytes[4][256];
+
+        SecondDimensionTable();
+    };
+
+    static const SecondDimensionTable SECOND_DIMENSION;
+
+    static uint32_t ReversedSobolSecond(uint32_t index);
+    static uint32_t ReverseBits(uint32_t x);
+    // Random permutation that only flips a bit based on the bits below 
+    // it. On bit reversed fractions that is Owen scrambling: every aligned
+    // block of 2^k values goes to an aligned block.
+    static uint32_t LaineKarrasPermutation(uint32_t x, uint32_t seed);
+    static uint32_t DimensionSeed(const PixelSample& sample, 
+                                uint32_t dimension);
+};
+
+inline double SobolSampler::Get1D(const PixelSample& sample, 
+                                uint32_t dimension) const {
+    return ScrambledSobol1D(sample.index, DimensionSeed(sample, dimension));
+}
+
+inline void SobolSampler::Get2D(const PixelSample& sample, 
+                                uint32_t dimension,
+                                double& u, double& v) const {
+    ScrambledSobol2D(sample.index, DimensionSeed(sample, dimension), u, v);
+}
+
+// The first dimension is the bit reversed index, so the shuffled index 
+// (bit reversed, permuted, reversed back) is scrambled directly.
+inline double SobolSampler::ScrambledSobol1D(uint32_t index, uint32_t seed) {
+    uint32_t shuffled = ReverseBits(LaineKarrasPermutation(ReverseBits(index), 
+                                                        seed));
+
+    return ToUnit(ReverseBits(LaineKarrasPermutation(shuffled, 
+                                                    seed ^ 0x68bc21ebu)));
+}
+
+inline void SobolSampler::ScrambledSobol2D(uint32_t index, uint32_t seed,
+                                        double& u, double& v) {
+    uint32_t shuffled = ReverseBits(LaineKarrasPermutation(ReverseBits(index), 
+                                                        seed));
+
+    u = ToUnit(ReverseBits(LaineKarrasPermutation(shuffled, 
+                                                seed ^ 0x68bc21ebu)));
+    v = ToUnit(ReverseBits(LaineKarrasPermutation(
+                                            ReversedSobolSecond(shuffled), 
+                                            seed ^ 0x02e5be93u)));
+}
+
+inline uint32_t SobolSampler::ReversedSobolSecond(uint32_t index) {
+    return (SECOND_DIMENSION.bytes[0][index & 0xff] ^
+            SECOND_DIMENSION.bytes[1][(index >> 8) & 0xff] ^
+            SECOND_DIMENSION.bytes[2][(index >> 16) & 0xff] ^
+            SECOND_DIMENSION.bytes[3][index >> 24]);
+}
+
+inline uint32_t SobolSampler::ReverseBits(uint32_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    x = __builtin_bswap32(x);
+#else
+    x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+    x = (x >> 16) | (x << 16);
+#endif
+    x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+
+    return (((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1));
+}
+
+inline uint32_t SobolSampler::LaineKarrasPermutation(uint32_t x, uint32_t seed) {
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+
+    return x;
+}
+
+inline uint32_t SobolSampler::DimensionSeed(const PixelSample& sample, 
+                                            uint32_t dimension) {
+    uint64_t pixel = (static_cast<uint64_t>(sample.y) << 32) | sample.x;
+
+    return static_cast<uint32_t>(RNG::Hash(pixel, sample.seed, dimension));
+}
+
+}
+
+#endif // SOBOL_SAMPLER_HPP
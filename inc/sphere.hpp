@@ -23,21 +23,37 @@ public:
     bool Hit(const Ray& ray,
             const Interval& ray_t,
             HitRecord& rec) const override;
+    bool Occluded(const Ray& ray, const Interval& ray_t) const override;
     AABB BoundingBox() const override;
     double PDFValue(const Point3& origin, const Vec3& direction) const override;
-    Vec3 Random(const Point3& origin) const override;
+    Vec3 Random(const Point3& origin, 
+                double uc, double u, double v) const override;
+
+    // Nearest root of the ray / sphere equation inside ray_t, and the
+    // texture coordinates of a point on the unit sphere. SphereSet
+    // intersects its spheres with the same two.
+    static bool HitRoot(const Ray& ray, 
+                        const Interval& ray_t, 
+                        const Point3& center, 
+                        double radius,
+                        double& root);
+    static std::pair<double, double> GetSphereUV(const Point3& p);
+    // uv area 1 over the surface area 4 * pi * radius^2, see
+    // HitRecord::uv_density.
+    static double UVDensity(double radius);
 
 private:
     AABB m_bbox;
-    Point3 m_center;
-    Vec3 m_center_vec;
+    // stored as floats, the box is computed from the stored center
+    Vec3f m_center;
+    Vec3f m_center_vec;
     std::shared_ptr<Material> m_mat;
     double m_radius;
     bool m_is_moving;
 
     Point3 SphereCenter(double time) const;
-    static std::pair<double, double> GetSphereUV(const Point3& p);
-    static Vec3 RandomToSphere(double radius, double distance_squared);
+    static Vec3 RandomToSphere(double radius, double distance_squared,
+                                double r1, double r2);
 
 };
 
@@ -47,8 +63,9 @@ inline Sphere::Sphere(const Point3& center,
 m_center(center), m_center_vec(), m_mat(mat), 
 m_radius(std::fmax(0.0, radius)), m_is_moving(false) 
 {
+    Point3 stored_center(m_center);
     Vec3 rvec = Vec3(m_radius, m_radius, m_radius);
-    m_bbox = AABB(m_center - rvec, m_center + rvec);
+    m_bbox = AABB(stored_center - rvec, stored_center + rvec);
 }
 
 inline Sphere::Sphere(const Point3& center1, const Point3& center2, 
@@ -57,8 +74,10 @@ m_center(center1), m_center_vec(center2 - center1), m_mat(mat),
 m_radius(std::fmax(0.0, radius)), m_is_moving(true)
 {
     Vec3 rvec = Vec3(m_radius, m_radius, m_radius);
-    AABB box1(center1 - rvec, center1 + rvec);
-    AABB box2(center2 - rvec, center2 + rvec);
+    Point3 start = SphereCenter(0.0);
+    Point3 end = SphereCenter(1.0);
+    AABB box1(start - rvec, start + rvec);
+    AABB box2(end - rvec, end + rvec);
     m_bbox = AABB(box1, box2);
 }
 
@@ -70,24 +89,27 @@ inline double Sphere::PDFValue(const Point3& origin,
                             const Vec3& direction) const {
     // this method only works for stationary spheres
 
-    HitRecord rec;
-    if (!this->Hit(Ray(origin, direction), Interval(0.001, INF), rec)) {
+    if (!Occluded(Ray(origin, direction), Interval(0.001, INF))) {
         return 0.0;
     }
 
+    double distance_squared = (Point3(m_center) - origin).LengthSquared();
     double cos_theta_max = std::sqrt(1 - m_radius * m_radius / 
-                                    ((m_center - origin).LengthSquared()));
+                                    distance_squared);
     double solid_angle = 2 * PI * (1 - cos_theta_max);
 
     return (1 / solid_angle);
 }
 
-inline Vec3 Sphere::Random(const Point3& origin) const {
-    Vec3 direction = m_center - origin;
+inline Vec3 Sphere::Random(const Point3& origin, 
+                        double uc, double u, double v) const {
+    (void)uc;
+
+    Vec3 direction = Point3(m_center) - origin;
     double distance_squared = direction.LengthSquared();
     ONB uvw(direction);
 
-    return uvw.Transform(RandomToSphere(m_radius, distance_squared));
+    return uvw.Transform(RandomToSphere(m_radius, distance_squared, u, v));
 }
 
 inline std::pair<double, double> Sphere::GetSphereUV(const Point3& p) {
@@ -107,9 +129,12 @@ inline std::pair<double, double> Sphere::GetSphereUV(const Point3& p) {
     return std::pair<double, double>(u, v);
 }
 
-inline Vec3 Sphere::RandomToSphere(double radius, double distance_squared) {
-    double r1 = RandomDouble();
-    double r2 = RandomDouble();
+inline double Sphere::UVDensity(double radius) {
+    return (0.5 / (std::sqrt(PI) * radius));
+}
+
+inline Vec3 Sphere::RandomToSphere(double radius, double distance_squared,
+                                    double r1, double r2) {
     double z = 1 + r2 * (std::sqrt(1 - radius * radius / distance_squared) - 1);
 
     double phi = 2 * PI * r1;
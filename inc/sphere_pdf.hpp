@@ -11,7 +11,7 @@ public:
     SpherePDF();
 
     double Value(const Vec3& direction) const override;
-    Vec3 Generate() const override;
+    Vec3 Generate(double uc, double u, double v) const override;
 
 };
 
@@ -22,8 +22,10 @@ inline double SpherePDF::Value(const Vec3& direction) const {
     return (1 / (4 * PI));
 }
 
-inline Vec3 SpherePDF::Generate() const {
-    return RandomUnitVector();
+inline Vec3 SpherePDF::Generate(double uc, double u, double v) const {
+    (void)uc;
+
+    return RandomUnitVector(u, v);
 }
 
 }
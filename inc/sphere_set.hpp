@@ -0,0 +1,135 @@
+#ifndef SPHERE_SET_HPP
+#define SPHERE_SET_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "hittable.hpp"
+#include "bvh_builder.hpp"
+#include "wide_bvh.hpp"
+
+namespace RayTracing {
+
+constexpr size_t SPHERE_BLOCK_SIZE = 8;
+
+// Spheres of one SphereSet leaf as structure of arrays, so one SIMD
+// register holds the same value of several spheres. Unused slots have a
+// zero center and radius.
+struct SphereBlock {
+    float center[3][SPHERE_BLOCK_SIZE];
+    float radius[SPHERE_BLOCK_SIZE];
+    uint32_t material[SPHERE_BLOCK_SIZE];   // index into the set's materials
+};
+
+// Ray data shared by all block tests of one traversal.
+struct SphereSetRay {
+    float origin[3];
+    float direction[3];
+    float origin_l1;        // |x| + |y| + |z| of the origin
+    float inv_a;            // 1 / |direction|^2
+    float inv_sqrt_a;       // 1 / |direction|
+    float t_min;
+};
+
+// Many stationary spheres as one object, for particle-like scenes.
+// Centers, radii and material ids are kept in blocks of up to
+// SPHERE_BLOCK_SIZE spheres, one block per leaf of a wide BVH of the set's
+// own (see WideBVH), which costs about 20 bytes per sphere instead of a
+// Sphere object, its shared_ptr and a share of the scene's BVH.
+// A leaf is tested against the ray in single precision, all its spheres
+// at once with AVX2 (8 lanes), SSE (2 x 4 lanes) or a scalar loop. That
+// test only culls, with a margin for its rounding errors: the spheres it
+// keeps are intersected with Sphere::HitRoot in double precision, so a set
+// finds the same hits as Sphere objects with float radii would.
+class SphereSet : public Hittable {
+public:
+    using SplitMethod = BVHBuilder::SplitMethod;
+
+    // One center, radius and material per sphere. isa is lowered to what
+    // the CPU supports.
+    SphereSet(const std::vector<Point3>& centers,
+            const std::vector<double>& radii,
+            const std::vector<std::shared_ptr<Material>>& materials,
+            SplitMethod method = SplitMethod::SAH,
+            WideBVH::ISA isa = WideBVH::DetectISA());
+
+    bool Hit(const Ray& ray,
+            const Interval& ray_t,
+            HitRecord& rec) const override;
+    bool Occluded(const Ray& ray, const Interval& ray_t) const override;
+    AABB BoundingBox() const override;
+
+    WideBVH::ISA GetISA() const;
+    size_t GetSize() const;
+    size_t GetNodeCount() const;
+    // Stats of the binary tree before small subtrees became leaves.
+    const BVHBuildStats& GetBuildStats() const;
+
+private:
+    // Wide trees are never deeper than the binary tree they come from.
+    static constexpr size_t MAX_DEPTH = 64;
+
+    // Returns a bit mask of the spheres of block that the ray may hit
+    // in [ray.t_min, t_max].
+    using CullFunc = uint32_t (*)(const SphereBlock& block,
+                                uint32_t count,
+                                const SphereSetRay& ray,
+                                float t_max);
+
+    WideBVH::ISA m_isa;
+    AABB m_bbox;
+    BVHBuildStats m_build_stats;
+    size_t m_size;
+    // leaf children refer to a block instead of their first primitive
+    std::vector<WideBVHNode<4>> m_nodes4;
+    std::vector<WideBVHNode<8>> m_nodes8;
+    std::vector<SphereBlock> m_blocks;
+    std::vector<std::shared_ptr<Material>> m_materials;
+
+    // Copies the subtree at build_index to nodes, subtrees of at most
+    // SPHERE_BLOCK_SIZE spheres become leaves.
+    static void Regroup(const std::vector<BVHBuildNode>& build_nodes,
+                        const std::vector<size_t>& first_prims,
+                        const std::vector<size_t>& prim_counts,
+                        size_t build_index,
+                        std::vector<BVHBuildNode>& nodes);
+    static Point3 Center(const SphereBlock& block, uint32_t slot);
+    // Same traversal as WideBVH::Traverse, leaves are culled as a whole
+    // before their spheres are intersected.
+    template <size_t WIDTH, bool ANY_HIT,
+            WideBVH::IntersectFunc<WIDTH> INTERSECT, CullFunc CULL>
+    bool Traverse(const std::vector<WideBVHNode<WIDTH>>& nodes,
+                const Ray& ray,
+                const Interval& ray_t,
+                HitRecord *rec) const;
+};
+
+inline AABB SphereSet::BoundingBox() const {
+    return m_bbox;
+}
+
+inline WideBVH::ISA SphereSet::GetISA() const {
+    return m_isa;
+}
+
+inline size_t SphereSet::GetSize() const {
+    return m_size;
+}
+
+inline size_t SphereSet::GetNodeCount() const {
+    return ((m_isa == WideBVH::ISA::AVX2) ? m_nodes8.size() : m_nodes4.size());
+}
+
+inline const BVHBuildStats& SphereSet::GetBuildStats() const {
+    return m_build_stats;
+}
+
+inline Point3 SphereSet::Center(const SphereBlock& block, uint32_t slot) {
+    return Point3(block.center[0][slot], block.center[1][slot],
+                block.center[2][slot]);
+}
+
+}
+
+#endif // SPHERE_SET_HPP
@@ -11,8 +11,19 @@ public:
     virtual ~Texture() = default;
 
     virtual Color Value(double u, double v, const Point3& p) const =0;
+    // Value averaged over a footprint uv_width wide in texture space, see
+    // HitRecord::uv_width. Textures without prefiltered data return Value.
+    virtual Color FilteredValue(double u, double v, const Point3& p,
+                                double uv_width) const;
 };
 
+inline Color Texture::FilteredValue(double u, double v, const Point3& p,
+                                    double uv_width) const {
+    (void)uv_width;
+
+    return Value(u, v, p);
+}
+
 }
 
 #endif // TEXTURE_HPP
\ No newline at end of file
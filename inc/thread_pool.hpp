@@ -0,0 +1,73 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+namespace RayTracing {
+
+// Fixed size pool of worker threads.
+// Work is handed out as task indices, every worker owns a deque of tasks,
+// pops from its front and steals from the back of the other deques
+// once its own deque runs dry.
+class ThreadPool {
+public:
+    using Task = std::function<void(size_t task, uint32_t worker)>;
+
+    // num_threads == 0 - use the number of hardware threads.
+    explicit ThreadPool(uint32_t num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    uint32_t GetNumThreads() const;
+
+    // Runs func(task, worker) for every task in [0, num_tasks) and blocks
+    // until all of them are done. Not reentrant: func must not call
+    // ParallelFor on the same pool.
+    void ParallelFor(size_t num_tasks, const Task& func);
+
+    static uint32_t HardwareThreads();
+
+private:
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<size_t> tasks;
+    };
+
+    std::vector<std::thread> m_threads;
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    std::mutex m_lock;
+    std::condition_variable m_work_cv;
+    std::condition_variable m_done_cv;
+    const Task *m_task;
+    uint64_t m_generation;
+    uint32_t m_busy_workers;
+    bool m_stop;
+
+    void WorkerLoop(uint32_t worker);
+    void RunTasks(uint32_t worker);
+    bool PopTask(uint32_t worker, size_t& task);
+    bool StealTask(uint32_t thief, size_t& task);
+};
+
+inline uint32_t ThreadPool::GetNumThreads() const {
+    return static_cast<uint32_t>(m_threads.size());
+}
+
+inline uint32_t ThreadPool::HardwareThreads() {
+    uint32_t num_threads = std::thread::hardware_concurrency();
+
+    return ((num_threads == 0) ? 1 : num_threads);
+}
+
+}
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,96 @@
+#ifndef TRANSFORM_HPP
+#define TRANSFORM_HPP
+
+#include "vec3.hpp"
+#include "aabb.hpp"
+#include "ray.hpp"
+
+namespace RayTracing {
+
+// Affine transform as a 3x4 matrix: a 3x3 linear part in the first three
+// columns and a translation in the fourth. Points are transformed with the
+// translation, vectors without it. Transforms compose like matrices,
+// (a * b) applies b first.
+class Transform {
+public:
+    // identity
+    Transform();
+    Transform(const double (&m)[3][4]);
+
+    static Transform Translation(const Vec3& offset);
+    static Transform Scaling(const Vec3& factors);
+    // angle in degrees, counterclockwise looking down the axis
+    static Transform Rotation(const Vec3& axis, double angle);
+    static Transform RotationY(double angle);
+
+    Point3 TransformPoint(const Point3& p) const;
+    Vec3 TransformVector(const Vec3& v) const;
+    // Normals of a surface transformed by the inverse of this transform:
+    // multiplies by the transpose of the linear part, so call it on the
+    // inverse of the surface's transform. Not normalized.
+    Vec3 TransformNormal(const Vec3& n) const;
+    // The direction is not normalized, so distances along the ray stay
+    // the same in both spaces.
+    Ray TransformRay(const Ray& ray) const;
+    // Box around the transformed box.
+    AABB TransformBox(const AABB& box) const;
+
+    // Inverse of the transform, the identity when it is singular.
+    Transform Inverse() const;
+    double Determinant() const;
+    bool IsIdentity() const;
+
+    double operator()(unsigned int row, unsigned int col) const;
+
+private:
+    double m_m[3][4];
+
+    friend Transform operator*(const Transform& a, const Transform& b);
+};
+
+Transform operator*(const Transform& a, const Transform& b);
+
+inline Transform::Transform() :
+m_m{{1.0, 0.0, 0.0, 0.0}, {0.0, 1.0, 0.0, 0.0}, {0.0, 0.0, 1.0, 0.0}}
+{}
+
+inline Point3 Transform::TransformPoint(const Point3& p) const {
+    return Point3(m_m[0][0] * p.GetX() + m_m[0][1] * p.GetY() +
+                    m_m[0][2] * p.GetZ() + m_m[0][3],
+                m_m[1][0] * p.GetX() + m_m[1][1] * p.GetY() +
+                    m_m[1][2] * p.GetZ() + m_m[1][3],
+                m_m[2][0] * p.GetX() + m_m[2][1] * p.GetY() +
+                    m_m[2][2] * p.GetZ() + m_m[2][3]);
+}
+
+inline Vec3 Transform::TransformVector(const Vec3& v) const {
+    return Vec3(m_m[0][0] * v.GetX() + m_m[0][1] * v.GetY() +
+                    m_m[0][2] * v.GetZ(),
+                m_m[1][0] * v.GetX() + m_m[1][1] * v.GetY() +
+                    m_m[1][2] * v.GetZ(),
+                m_m[2][0] * v.GetX() + m_m[2][1] * v.GetY() +
+                    m_m[2][2] * v.GetZ());
+}
+
+inline Vec3 Transform::TransformNormal(const Vec3& n) const {
+    return Vec3(m_m[0][0] * n.GetX() + m_m[1][0] * n.GetY() +
+                    m_m[2][0] * n.GetZ(),
+                m_m[0][1] * n.GetX() + m_m[1][1] * n.GetY() +
+                    m_m[2][1] * n.GetZ(),
+                m_m[0][2] * n.GetX() + m_m[1][2] * n.GetY() +
+                    m_m[2][2] * n.GetZ());
+}
+
+inline Ray Transform::TransformRay(const Ray& ray) const {
+    return Ray(TransformPoint(ray.GetOrigin()),
+                TransformVector(ray.GetDirection()),
+                ray.GetTime());
+}
+
+inline double Transform::operator()(unsigned int row, unsigned int col) const {
+    return m_m[row][col];
+}
+
+}
+
+#endif // TRANSFORM_HPP
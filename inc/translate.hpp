@@ -13,6 +13,7 @@ public:
     bool Hit(const Ray& ray,
             const Interval& ray_t,
             HitRecord& rec) const override;
+    bool Occluded(const Ray& ray, const Interval& ray_t) const override;
     AABB BoundingBox() const override;
 
 private:
@@ -27,7 +28,7 @@ inline Translate::Translate(
 m_bbox(object->BoundingBox() + offset), m_object(object), m_offset(offset)
 {}
 
-bool Translate::Hit(const Ray& ray,
+inline bool Translate::Hit(const Ray& ray,
             const Interval& ray_t,
             HitRecord& rec) const {
     Ray offset_r(ray.GetOrigin() - m_offset, ray.GetDirection(), ray.GetTime());
@@ -41,6 +42,12 @@ bool Translate::Hit(const Ray& ray,
     return true;
 }
 
+inline bool Translate::Occluded(const Ray& ray, const Interval& ray_t) const {
+    Ray offset_r(ray.GetOrigin() - m_offset, ray.GetDirection(), ray.GetTime());
+
+    return m_object->Occluded(offset_r, ray_t);
+}
+
 inline AABB Translate::BoundingBox() const {
     return m_bbox;
 }
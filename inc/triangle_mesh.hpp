@@ -0,0 +1,110 @@
+#ifndef TRIANGLE_MESH_HPP
+#define TRIANGLE_MESH_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "hittable.hpp"
+#include "bvh_builder.hpp"
+#include "linear_bvh.hpp"
+
+namespace RayTracing {
+
+// Vertex and index buffers of a triangle mesh, in the layout TriangleMesh
+// keeps them. Vertex attributes are single precision.
+struct MeshData {
+    std::vector<float> positions;   // x, y, z per vertex
+    std::vector<float> normals;     // x, y, z per vertex, or empty
+    std::vector<float> uvs;         // u, v per vertex, or empty
+    std::vector<uint32_t> indices;  // 3 vertices per triangle
+
+    size_t GetVertexCount() const;
+    size_t GetTriangleCount() const;
+};
+
+// Indexed triangle mesh with one material. Triangles share their vertices
+// and are found through a BVH of the mesh's own, so the whole mesh is a
+// single object to the scene's BVH and costs 12 bytes of indices,
+// about 32 bytes of nodes and a share of the vertices per triangle.
+// Rays are intersected with the Moller-Trumbore test in double precision.
+// Meshes without normals are flat shaded, without uvs the barycentric
+// coordinates of the hit are used.
+class TriangleMesh : public Hittable {
+public:
+    using SplitMethod = BVHBuilder::SplitMethod;
+
+    TriangleMesh(MeshData data,
+                std::shared_ptr<Material> mat,
+                SplitMethod method = SplitMethod::SAH);
+
+    bool Hit(const Ray& ray,
+            const Interval& ray_t,
+            HitRecord& rec) const override;
+    bool Occluded(const Ray& ray, const Interval& ray_t) const override;
+    AABB BoundingBox() const override;
+
+    const MeshData& GetData() const;
+    size_t GetNodeCount() const;
+    // Stats of the mesh's BVH.
+    const BVHBuildStats& GetBuildStats() const;
+
+private:
+    static constexpr size_t STACK_SIZE = 64;
+
+    MeshData m_data;                // triangles in BVH leaf order
+    std::shared_ptr<Material> m_mat;
+    AABB m_bbox;
+    BVHBuildStats m_build_stats;
+    std::vector<LinearBVHNode> m_nodes;
+
+    Point3 Position(uint32_t vertex) const;
+    // Distance t and barycentric coordinates b1, b2 (of the second and
+    // third vertex) of the hit of triangle tri in ray_t.
+    bool IntersectTriangle(const Ray& ray,
+                        uint32_t tri,
+                        const Interval& ray_t,
+                        double& t, double& b1, double& b2) const;
+    void FillHitRecord(const Ray& ray,
+                    uint32_t tri,
+                    double t, double b1, double b2,
+                    HitRecord& rec) const;
+    // Same traversal as LinearBVH::Traverse with the triangles tested
+    // in place.
+    template <bool ANY_HIT>
+    bool Traverse(const Ray& ray, const Interval& ray_t, HitRecord *rec) const;
+};
+
+inline size_t MeshData::GetVertexCount() const {
+    return positions.size() / 3;
+}
+
+inline size_t MeshData::GetTriangleCount() const {
+    return indices.size() / 3;
+}
+
+inline AABB TriangleMesh::BoundingBox() const {
+    return m_bbox;
+}
+
+inline const MeshData& TriangleMesh::GetData() const {
+    return m_data;
+}
+
+inline size_t TriangleMesh::GetNodeCount() const {
+    return m_nodes.size();
+}
+
+inline const BVHBuildStats& TriangleMesh::GetBuildStats() const {
+    return m_build_stats;
+}
+
+inline Point3 TriangleMesh::Position(uint32_t vertex) const {
+    const float *p = &m_data.positions[3 * static_cast<size_t>(vertex)];
+
+    return Point3(p[0], p[1], p[2]);
+}
+
+}
+
+#endif // TRIANGLE_MESH_HPP
@@ -2,31 +2,74 @@
 #ifndef UTILS_HPP
 #define UTILS_HPP
 
+#include <cmath>
 #include <limits>
-#include <random>
+
+#include "rng.hpp"
 
 namespace RayTracing {
 
+// Scalar type of the vector math (Vec3, Ray, Interval, AABB and with
+// them colors). Build with RT_SINGLE_PRECISION defined for floats, doubles
+// by default. Distances along rays, pdfs and sample values stay double
+// either way, data that is only read by traversal (BVH nodes, mesh
+// vertices, sphere centers) is float either way.
+#ifdef RT_SINGLE_PRECISION
+using Real = float;
+#else
+using Real = double;
+#endif
+
 constexpr double INF = std::numeric_limits<double>::infinity();
 constexpr double PI = 3.1415926535897932385;
+// Largest double below 1, keeps remapped samples in [0, 1).
+constexpr double ONE_MINUS_EPSILON = 
+                    1.0 - std::numeric_limits<double>::epsilon() / 2.0;
 
 inline double DegreesToRadians(double degrees) {
     return (degrees * (PI / 180.0));
 }
 
-inline double RandomDouble() {
-    static std::uniform_real_distribution<double> distribution(0.0, 1.0);
-    static std::mt19937 generator;
+// Nearest float that is <= x / >= x, used to store double precision
+// bounds as floats without shrinking them.
+inline float FloatRoundDown(double x) {
+    float f = static_cast<float>(x);
+
+    return ((f > x) ? 
+            std::nextafter(f, -std::numeric_limits<float>::infinity()) : f);
+}
+
+inline float FloatRoundUp(double x) {
+    float f = static_cast<float>(x);
+
+    return ((f < x) ? 
+            std::nextafter(f, std::numeric_limits<float>::infinity()) : f);
+}
 
-    return distribution(generator);
+inline double RandomDouble(RNG& rng) {
+    return rng.NextDouble();
+}
+
+inline double RandomDouble(RNG& rng, double min, double max) {
+    return (min + (max - min) * RandomDouble(rng));
+}
+
+inline int RandomInt(RNG& rng, int min, int max) {
+    return static_cast<int>(RandomDouble(rng, min, max + 1));
+}
+
+// The overloads without a generator draw from the calling thread's generator.
+
+inline double RandomDouble() {
+    return RandomDouble(ThreadRNG());
 }
 
 inline double RandomDouble(double min, double max) {
-    return (min + (max - min) * RandomDouble());
+    return RandomDouble(ThreadRNG(), min, max);
 }
 
 inline int RandomInt(int min, int max) {
-    return static_cast<int>(RandomDouble(min, max + 1));
+    return RandomInt(ThreadRNG(), min, max);
 }
 
 }
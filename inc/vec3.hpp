@@ -9,66 +9,98 @@
 
 namespace RayTracing {
 
-class Vec3 {
-public:
+// Coordinates of a Vec3T, the same type for every scalar type.
+struct Vec3Base {
     enum Cord: unsigned int {X = 0, Y, Z, NUM_OF_DIM};
+};
+
+// Three component vector of scalar type T. Vec3 (and Point3) use Real,
+// the precision the renderer is built with, Vec3f stores floats for
+// compact data and converts explicitly.
+template <typename T>
+class Vec3T : public Vec3Base {
+public:
+    using Scalar = T;
 
-    Vec3();
-    Vec3(double e0, double e1, double e2);
+    Vec3T();
+    Vec3T(T e0, T e1, T e2);
+    template <typename U>
+    explicit Vec3T(const Vec3T<U>& v);
 
-    double GetX() const;
-    double GetY() const;
-    double GetZ() const;
+    T GetX() const;
+    T GetY() const;
+    T GetZ() const;
 
-    Vec3 operator-() const;
-    double operator[](Cord i) const;
-    double& operator[](Cord i);
+    Vec3T operator-() const;
+    T operator[](Cord i) const;
+    T& operator[](Cord i);
 
-    Vec3& operator+=(const Vec3& v);
-    Vec3& operator*=(double t);
-    Vec3& operator/=(double t);
+    Vec3T& operator+=(const Vec3T& v);
+    Vec3T& operator*=(T t);
+    Vec3T& operator/=(T t);
 
-    double Length() const;
-    double LengthSquared() const;
+    T Length() const;
+    T LengthSquared() const;
     bool NearZero() const;
 
-    static Vec3 Random();
-    static Vec3 Random(double min, double max);
+    static Vec3T Random();
+    static Vec3T Random(double min, double max);
+    static Vec3T Random(RNG& rng);
+    static Vec3T Random(RNG& rng, double min, double max);
 
 private:
-    double m_e[NUM_OF_DIM];
+    T m_e[NUM_OF_DIM];
 };
 
-inline Vec3::Vec3() : m_e{0.0, 0.0, 0.0} {}
+using Vec3 = Vec3T<Real>;
+using Vec3f = Vec3T<float>;
 
-inline Vec3::Vec3(double e0, double e1, double e2) : m_e{e0, e1, e2} 
+template <typename T>
+inline Vec3T<T>::Vec3T() : m_e{0, 0, 0} {}
+
+template <typename T>
+inline Vec3T<T>::Vec3T(T e0, T e1, T e2) : m_e{e0, e1, e2} 
+{}
+
+template <typename T>
+template <typename U>
+inline Vec3T<T>::Vec3T(const Vec3T<U>& v) : 
+m_e{static_cast<T>(v.GetX()), static_cast<T>(v.GetY()), 
+    static_cast<T>(v.GetZ())}
 {}
 
-inline double Vec3::GetX() const {
+template <typename T>
+inline T Vec3T<T>::GetX() const {
     return m_e[Cord::X];
 }
 
-inline double Vec3::GetY() const {
+template <typename T>
+inline T Vec3T<T>::GetY() const {
     return m_e[Cord::Y];
 }
 
-inline double Vec3::GetZ() const {
+template <typename T>
+inline T Vec3T<T>::GetZ() const {
     return m_e[Cord::Z];
 }
 
-inline Vec3 Vec3::operator-() const {
-    return (Vec3(-m_e[Cord::X], -m_e[Cord::Y], -m_e[Cord::Z]));
+template <typename T>
+inline Vec3T<T> Vec3T<T>::operator-() const {
+    return (Vec3T(-m_e[Cord::X], -m_e[Cord::Y], -m_e[Cord::Z]));
 }
 
-inline double Vec3::operator[](Cord i) const {
+template <typename T>
+inline T Vec3T<T>::operator[](Cord i) const {
     return m_e[i];
 }
 
-inline double& Vec3::operator[](Cord i) {
+template <typename T>
+inline T& Vec3T<T>::operator[](Cord i) {
     return m_e[i];
 }
 
-inline Vec3& Vec3::operator+=(const Vec3& v) {
+template <typename T>
+inline Vec3T<T>& Vec3T<T>::operator+=(const Vec3T& v) {
     m_e[Cord::X] += v.m_e[Cord::X];
     m_e[Cord::Y] += v.m_e[Cord::Y];
     m_e[Cord::Z] += v.m_e[Cord::Z];
@@ -76,7 +108,8 @@ inline Vec3& Vec3::operator+=(const Vec3& v) {
     return *this;
 }
 
-inline Vec3& Vec3::operator*=(double t) {
+template <typename T>
+inline Vec3T<T>& Vec3T<T>::operator*=(T t) {
     m_e[Cord::X] *= t;
     m_e[Cord::Y] *= t;
     m_e[Cord::Z] *= t;
@@ -84,125 +117,193 @@ inline Vec3& Vec3::operator*=(double t) {
     return *this;
 }
 
-inline Vec3& Vec3::operator/=(double t) {
+template <typename T>
+inline Vec3T<T>& Vec3T<T>::operator/=(T t) {
     return (*this *= (1 / t));
 }
 
-inline double Vec3::Length() const {
+template <typename T>
+inline T Vec3T<T>::Length() const {
     return (std::sqrt(LengthSquared()));
 }
 
-inline double Vec3::LengthSquared() const {
+template <typename T>
+inline T Vec3T<T>::LengthSquared() const {
     return (m_e[Cord::X] * m_e[Cord::X] +
             m_e[Cord::Y] * m_e[Cord::Y] +
             m_e[Cord::Z] * m_e[Cord::Z]);
 }
 
-inline bool Vec3::NearZero() const {
-    double s = 1.0e-8;
+template <typename T>
+inline bool Vec3T<T>::NearZero() const {
+    T s = static_cast<T>(1.0e-8);
 
     return ((std::fabs(m_e[Cord::X]) < s) && 
             (std::fabs(m_e[Cord::Y]) < s) &&
             (std::fabs(m_e[Cord::Z]) < s));
 }
 
-inline Vec3 Vec3::Random() {
-    return Vec3(RandomDouble(), RandomDouble(), RandomDouble());
+template <typename T>
+inline Vec3T<T> Vec3T<T>::Random() {
+    return Random(ThreadRNG());
 }
 
-inline Vec3 Vec3::Random(double min, double max) {
-    return Vec3(RandomDouble(min, max), 
-                RandomDouble(min, max), 
-                RandomDouble(min, max));
+template <typename T>
+inline Vec3T<T> Vec3T<T>::Random(double min, double max) {
+    return Random(ThreadRNG(), min, max);
+}
+
+template <typename T>
+inline Vec3T<T> Vec3T<T>::Random(RNG& rng) {
+    T x = static_cast<T>(RandomDouble(rng));
+    T y = static_cast<T>(RandomDouble(rng));
+    T z = static_cast<T>(RandomDouble(rng));
+
+    return Vec3T(x, y, z);
+}
+
+template <typename T>
+inline Vec3T<T> Vec3T<T>::Random(RNG& rng, double min, double max) {
+    T x = static_cast<T>(RandomDouble(rng, min, max));
+    T y = static_cast<T>(RandomDouble(rng, min, max));
+    T z = static_cast<T>(RandomDouble(rng, min, max));
+
+    return Vec3T(x, y, z);
 }
 
 // point3 is just an alias for vec3, but useful for geometric clarity in the code.
 using Point3 = Vec3;
 
-// non member functions
+// non member functions, scalars are taken as the vector's Scalar so that
+// double constants work with float vectors
 
-inline std::ostream& operator<<(std::ostream& out, const Vec3& v) {
-    return (out << v[Vec3::Cord::X] << ' ' 
-            << v[Vec3::Cord::Y] << ' ' 
-            << v[Vec3::Cord::Z]);
+template <typename T>
+inline std::ostream& operator<<(std::ostream& out, const Vec3T<T>& v) {
+    return (out << v[Vec3Base::Cord::X] << ' ' 
+            << v[Vec3Base::Cord::Y] << ' ' 
+            << v[Vec3Base::Cord::Z]);
 }
 
-inline Vec3 operator+(const Vec3& u, const Vec3& v) {
-    Vec3 tmp(u);
+template <typename T>
+inline Vec3T<T> operator+(const Vec3T<T>& u, const Vec3T<T>& v) {
+    Vec3T<T> tmp(u);
 
     return (tmp += v);
 }
 
-inline Vec3 operator-(const Vec3& u, const Vec3& v) {
+template <typename T>
+inline Vec3T<T> operator-(const Vec3T<T>& u, const Vec3T<T>& v) {
     return (u + (-v));
 }
 
-inline Vec3 operator*(const Vec3& u, const Vec3& v) {
-    return Vec3(u.GetX() * v.GetX(), 
-                u.GetY() * v.GetY(), 
-                u.GetZ() * v.GetZ());
+template <typename T>
+inline Vec3T<T> operator*(const Vec3T<T>& u, const Vec3T<T>& v) {
+    return Vec3T<T>(u.GetX() * v.GetX(), 
+                    u.GetY() * v.GetY(), 
+                    u.GetZ() * v.GetZ());
 }
 
-inline Vec3 operator*(double t, const Vec3& v) {
-    Vec3 tmp(v);
+template <typename T>
+inline Vec3T<T> operator*(typename Vec3T<T>::Scalar t, const Vec3T<T>& v) {
+    Vec3T<T> tmp(v);
 
     return (tmp *= t);
 }
 
-inline Vec3 operator*(const Vec3& v, double t) {
+template <typename T>
+inline Vec3T<T> operator*(const Vec3T<T>& v, typename Vec3T<T>::Scalar t) {
     return (t * v);
 }
 
-inline Vec3 operator/(const Vec3& v, double t) {
-    return (v * (1.0 / t));
+template <typename T>
+inline Vec3T<T> operator/(const Vec3T<T>& v, typename Vec3T<T>::Scalar t) {
+    return (v * (1 / t));
 }
 
-inline double Dot(const Vec3& u, const Vec3& v) {
+template <typename T>
+inline T Dot(const Vec3T<T>& u, const Vec3T<T>& v) {
     return (u.GetX() * v.GetX() + 
             u.GetY() * v.GetY() +
             u.GetZ() * v.GetZ());
 }
 
-inline Vec3 Cross(const Vec3& u, const Vec3& v) {
-    return Vec3(u.GetY() * v.GetZ() - u.GetZ() * v.GetY(),
-                u.GetZ() * v.GetX() - u.GetX() * v.GetZ(),
-                u.GetX() * v.GetY() - u.GetY() * v.GetX());
+template <typename T>
+inline Vec3T<T> Cross(const Vec3T<T>& u, const Vec3T<T>& v) {
+    return Vec3T<T>(u.GetY() * v.GetZ() - u.GetZ() * v.GetY(),
+                    u.GetZ() * v.GetX() - u.GetX() * v.GetZ(),
+                    u.GetX() * v.GetY() - u.GetY() * v.GetX());
 }
 
-inline Vec3 UnitVector(const Vec3& v) {
+template <typename T>
+inline Vec3T<T> UnitVector(const Vec3T<T>& v) {
     return (v / v.Length());
 }
 
-inline Vec3 RandomInUnitDisk() {
+// Concentric mapping (Shirley and Chiu) of the unit square onto the disk,
+// keeps the stratification of (r1, r2).
+inline Vec3 RandomInUnitDisk(double r1, double r2) {
+    double x = 2.0 * r1 - 1.0;
+    double y = 2.0 * r2 - 1.0;
+
+    if ((x == 0.0) && (y == 0.0)) {
+        return Vec3(0.0, 0.0, 0.0);
+    }
+
+    double radius = 0.0;
+    double theta = 0.0;
+
+    if (std::fabs(x) > std::fabs(y)) {
+        radius = x;
+        theta = (PI / 4.0) * (y / x);
+    }
+    else {
+        radius = y;
+        theta = (PI / 2.0) - (PI / 4.0) * (x / y);
+    }
+
+    return Vec3(radius * std::cos(theta), radius * std::sin(theta), 0.0);
+}
+
+inline Vec3 RandomInUnitDisk(RNG& rng) {
     bool is_valid = false;
     Vec3 vec;
 
     while (!is_valid) {
-        vec = Vec3(RandomDouble(-1.0, 1.0), RandomDouble(-1.0, 1.0), 0.0);
+        double x = RandomDouble(rng, -1.0, 1.0);
+        double y = RandomDouble(rng, -1.0, 1.0);
+        vec = Vec3(x, y, 0.0);
         is_valid = (vec.LengthSquared() < 1.0);
     }
 
     return vec;
 }
 
-inline Vec3 RandomInUnitSphere() {
+inline Vec3 RandomInUnitSphere(RNG& rng) {
     bool is_valid = false;
     Vec3 vec;
 
     while (!is_valid) {
-        vec = Vec3::Random(-1.0, 1.0);
+        vec = Vec3::Random(rng, -1.0, 1.0);
         is_valid = (vec.LengthSquared() < 1.0);
     }
 
     return vec;
 }
 
-inline Vec3 RandomUnitVector() {
-    return UnitVector(RandomInUnitSphere());
+inline Vec3 RandomUnitVector(RNG& rng) {
+    return UnitVector(RandomInUnitSphere(rng));
 }
 
-inline Vec3 RandomOnHemisphere(const Vec3& normal) {
-    Vec3 on_unit_sphere = RandomInUnitSphere();
+inline Vec3 RandomUnitVector(double r1, double r2) {
+    double z = 1.0 - 2.0 * r1;
+    double r = std::sqrt(std::fmax(0.0, 1.0 - z * z));
+    double phi = 2 * PI * r2;
+
+    return Vec3(r * std::cos(phi), r * std::sin(phi), z);
+}
+
+inline Vec3 RandomOnHemisphere(RNG& rng, const Vec3& normal) {
+    Vec3 on_unit_sphere = RandomInUnitSphere(rng);
 
     return ((Dot(on_unit_sphere, normal) > 0.0) ? 
             on_unit_sphere : -on_unit_sphere);
@@ -221,10 +322,7 @@ inline Vec3 Refract(const Vec3& uv, const Vec3& n, double etai_over_etat) {
     return (ray_out_perp + ray_out_parallel);
 }
 
-inline Vec3 RandomCosineDirection() {
-    double r1 = RandomDouble();
-    double r2 = RandomDouble();
-
+inline Vec3 RandomCosineDirection(double r1, double r2) {
     double phi = 2 * PI * r1;
     double x = std::cos(phi) * std::sqrt(r2);
     double y = std::sin(phi) * std::sqrt(r2);
@@ -233,6 +331,13 @@ inline Vec3 RandomCosineDirection() {
     return Vec3(x, y, z);
 }
 
+inline Vec3 RandomCosineDirection(RNG& rng) {
+    double r1 = RandomDouble(rng);
+    double r2 = RandomDouble(rng);
+
+    return RandomCosineDirection(r1, r2);
+}
+
 } // RayTracing
 
 #endif // VEC3_HPP
\ No newline at end of file
@@ -0,0 +1,233 @@
+#ifndef WAVEFRONT_INTEGRATOR_HPP
+#define WAVEFRONT_INTEGRATOR_HPP
+
+#include <cstdint>
+#include <typeinfo>
+#include <vector>
+
+#include "hittable.hpp"
+#include "material.hpp"
+#include "sampler.hpp"
+#include "rng.hpp"
+
+namespace RayTracing {
+
+// Rays of the paths being traced, as structure of arrays. The arrays only
+// grow, the first Size() entries are valid.
+struct RayQueue {
+    size_t size = 0;
+    std::vector<uint32_t> path;     // index of the path the ray belongs to
+    std::vector<double> origin[3];
+    std::vector<double> direction[3];
+    std::vector<double> time;
+
+    size_t Size() const;
+    void Clear();
+    void Push(uint32_t path_index, const Ray& ray);
+    Ray Get(size_t index) const;
+    void Reserve(size_t capacity);
+};
+
+// Hit records of the rays of a RayQueue that hit something, as structure
+// of arrays like RayQueue. material_type is the dynamic type of mat.
+struct HitQueue {
+    size_t size = 0;
+    std::vector<uint32_t> ray;      // index into the RayQueue
+    std::vector<double> point[3];
+    std::vector<double> normal[3];
+    std::vector<double> t;
+    std::vector<double> u;
+    std::vector<double> v;
+    std::vector<double> uv_density;
+    std::vector<uint8_t> front_face;
+    std::vector<const Material *> mat;
+    std::vector<const std::type_info *> material_type;
+
+    size_t Size() const;
+    void Clear();
+    void Push(uint32_t ray_index, const HitRecord& rec);
+    HitRecord Get(size_t index) const;
+    void Reserve(size_t capacity);
+};
+
+// Wavefront (stream) path tracer: a batch of camera paths is traced one
+// bounce at a time for all paths together. Every bounce intersects the
+// whole ray queue with the world, sorts the hits by material class and
+// shades each class's queue in one go, so the virtual Hit, Scatter and
+// Texture::Value calls of a stage run the same code over many paths
+// instead of alternating between them for every path.
+// Camera rays are intersected in packets (see Hittable::HitPacket).
+// Paths are shaded with ShadePathVertex and draw from their own generator,
+// the light samples of a bounce are queued and traced as a stage of their
+// own. The results equal those of Camera::RayColor for the same samples. Only
+// media can differ: the order in which a packet visits them changes 
+// which distances are drawn.
+// Buffers are kept between batches, one integrator per render thread.
+class WavefrontIntegrator {
+public:
+    WavefrontIntegrator(const Sampler& sampler,
+                        const Hittable& world,
+                        const Hittable& lights,
+                        const Color& background,
+                        uint32_t max_depth,
+                        uint32_t roulette_depth,
+                        double cone_spread);
+
+    // Makes room for batches of num_paths paths, smaller batches are
+    // traced without allocations.
+    void Reserve(size_t num_paths);
+    // Removes all paths.
+    void Clear();
+    // Queues a path starting with a camera ray, the sequence continues at
+    // its current dimension. Returns the index of the path.
+    size_t AddPath(const Ray& ray, const SampleSequence& sequence,
+                    const RNG& rng);
+    // Traces all queued paths to their end.
+    void Trace();
+
+    size_t GetPathCount() const;
+    const PixelSample& GetSample(size_t path) const;
+    // Radiance of a traced path.
+    Color GetRadiance(size_t path) const;
+
+private:
+    // material classes the buckets are reserved for, scenes with more
+    // grow them on the first batches
+    static constexpr size_t RESERVED_MATERIAL_TYPES = 16;
+
+    const Sampler& m_sampler;
+    const Hittable& m_world;
+    const Hittable& m_lights;
+    Color m_background;
+    uint32_t m_max_depth;
+    uint32_t m_roulette_depth;
+    double m_cone_spread;                   // of the camera rays' cones
+
+    // per path state
+    std::vector<PixelSample> m_samples;
+    std::vector<uint32_t> m_dimensions;
+    std::vector<RNG> m_rngs;
+    std::vector<double> m_throughput[3];
+    std::vector<double> m_radiance[3];
+    std::vector<double> m_bsdf_pdf;         // PathState of the paths
+    std::vector<double> m_light_pdf;
+    std::vector<double> m_cone_width;
+
+    RayQueue m_rays;
+    RayQueue m_next_rays;
+    // light samples of the shaded vertices, traced after the shade stage
+    RayQueue m_shadow_rays;
+    std::vector<double> m_shadow_weight[3];
+    HitQueue m_hits;
+    std::vector<uint32_t> m_shading_order;  // hit indices sorted by material
+    // Material classes seen so far, the index of a class is its bucket
+    // in the counting sort of the hits.
+    std::vector<const std::type_info *> m_material_types;
+    std::vector<uint32_t> m_hit_buckets;
+    std::vector<size_t> m_bucket_offsets;
+
+    void Intersect();
+    void IntersectPackets();
+    void AddHit(size_t r, bool hit, const HitRecord& rec);
+    void SortHits();
+    uint32_t MaterialBucket(const std::type_info *type);
+    void Shade(uint32_t depth);
+    void TraceShadowRays();
+};
+
+inline size_t RayQueue::Size() const {
+    return size;
+}
+
+inline void RayQueue::Clear() {
+    size = 0;
+}
+
+inline void RayQueue::Push(uint32_t path_index, const Ray& ray) {
+    if (size == path.size()) {
+        Reserve(2 * size);
+    }
+
+    Point3 o = ray.GetOrigin();
+    Vec3 d = ray.GetDirection();
+
+    path[size] = path_index;
+
+    for (size_t axis = 0; axis < 3; ++axis) {
+        auto cord = static_cast<Vec3::Cord>(axis);
+        origin[axis][size] = o[cord];
+        direction[axis][size] = d[cord];
+    }
+
+    time[size] = ray.GetTime();
+    ++size;
+}
+
+inline Ray RayQueue::Get(size_t index) const {
+    return Ray(Point3(origin[0][index], origin[1][index], origin[2][index]),
+            Vec3(direction[0][index], direction[1][index],
+                direction[2][index]),
+            time[index]);
+}
+
+inline size_t HitQueue::Size() const {
+    return size;
+}
+
+inline void HitQueue::Clear() {
+    size = 0;
+}
+
+inline void HitQueue::Push(uint32_t ray_index, const HitRecord& rec) {
+    if (size == ray.size()) {
+        Reserve(2 * size);
+    }
+
+    ray[size] = ray_index;
+
+    for (size_t axis = 0; axis < 3; ++axis) {
+        auto cord = static_cast<Vec3::Cord>(axis);
+        point[axis][size] = rec.point[cord];
+        normal[axis][size] = rec.normal[cord];
+    }
+
+    t[size] = rec.t;
+    u[size] = rec.u;
+    v[size] = rec.v;
+    uv_density[size] = rec.uv_density;
+    front_face[size] = rec.front_face;
+    mat[size] = rec.mat;
+    material_type[size] = &typeid(*rec.mat);
+    ++size;
+}
+
+inline HitRecord HitQueue::Get(size_t index) const {
+    HitRecord rec;
+    rec.point = Point3(point[0][index], point[1][index], point[2][index]);
+    rec.normal = Vec3(normal[0][index], normal[1][index], normal[2][index]);
+    rec.mat = mat[index];
+    rec.t = t[index];
+    rec.u = u[index];
+    rec.v = v[index];
+    rec.uv_density = uv_density[index];
+    rec.front_face = (front_face[index] != 0);
+
+    return rec;
+}
+
+inline size_t WavefrontIntegrator::GetPathCount() const {
+    return m_samples.size();
+}
+
+inline const PixelSample& WavefrontIntegrator::GetSample(size_t path) const {
+    return m_samples[path];
+}
+
+inline Color WavefrontIntegrator::GetRadiance(size_t path) const {
+    return Color(m_radiance[0][path], m_radiance[1][path],
+                m_radiance[2][path]);
+}
+
+}
+
+#endif // WAVEFRONT_INTEGRATOR_HPP
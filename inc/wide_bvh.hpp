@@ -0,0 +1,182 @@
+#ifndef WIDE_BVH_HPP
+#define WIDE_BVH_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "hittable.hpp"
+#include "hittable_list.hpp"
+#include "bvh_builder.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define WIDE_BVH_X86
+#endif
+
+namespace RayTracing {
+
+// Node of a WideBVH with up to WIDTH children. Child boxes are stored as
+// structure of arrays, so one SIMD register holds the same bound of all
+// children. Bounds are floats rounded outwards like in LinearBVHNode.
+template <size_t WIDTH>
+struct WideBVHNode {
+    float bounds_min[3][WIDTH];
+    float bounds_max[3][WIDTH];
+    uint32_t offset[WIDTH];     // leaf child: first primitive, interior: node
+    uint16_t prim_count[WIDTH]; // 0 for interior children
+    uint32_t num_children;
+};
+
+// Ray data shared by all node tests of one traversal.
+struct WideBVHRay {
+    float origin[3];
+    float inv_dir[3];
+};
+
+// Rays of a RayPacket in single precision, one array per component so one
+// SIMD register holds the same component of several rays.
+struct WideBVHPacket {
+    float origin[3][RayPacket::MAX_SIZE];
+    float inv_dir[3][RayPacket::MAX_SIZE];
+    float t_max[RayPacket::MAX_SIZE];
+};
+
+// BVH with 4 or 8 children per node, collapsed from the binary tree of
+// BVHBuilder. All children of a node are tested against the ray at once,
+// with AVX2 (8 wide tree), SSE (4 wide tree) or a scalar loop (4 wide tree),
+// whichever the CPU supports.
+// Packets of coherent rays (camera rays) are traversed together: every
+// child box is tested against all rays of the packet at once and a node
+// is visited once for all rays that enter it. When fewer than 
+// PACKET_MIN_RAYS rays are left in a subtree, they finish it one by one.
+class WideBVH : public Hittable {
+public:
+    using SplitMethod = BVHBuilder::SplitMethod;
+
+    enum ISA : unsigned int {SCALAR, SSE, AVX2};
+
+    // isa is lowered to what the CPU supports.
+    explicit WideBVH(HittableList list,
+                    SplitMethod method = SplitMethod::SAH,
+                    ISA isa = DetectISA());
+    explicit WideBVH(const std::vector<std::shared_ptr<Hittable>>& objects,
+                    SplitMethod method = SplitMethod::SAH,
+                    ISA isa = DetectISA());
+
+    bool Hit(const Ray& ray,
+            const Interval& ray_t,
+            HitRecord& rec) const override;
+    bool Occluded(const Ray& ray, const Interval& ray_t) const override;
+    uint32_t HitPacket(RayPacket& packet, HitRecord *recs) const override;
+    uint32_t OccludedPacket(const RayPacket& packet) const override;
+    AABB BoundingBox() const override;
+
+    ISA GetISA() const;
+    size_t GetWidth() const;
+    size_t GetNodeCount() const;
+    // Stats of the binary tree the nodes were built from.
+    const BVHBuildStats& GetBuildStats() const;
+
+    // Widest instruction set of the running CPU.
+    static ISA DetectISA();
+
+    // Tests the ray against all children of a node, writes the entry
+    // distances to t_near and returns a bit mask of the children hit.
+    template <size_t WIDTH>
+    using IntersectFunc = uint32_t (*)(const WideBVHNode<WIDTH>& node,
+                                    const WideBVHRay& ray,
+                                    float t_min, float t_max,
+                                    float *t_near);
+
+    // Turns the binary subtree at build_index into wide nodes appended to
+    // nodes, leaf children keep the build node's first_prim as offset.
+    // Returns the index of the subtree's root.
+    template <size_t WIDTH>
+    static uint32_t Collapse(const std::vector<BVHBuildNode>& build_nodes,
+                            size_t build_index,
+                            std::vector<WideBVHNode<WIDTH>>& nodes);
+    // Slab tests of the ray against all children of a node, see
+    // IntersectFunc. The SSE and AVX2 versions only exist on x86
+    // (WIDE_BVH_X86) and may only run when DetectISA reports them.
+    template <size_t WIDTH>
+    static uint32_t IntersectScalar(const WideBVHNode<WIDTH>& node,
+                                    const WideBVHRay& ray,
+                                    float t_min, float t_max,
+                                    float *t_near);
+#ifdef WIDE_BVH_X86
+    static uint32_t IntersectSSE(const WideBVHNode<4>& node,
+                                const WideBVHRay& ray,
+                                float t_min, float t_max,
+                                float *t_near);
+    static uint32_t IntersectAVX2(const WideBVHNode<8>& node,
+                                const WideBVHRay& ray,
+                                float t_min, float t_max,
+                                float *t_near);
+#endif
+
+private:
+    // Tests one child box against all rays of a packet, writes the entry
+    // distances to t_near and returns a bit mask of the rays that hit it.
+    template <size_t WIDTH>
+    using PacketIntersectFunc = uint32_t (*)(const WideBVHNode<WIDTH>& node,
+                                            uint32_t child,
+                                            const WideBVHPacket& packet,
+                                            float t_min,
+                                            float *t_near);
+
+    // Wide trees are never deeper than the binary tree they come from.
+    static constexpr size_t MAX_DEPTH = 64;
+    // Subtrees entered by fewer rays of a packet are traversed per ray.
+    static constexpr uint32_t PACKET_MIN_RAYS = 3;
+
+    ISA m_isa;
+    AABB m_bbox;
+    BVHBuildStats m_build_stats;
+    std::vector<WideBVHNode<4>> m_nodes4;
+    std::vector<WideBVHNode<8>> m_nodes8;
+    std::vector<std::shared_ptr<Hittable>> m_primitives;
+
+    // Shared traversal loop of Hit (ANY_HIT = false, rec is filled in)
+    // and Occluded (ANY_HIT = true, stops at the first hit).
+    // The traversal starts at node root.
+    template <size_t WIDTH, bool ANY_HIT, IntersectFunc<WIDTH> INTERSECT>
+    bool Traverse(const std::vector<WideBVHNode<WIDTH>>& nodes,
+                uint32_t root,
+                const Ray& ray,
+                const Interval& ray_t,
+                HitRecord *rec) const;
+    // Packet version of Traverse, returns the mask of the rays hit 
+    // (or occluded).
+    template <size_t WIDTH, bool ANY_HIT, IntersectFunc<WIDTH> INTERSECT,
+            PacketIntersectFunc<WIDTH> PACKET_INTERSECT>
+    uint32_t TraversePacket(const std::vector<WideBVHNode<WIDTH>>& nodes,
+                            RayPacket& packet,
+                            HitRecord *recs) const;
+};
+
+inline WideBVH::WideBVH(HittableList list, SplitMethod method, ISA isa) :
+WideBVH(list.GetObjects(), method, isa)
+{}
+
+inline AABB WideBVH::BoundingBox() const {
+    return m_bbox;
+}
+
+inline WideBVH::ISA WideBVH::GetISA() const {
+    return m_isa;
+}
+
+inline size_t WideBVH::GetWidth() const {
+    return ((m_isa == ISA::AVX2) ? 8 : 4);
+}
+
+inline size_t WideBVH::GetNodeCount() const {
+    return ((m_isa == ISA::AVX2) ? m_nodes8.size() : m_nodes4.size());
+}
+
+inline const BVHBuildStats& WideBVH::GetBuildStats() const {
+    return m_build_stats;
+}
+
+}
+
+#endif // WIDE_BVH_HPP
@@ -1,10 +1,15 @@
-
 #include "aabb.hpp"
 
 namespace RayTracing {
 
-const AABB AABB::EMPTY{Interval::EMPTY, Interval::EMPTY, Interval::EMPTY};
-const AABB AABB::UNIVERSE{Interval::UNIVERSE, Interval::UNIVERSE, Interval::UNIVERSE};
+// Built from plain intervals rather than Interval::EMPTY / UNIVERSE, the
+// initialization order of statics across translation units is unspecified.
+const AABB AABB::EMPTY{Interval(+INF, -INF), 
+                        Interval(+INF, -INF), 
+                        Interval(+INF, -INF)};
+const AABB AABB::UNIVERSE{Interval(-INF, +INF), 
+                        Interval(-INF, +INF), 
+                        Interval(-INF, +INF)};
 
 
-}
\ No newline at end of file
+}
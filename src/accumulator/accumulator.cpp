@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "accumulator.hpp"
+#include "utils.hpp"
+
+namespace RayTracing {
+
+constexpr char Accumulator::MAGIC[8];
+constexpr size_t Accumulator::HEADER_SIZE;
+constexpr size_t Accumulator::PIXEL_SIZE;
+constexpr double Accumulator::MIN_LUMINANCE;
+
+uint32_t Accumulator::GetMinSampleCount() const {
+    return (m_counts.empty() ? 0 : 
+            *std::min_element(m_counts.begin(), m_counts.end()));
+}
+
+uint64_t Accumulator::GetTotalSampleCount() const {
+    uint64_t total = 0;
+
+    for (uint32_t count : m_counts) {
+        total += count;
+    }
+
+    return total;
+}
+
+double Accumulator::GetRelativeError(uint32_t i, uint32_t j) const {
+    size_t index = static_cast<size_t>(j) * m_width + i;
+    double n = m_counts[index];
+
+    if (n < 2.0) {
+        return INF;
+    }
+
+    double mean = m_sums[index].Luminance() / n;
+    double variance = std::fmax((m_luminance_squares[index] - n * mean * mean) / 
+                                (n - 1.0), 0.0);
+
+    return (std::sqrt(variance / n) / std::sqrt(std::fmax(mean, MIN_LUMINANCE)));
+}
+
+void Accumulator::Resolve(Framebuffer& framebuffer) const {
+    framebuffer.Resize(m_width, m_height);
+
+    for (uint32_t j = 0; j < m_height; ++j) {
+        for (uint32_t i = 0; i < m_width; ++i) {
+            uint32_t count = GetSampleCount(i, j);
+
+            if (count > 0) {
+                framebuffer.SetPixel(i, j, Color(static_cast<Vec3>(GetSum(i, j)) 
+                                                / count));
+            }
+        }
+    }
+}
+
+void Accumulator::ResolveSampleCounts(Framebuffer& framebuffer, 
+                                    uint32_t max_count) const {
+    double scale = (max_count > 0) ? (1.0 / max_count) : 0.0;
+
+    framebuffer.Resize(m_width, m_height);
+
+    for (uint32_t j = 0; j < m_height; ++j) {
+        for (uint32_t i = 0; i < m_width; ++i) {
+            double value = scale * GetSampleCount(i, j);
+
+            framebuffer.SetPixel(i, j, Color(value, value, value));
+        }
+    }
+}
+
+// Layout: MAGIC, width, height, then per pixel the r, g, b sums and the 
+// luminance squares as doubles and the sample count.
+bool Accumulator::Save(const std::string& filename) const {
+    size_t num_pixels = m_counts.size();
+    std::vector<uint8_t> data(HEADER_SIZE + num_pixels * PIXEL_SIZE);
+    uint8_t *out = data.data();
+
+    std::memcpy(out, MAGIC, sizeof(MAGIC));
+    out += sizeof(MAGIC);
+    std::memcpy(out, &m_width, sizeof(m_width));
+    out += sizeof(m_width);
+    std::memcpy(out, &m_height, sizeof(m_height));
+    out += sizeof(m_height);
+
+    for (size_t p = 0; p < num_pixels; ++p) {
+        double sum[4] = {m_sums[p].GetR(), m_sums[p].GetG(), m_sums[p].GetB(),
+                        m_luminance_squares[p]};
+
+        std::memcpy(out, sum, sizeof(sum));
+        out += sizeof(sum);
+        std::memcpy(out, &m_counts[p], sizeof(uint32_t));
+        out += sizeof(uint32_t);
+    }
+
+    std::string tmp_filename = filename + ".tmp";
+    std::FILE *file = std::fopen(tmp_filename.c_str(), "wb");
+
+    if (file == nullptr) {
+        return false;
+    }
+
+    bool written = (std::fwrite(data.data(), 1, data.size(), file) == data.size());
+    written = (std::fclose(file) == 0) && written;
+
+    if (!written) {
+        std::remove(tmp_filename.c_str());
+
+        return false;
+    }
+
+    // rename does not replace an existing file everywhere
+    std::remove(filename.c_str());
+
+    return (std::rename(tmp_filename.c_str(), filename.c_str()) == 0);
+}
+
+bool Accumulator::Load(const std::string& filename) {
+    std::FILE *file = std::fopen(filename.c_str(), "rb");
+
+    if (file == nullptr) {
+        return false;
+    }
+
+    char magic[sizeof(MAGIC)];
+    uint32_t width = 0;
+    uint32_t height = 0;
+    bool valid = (std::fread(magic, 1, sizeof(magic), file) == sizeof(magic)) &&
+                (std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0) &&
+                (std::fread(&width, sizeof(width), 1, file) == 1) &&
+                (std::fread(&height, sizeof(height), 1, file) == 1);
+
+    // a truncated or corrupt header must not size the buffers
+    if (valid) {
+        long file_size = (std::fseek(file, 0, SEEK_END) == 0) ?
+                        std::ftell(file) : -1;
+        valid = (file_size >= static_cast<long>(HEADER_SIZE));
+
+        if (valid) {
+            uint64_t pixel_bytes = static_cast<uint64_t>(file_size) -
+                                    HEADER_SIZE;
+
+            valid = (pixel_bytes % PIXEL_SIZE == 0) &&
+                    (pixel_bytes / PIXEL_SIZE ==
+                    static_cast<uint64_t>(width) * height) &&
+                    (std::fseek(file, HEADER_SIZE, SEEK_SET) == 0);
+        }
+    }
+
+    if (valid) {
+        size_t num_pixels = static_cast<size_t>(width) * height;
+        std::vector<Color> sums(num_pixels);
+        std::vector<double> luminance_squares(num_pixels);
+        std::vector<uint32_t> counts(num_pixels);
+
+        for (size_t p = 0; valid && (p < num_pixels); ++p) {
+            double sum[4];
+
+            valid = (std::fread(sum, sizeof(double), 4, file) == 4) &&
+                    (std::fread(&counts[p], sizeof(uint32_t), 1, file) == 1);
+            sums[p] = Color(sum[0], sum[1], sum[2]);
+            luminance_squares[p] = sum[3];
+        }
+
+        if (valid) {
+            m_width = width;
+            m_height = height;
+            m_sums.swap(sums);
+            m_luminance_squares.swap(luminance_squares);
+            m_counts.swap(counts);
+        }
+    }
+
+    std::fclose(file);
+
+    if (!valid) {
+        std::cerr << "ERROR: '" << filename 
+                << "' is not a valid accumulation checkpoint\n";
+    }
+
+    return valid;
+}
+
+}
@@ -0,0 +1,70 @@
+#include "alias_table.hpp"
+
+namespace RayTracing {
+
+// Vose: bins of indices with less than the average weight are filled up
+// by an index with more, which then goes back to the small or the large
+// ones with what is left of it.
+AliasTable::AliasTable(const std::vector<double>& weights) :
+m_bins(weights.size()), m_probabilities(weights.size())
+{
+    size_t n = weights.size();
+    double sum = 0.0;
+
+    for (double weight : weights) {
+        sum += std::max(weight, 0.0);
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        m_probabilities[i] = (sum > 0.0) ? 
+                            (std::max(weights[i], 0.0) / sum) : (1.0 / n);
+    }
+
+    std::vector<double> scaled(n);
+    std::vector<uint32_t> small;
+    std::vector<uint32_t> large;
+
+    for (size_t i = 0; i < n; ++i) {
+        scaled[i] = m_probabilities[i] * n;
+
+        if (scaled[i] < 1.0) {
+            small.push_back(static_cast<uint32_t>(i));
+        }
+        else {
+            large.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    while (!small.empty() && !large.empty()) {
+        uint32_t s = small.back();
+        uint32_t l = large.back();
+
+        small.pop_back();
+        large.pop_back();
+
+        m_bins[s].threshold = scaled[s];
+        m_bins[s].alias = l;
+
+        scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+
+        if (scaled[l] < 1.0) {
+            small.push_back(l);
+        }
+        else {
+            large.push_back(l);
+        }
+    }
+
+    // what is left is 1 up to rounding
+    for (uint32_t i : large) {
+        m_bins[i].threshold = 1.0;
+        m_bins[i].alias = i;
+    }
+
+    for (uint32_t i : small) {
+        m_bins[i].threshold = 1.0;
+        m_bins[i].alias = i;
+    }
+}
+
+}
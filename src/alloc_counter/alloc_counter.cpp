@@ -0,0 +1,42 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "alloc_counter.hpp"
+
+namespace RayTracing {
+
+static std::atomic<uint64_t> g_heap_allocations(0);
+
+uint64_t HeapAllocationCount() {
+    return g_heap_allocations.load();
+}
+
+}
+
+// Kept in their own translation unit, so the compiler never sees a new
+// expression and these definitions together.
+
+void* operator new(std::size_t size) {
+    void *ptr = std::malloc((size == 0) ? 1 : size);
+
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    RayTracing::g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    return ptr;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    std::free(ptr);
+}
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <cmath>
+
+#include "blue_noise_sampler.hpp"
+#include "sobol_sampler.hpp"
+
+namespace RayTracing {
+
+constexpr uint32_t BlueNoiseSampler::MASK_SIZE;
+
+double BlueNoiseSampler::Get1D(const PixelSample& sample, 
+                            uint32_t dimension) const {
+    // the same points for every pixel
+    uint32_t seed = static_cast<uint32_t>(RNG::Hash(sample.seed, dimension));
+    double u = SobolSampler::ScrambledSobol1D(sample.index, seed);
+
+    return Shift(u, MaskValue(sample, dimension, 0));
+}
+
+void BlueNoiseSampler::Get2D(const PixelSample& sample, 
+                            uint32_t dimension,
+                            double& u, double& v) const {
+    uint32_t seed = static_cast<uint32_t>(RNG::Hash(sample.seed, dimension));
+    SobolSampler::ScrambledSobol2D(sample.index, seed, u, v);
+
+    u = Shift(u, MaskValue(sample, dimension, 0));
+    v = Shift(v, MaskValue(sample, dimension, 1));
+}
+
+const std::vector<double>& BlueNoiseSampler::Mask() {
+    static const std::vector<double> mask = GenerateMask();
+
+    return mask;
+}
+
+double BlueNoiseSampler::MaskValue(const PixelSample& sample, 
+                                uint32_t dimension, uint32_t channel) const {
+    uint64_t offset = RNG::Hash(sample.seed, dimension, channel);
+    uint32_t x = (sample.x + static_cast<uint32_t>(offset)) % MASK_SIZE;
+    uint32_t y = (sample.y + static_cast<uint32_t>(offset >> 32)) % MASK_SIZE;
+
+    return m_mask[y * MASK_SIZE + x];
+}
+
+// Void and cluster (Ulichney 1993). The energy of a pixel is the Gaussian
+// weighted count of set pixels around it on the torus. Starting from a 
+// random pattern whose tightest cluster and largest void are swapped until
+// it is even, set pixels are ranked by removing the tightest clusters and
+// the remaining ones by filling the largest voids.
+std::vector<double> BlueNoiseSampler::GenerateMask() {
+    constexpr uint32_t size = MASK_SIZE;
+    constexpr uint32_t num_pixels = size * size;
+    constexpr double sigma = 1.5;
+
+    std::vector<double> kernel(num_pixels);
+    for (uint32_t dy = 0; dy < size; ++dy) {
+        for (uint32_t dx = 0; dx < size; ++dx) {
+            double x = std::min(dx, size - dx);
+            double y = std::min(dy, size - dy);
+
+            kernel[dy * size + dx] = std::exp(-(x * x + y * y) / 
+                                            (2.0 * sigma * sigma));
+        }
+    }
+
+    std::vector<uint8_t> pattern(num_pixels, 0);
+    std::vector<double> energy(num_pixels, 0.0);
+
+    auto splat = [&kernel, &energy](uint32_t p, double sign) {
+        uint32_t px = p % size;
+        uint32_t py = p / size;
+
+        for (uint32_t y = 0; y < size; ++y) {
+            const double *row = &kernel[((y + size - py) % size) * size];
+
+            for (uint32_t x = 0; x < size; ++x) {
+                energy[y * size + x] += sign * row[(x + size - px) % size];
+            }
+        }
+    };
+    // set == 1: tightest cluster (highest energy of set pixels), 
+    // set == 0: largest void (lowest energy of empty pixels)
+    auto find = [&pattern, &energy](uint8_t set) {
+        uint32_t best = num_pixels;
+
+        for (uint32_t p = 0; p < num_pixels; ++p) {
+            if ((pattern[p] == set) && ((best == num_pixels) || 
+                (set ? (energy[p] > energy[best]) : 
+                        (energy[p] < energy[best])))) {
+                best = p;
+            }
+        }
+
+        return best;
+    };
+
+    RNG rng(0x5eed);
+    uint32_t num_initial = num_pixels / 10;
+
+    for (uint32_t count = 0; count < num_initial; ) {
+        uint32_t p = rng.NextUInt32() % num_pixels;
+
+        if (!pattern[p]) {
+            pattern[p] = 1;
+            splat(p, 1.0);
+            ++count;
+        }
+    }
+
+    for (;;) {
+        uint32_t cluster = find(1);
+        pattern[cluster] = 0;
+        splat(cluster, -1.0);
+
+        uint32_t void_pixel = find(0);
+        pattern[void_pixel] = 1;
+        splat(void_pixel, 1.0);
+
+        if (void_pixel == cluster) {
+            break;
+        }
+    }
+
+    std::vector<uint32_t> ranks(num_pixels, 0);
+    std::vector<uint8_t> initial_pattern = pattern;
+    std::vector<double> initial_energy = energy;
+
+    for (uint32_t rank = num_initial; rank > 0; --rank) {
+        uint32_t cluster = find(1);
+        pattern[cluster] = 0;
+        splat(cluster, -1.0);
+        ranks[cluster] = rank - 1;
+    }
+
+    pattern.swap(initial_pattern);
+    energy.swap(initial_energy);
+
+    for (uint32_t rank = num_initial; rank < num_pixels; ++rank) {
+        uint32_t void_pixel = find(0);
+        pattern[void_pixel] = 1;
+        splat(void_pixel, 1.0);
+        ranks[void_pixel] = rank;
+    }
+
+    std::vector<double> mask(num_pixels);
+    for (uint32_t p = 0; p < num_pixels; ++p) {
+        mask[p] = (ranks[p] + 0.5) / num_pixels;
+    }
+
+    return mask;
+}
+
+}
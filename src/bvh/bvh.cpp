@@ -1,40 +1,58 @@
-
-#include <algorithm>
-
 #include "bvh.hpp"
 
 namespace RayTracing {
 
 BVHNode::BVHNode(std::vector<std::shared_ptr<Hittable>>& objects,
-                size_t start, size_t end) {
-
-    m_bbox = AABB::EMPTY;
+                size_t start, size_t end,
+                SplitMethod method) {
+    std::vector<BVHPrimitive> prims = 
+                        BVHBuilder::MakePrimitives(objects, start, end);
 
-    for (size_t object_index = start; object_index < end; ++object_index) {
-        m_bbox = AABB(m_bbox, objects[object_index]->BoundingBox());
+    if (method == SplitMethod::MORTON) {
+        BVHBuilder::SortMorton(prims);
     }
 
-    auto axis = m_bbox.LongestAxis();
+    Build(objects, prims, 0, prims.size(), method);
+}
+
+BVHNode::BVHNode(const std::vector<std::shared_ptr<Hittable>>& objects,
+                std::vector<BVHPrimitive>& prims,
+                size_t start, size_t end,
+                SplitMethod method) {
+    Build(objects, prims, start, end, method);
+}
 
-    auto comparator = ChoseCompare(axis);
+void BVHNode::Build(const std::vector<std::shared_ptr<Hittable>>& objects,
+                    std::vector<BVHPrimitive>& prims,
+                    size_t start, size_t end,
+                    SplitMethod method) {
+    m_bbox = BVHBuilder::Bounds(prims, start, end);
+    m_axis = AABB::Axis::X;
 
     size_t object_span = end - start;
+    size_t mid = BVHBuilder::Partition(prims, start, end, method, m_axis);
 
     if (object_span == 1) {
-        m_left = m_right = objects[start];
+        m_left = objects[prims[start].index];
     }
-    else if (object_span == 2) {
-        m_left = objects[start];
-        m_right = objects[start + 1];
+    else if (object_span == 2 && mid == end) {
+        m_left = objects[prims[start].index];
+        m_right = objects[prims[start + 1].index];
     }
-    else {
-        std::sort(objects.begin() + start, 
-                objects.begin() + end, 
-                comparator);
+    else if (mid == end) {
+        auto leaf = std::make_shared<HittableList>();
+
+        for (size_t i = start; i < end; ++i) {
+            leaf->Add(objects[prims[i].index]);
+        }
 
-        size_t mid = start + object_span / 2;
-        m_left = std::make_shared<BVHNode>(objects, start, mid);
-        m_right = std::make_shared<BVHNode>(objects, mid, end);
+        m_left = leaf;
+    }
+    else {
+        m_left = std::shared_ptr<BVHNode>(
+                    new BVHNode(objects, prims, start, mid, method));
+        m_right = std::shared_ptr<BVHNode>(
+                    new BVHNode(objects, prims, mid, end, method));
     }
 }
 
@@ -45,61 +63,32 @@ bool BVHNode::Hit(const Ray& ray,
         return false;
     }
 
-    bool hit_left = m_left->Hit(ray, ray_t, rec);
-    bool hit_right = m_right->Hit(ray, 
-                    Interval(ray_t.GetMin(), hit_left ? rec.t : ray_t.GetMax()),
-                    rec);
-
-    return (hit_left || hit_right);
-}
-
-inline bool BVHNode::BoxCompare(const std::shared_ptr<Hittable>& a,
-                        const std::shared_ptr<Hittable>& b, 
-                        AABB::Axis axis_index) {
-    Interval a_axis = a->BoundingBox().AxisInterval(axis_index);
-    Interval b_axis = b->BoundingBox().AxisInterval(axis_index);
-
-    return (a_axis.GetMin() < b_axis.GetMin());
-}
+    if (!m_right) {
+        return m_left->Hit(ray, ray_t, rec);
+    }
 
-bool BVHNode::BoxCompareX(const std::shared_ptr<Hittable>& a,
-                        const std::shared_ptr<Hittable>& b) {
-    return BoxCompare(a, b, AABB::Axis::X);
-}
+    // Visit the child on the near side of the split first, the far child
+    // then only has to beat the closest hit found so far.
+    bool right_first = 
+            (ray.GetDirection()[static_cast<Vec3::Cord>(m_axis)] < 0.0);
+    const Hittable& near_child = right_first ? *m_right : *m_left;
+    const Hittable& far_child = right_first ? *m_left : *m_right;
 
-bool BVHNode::BoxCompareY(const std::shared_ptr<Hittable>& a,
-                        const std::shared_ptr<Hittable>& b) {
-    return BoxCompare(a, b, AABB::Axis::Y);
-}
+    bool hit_near = near_child.Hit(ray, ray_t, rec);
+    bool hit_far = far_child.Hit(ray, 
+                    Interval(ray_t.GetMin(), hit_near ? rec.t : ray_t.GetMax()),
+                    rec);
 
-bool BVHNode::BoxCompareZ(const std::shared_ptr<Hittable>& a,
-                        const std::shared_ptr<Hittable>& b) {
-    return BoxCompare(a, b, AABB::Axis::Z);
+    return (hit_near || hit_far);
 }
 
-inline std::function<bool(const std::shared_ptr<Hittable>&,
-                        const std::shared_ptr<Hittable>&)> 
-            BVHNode::ChoseCompare(AABB::Axis axis_index) {
-    using Axis = AABB::Axis;
-    
-    std::function<bool(const std::shared_ptr<Hittable>&,
-                    const std::shared_ptr<Hittable>&)> compare;
-
-    switch (axis_index) {
-        case Axis::X :
-            compare = &BoxCompareX;
-            break;
-        case Axis::Y :
-            compare = &BoxCompareY;
-            break;
-        case Axis::Z :
-            compare = &BoxCompareZ;
-            break;
-        default:
-            break;
+bool BVHNode::Occluded(const Ray& ray, const Interval& ray_t) const {
+    if (!m_bbox.Hit(ray, ray_t)) {
+        return false;
     }
 
-    return compare;
+    return (m_left->Occluded(ray, ray_t) || 
+            (m_right && m_right->Occluded(ray, ray_t)));
 }
 
-}
\ No newline at end of file
+}
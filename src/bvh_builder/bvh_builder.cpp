@@ -0,0 +1,661 @@
+#include <algorithm>
+#include <chrono>
+
+#include "bvh_builder.hpp"
+
+namespace RayTracing {
+
+std::vector<BVHPrimitive> BVHBuilder::MakePrimitives(
+                const std::vector<std::shared_ptr<Hittable>>& objects,
+                size_t start, size_t end) {
+    std::vector<BVHPrimitive> prims;
+    prims.reserve(end - start);
+
+    for (size_t object_index = start; object_index < end; ++object_index) {
+        BVHPrimitive prim;
+        prim.bbox = objects[object_index]->BoundingBox();
+        prim.centroid = prim.bbox.Centroid();
+        prim.index = object_index;
+
+        prims.push_back(prim);
+    }
+
+    return prims;
+}
+
+size_t BVHBuilder::Partition(std::vector<BVHPrimitive>& prims,
+                            size_t start, size_t end,
+                            SplitMethod method,
+                            AABB::Axis& axis) {
+    switch (method) {
+        case SplitMethod::MEDIAN:
+            return PartitionMedian(prims, start, end, axis);
+        case SplitMethod::MORTON:
+            return PartitionMorton(prims, start, end, axis);
+        default:
+            return PartitionSAH(prims, start, end, axis);
+    }
+}
+
+std::vector<BVHBuildNode> BVHBuilder::Build(std::vector<BVHPrimitive>& prims,
+                                            SplitMethod method,
+                                            BVHBuildStats *stats) {
+    if ((prims.size() >= PARALLEL_BUILD_SIZE) && 
+        (ThreadPool::HardwareThreads() > 1)) {
+        ThreadPool pool;
+
+        return BuildTree(prims, method, &pool, stats);
+    }
+
+    return BuildTree(prims, method, nullptr, stats);
+}
+
+std::vector<BVHBuildNode> BVHBuilder::Build(std::vector<BVHPrimitive>& prims,
+                                            SplitMethod method,
+                                            ThreadPool& pool,
+                                            BVHBuildStats *stats) {
+    return BuildTree(prims, method, &pool, stats);
+}
+
+double BVHBuilder::SAHCost(const std::vector<BVHBuildNode>& nodes) {
+    if (nodes.empty()) {
+        return 0.0;
+    }
+
+    double root_area = nodes[0].bbox.SurfaceArea();
+    double cost = 0.0;
+
+    for (const auto& node : nodes) {
+        double hit_probability = node.bbox.SurfaceArea() / root_area;
+
+        cost += hit_probability * ((node.prim_count > 0) ? 
+                                INTERSECT_COST * node.prim_count : 
+                                TRAVERSAL_COST);
+    }
+
+    return cost;
+}
+
+void BVHBuilder::SortMorton(std::vector<BVHPrimitive>& prims) {
+    constexpr uint32_t radix_bits = 10;
+    constexpr uint32_t radix = 1u << radix_bits;
+
+    AABB bounds = CentroidBounds(prims, 0, prims.size());
+
+    for (auto& prim : prims) {
+        prim.morton_code = MortonCode(prim.centroid, bounds);
+    }
+
+    // LSD radix sort of the 30 bit codes, stable and O(n)
+    std::vector<BVHPrimitive> sorted(prims.size());
+
+    for (uint32_t shift = 0; shift < 30; shift += radix_bits) {
+        size_t offsets[radix] = {};
+
+        for (const auto& prim : prims) {
+            ++offsets[(prim.morton_code >> shift) & (radix - 1)];
+        }
+
+        size_t sum = 0;
+        for (auto& offset : offsets) {
+            size_t count = offset;
+            offset = sum;
+            sum += count;
+        }
+
+        for (const auto& prim : prims) {
+            sorted[offsets[(prim.morton_code >> shift) & (radix - 1)]++] = prim;
+        }
+
+        prims.swap(sorted);
+    }
+}
+
+std::vector<BVHBuildNode> BVHBuilder::BuildTree(
+                                        std::vector<BVHPrimitive>& prims,
+                                        SplitMethod method,
+                                        ThreadPool *pool,
+                                        BVHBuildStats *stats) {
+    auto build_start = std::chrono::steady_clock::now();
+    std::vector<BVHBuildNode> nodes;
+
+    if (!prims.empty()) {
+        if (method == SplitMethod::MORTON) {
+            SortMorton(prims);
+        }
+
+        nodes.reserve(2 * prims.size());
+
+        if ((pool != nullptr) && (pool->GetNumThreads() > 1) &&
+            (prims.size() >= PARALLEL_BUILD_SIZE)) {
+            // The top of the tree is split on this thread until the ranges
+            // give every worker about 8 subtrees to build, work stealing 
+            // evens out their different sizes.
+            size_t subtree_size = std::max(static_cast<size_t>(1024), 
+                                    prims.size() / (8 * pool->GetNumThreads()));
+            std::vector<BVHBuildNode> top_nodes;
+            std::vector<Subtree> subtrees;
+
+            BuildTop(prims, 0, prims.size(), method, 0, subtree_size, 
+                    *pool, top_nodes, subtrees);
+
+            pool->ParallelFor(subtrees.size(), 
+                [&prims, method, &subtrees](size_t task, uint32_t) {
+                    Subtree& subtree = subtrees[task];
+
+                    BuildRecursive(prims, subtree.start, subtree.end, method, 
+                                subtree.depth, subtree.nodes);
+                });
+
+            Splice(top_nodes, 0, subtrees, nodes);
+        }
+        else {
+            BuildRecursive(prims, 0, prims.size(), method, 0, nodes);
+        }
+    }
+
+    if (stats != nullptr) {
+        std::chrono::duration<double, std::milli> build_time = 
+                                std::chrono::steady_clock::now() - build_start;
+
+        stats->build_ms = build_time.count();
+        stats->sah_cost = SAHCost(nodes);
+        stats->node_count = nodes.size();
+        stats->leaf_count = static_cast<size_t>(std::count_if(
+                            nodes.begin(), nodes.end(),
+                            [](const BVHBuildNode& node) {
+                                return (node.prim_count > 0);
+                            }));
+    }
+
+    return nodes;
+}
+
+// Same node layout as BuildRecursive, but ranges smaller than subtree_size
+// are left as placeholders for the pool. Bounds of the top nodes are only
+// known after Splice.
+size_t BVHBuilder::BuildTop(std::vector<BVHPrimitive>& prims,
+                            size_t start, size_t end,
+                            SplitMethod method,
+                            size_t depth,
+                            size_t subtree_size,
+                            ThreadPool& pool,
+                            std::vector<BVHBuildNode>& nodes,
+                            std::vector<Subtree>& subtrees) {
+    size_t node_index = nodes.size();
+    nodes.push_back(BVHBuildNode());
+
+    AABB::Axis axis = AABB::Axis::X;
+    size_t mid = end;
+
+    if ((end - start) >= subtree_size) {
+        mid = SplitNode(prims, start, end, method, depth, axis, &pool);
+    }
+
+    if (mid == end) {
+        Subtree subtree;
+        subtree.start = start;
+        subtree.end = end;
+        subtree.depth = depth;
+
+        BVHBuildNode& node = nodes[node_index];
+        node.bbox = AABB::EMPTY;
+        node.second_child = 0;
+        node.first_prim = subtrees.size();
+        node.prim_count = SUBTREE_PLACEHOLDER;
+        node.axis = axis;
+
+        subtrees.push_back(std::move(subtree));
+
+        return node_index;
+    }
+
+    BuildTop(prims, start, mid, method, depth + 1, subtree_size, 
+            pool, nodes, subtrees);
+    size_t second_child = BuildTop(prims, mid, end, method, depth + 1, 
+                                subtree_size, pool, nodes, subtrees);
+
+    BVHBuildNode& node = nodes[node_index];
+    node.bbox = AABB::EMPTY;
+    node.second_child = second_child;
+    node.first_prim = start;
+    node.prim_count = 0;
+    node.axis = axis;
+
+    return node_index;
+}
+
+// Copies the top nodes and the built subtrees into one depth-first array.
+size_t BVHBuilder::Splice(const std::vector<BVHBuildNode>& top_nodes,
+                        size_t top_index,
+                        std::vector<Subtree>& subtrees,
+                        std::vector<BVHBuildNode>& nodes) {
+    const BVHBuildNode& top_node = top_nodes[top_index];
+    size_t node_index = nodes.size();
+
+    if (top_node.prim_count == SUBTREE_PLACEHOLDER) {
+        Subtree& subtree = subtrees[top_node.first_prim];
+
+        for (BVHBuildNode node : subtree.nodes) {
+            if (node.prim_count == 0) {
+                node.second_child += node_index;
+            }
+
+            nodes.push_back(node);
+        }
+
+        subtree.nodes = std::vector<BVHBuildNode>();
+
+        return node_index;
+    }
+
+    nodes.push_back(top_node);
+    Splice(top_nodes, top_index + 1, subtrees, nodes);
+    size_t second_child = Splice(top_nodes, top_node.second_child, 
+                                subtrees, nodes);
+
+    BVHBuildNode& node = nodes[node_index];
+    node.bbox = AABB(nodes[node_index + 1].bbox, nodes[second_child].bbox);
+    node.second_child = second_child;
+
+    return node_index;
+}
+
+size_t BVHBuilder::SplitNode(std::vector<BVHPrimitive>& prims,
+                            size_t start, size_t end,
+                            SplitMethod method,
+                            size_t depth,
+                            AABB::Axis& axis,
+                            ThreadPool *pool) {
+    if (depth < BALANCED_DEPTH) {
+        return ((method == SplitMethod::SAH) ? 
+                PartitionSAH(prims, start, end, axis, pool) :
+                Partition(prims, start, end, method, axis));
+    }
+
+    if ((end - start) > MAX_LEAF_SIZE) {
+        axis = CentroidBounds(prims, start, end).LongestAxis();
+
+        return PartitionCentroidMedian(prims, start, end, axis);
+    }
+
+    return end;
+}
+
+size_t BVHBuilder::BuildRecursive(std::vector<BVHPrimitive>& prims,
+                                size_t start, size_t end,
+                                SplitMethod method,
+                                size_t depth,
+                                std::vector<BVHBuildNode>& nodes) {
+    size_t node_index = nodes.size();
+    nodes.push_back(BVHBuildNode());
+
+    AABB bbox = Bounds(prims, start, end);
+    AABB::Axis axis = AABB::Axis::X;
+    size_t mid = SplitNode(prims, start, end, method, depth, axis, nullptr);
+
+    size_t second_child = 0;
+    size_t prim_count = 0;
+
+    if (mid == end) {
+        prim_count = end - start;
+    }
+    else {
+        BuildRecursive(prims, start, mid, method, depth + 1, nodes);
+        second_child = BuildRecursive(prims, mid, end, method, 
+                                    depth + 1, nodes);
+    }
+
+    BVHBuildNode& node = nodes[node_index];
+    node.bbox = bbox;
+    node.second_child = second_child;
+    node.first_prim = start;
+    node.prim_count = prim_count;
+    node.axis = axis;
+
+    return node_index;
+}
+
+AABB BVHBuilder::Bounds(const std::vector<BVHPrimitive>& prims,
+                        size_t start, size_t end) {
+    AABB bounds = AABB::EMPTY;
+
+    for (size_t i = start; i < end; ++i) {
+        bounds = AABB(bounds, prims[i].bbox);
+    }
+
+    return bounds;
+}
+
+AABB BVHBuilder::CentroidBounds(const std::vector<BVHPrimitive>& prims,
+                                size_t start, size_t end) {
+    Point3 min, max;
+    CentroidExtent(prims, start, end, min, max);
+
+    return AABB(Interval(min.GetX(), max.GetX()),
+                Interval(min.GetY(), max.GetY()),
+                Interval(min.GetZ(), max.GetZ()));
+}
+
+void BVHBuilder::CentroidExtent(const std::vector<BVHPrimitive>& prims,
+                                size_t start, size_t end,
+                                Point3& min, Point3& max) {
+    min = Point3(INF, INF, INF);
+    max = Point3(-INF, -INF, -INF);
+
+    for (size_t i = start; i < end; ++i) {
+        for (unsigned int c = 0; c < Vec3::Cord::NUM_OF_DIM; ++c) {
+            auto cord = static_cast<Vec3::Cord>(c);
+            min[cord] = std::fmin(min[cord], prims[i].centroid[cord]);
+            max[cord] = std::fmax(max[cord], prims[i].centroid[cord]);
+        }
+    }
+}
+
+void BVHBuilder::ForEachChunk(size_t start, size_t end,
+                            size_t num_chunks,
+                            ThreadPool *pool,
+                            const std::function<void(size_t chunk, 
+                                                    size_t chunk_start,
+                                                    size_t chunk_end)>& func) {
+    size_t count = end - start;
+    auto run_chunk = [start, count, num_chunks, &func](size_t chunk, uint32_t) {
+        func(chunk, 
+            start + (chunk * count) / num_chunks, 
+            start + ((chunk + 1) * count) / num_chunks);
+    };
+
+    if (pool != nullptr) {
+        pool->ParallelFor(num_chunks, run_chunk);
+    }
+    else {
+        for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+            run_chunk(chunk, 0);
+        }
+    }
+}
+
+size_t BVHBuilder::BinIndex(double cord, const Interval& extent) {
+    if (extent.Size() <= 0.0) {
+        return 0;
+    }
+
+    double offset = (cord - extent.GetMin()) * (SAH_BINS / extent.Size());
+
+    return std::min(SAH_BINS - 1, static_cast<size_t>(offset));
+}
+
+void BVHBuilder::BinPrimitives(const std::vector<BVHPrimitive>& prims,
+                            size_t start, size_t end,
+                            const AABB& centroid_bounds,
+                            SAHBins& bins) {
+    for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+        for (auto& bin : bins.bins[axis]) {
+            bin.bbox = AABB::EMPTY;
+            bin.count = 0;
+        }
+    }
+
+    for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+        Interval extent = centroid_bounds.AxisInterval(
+                                        static_cast<AABB::Axis>(axis));
+        auto cord = static_cast<Vec3::Cord>(axis);
+
+        for (size_t i = start; i < end; ++i) {
+            SAHBin& bin = bins.bins[axis][BinIndex(prims[i].centroid[cord], 
+                                                extent)];
+
+            ++bin.count;
+            bin.bbox = AABB(bin.bbox, prims[i].bbox);
+        }
+    }
+}
+
+// Binned surface area heuristic: the centroids are dropped into SAH_BINS
+// buckets per axis and only the bucket boundaries are evaluated as split
+// candidates, which keeps every level O(n). Large ranges are binned in 
+// chunks on the pool and the chunk bins merged.
+size_t BVHBuilder::PartitionSAH(std::vector<BVHPrimitive>& prims,
+                                size_t start, size_t end,
+                                AABB::Axis& split_axis,
+                                ThreadPool *pool) {
+    size_t count = end - start;
+
+    if (count <= 1) {
+        return end;
+    }
+
+    if (count < PARALLEL_BIN_SIZE) {
+        pool = nullptr;
+    }
+
+    size_t num_chunks = (pool != nullptr) ? 4 * pool->GetNumThreads() : 1;
+    std::vector<Point3> chunk_min(num_chunks), chunk_max(num_chunks);
+
+    ForEachChunk(start, end, num_chunks, pool,
+        [&prims, &chunk_min, &chunk_max](size_t chunk, 
+                                        size_t chunk_start, size_t chunk_end) {
+            CentroidExtent(prims, chunk_start, chunk_end, 
+                        chunk_min[chunk], chunk_max[chunk]);
+        });
+
+    Point3 centroid_min = chunk_min[0];
+    Point3 centroid_max = chunk_max[0];
+
+    for (size_t chunk = 1; chunk < num_chunks; ++chunk) {
+        for (unsigned int c = 0; c < Vec3::Cord::NUM_OF_DIM; ++c) {
+            auto cord = static_cast<Vec3::Cord>(c);
+            centroid_min[cord] = std::fmin(centroid_min[cord], 
+                                        chunk_min[chunk][cord]);
+            centroid_max[cord] = std::fmax(centroid_max[cord], 
+                                        chunk_max[chunk][cord]);
+        }
+    }
+
+    AABB centroid_bounds(Interval(centroid_min.GetX(), centroid_max.GetX()),
+                        Interval(centroid_min.GetY(), centroid_max.GetY()),
+                        Interval(centroid_min.GetZ(), centroid_max.GetZ()));
+
+    std::vector<SAHBins> chunk_bins(num_chunks);
+
+    ForEachChunk(start, end, num_chunks, pool,
+        [&prims, &centroid_bounds, &chunk_bins](size_t chunk, 
+                                        size_t chunk_start, size_t chunk_end) {
+            BinPrimitives(prims, chunk_start, chunk_end, 
+                        centroid_bounds, chunk_bins[chunk]);
+        });
+
+    SAHBins& all_bins = chunk_bins[0];
+
+    for (size_t chunk = 1; chunk < num_chunks; ++chunk) {
+        for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+            for (size_t b = 0; b < SAH_BINS; ++b) {
+                SAHBin& bin = all_bins.bins[axis][b];
+                const SAHBin& chunk_bin = chunk_bins[chunk].bins[axis][b];
+
+                bin.bbox = AABB(bin.bbox, chunk_bin.bbox);
+                bin.count += chunk_bin.count;
+            }
+        }
+    }
+
+    // every primitive is in one bin per axis
+    AABB parent_bbox = AABB::EMPTY;
+    for (const auto& bin : all_bins.bins[0]) {
+        parent_bbox = AABB(parent_bbox, bin.bbox);
+    }
+
+    double parent_area = parent_bbox.SurfaceArea();
+    double best_cost = INF;
+    unsigned int best_axis = AABB::Axis::NUM_OF_AXIS;
+    size_t best_split = 0;
+
+    for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+        const SAHBin *bins = all_bins.bins[axis];
+
+        // right_area[s], right_count[s] describe bins [s, SAH_BINS)
+        double right_area[SAH_BINS];
+        size_t right_count[SAH_BINS];
+        AABB right_bbox = AABB::EMPTY;
+        size_t right_total = 0;
+
+        for (size_t b = SAH_BINS - 1; b > 0; --b) {
+            right_bbox = AABB(right_bbox, bins[b].bbox);
+            right_total += bins[b].count;
+            right_area[b] = (right_total > 0) ? right_bbox.SurfaceArea() : 0.0;
+            right_count[b] = right_total;
+        }
+
+        AABB left_bbox = AABB::EMPTY;
+        size_t left_total = 0;
+
+        for (size_t split = 1; split < SAH_BINS; ++split) {
+            left_bbox = AABB(left_bbox, bins[split - 1].bbox);
+            left_total += bins[split - 1].count;
+
+            if ((left_total == 0) || (right_count[split] == 0)) {
+                continue;
+            }
+
+            double cost = TRAVERSAL_COST + INTERSECT_COST *
+                        (left_total * left_bbox.SurfaceArea() +
+                        right_count[split] * right_area[split]) / parent_area;
+
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_axis = axis;
+                best_split = split;
+            }
+        }
+    }
+
+    if (best_axis == AABB::Axis::NUM_OF_AXIS) {
+        // all centroids fell into the same bin on every axis
+        split_axis = centroid_bounds.LongestAxis();
+
+        return ((count <= MAX_LEAF_SIZE) ? end :
+                PartitionCentroidMedian(prims, start, end, split_axis));
+    }
+
+    if ((count <= MAX_LEAF_SIZE) && (best_cost >= INTERSECT_COST * count)) {
+        return end;
+    }
+
+    split_axis = static_cast<AABB::Axis>(best_axis);
+
+    Interval extent = centroid_bounds.AxisInterval(split_axis);
+    auto cord = static_cast<Vec3::Cord>(best_axis);
+
+    auto mid = std::partition(prims.begin() + start, prims.begin() + end,
+        [cord, &extent, best_split](const BVHPrimitive& prim) {
+            return (BinIndex(prim.centroid[cord], extent) < best_split);
+        });
+
+    return static_cast<size_t>(mid - prims.begin());
+}
+
+// Object median along the longest axis of the node bounds.
+size_t BVHBuilder::PartitionMedian(std::vector<BVHPrimitive>& prims,
+                                size_t start, size_t end,
+                                AABB::Axis& axis) {
+    size_t count = end - start;
+
+    if (count <= 2) {
+        return end;
+    }
+
+    axis = Bounds(prims, start, end).LongestAxis();
+    size_t mid = start + count / 2;
+
+    std::nth_element(prims.begin() + start,
+                    prims.begin() + mid,
+                    prims.begin() + end,
+                    [axis](const BVHPrimitive& a, const BVHPrimitive& b) {
+                        return (a.bbox.AxisInterval(axis).GetMin() <
+                                b.bbox.AxisInterval(axis).GetMin());
+                    });
+
+    return mid;
+}
+
+size_t BVHBuilder::PartitionCentroidMedian(std::vector<BVHPrimitive>& prims,
+                                        size_t start, size_t end,
+                                        AABB::Axis axis) {
+    auto cord = static_cast<Vec3::Cord>(axis);
+    size_t mid = start + (end - start) / 2;
+
+    std::nth_element(prims.begin() + start,
+                    prims.begin() + mid,
+                    prims.begin() + end,
+                    [cord](const BVHPrimitive& a, const BVHPrimitive& b) {
+                        return (a.centroid[cord] < b.centroid[cord]);
+                    });
+
+    return mid;
+}
+
+// Prims are sorted by Morton code, so the split of a range is where the
+// highest bit that differs between its first and last code flips to 1.
+size_t BVHBuilder::PartitionMorton(std::vector<BVHPrimitive>& prims,
+                                size_t start, size_t end,
+                                AABB::Axis& axis) {
+    if ((end - start) <= MAX_LEAF_SIZE) {
+        return end;
+    }
+
+    uint32_t first_code = prims[start].morton_code;
+    uint32_t last_code = prims[end - 1].morton_code;
+
+    if (first_code == last_code) {
+        axis = CentroidBounds(prims, start, end).LongestAxis();
+
+        return PartitionCentroidMedian(prims, start, end, axis);
+    }
+
+    uint32_t bit = 0;
+    for (uint32_t diff = first_code ^ last_code; diff > 1; diff >>= 1) {
+        ++bit;
+    }
+
+    uint32_t mask = 1u << bit;
+    auto mid = std::partition_point(prims.begin() + start, 
+                                    prims.begin() + end,
+                                    [mask](const BVHPrimitive& prim) {
+                                        return !(prim.morton_code & mask);
+                                    });
+
+    // bits 3i + 2, 3i + 1, 3i hold x, y, z
+    axis = static_cast<AABB::Axis>(2 - bit % 3);
+
+    return static_cast<size_t>(mid - prims.begin());
+}
+
+// 30 bit code, 10 bits per axis of the position inside bounds.
+uint32_t BVHBuilder::MortonCode(const Point3& p, const AABB& bounds) {
+    uint32_t code = 0;
+
+    for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+        Interval extent = bounds.AxisInterval(static_cast<AABB::Axis>(axis));
+        double offset = (extent.Size() > 0.0) ? 
+                        (p[static_cast<Vec3::Cord>(axis)] - extent.GetMin()) / 
+                        extent.Size() : 0.0;
+        uint32_t cell = static_cast<uint32_t>(
+                        std::fmin(std::fmax(offset * 1024.0, 0.0), 1023.0));
+
+        code |= ExpandBits(cell) << (2 - axis);
+    }
+
+    return code;
+}
+
+// Spreads the lower 10 bits of v out to every third bit.
+uint32_t BVHBuilder::ExpandBits(uint32_t v) {
+    v = (v * 0x00010001u) & 0xFF0000FFu;
+    v = (v * 0x00000101u) & 0x0F00F00Fu;
+    v = (v * 0x00000011u) & 0xC30C30C3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+
+    return v;
+}
+
+}
@@ -1,80 +1,349 @@
 
-#include <future>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include "camera.hpp"
 #include "utils.hpp"
-#include "hittable_pdf.hpp"
-#include "cosine_pdf.hpp"
-#include "mixture_pdf.hpp"
+#include "path_vertex.hpp"
+#include "thread_pool.hpp"
 
 namespace RayTracing {
 
+constexpr size_t Camera::WAVEFRONT_BATCH_SIZE;
+constexpr uint32_t Camera::BUDGET_PASS_SIZE;
+
 void Camera::Render(const Hittable& world, const Hittable& lights) {
+    Render(world, lights, false);
+}
+
+// Renders passes of m_pass_size samples into the accumulator until every
+// pixel has m_target_samples samples (or converged, with adaptive 
+// sampling) or the time budget runs out, writing snapshots of the image
+// (and the checkpoint) along the way.
+void Camera::Render(const Hittable& world, const Hittable& lights, bool parallel) {
     Initialize();
 
-    std::cout << "P3\n" << m_image_width << ' ' << m_image_height << "\n255\n";
+    if (!m_checkpoint_file.empty()) {
+        ResumeFromCheckpoint();
+    }
 
-    for (size_t j = 0; j < m_image_height; ++j) {
-        std::clog << "\rScanlines remaining: " << 
-        (m_image_height - j) << ' ' << std::flush;
-        
-        for (size_t i = 0; i < m_image_width; ++i) {
-            Color pixel_color(0.0, 0.0, 0.0);
+    std::unique_ptr<ThreadPool> pool(parallel ? 
+                                    new ThreadPool(m_num_threads) : nullptr);
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline = (m_time_budget > 0.0) ? 
+                            (start + std::chrono::duration_cast<Clock::duration>(
+                                std::chrono::duration<double>(m_time_budget))) :
+                            Clock::time_point::max();
+    Clock::time_point last_snapshot = start;
+    bool budget_reached = false;
+
+    std::clog << "Rendering " << m_image_width << 'x' << m_image_height 
+            << " in passes of " << m_pass_size << " spp on " 
+            << (pool ? pool->GetNumThreads() : 1) << " threads\n";
+
+    size_t num_pixels = static_cast<size_t>(m_image_width) * m_image_height;
+    std::vector<WavefrontIntegrator> integrators;
+
+    if (m_integrator == Integrator::WAVEFRONT) {
+        size_t num_workers = pool ? pool->GetNumThreads() : 1;
+        integrators.reserve(num_workers);
+
+        for (size_t worker = 0; worker < num_workers; ++worker) {
+            integrators.emplace_back(*m_sampler, world, lights, m_background,
+                                    m_max_depth, m_roulette_depth,
+                                    m_cone_spread);
+            integrators.back().Reserve(std::max<size_t>(WAVEFRONT_BATCH_SIZE,
+                                                        m_pass_size));
+        }
+    }
+
+    for (uint32_t pass = 1; UpdateActivePixels() > 0; ++pass) {
+        bool finished = RenderPass(world, lights, pool.get(), deadline, 
+                                integrators);
+        Clock::time_point now = Clock::now();
+
+        std::clog << "\rPass " << pass << ": " 
+                << static_cast<double>(m_accumulator.GetTotalSampleCount()) / 
+                    num_pixels << " spp average, "
+                << std::chrono::duration<double>(now - start).count() 
+                << " s        " << std::flush;
+
+        if (!finished || (now >= deadline)) {
+            std::clog << "\nTime budget of " << m_time_budget 
+                    << " s reached\n";
+            budget_reached = true;
+            break;
+        }
 
-            for (int s_j = 0; s_j < m_sqrt_spp; ++s_j) {
-                for (int s_i = 0; s_i < m_sqrt_spp; ++s_i) {
-                    Ray r = GetRay(i, j, s_i, s_j);
-                    pixel_color += RayColor(r, m_max_depth, world, lights);
+        if ((m_pass_samples > 0) && 
+            (std::chrono::duration<double>(now - last_snapshot).count() >= 
+            m_snapshot_interval)) {
+            WriteSnapshot();
+            last_snapshot = now;
+        }
+    }
+
+    if (!budget_reached) {
+        std::clog << "\rDone.                 \n";
+    }
+
+    WriteSnapshot();
+}
+
+// Marks the pixels the next pass renders: those short of the target spp
+// and, with adaptive sampling, not yet converged. The error of a pixel is
+// the largest one of its 3x3 neighbourhood, so isolated noisy pixels 
+// that happen to look converged are not left behind.
+// Returns the number of active pixels.
+size_t Camera::UpdateActivePixels() {
+    size_t num_pixels = static_cast<size_t>(m_image_width) * m_image_height;
+    bool adaptive = (m_adaptive_max_error > 0.0);
+    std::vector<double> errors;
+
+    if (adaptive) {
+        errors.resize(num_pixels);
+
+        for (uint32_t j = 0; j < m_image_height; ++j) {
+            for (uint32_t i = 0; i < m_image_width; ++i) {
+                errors[static_cast<size_t>(j) * m_image_width + i] = 
+                                        m_accumulator.GetRelativeError(i, j);
+            }
+        }
+    }
+
+    m_active_pixels.assign(num_pixels, 0);
+    size_t num_active = 0;
+
+    for (uint32_t j = 0; j < m_image_height; ++j) {
+        for (uint32_t i = 0; i < m_image_width; ++i) {
+            uint32_t sample_count = m_accumulator.GetSampleCount(i, j);
+            bool active = (sample_count < m_target_samples);
+
+            if (active && adaptive && 
+                (sample_count >= m_adaptive_min_samples)) {
+                double error = 0.0;
+                uint32_t y0 = (j > 0) ? (j - 1) : 0;
+                uint32_t y1 = std::min(j + 2, m_image_height);
+                uint32_t x0 = (i > 0) ? (i - 1) : 0;
+                uint32_t x1 = std::min(i + 2, m_image_width);
+
+                for (uint32_t y = y0; y < y1; ++y) {
+                    for (uint32_t x = x0; x < x1; ++x) {
+                        error = std::fmax(error, 
+                                errors[static_cast<size_t>(y) * m_image_width + x]);
+                    }
                 }
+
+                active = (error > m_adaptive_max_error);
             }
 
-            WriteColor(std::cout, 
-                Color(m_pixel_samples_scale * static_cast<Vec3>(pixel_color)));
+            m_active_pixels[static_cast<size_t>(j) * m_image_width + i] = active;
+            num_active += active;
         }
     }
 
-    std::clog << "\rDone.                 \n";
+    return num_active;
 }
 
-void Camera::Render(const Hittable& world, const Hittable& lights, bool parallel) {
-    Initialize();
+uint32_t Camera::PassSamples(uint32_t sample_count) const {
+    return ((sample_count < m_target_samples) ?
+            std::min(m_pass_size, m_target_samples - sample_count) : 0);
+}
 
-    std::vector<std::future<Color>> futers(m_image_height * m_image_width);
+// Adds one pass to every active pixel. Tiles starting after the deadline 
+// are skipped, returns false if that happened.
+bool Camera::RenderPass(const Hittable& world, const Hittable& lights,
+                        ThreadPool *pool, Clock::time_point deadline,
+                        std::vector<WavefrontIntegrator>& integrators) {
+    uint32_t tiles_x = (m_image_width + m_tile_size - 1) / m_tile_size;
+    uint32_t tiles_y = (m_image_height + m_tile_size - 1) / m_tile_size;
+    size_t num_tiles = static_cast<size_t>(tiles_x) * tiles_y;
+
+    std::atomic<size_t> tiles_remaining(num_tiles);
+    std::atomic<bool> finished(true);
+    std::mutex log_lock;
+
+    auto render_tile = [this, &world, &lights, &integrators, &tiles_remaining,
+                        &finished, &log_lock, tiles_x, deadline]
+                        (size_t tile, uint32_t worker) {
+        if (Clock::now() >= deadline) {
+            finished = false;
+
+            return;
+        }
 
-    std::cout << "P3\n" << m_image_width << ' ' << m_image_height << "\n255\n";
+        uint32_t x0 = static_cast<uint32_t>(tile % tiles_x) * m_tile_size;
+        uint32_t y0 = static_cast<uint32_t>(tile / tiles_x) * m_tile_size;
+        uint32_t x1 = std::min(x0 + m_tile_size, m_image_width);
+        uint32_t y1 = std::min(y0 + m_tile_size, m_image_height);
 
-    for (size_t j = 0; j < m_image_height; ++j) {
-        std::clog << "\rScanlines remaining: " << 
-        (m_image_height - j) << ' ' << std::flush;
-        
-        for (size_t i = 0; i < m_image_width; ++i) {
-            futers[j * m_image_width + i] = std::async(
-                [this, &world, &lights](size_t j, size_t i) {
-                Color pixel_color(0.0, 0.0, 0.0);
-
-                for (int s_j = 0; s_j < m_sqrt_spp; ++s_j) {
-                    for (int s_i = 0; s_i < m_sqrt_spp; ++s_i) {
-                        Ray r = GetRay(i, j, s_i, s_j);
-                        pixel_color += RayColor(r, m_max_depth, world, lights);
-                    }
-                }
+        if (integrators.empty()) {
+            RenderTile(x0, y0, x1, y1, world, lights);
+        }
+        else {
+            RenderTileWavefront(x0, y0, x1, y1, integrators[worker]);
+        }
 
-                return pixel_color;
-            }, j, i);
+        // a pass of the whole image is only worth a progress line
+        // when it is the only one
+        if (m_pass_size >= m_target_samples) {
+            size_t remaining = --tiles_remaining;
+            std::lock_guard<std::mutex> guard(log_lock);
+            std::clog << "\rTiles remaining: " << remaining << ' ' << std::flush;
         }
+    };
+
+    if (pool != nullptr) {
+        pool->ParallelFor(num_tiles, render_tile);
     }
-    
-    for (auto& f : futers) {
-        Color pixel = f.get();
+    else {
+        for (size_t tile = 0; tile < num_tiles; ++tile) {
+            render_tile(tile, 0);
+        }
+    }
+
+    return finished;
+}
+
+// Adds one pass to the active pixels of the tile [x0, x1) x [y0, y1).
+void Camera::RenderTile(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1,
+                        const Hittable& world, const Hittable& lights) {
+    for (uint32_t j = y0; j < y1; ++j) {
+        for (uint32_t i = x0; i < x1; ++i) {
+            if (!m_active_pixels[static_cast<size_t>(j) * m_image_width + i]) {
+                continue;
+            }
 
-        WriteColor(std::cout, 
-                Color(m_pixel_samples_scale * static_cast<Vec3>(pixel)));
+            uint32_t sample_count = m_accumulator.GetSampleCount(i, j);
+            uint32_t num_samples = PassSamples(sample_count);
+            double luminance_squares = 0.0;
+            Color pixel_color = RenderPixel(i, j, sample_count, num_samples,
+                                            world, lights, 
+                                            luminance_squares);
+
+            m_accumulator.AddSamples(i, j, pixel_color, luminance_squares,
+                                    num_samples);
+        }
+    }
+}
+
+// Same as RenderTile with the samples of the tile traced by the wavefront
+// integrator. Camera rays are generated exactly like in RenderPixel, 
+// batches always hold all samples of their pixels.
+void Camera::RenderTileWavefront(uint32_t x0, uint32_t y0, 
+                                uint32_t x1, uint32_t y1,
+                                WavefrontIntegrator& integrator) {
+    RNG rng;
+    integrator.Clear();
+
+    for (uint32_t j = y0; j < y1; ++j) {
+        for (uint32_t i = x0; i < x1; ++i) {
+            if (!m_active_pixels[static_cast<size_t>(j) * m_image_width + i]) {
+                continue;
+            }
+
+            if ((integrator.GetPathCount() > 0) && 
+                (integrator.GetPathCount() + m_pass_size > 
+                WAVEFRONT_BATCH_SIZE)) {
+                integrator.Trace();
+                AccumulateWavefront(integrator);
+                integrator.Clear();
+            }
+
+            uint32_t first_sample = m_accumulator.GetSampleCount(i, j);
+            uint32_t num_samples = PassSamples(first_sample);
+            uint64_t pixel_index = static_cast<uint64_t>(j) * m_image_width + i;
+
+            for (uint32_t s = 0; s < num_samples; ++s) {
+                PixelSample sample = {i, j, first_sample + s, m_frame};
+                SampleSequence sequence(*m_sampler, sample);
+                rng.Seed(RNG::Hash(pixel_index, sample.index, m_frame));
+
+                Ray r = GetRay(i, j, sequence);
+                integrator.AddPath(r, sequence, rng);
+            }
+        }
     }
 
-    std::clog << "\rDone.                 \n";
+    integrator.Trace();
+    AccumulateWavefront(integrator);
 }
 
+// Adds the traced paths of a batch to the accumulator, the samples of a
+// pixel are consecutive and summed in the order RenderPixel sums them.
+// Pixels are accumulated after their batch is traced, so their sample
+// counts still tell how many paths they added.
+void Camera::AccumulateWavefront(const WavefrontIntegrator& integrator) {
+    size_t num_paths = integrator.GetPathCount();
+    uint32_t num_samples = 0;
+
+    for (size_t first = 0; first < num_paths; first += num_samples) {
+        const PixelSample& sample = integrator.GetSample(first);
+        Color pixel_color(0.0, 0.0, 0.0);
+        double luminance_squares = 0.0;
+
+        num_samples = PassSamples(m_accumulator.GetSampleCount(sample.x,
+                                                            sample.y));
+
+        for (size_t path = first; path < first + num_samples; ++path) {
+            Color sample_color = integrator.GetRadiance(path);
+            double luminance = sample_color.Luminance();
+
+            pixel_color += sample_color;
+            luminance_squares += luminance * luminance;
+        }
+
+        m_accumulator.AddSamples(sample.x, sample.y, pixel_color, 
+                                luminance_squares, num_samples);
+    }
+}
+
+void Camera::ResumeFromCheckpoint() {
+    Accumulator checkpoint;
+
+    if (!checkpoint.Load(m_checkpoint_file)) {
+        return;
+    }
+
+    if ((checkpoint.GetWidth() != m_image_width) || 
+        (checkpoint.GetHeight() != m_image_height)) {
+        std::cerr << "ERROR: checkpoint '" << m_checkpoint_file << "' is " 
+                << checkpoint.GetWidth() << 'x' << checkpoint.GetHeight() 
+                << ", the image is " << m_image_width << 'x' 
+                << m_image_height << ", starting over\n";
+
+        return;
+    }
+
+    m_accumulator = checkpoint;
+
+    std::clog << "Resuming from '" << m_checkpoint_file << "' with " 
+            << m_accumulator.GetMinSampleCount() << " spp\n";
+}
+
+void Camera::WriteSnapshot() {
+    m_accumulator.Resolve(m_framebuffer);
+
+    WriteImage();
+
+    if (!m_sample_map_file.empty()) {
+        Framebuffer sample_map;
+        m_accumulator.ResolveSampleCounts(sample_map, m_target_samples);
+
+        if (!sample_map.Write(m_sample_map_file)) {
+            std::cerr << "ERROR: could not write image file '" 
+                    << m_sample_map_file << "'\n";
+        }
+    }
+
+    if (!m_checkpoint_file.empty() && !m_accumulator.Save(m_checkpoint_file)) {
+        std::cerr << "ERROR: could not write checkpoint file '" 
+                << m_checkpoint_file << "'\n";
+    }
+}
 
 // void Camera::Render(const Hittable& world, bool parallel) {
 //     Initialize();
@@ -117,10 +386,18 @@ void Camera::Render(const Hittable& world, const Hittable& lights, bool parallel
 void Camera::Initialize() {
     m_image_height = static_cast<uint32_t>(m_image_width / m_aspect_ratio);
     m_image_height = (m_image_height < 1) ? 1 : m_image_height;
-
-    m_sqrt_spp = static_cast<uint32_t>(std::sqrt(m_samples_per_pixel));
-    m_pixel_samples_scale = 1.0 / (m_sqrt_spp * m_sqrt_spp);
-    m_recip_sqrt_spp = 1.0 / m_sqrt_spp;
+    m_framebuffer.Resize(m_image_width, m_image_height);
+    m_accumulator.Resize(m_image_width, m_image_height);
+
+    // adaptive sampling and time budgets need passes even if no pass size
+    // was set, a single pass would leave the tiles after the deadline black
+    uint32_t pass_samples = (m_pass_samples > 0) ? m_pass_samples : 
+                            (m_adaptive_max_error > 0.0) ? 
+                            m_adaptive_min_samples : 
+                            (m_time_budget > 0.0) ? 
+                            BUDGET_PASS_SIZE : m_samples_per_pixel;
+    m_pass_size = std::max(std::min(pass_samples, m_samples_per_pixel), 1u);
+    m_target_samples = std::max(m_samples_per_pixel, 1u);
     
     m_center = m_look_from;
     
@@ -139,6 +416,7 @@ void Camera::Initialize() {
 
     m_pixel_delta_u = viewport_u / m_image_width;
     m_pixel_delta_v = viewport_v / m_image_height;
+    m_cone_spread = viewport_hight / (m_image_height * m_focus_dist);
 
     Vec3 viewport_upper_left = m_center - (m_focus_dist * m_w) -
                             viewport_u / 2 - viewport_v / 2;
@@ -152,51 +430,90 @@ void Camera::Initialize() {
 
 }
 
-Color Camera::RayColor(const Ray& ray, 
-                    uint32_t depth, 
-                    const Hittable& world, 
-                    const Hittable& lights) const {
-    if (depth == 0) {
-        return Color(0.0, 0.0, 0.0);
+void Camera::WriteImage() const {
+    if (m_output_file.empty()) {
+        return;
     }
-    
-    HitRecord rec;
 
-    // Interval min = 0.001 - Fixing shadow acne
-    if (!world.Hit(ray, Interval(0.001, RayTracing::INF), rec)) {
-        return m_background;
-    }
-    
-    ScatterRecord srec;
-    Color color_from_emission = 
-            rec.mat->Emitted(ray, rec, rec.u, rec.v, rec.point);
-    
-    if (!rec.mat->Scatter(ray, rec, srec)) {
-        return color_from_emission;
+    if (!m_framebuffer.Write(m_output_file)) {
+        std::cerr << "ERROR: could not write image file '" 
+                << m_output_file << "'\n";
     }
+}
 
-    if (srec.skip_pdf) {
-        Vec3 attenuation(srec.attenuation);
-        Vec3 ray_color(RayColor(srec.skip_pdf_ray, depth - 1, world, lights));
-        
-        return Color(attenuation * ray_color); 
+// Sum of num_samples samples of pixel i, j, numbered on from first_sample.
+// The squared luminances of the samples are summed up in luminance_squares.
+// The sampler's numbers only depend on (pixel, sample, frame) and every 
+// sample reseeds the thread's generator (still used by the materials) from
+// them, so the image does not depend on the number of threads, the tile
+// order or where a resumed render was stopped.
+Color Camera::RenderPixel(uint32_t i, uint32_t j,
+                        uint32_t first_sample,
+                        uint32_t num_samples,
+                        const Hittable& world,
+                        const Hittable& lights,
+                        double& luminance_squares) const {
+    Color pixel_color(0.0, 0.0, 0.0);
+    RNG& rng = ThreadRNG();
+    uint64_t pixel_index = static_cast<uint64_t>(j) * m_image_width + i;
+
+    for (uint32_t s = 0; s < num_samples; ++s) {
+        PixelSample sample = {i, j, first_sample + s, m_frame};
+        SampleSequence sequence(*m_sampler, sample);
+        rng.Seed(RNG::Hash(pixel_index, sample.index, m_frame));
+
+        Ray r = GetRay(i, j, sequence);
+        Color sample_color = RayColor(r, world, lights, sequence, rng);
+        double luminance = sample_color.Luminance();
+
+        pixel_color += sample_color;
+        luminance_squares += luminance * luminance;
     }
 
-    auto light_ptr = std::make_shared<HittablePDF>(lights, rec.point);
-    MixturePDF mixed_pdf(light_ptr, srec.pdf_ptr);
+    return pixel_color;
+}
+
+// Iterative path tracer: throughput is the product of the 
+// attenuation * scattering pdf / pdf factors along the path so far, 
+// every emission found is weighted by it (see ShadePathVertex). The light
+// sample of a vertex is traced before the path goes on.
+Color Camera::RayColor(const Ray& ray, 
+                    const Hittable& world, 
+                    const Hittable& lights,
+                    SampleSequence& sequence,
+                    RNG& rng) const {
+    Vec3 radiance(0.0, 0.0, 0.0);
+    Vec3 throughput(1.0, 1.0, 1.0);
+    PathState state = {1.0, 0.0, 0.0, m_cone_spread};
+    Ray current_ray = ray;
+
+    for (uint32_t depth = 0; depth < m_max_depth; ++depth) {
+        HitRecord rec;
+
+        // Interval min = 0.001 - Fixing shadow acne
+        if (!world.Hit(current_ray, Interval(0.001, RayTracing::INF), rec)) {
+            radiance += PowerHeuristic(state.bsdf_pdf, state.light_pdf) *
+                        throughput * static_cast<Vec3>(m_background);
+            break;
+        }
+
+        ShadowRay shadow;
+        bool has_shadow = false;
+        bool alive = ShadePathVertex(current_ray, rec, lights, depth, 
+                                    m_roulette_depth, sequence, rng, 
+                                    radiance, throughput, state, 
+                                    current_ray, shadow, has_shadow);
 
-    Ray scattered = Ray(rec.point, mixed_pdf.Generate(), ray.GetTime());
-    double pdf_value = mixed_pdf.Value(scattered.GetDirection());
+        if (has_shadow) {
+            TraceShadowRay(world, m_background, shadow, radiance);
+        }
 
-    double scattering_pdf = rec.mat->ScatteringPDF(ray, rec, scattered);
+        if (!alive) {
+            break;
+        }
+    }
 
-    Color sample_color(RayColor(scattered, depth - 1, world, lights));
-    Color color_from_scatter((static_cast<Vec3>(srec.attenuation) * 
-                            scattering_pdf *
-                            static_cast<Vec3>(sample_color)) / 
-                            pdf_value);
-    
-    return (color_from_emission + color_from_scatter);
+    return Color(radiance);
 }
 
 // Color Camera::RayColor(const Ray& ray, 
@@ -236,41 +553,39 @@ Color Camera::RayColor(const Ray& ray,
 //     return (color_from_emission + color_from_scatter);
 // }
 
-// Construct a camera ray originating from the defocus disk and directed at a randomly
-// sampled point around the pixel location i, j for stratified sample squre s_i, s_j.
-inline Ray Camera::GetRay(int i, int j, int s_i, int s_j) const {
-    Vec3 offset = SampleSquareStratified(s_i, s_j);
+// Construct a camera ray originating from the defocus disk and directed at a 
+// sampled point of the unit square pixel i, j. The first five dimensions of
+// every sample are the pixel position, the lens position and the time, 
+// the lens ones are drawn even without defocus to keep the path dimensions
+// in place.
+inline Ray Camera::GetRay(uint32_t i, uint32_t j, 
+                        SampleSequence& sequence) const {
+    double px = 0.0;
+    double py = 0.0;
+    sequence.Next2D(px, py);
+
     Point3 pixel_sample = m_pixel00_loc 
-                        + ((i + offset.GetX()) * m_pixel_delta_u)
-                        + ((j + offset.GetY()) * m_pixel_delta_v);
+                        + ((i + px - 0.5) * m_pixel_delta_u)
+                        + ((j + py - 0.5) * m_pixel_delta_v);
+
+    double lens_u = 0.0;
+    double lens_v = 0.0;
+    sequence.Next2D(lens_u, lens_v);
 
     Point3 ray_origin = (m_defocus_angle <= 0.0) ? 
-                        m_center : DefocusDiskSample();
+                        m_center : DefocusDiskSample(lens_u, lens_v);
     Vec3 ray_direction = pixel_sample - ray_origin;
-    double ray_time = RandomDouble();
+    double ray_time = sequence.Next1D();
 
     return Ray(ray_origin, ray_direction, ray_time);
 }
 
-inline Point3 Camera::DefocusDiskSample() const {
-    Point3 p = RandomInUnitDisk();
+inline Point3 Camera::DefocusDiskSample(double u, double v) const {
+    Point3 p = RandomInUnitDisk(u, v);
 
     return (m_center + 
         (p[Vec3::Cord::X] * m_defocus_disk_u) +
         (p[Vec3::Cord::Y] * m_defocus_disk_v));
 }
 
-inline Vec3 Camera::SampleSqure() {
-    return (Vec3(RandomDouble() - 0.5, RandomDouble() - 0.5, 0.0));
-}
-
-// Returns the vector to a random point in the square sub-pixel specified by grid
-// indices s_i and s_j, for an idealized unit square pixel [-.5,-.5] to [+.5,+.5].
-inline Vec3 Camera::SampleSquareStratified(int s_i, int s_j) const {
-    double px = ((s_i + RandomDouble()) * m_recip_sqrt_spp) - 0.5;
-    double py = ((s_j + RandomDouble()) * m_recip_sqrt_spp) - 0.5;
-
-    return Vec3(px, py, 0.0);
-}
-
 }
\ No newline at end of file
@@ -0,0 +1,10 @@
+#include "framebuffer.hpp"
+#include "image_writer.hpp"
+
+namespace RayTracing {
+
+bool Framebuffer::Write(const std::string& filename) const {
+    return ImageWriter::ForFile(filename)->Write(*this, filename);
+}
+
+}
@@ -3,6 +3,8 @@
 
 namespace RayTracing {
 
+constexpr uint32_t RayPacket::MAX_SIZE;
+
 HittableList::HittableList(const std::vector<std::shared_ptr<Hittable>>& objs) :
 m_objects(objs) 
 {
@@ -29,5 +31,41 @@ bool HittableList::Hit(const Ray& ray,
     return hit_anything;
 }
 
+bool HittableList::Occluded(const Ray& ray, const Interval& ray_t) const {
+    for (const auto& object : m_objects) {
+        if (object->Occluded(ray, ray_t)) {
+            return true;
+        }
+    }
+
+    return false;
+}
 
-}
\ No newline at end of file
+// Every object only writes the records of rays it hits closer than their
+// t_max, which the hits of earlier objects have already shrunk.
+uint32_t HittableList::HitPacket(RayPacket& packet, HitRecord *recs) const {
+    uint32_t mask = 0;
+
+    for (const auto& object : m_objects) {
+        mask |= object->HitPacket(packet, recs);
+    }
+
+    return mask;
+}
+
+uint32_t HittableList::OccludedPacket(const RayPacket& packet) const {
+    uint32_t all_rays = (1u << packet.size) - 1;
+    uint32_t mask = 0;
+
+    for (const auto& object : m_objects) {
+        mask |= object->OccludedPacket(packet);
+
+        if (mask == all_rays) {
+            break;
+        }
+    }
+
+    return mask;
+}
+
+}
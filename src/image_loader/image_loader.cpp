@@ -0,0 +1,5 @@
+// stb_image is header only, its implementation is compiled here so any
+// number of files can include image_loader.hpp.
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_FAILURE_USERMSG
+#include "stb_image/stb_image.h"
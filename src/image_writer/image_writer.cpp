@@ -0,0 +1,317 @@
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "image_writer.hpp"
+
+namespace RayTracing {
+
+namespace {
+
+void AppendString(std::vector<uint8_t>& out, const std::string& str) {
+    out.insert(out.end(), str.begin(), str.end());
+}
+
+// null terminated, as OpenEXR attribute names and types are stored
+void AppendCString(std::vector<uint8_t>& out, const std::string& str) {
+    AppendString(out, str);
+    out.push_back(0);
+}
+
+void AppendUInt16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void AppendUInt32(std::vector<uint8_t>& out, uint32_t value) {
+    for (unsigned int byte = 0; byte < 4; ++byte) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * byte)));
+    }
+}
+
+void AppendFloat(std::vector<uint8_t>& out, float value) {
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    AppendUInt32(out, bits);
+}
+
+void WriteUInt64At(std::vector<uint8_t>& out, size_t pos, 
+                    uint64_t value) {
+    for (unsigned int byte = 0; byte < 8; ++byte) {
+        out[pos + byte] = static_cast<uint8_t>(value >> (8 * byte));
+    }
+}
+
+}
+
+bool ImageWriter::Write(const Framebuffer& framebuffer, 
+                        const std::string& filename) const {
+    std::vector<uint8_t> data = Encode(framebuffer);
+    std::FILE *file = std::fopen(filename.c_str(), "wb");
+
+    if (file == nullptr) {
+        return false;
+    }
+
+    bool written = 
+            (std::fwrite(data.data(), 1, data.size(), file) == data.size());
+
+    return ((std::fclose(file) == 0) && written);
+}
+
+std::unique_ptr<ImageWriter> ImageWriter::ForFile(const std::string& filename) {
+    size_t dot = filename.rfind('.');
+    std::string extension = (dot == std::string::npos) ? 
+                            "" : filename.substr(dot + 1);
+
+    for (auto& c : extension) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+
+    if (extension == "pfm") {
+        return std::unique_ptr<ImageWriter>(new PFMWriter);
+    }
+    if (extension == "exr") {
+        return std::unique_ptr<ImageWriter>(new EXRWriter);
+    }
+
+    return std::unique_ptr<ImageWriter>(new PPMWriter);
+}
+
+std::vector<uint8_t> PPMWriter::Encode(const Framebuffer& framebuffer) const {
+    std::vector<uint8_t> out;
+    AppendString(out, "P6\n" + std::to_string(framebuffer.GetWidth()) + ' ' +
+                std::to_string(framebuffer.GetHeight()) + "\n255\n");
+    out.reserve(out.size() + 3 * framebuffer.GetPixels().size());
+
+    for (const auto& pixel : framebuffer.GetPixels()) {
+        out.push_back(ComponentToByte(pixel.GetR()));
+        out.push_back(ComponentToByte(pixel.GetG()));
+        out.push_back(ComponentToByte(pixel.GetB()));
+    }
+
+    return out;
+}
+
+// A negative scale marks little endian data, rows go from bottom to top.
+std::vector<uint8_t> PFMWriter::Encode(const Framebuffer& framebuffer) const {
+    std::vector<uint8_t> out;
+    AppendString(out, "PF\n" + std::to_string(framebuffer.GetWidth()) + ' ' +
+                std::to_string(framebuffer.GetHeight()) + "\n-1.0\n");
+    out.reserve(out.size() + 12 * framebuffer.GetPixels().size());
+
+    for (uint32_t row = framebuffer.GetHeight(); row > 0; --row) {
+        for (uint32_t i = 0; i < framebuffer.GetWidth(); ++i) {
+            const Color& pixel = framebuffer.GetPixel(i, row - 1);
+
+            AppendFloat(out, static_cast<float>(pixel.GetR()));
+            AppendFloat(out, static_cast<float>(pixel.GetG()));
+            AppendFloat(out, static_cast<float>(pixel.GetB()));
+        }
+    }
+
+    return out;
+}
+
+// Header attributes, the offset table and one chunk per scanline
+// holding the B, G and R halves of its pixels (channels sorted by name).
+std::vector<uint8_t> EXRWriter::Encode(const Framebuffer& framebuffer) const {
+    const char *channel_names[] = {"B", "G", "R"};
+    constexpr uint32_t half_type = 1;
+    int32_t max_x = static_cast<int32_t>(framebuffer.GetWidth()) - 1;
+    int32_t max_y = static_cast<int32_t>(framebuffer.GetHeight()) - 1;
+
+    std::vector<uint8_t> out;
+
+    AppendUInt32(out, 20000630);        // magic number
+    AppendUInt32(out, 2);               // version 2, single part scanline
+
+    AppendCString(out, "channels");
+    AppendCString(out, "chlist");
+    AppendUInt32(out, 3 * (2 + 16) + 1);
+    for (const char *name : channel_names) {
+        AppendCString(out, name);
+        AppendUInt32(out, half_type);
+        AppendUInt32(out, 0);           // pLinear + reserved
+        AppendUInt32(out, 1);           // x sampling
+        AppendUInt32(out, 1);           // y sampling
+    }
+    out.push_back(0);
+
+    AppendCString(out, "compression");
+    AppendCString(out, "compression");
+    AppendUInt32(out, 1);
+    out.push_back(m_compression);
+
+    for (const char *window : {"dataWindow", "displayWindow"}) {
+        AppendCString(out, window);
+        AppendCString(out, "box2i");
+        AppendUInt32(out, 16);
+        AppendUInt32(out, 0);
+        AppendUInt32(out, 0);
+        AppendUInt32(out, static_cast<uint32_t>(max_x));
+        AppendUInt32(out, static_cast<uint32_t>(max_y));
+    }
+
+    AppendCString(out, "lineOrder");
+    AppendCString(out, "lineOrder");
+    AppendUInt32(out, 1);
+    out.push_back(0);                   // increasing y
+
+    AppendCString(out, "pixelAspectRatio");
+    AppendCString(out, "float");
+    AppendUInt32(out, 4);
+    AppendFloat(out, 1.0f);
+
+    AppendCString(out, "screenWindowCenter");
+    AppendCString(out, "v2f");
+    AppendUInt32(out, 8);
+    AppendFloat(out, 0.0f);
+    AppendFloat(out, 0.0f);
+
+    AppendCString(out, "screenWindowWidth");
+    AppendCString(out, "float");
+    AppendUInt32(out, 4);
+    AppendFloat(out, 1.0f);
+
+    out.push_back(0);                   // end of header
+
+    size_t offset_table = out.size();
+    out.resize(out.size() + 8 * static_cast<size_t>(framebuffer.GetHeight()));
+
+    std::vector<uint8_t> scanline;
+    std::vector<uint8_t> compressed;
+
+    for (uint32_t j = 0; j < framebuffer.GetHeight(); ++j) {
+        scanline.clear();
+
+        for (unsigned int channel = 0; channel < 3; ++channel) {
+            for (uint32_t i = 0; i < framebuffer.GetWidth(); ++i) {
+                const Color& pixel = framebuffer.GetPixel(i, j);
+                double value = (channel == 0) ? pixel.GetB() : 
+                                (channel == 1) ? pixel.GetG() : pixel.GetR();
+
+                AppendUInt16(scanline, FloatToHalf(static_cast<float>(value)));
+            }
+        }
+
+        // a chunk as large as the raw data is read back as uncompressed
+        bool use_compressed = (m_compression == Compression::RLE) && 
+                            CompressRLE(scanline, compressed);
+        const std::vector<uint8_t>& data = use_compressed ? 
+                                        compressed : scanline;
+
+        WriteUInt64At(out, offset_table + 8 * static_cast<size_t>(j), 
+                    out.size());
+        AppendUInt32(out, j);
+        AppendUInt32(out, static_cast<uint32_t>(data.size()));
+        out.insert(out.end(), data.begin(), data.end());
+    }
+
+    return out;
+}
+
+bool EXRWriter::CompressRLE(const std::vector<uint8_t>& raw, 
+                            std::vector<uint8_t>& compressed) {
+    constexpr size_t min_run_length = 3;
+    constexpr size_t max_run_length = 127;
+    size_t size = raw.size();
+    std::vector<uint8_t> tmp(size);
+
+    // even bytes to the first half, odd bytes to the second
+    size_t half = (size + 1) / 2;
+    for (size_t i = 0; i < size; ++i) {
+        tmp[(i % 2 == 0) ? (i / 2) : (half + i / 2)] = raw[i];
+    }
+
+    // delta to the previous byte
+    uint8_t previous = (size > 0) ? tmp[0] : 0;
+    for (size_t i = 1; i < size; ++i) {
+        uint8_t current = tmp[i];
+        tmp[i] = static_cast<uint8_t>(current - previous + 128);
+        previous = current;
+    }
+
+    // runs: (length - 1, byte), literals: (-length, bytes...)
+    compressed.clear();
+    size_t run_start = 0;
+    size_t run_end = 1;
+
+    while (run_start < size) {
+        while ((run_end < size) && (tmp[run_start] == tmp[run_end]) &&
+                (run_end - run_start - 1 < max_run_length)) {
+            ++run_end;
+        }
+
+        if (run_end - run_start >= min_run_length) {
+            compressed.push_back(static_cast<uint8_t>(run_end - run_start - 1));
+            compressed.push_back(tmp[run_start]);
+            run_start = run_end;
+        }
+        else {
+            while ((run_end < size) &&
+                    (((run_end + 1 >= size) || 
+                    (tmp[run_end] != tmp[run_end + 1])) ||
+                    ((run_end + 2 >= size) || 
+                    (tmp[run_end + 1] != tmp[run_end + 2]))) &&
+                    (run_end - run_start < max_run_length)) {
+                ++run_end;
+            }
+
+            compressed.push_back(static_cast<uint8_t>(
+                        -static_cast<int>(run_end - run_start)));
+            compressed.insert(compressed.end(), 
+                            tmp.begin() + run_start, tmp.begin() + run_end);
+            run_start = run_end;
+        }
+
+        ++run_end;
+    }
+
+    return (compressed.size() < size);
+}
+
+// Round to nearest even, overflow to infinity, NaN stays NaN.
+uint16_t EXRWriter::FloatToHalf(float value) {
+    constexpr uint32_t float_infinity = 255u << 23;
+    constexpr uint32_t half_overflow = (127u + 16u) << 23;
+    constexpr uint32_t half_normal_min = 113u << 23;
+    // adding 0.5f aligns the mantissa of small values to half subnormals
+    constexpr uint32_t subnormal_magic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint32_t half = 0;
+
+    if (bits >= half_overflow) {
+        half = (bits > float_infinity) ? 0x7e00u : 0x7c00u;
+    }
+    else if (bits < half_normal_min) {
+        float magic = 0.0f;
+        float abs_value = 0.0f;
+        std::memcpy(&magic, &subnormal_magic, sizeof(magic));
+        std::memcpy(&abs_value, &bits, sizeof(abs_value));
+
+        float sum = abs_value + magic;
+        uint32_t sum_bits = 0;
+        std::memcpy(&sum_bits, &sum, sizeof(sum_bits));
+
+        half = sum_bits - subnormal_magic;
+    }
+    else {
+        uint32_t mantissa_odd = (bits >> 13) & 1u;
+
+        bits -= (112u << 23);           // rebias exponent from 127 to 15
+        bits += 0xfffu + mantissa_odd;
+        half = bits >> 13;
+    }
+
+    return static_cast<uint16_t>(half | (sign >> 16));
+}
+
+}
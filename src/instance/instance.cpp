@@ -0,0 +1,28 @@
+#include <cmath>
+#include <iostream>
+
+#include "instance.hpp"
+
+namespace RayTracing {
+
+Instance::Instance(std::shared_ptr<Hittable> object,
+                const Transform& transform) :
+m_object_to_world(transform),
+m_world_to_object(transform.Inverse()),
+m_bbox(AABB::EMPTY),
+m_object(object),
+m_uv_scale(1.0)
+{
+    if (transform.Determinant() == 0.0) {
+        std::cerr << "ERROR: instance transform is singular, "
+                    "the identity is used\n";
+        m_object_to_world = Transform();
+    }
+    else {
+        m_uv_scale = std::cbrt(std::fabs(m_world_to_object.Determinant()));
+    }
+
+    m_bbox = m_object_to_world.TransformBox(m_object->BoundingBox());
+}
+
+}
@@ -0,0 +1,115 @@
+#include "instance_bvh.hpp"
+
+namespace RayTracing {
+
+constexpr size_t InstanceBVH::STACK_SIZE;
+
+InstanceBVH::InstanceBVH(std::vector<Instance> instances,
+                        SplitMethod method) :
+m_bbox(AABB::EMPTY), m_build_stats()
+{
+    std::vector<BVHPrimitive> prims(instances.size());
+
+    for (size_t i = 0; i < instances.size(); ++i) {
+        BVHPrimitive& prim = prims[i];
+
+        prim.bbox = instances[i].BoundingBox();
+        prim.centroid = prim.bbox.Centroid();
+        prim.index = i;
+        prim.morton_code = 0;
+    }
+
+    std::vector<BVHBuildNode> build_nodes =
+                    BVHBuilder::Build(prims, method, &m_build_stats);
+
+    if (build_nodes.empty()) {
+        return;
+    }
+
+    m_bbox = build_nodes[0].bbox;
+    m_nodes = LinearBVH::MakeNodes(build_nodes);
+    m_instances.reserve(instances.size());
+
+    for (const BVHPrimitive& prim : prims) {
+        m_instances.push_back(std::move(instances[prim.index]));
+    }
+}
+
+bool InstanceBVH::Hit(const Ray& ray,
+                    const Interval& ray_t,
+                    HitRecord& rec) const {
+    return Traverse<false>(ray, ray_t, &rec);
+}
+
+bool InstanceBVH::Occluded(const Ray& ray, const Interval& ray_t) const {
+    return Traverse<true>(ray, ray_t, nullptr);
+}
+
+template <bool ANY_HIT>
+bool InstanceBVH::Traverse(const Ray& ray,
+                        const Interval& ray_t,
+                        HitRecord *rec) const {
+    if (m_nodes.empty()) {
+        return false;
+    }
+
+    const SimdVec3 origin(ray.GetOrigin());
+    const Vec3 direction = ray.GetDirection();
+    const SimdVec3 inv_dir = SimdVec3::Broadcast(1) / SimdVec3(direction);
+    const bool dir_is_neg[AABB::Axis::NUM_OF_AXIS] = {
+        (direction.GetX() < 0.0),
+        (direction.GetY() < 0.0),
+        (direction.GetZ() < 0.0)
+    };
+
+    uint32_t stack[STACK_SIZE];
+    size_t stack_top = 0;
+    uint32_t node_index = 0;
+    double closest_so_far = ray_t.GetMax();
+    bool hit_anything = false;
+
+    for (;;) {
+        const LinearBVHNode& node = m_nodes[node_index];
+
+        if (LinearBVH::HitNode(node, origin, inv_dir,
+                            ray_t.GetMin(), closest_so_far)) {
+            if (node.prim_count == 0) {
+                if (dir_is_neg[node.axis]) {
+                    stack[stack_top++] = node_index + 1;
+                    node_index = node.offset;
+                }
+                else {
+                    stack[stack_top++] = node.offset;
+                    node_index = node_index + 1;
+                }
+
+                continue;
+            }
+
+            for (uint32_t i = 0; i < node.prim_count; ++i) {
+                const Instance& instance = m_instances[node.offset + i];
+                Interval instance_t(ray_t.GetMin(), closest_so_far);
+
+                if (ANY_HIT) {
+                    if (instance.Occluded(ray, instance_t)) {
+                        return true;
+                    }
+                }
+                else if (instance.Hit(ray, instance_t, *rec)) {
+                    hit_anything = true;
+                    closest_so_far = rec->t;
+                }
+            }
+        }
+
+        if (stack_top == 0) {
+            break;
+        }
+
+        node_index = stack[--stack_top];
+    }
+
+    return hit_anything;
+}
+
+}
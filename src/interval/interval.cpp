@@ -3,7 +3,7 @@
 
 namespace RayTracing {
 
-const Interval Interval::EMPTY{+INF, -INF};
-const Interval Interval::UNIVERSE{-INF, +INF};
+const Interval Interval::EMPTY(+INF, -INF);
+const Interval Interval::UNIVERSE(-INF, +INF);
 
 }
\ No newline at end of file
@@ -0,0 +1,293 @@
+#include "light_sampler.hpp"
+#include "bvh_builder.hpp"
+
+namespace RayTracing {
+
+constexpr size_t LightSampler::STACK_SIZE;
+
+LightSampler::LightSampler(
+                    const std::vector<std::shared_ptr<Hittable>>& lights,
+                    const std::vector<double>& powers,
+                    Strategy strategy) :
+m_strategy(strategy),
+m_lights(lights.size()),
+m_bboxes(lights.size()),
+m_powers(lights.size()),
+m_leaves(lights.size()),
+m_order(lights.size())
+{
+    std::vector<BVHPrimitive> prims =
+                    BVHBuilder::MakePrimitives(lights, 0, lights.size());
+    std::vector<BVHBuildNode> build_nodes =
+                    BVHBuilder::Build(prims, BVHBuilder::SplitMethod::SAH);
+    bool has_power = false;
+
+    for (size_t i = 0; i < lights.size(); ++i) {
+        has_power = has_power || ((i < powers.size()) && (powers[i] > 0.0));
+    }
+
+    // lights in leaf order
+    for (size_t i = 0; i < prims.size(); ++i) {
+        size_t index = prims[i].index;
+        double power = (index < powers.size()) ? powers[index] : 0.0;
+
+        m_lights[i] = lights[index];
+        m_bboxes[i] = prims[i].bbox;
+        m_powers[i] = has_power ? std::max(power, 0.0) : 1.0;
+        m_order[index] = static_cast<uint32_t>(i);
+    }
+
+    m_nodes.resize(build_nodes.size());
+
+    for (size_t i = 0; i < build_nodes.size(); ++i) {
+        const BVHBuildNode& build_node = build_nodes[i];
+        Node& node = m_nodes[i];
+
+        node.bbox = build_node.bbox;
+        node.power = 0.0;
+        node.light_count = static_cast<uint32_t>(build_node.prim_count);
+
+        if (build_node.prim_count == 0) {
+            node.offset = static_cast<uint32_t>(build_node.second_child);
+            m_nodes[i + 1].parent = static_cast<uint32_t>(i);
+            m_nodes[build_node.second_child].parent = static_cast<uint32_t>(i);
+        }
+        else {
+            node.offset = static_cast<uint32_t>(build_node.first_prim);
+
+            for (size_t j = 0; j < build_node.prim_count; ++j) {
+                m_leaves[build_node.first_prim + j] = static_cast<uint32_t>(i);
+            }
+        }
+    }
+
+    if (!m_nodes.empty()) {
+        m_nodes[0].parent = 0;
+    }
+
+    // children follow their parents, so powers add up from the back
+    for (size_t i = m_nodes.size(); i-- > 0;) {
+        Node& node = m_nodes[i];
+
+        if (node.light_count == 0) {
+            node.power = m_nodes[i + 1].power + m_nodes[node.offset].power;
+        }
+        else {
+            for (uint32_t j = 0; j < node.light_count; ++j) {
+                node.power += m_powers[node.offset + j];
+            }
+        }
+    }
+
+    if (m_strategy == Strategy::POWER) {
+        m_alias_table = AliasTable(m_powers);
+    }
+}
+
+bool LightSampler::Hit(const Ray& ray,
+                    const Interval& ray_t,
+                    HitRecord& rec) const {
+    bool hit_anything = false;
+
+    Traverse(ray, ray_t, [&](uint32_t light, double& t_max) {
+        if (m_lights[light]->Hit(ray, Interval(ray_t.GetMin(), t_max), rec)) {
+            hit_anything = true;
+            t_max = rec.t;
+        }
+
+        return false;
+    });
+
+    return hit_anything;
+}
+
+bool LightSampler::Occluded(const Ray& ray, const Interval& ray_t) const {
+    return Traverse(ray, ray_t, [&](uint32_t light, double& t_max) {
+        return m_lights[light]->Occluded(ray, 
+                                        Interval(ray_t.GetMin(), t_max));
+    });
+}
+
+// Lights whose boxes the direction misses have a PDF of 0 for it.
+double LightSampler::PDFValue(const Point3& origin,
+                            const Vec3& direction) const {
+    double sum = 0.0;
+
+    Traverse(Ray(origin, direction), Interval(0.001, INF),
+            [&](uint32_t light, double& t_max) {
+        (void)t_max;
+
+        double pdf = m_lights[light]->PDFValue(origin, direction);
+
+        if (pdf > 0.0) {
+            sum += Probability(origin, light) * pdf;
+        }
+
+        return false;
+    });
+
+    return sum;
+}
+
+Vec3 LightSampler::Random(const Point3& origin,
+                        double uc, double u, double v) const {
+    if (m_lights.empty()) {
+        return Vec3(1.0, 0.0, 0.0);
+    }
+
+    size_t light = 0;
+
+    if (m_strategy == Strategy::POWER) {
+        light = m_alias_table.Sample(uc, uc);
+
+        return m_lights[light]->Random(origin, uc, u, v);
+    }
+
+    uint32_t node_index = 0;
+
+    while (m_nodes[node_index].light_count == 0) {
+        double p_first = FirstChildProbability(origin, node_index);
+
+        if (uc < p_first) {
+            uc /= p_first;
+            node_index = node_index + 1;
+        }
+        else {
+            uc = (uc - p_first) / (1.0 - p_first);
+            node_index = m_nodes[node_index].offset;
+        }
+
+        uc = std::min(uc, ONE_MINUS_EPSILON);
+    }
+
+    const Node& leaf = m_nodes[node_index];
+    double sum = 0.0;
+
+    for (uint32_t i = 0; i < leaf.light_count; ++i) {
+        uint32_t j = leaf.offset + i;
+
+        sum += Importance(origin, m_bboxes[j], m_powers[j]);
+    }
+
+    if (sum > 0.0) {
+        double target = uc * sum;
+        double cdf = 0.0;
+
+        light = leaf.offset + leaf.light_count - 1;
+
+        for (uint32_t i = 0; i < leaf.light_count; ++i) {
+            uint32_t j = leaf.offset + i;
+            double importance = Importance(origin, m_bboxes[j], m_powers[j]);
+
+            if ((importance > 0.0) && (target < cdf + importance)) {
+                light = j;
+                uc = (target - cdf) / importance;
+                break;
+            }
+
+            cdf += importance;
+        }
+    }
+    else {
+        double scaled = uc * leaf.light_count;
+        uint32_t i = std::min(static_cast<uint32_t>(scaled),
+                            leaf.light_count - 1);
+
+        light = leaf.offset + i;
+        uc = scaled - i;
+    }
+
+    uc = std::min(std::max(uc, 0.0), ONE_MINUS_EPSILON);
+
+    return m_lights[light]->Random(origin, uc, u, v);
+}
+
+double LightSampler::Probability(const Point3& origin, uint32_t light) const {
+    if (m_strategy == Strategy::POWER) {
+        return m_alias_table.GetProbability(light);
+    }
+
+    double probability = LeafProbability(origin, light);
+    uint32_t node_index = m_leaves[light];
+
+    while (node_index != 0) {
+        uint32_t parent = m_nodes[node_index].parent;
+        double p_first = FirstChildProbability(origin, parent);
+
+        probability *= (node_index == parent + 1) ? p_first : (1.0 - p_first);
+        node_index = parent;
+    }
+
+    return probability;
+}
+
+double LightSampler::FirstChildProbability(const Point3& origin,
+                                        uint32_t node) const {
+    const Node& first = m_nodes[node + 1];
+    const Node& second = m_nodes[m_nodes[node].offset];
+    double first_importance = Importance(origin, first.bbox, first.power);
+    double second_importance = Importance(origin, second.bbox, second.power);
+    double sum = first_importance + second_importance;
+
+    return ((sum > 0.0) ? (first_importance / sum) : 0.5);
+}
+
+double LightSampler::LeafProbability(const Point3& origin,
+                                    uint32_t light) const {
+    const Node& leaf = m_nodes[m_leaves[light]];
+    double sum = 0.0;
+
+    for (uint32_t i = 0; i < leaf.light_count; ++i) {
+        uint32_t j = leaf.offset + i;
+
+        sum += Importance(origin, m_bboxes[j], m_powers[j]);
+    }
+
+    if (sum <= 0.0) {
+        return (1.0 / leaf.light_count);
+    }
+
+    return (Importance(origin, m_bboxes[light], m_powers[light]) / sum);
+}
+
+template <typename Visitor>
+bool LightSampler::Traverse(const Ray& ray, const Interval& ray_t,
+                            Visitor visit) const {
+    if (m_nodes.empty()) {
+        return false;
+    }
+
+    uint32_t stack[STACK_SIZE];
+    size_t stack_top = 0;
+    uint32_t node_index = 0;
+    double t_max = ray_t.GetMax();
+
+    for (;;) {
+        const Node& node = m_nodes[node_index];
+
+        if (node.bbox.Hit(ray, Interval(ray_t.GetMin(), t_max))) {
+            if (node.light_count == 0) {
+                stack[stack_top++] = node.offset;
+                node_index = node_index + 1;
+
+                continue;
+            }
+
+            for (uint32_t i = 0; i < node.light_count; ++i) {
+                if (visit(node.offset + i, t_max)) {
+                    return true;
+                }
+            }
+        }
+
+        if (stack_top == 0) {
+            break;
+        }
+
+        node_index = stack[--stack_top];
+    }
+
+    return false;
+}
+
+}
@@ -0,0 +1,130 @@
+#include "linear_bvh.hpp"
+
+namespace RayTracing {
+
+LinearBVH::LinearBVH(const std::vector<std::shared_ptr<Hittable>>& objects,
+                    SplitMethod method) {
+    std::vector<BVHPrimitive> prims = 
+                    BVHBuilder::MakePrimitives(objects, 0, objects.size());
+    std::vector<BVHBuildNode> build_nodes =
+                    BVHBuilder::Build(prims, method, &m_build_stats);
+
+    m_bbox = build_nodes.empty() ? AABB::EMPTY : build_nodes[0].bbox;
+
+    m_primitives.reserve(prims.size());
+    for (const auto& prim : prims) {
+        m_primitives.push_back(objects[prim.index]);
+    }
+
+    m_nodes = MakeNodes(build_nodes);
+}
+
+std::vector<LinearBVHNode> LinearBVH::MakeNodes(
+                            const std::vector<BVHBuildNode>& build_nodes) {
+    std::vector<LinearBVHNode> nodes;
+    nodes.reserve(build_nodes.size());
+
+    for (const auto& build_node : build_nodes) {
+        LinearBVHNode node;
+
+        for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+            Interval inter = build_node.bbox.AxisInterval(
+                                            static_cast<AABB::Axis>(axis));
+            node.bounds_min[axis] = FloatRoundDown(inter.GetMin());
+            node.bounds_max[axis] = FloatRoundUp(inter.GetMax());
+        }
+
+        bool is_leaf = (build_node.prim_count > 0);
+        node.offset = static_cast<uint32_t>(is_leaf ? 
+                                build_node.first_prim : 
+                                build_node.second_child);
+        node.prim_count = static_cast<uint16_t>(build_node.prim_count);
+        node.axis = static_cast<uint8_t>(build_node.axis);
+        node.pad = 0;
+
+        nodes.push_back(node);
+    }
+
+    return nodes;
+}
+
+bool LinearBVH::Hit(const Ray& ray, 
+                    const Interval& ray_t, 
+                    HitRecord& rec) const {
+    return Traverse<false>(ray, ray_t, &rec);
+}
+
+bool LinearBVH::Occluded(const Ray& ray, const Interval& ray_t) const {
+    return Traverse<true>(ray, ray_t, nullptr);
+}
+
+template <bool ANY_HIT>
+bool LinearBVH::Traverse(const Ray& ray, 
+                        const Interval& ray_t, 
+                        HitRecord *rec) const {
+    if (m_nodes.empty()) {
+        return false;
+    }
+
+    const SimdVec3 origin(ray.GetOrigin());
+    const Vec3 direction = ray.GetDirection();
+    const SimdVec3 inv_dir = SimdVec3::Broadcast(1) / SimdVec3(direction);
+    const bool dir_is_neg[AABB::Axis::NUM_OF_AXIS] = {
+        (direction.GetX() < 0.0), 
+        (direction.GetY() < 0.0), 
+        (direction.GetZ() < 0.0)
+    };
+
+    uint32_t stack[STACK_SIZE];
+    size_t stack_top = 0;
+    uint32_t node_index = 0;
+    double closest_so_far = ray_t.GetMax();
+    bool hit_anything = false;
+
+    for (;;) {
+        const LinearBVHNode& node = m_nodes[node_index];
+
+        if (HitNode(node, origin, inv_dir, ray_t.GetMin(), closest_so_far)) {
+            if (node.prim_count == 0) {
+                // Descend into the child on the near side of the split,
+                // the far child waits on the stack and is skipped if its box 
+                // starts beyond the closest hit by the time it is popped.
+                if (dir_is_neg[node.axis]) {
+                    stack[stack_top++] = node_index + 1;
+                    node_index = node.offset;
+                }
+                else {
+                    stack[stack_top++] = node.offset;
+                    node_index = node_index + 1;
+                }
+
+                continue;
+            }
+
+            for (uint32_t i = 0; i < node.prim_count; ++i) {
+                const Hittable& prim = *m_primitives[node.offset + i];
+                Interval prim_t(ray_t.GetMin(), closest_so_far);
+
+                if (ANY_HIT) {
+                    if (prim.Occluded(ray, prim_t)) {
+                        return true;
+                    }
+                }
+                else if (prim.Hit(ray, prim_t, *rec)) {
+                    hit_anything = true;
+                    closest_so_far = rec->t;
+                }
+            }
+        }
+
+        if (stack_top == 0) {
+            break;
+        }
+
+        node_index = stack[--stack_top];
+    }
+
+    return hit_anything;
+}
+
+}
@@ -2,74 +2,125 @@
 #include <iostream>
 #include <memory>
 #include <chrono>
+#include <string>
 
 #include "hittable_list.hpp"
 #include "sphere.hpp"
+#include "sphere_set.hpp"
 #include "quad.hpp"
-#include "disk.hpp"
-#include "triangle.hpp"
 #include "camera.hpp"
 #include "lambertian.hpp"
 #include "metal.hpp"
 #include "dielectric.hpp"
-#include "bvh.hpp"
-#include "checker_texture.hpp"
+#include "wide_bvh.hpp"
 #include "image_texture.hpp"
 #include "noise_texture.hpp"
 #include "diffuse_light.hpp"
-#include "rotate_y.hpp"
-#include "translate.hpp"
+#include "instance.hpp"
 #include "constant_medium.hpp"
+#include "alloc_counter.hpp"
+#include "triangle_mesh.hpp"
+#include "mesh_loader.hpp"
+#include "mapped_file.hpp"
+#include "scene.hpp"
 
 void BouncingSpheres();
-void CheckeredSpheres();
-void Earth();
-void PerlinSpheres();
-void Quads();
-void SimpleLight();
-void CornellBox();
-void CornellSmoke();
+void CornellBoxScene(RayTracing::HittableList& world, 
+                    RayTracing::HittableList& lights);
 void FinalScene(uint32_t image_width, 
                 uint32_t samples_per_pixel, 
-                uint32_t max_depth);
+                uint32_t max_depth,
+                const std::string& checkpoint_file);
+void LogBuildStats(const char *name, const RayTracing::BVHBuildStats& stats);
+std::string SiblingFile(const std::string& filename, const std::string& suffix);
+void AllocationBenchmark();
+void MeshCornellBox();
+bool RenderSceneFile(const std::string& filename);
+bool CompileSceneFile(const std::string& filename, 
+                    const std::string& compiled_filename);
+std::string FindSceneFile(const std::string& filename);
+bool IsNumber(const std::string& str);
+void FitMesh(RayTracing::MeshData& data, const RayTracing::Point3& base, 
+            double size);
+
+// Image written by the scenes, the extension picks the format.
+static std::string g_output_file = "image.ppm";
+// Seconds the progressive FinalScene may render, 0 - until done.
+static double g_time_budget = 0.0;
+// How the scenes trace their samples.
+static RayTracing::Camera::Integrator g_integrator = 
+                                    RayTracing::Camera::Integrator::PATH;
 
 int main(int argc, char** argv) {
+    if ((argc > 1) && (std::string(argv[1]) == "compile")) {
+        if (argc != 4) {
+            std::clog << "Usage: compile <scene file> <compiled file>\n";
+
+            return 1;
+        }
+
+        return (CompileSceneFile(argv[2], argv[3]) ? 0 : 1);
+    }
+
+    if (argc > 2) {
+        g_output_file = argv[2];
+    }
+    if (argc > 3) {
+        g_time_budget = std::stod(argv[3]);
+    }
+    if (argc > 4) {
+        if (std::string(argv[4]) == "wavefront") {
+            g_integrator = RayTracing::Camera::Integrator::WAVEFRONT;
+        }
+        else if (std::string(argv[4]) != "path") {
+            std::clog << "Invalid integrator (valid integrators: path, "
+                    "wavefront)\n";
+
+            return 1;
+        }
+    }
+
+    if ((argc > 1) && !IsNumber(argv[1])) {
+        return (RenderSceneFile(argv[1]) ? 0 : 1);
+    }
+
     if (argc > 1) {    
-        switch(std::stoi(argv[1])) {
+        // examples 2 - 8 are scene files
+        const char *example_scenes[] = {"checkered_spheres.scene",
+                                        "earth.scene",
+                                        "perlin_spheres.scene",
+                                        "quads.scene",
+                                        "simple_light.scene",
+                                        "cornell_box.scene",
+                                        "cornell_smoke.scene"};
+        int example = std::stoi(argv[1]);
+
+        if ((example >= 2) && (example <= 8)) {
+            std::string scene = FindSceneFile(example_scenes[example - 2]);
+
+            return (RenderSceneFile(scene) ? 0 : 1);
+        }
+
+        switch(example) {
             case 1: 
                 BouncingSpheres();
                 break;
-            case 2:
-                CheckeredSpheres();
-                break;
-            case 3:
-                Earth();
-                break;
-            case 4:
-                PerlinSpheres();
-                break;
-            case 5:
-                Quads();
-                break;
-            case 6:
-                SimpleLight();
-                break;
-            case 7:
-                CornellBox();
+            case 9:
+                FinalScene(800, 10000, 40, "final_scene.acc");
                 break;
-            case 8:
-                CornellSmoke();
+            case 10:
+                AllocationBenchmark();
                 break;
-            case 9:
-                FinalScene(800, 10000, 40);
+            case 11:
+                MeshCornellBox();
                 break;
             default:
-            std::clog << "Invalid argument (valid arguments: 1 - 9)\n";
+            std::clog << "Invalid argument (valid arguments: 1 - 11)\n";
         }
     }
     else {
         std::clog << "defualt scene\n";
-        FinalScene(400, 250, 4);
+        FinalScene(400, 250, 4, "");
     }
 
     return 0;
@@ -142,9 +193,11 @@ void BouncingSpheres() {
         RayTracing::Point3(4.0, 1.0, 0.0), 1.0, material3));
 
 
+    auto bvh = std::make_shared<RayTracing::WideBVH>(world);
+    LogBuildStats("world", bvh->GetBuildStats());
+
     world = RayTracing::HittableList(
-            std::vector<std::shared_ptr<RayTracing::Hittable>>{
-            std::make_shared<RayTracing::BVHNode>(world)});
+            std::vector<std::shared_ptr<RayTracing::Hittable>>{bvh});
 
     // ligth sources
     auto empty_material = std::shared_ptr<RayTracing::Material>();
@@ -168,6 +221,9 @@ void BouncingSpheres() {
                         image_width, samples_per_pixel, max_depth,
                         look_from, look_at, vup);
 
+    cam.SetOutputFile(g_output_file);
+    cam.SetIntegrator(g_integrator);
+
     cam.SetBackground(RayTracing::Color(0.70, 0.80, 1.00));
 
     auto t1 = std::chrono::high_resolution_clock::now();
@@ -188,202 +244,135 @@ void BouncingSpheres() {
     
 }
 
-void CheckeredSpheres() {
-    RayTracing::HittableList world;
-
-    auto checker = std::make_shared<RayTracing::CheckerTexture>(
-                    0.32, RayTracing::Color(0.2, 0.3, 0.1), 
-                    RayTracing::Color(0.9, 0.9, 0.9));
-    world.Add(std::make_shared<RayTracing::Sphere>(
-        RayTracing::Point3(0.0, -10.0, 0.0), 10.0,
-        std::make_shared<RayTracing::Lambertian>(checker)));
-    world.Add(std::make_shared<RayTracing::Sphere>(
-        RayTracing::Point3(0.0, 10.0, 0.0), 10.0,
-        std::make_shared<RayTracing::Lambertian>(checker)));
-
-    // ligth sources
-    auto empty_material = std::shared_ptr<RayTracing::Material>();
-    RayTracing::Quad lights(RayTracing::Point3(13.0, 2.0, 3.0), 
-                            RayTracing::Vec3(400.0, 0.0, 0.0),
-                            RayTracing::Vec3(0.0, 225.0, 0.0),
-                            empty_material);
-
-
-    double aspect_ratio = 16.0 / 9.0;
-    double vfov = 20.0;
-    double defocus_angle = 0.0;
-    double focus_dist = 10.0;
-    uint32_t image_width = 400;
-    uint32_t samples_per_pixel = 100;
-    uint32_t max_depth = 50;
-    RayTracing::Point3 look_from(13, 2, 3);
-    RayTracing::Point3 look_at(0, 0, 0);
-    RayTracing::Vec3 vup(0, 1, 0);
-
-    RayTracing::Camera cam(aspect_ratio, vfov, defocus_angle, focus_dist,
-                        image_width, samples_per_pixel, max_depth,
-                        look_from, look_at, vup);
-
-    cam.SetBackground(RayTracing::Color(0.70, 0.80, 1.00));
-
-    auto t1 = std::chrono::high_resolution_clock::now();
-    cam.Render(world, lights, true);
-    auto t2 = std::chrono::high_resolution_clock::now();
-
-    std::chrono::duration<double, std::milli> ms = t2 - t1;
-
-    std::clog << "parallel execution time: " << ms.count() << '\n';
-
-}
-
-void Earth() {
-    auto earth_texture = std::make_shared<RayTracing::ImageTexture>(
-                        "earthmap.jpg");
-    auto earth_surface = std::make_shared<RayTracing::Lambertian>(
-                        earth_texture);
-    auto globe = std::make_shared<RayTracing::Sphere>(
-                RayTracing::Point3(0.0, 0.0, 0.0), 2.0, earth_surface);
-    
-    // ligth sources
-    auto empty_material = std::shared_ptr<RayTracing::Material>();
-    RayTracing::Quad lights(RayTracing::Point3(0.0, 0.0, 12.0), 
-                            RayTracing::Vec3(400.0, 0.0, 0.0),
-                            RayTracing::Vec3(0.0, 225.0, 0.0),
-                            empty_material);
-
-    double aspect_ratio = 16.0 / 9.0;
-    double vfov = 20.0;
-    double defocus_angle = 0.0;
-    double focus_dist = 10.0;
-    uint32_t image_width = 400;
-    uint32_t samples_per_pixel = 100;
-    uint32_t max_depth = 50;
-    RayTracing::Point3 look_from(0, 0, 12);
-    RayTracing::Point3 look_at(0, 0, 0);
-    RayTracing::Vec3 vup(0, 1, 0);
-
-    RayTracing::Camera cam(aspect_ratio, vfov, defocus_angle, focus_dist,
-                        image_width, samples_per_pixel, max_depth,
-                        look_from, look_at, vup);
+void FinalScene(uint32_t image_width, 
+                uint32_t samples_per_pixel, 
+                uint32_t max_depth,
+                const std::string& checkpoint_file) {
+    RayTracing::HittableList boxes1;
+    auto ground = std::make_shared<RayTracing::Lambertian>(
+                    RayTracing::Color(0.48, 0.83, 0.53));
 
-    cam.SetBackground(RayTracing::Color(0.70, 0.80, 1.00));
+    uint32_t boxes_per_side = 20;
+    for (uint32_t i = 0; i < boxes_per_side; ++i) {
+        for (uint32_t j = 0; j < boxes_per_side; ++j) {
+            double w = 100.0;
+            double x0 = -1000.0 + i * w;
+            double y0 = 0.0;
+            double z0 = -1000.0 + j * w;
+            double x1 = x0 + w;
+            double y1 = RayTracing::RandomDouble(1.0, 101.0);
+            double z1 = z0 + w;
 
-    auto t1 = std::chrono::high_resolution_clock::now();
-    cam.Render(RayTracing::HittableList(
-            std::vector<std::shared_ptr<RayTracing::Hittable>>{globe}), 
-            lights, true);
-    
-    auto t2 = std::chrono::high_resolution_clock::now();
+            boxes1.Add(RayTracing::Box(
+                        RayTracing::Point3(x0, y0, z0),
+                        RayTracing::Point3(x1, y1, z1),
+                        ground));
+        }
+    }
 
-    std::chrono::duration<double, std::milli> ms = t2 - t1;
+    RayTracing::HittableList world;
+    auto boxes1_bvh = std::make_shared<RayTracing::WideBVH>(boxes1);
+    LogBuildStats("boxes1", boxes1_bvh->GetBuildStats());
+    world.Add(boxes1_bvh);
 
-    std::clog << "parallel execution time: " << ms.count() << '\n';
-}
+    auto light = std::make_shared<RayTracing::DiffuseLight>(
+                RayTracing::Color(7, 7, 7));
+    world.Add(std::make_shared<RayTracing::Quad>(
+                RayTracing::Point3(123, 554, 147),
+                RayTracing::Vec3(300, 0, 0),
+                RayTracing::Vec3(0, 0, 265),
+                light));
 
-void PerlinSpheres() {
-    RayTracing::HittableList world;
+    RayTracing::Point3 center1(400, 400, 200);
+    RayTracing::Point3 center2(center1 + RayTracing::Vec3(30, 0, 0));
+    auto sphere_material = std::make_shared<RayTracing::Lambertian>(
+                            RayTracing::Color(0.7, 0.3, 0.1));
+    world.Add(std::make_shared<RayTracing::Sphere>(
+                center1, center2, 50.0, sphere_material));
 
-    auto pertext = std::make_shared<RayTracing::NoiseTexture>(4.0);
     world.Add(std::make_shared<RayTracing::Sphere>(
-            RayTracing::Point3(0, -1000, 0), 1000, 
-            std::make_shared<RayTracing::Lambertian>(pertext)));
+                RayTracing::Point3(260, 150, 45), 50, 
+                std::make_shared<RayTracing::Dielectric>(1.5)));
     world.Add(std::make_shared<RayTracing::Sphere>(
-            RayTracing::Point3(0, 2, 0), 2, 
-            std::make_shared<RayTracing::Lambertian>(pertext)));
-
-    // ligth sources
-    auto empty_material = std::shared_ptr<RayTracing::Material>();
-    RayTracing::Quad lights(RayTracing::Point3(13.0, 2.0, 3.0), 
-                            RayTracing::Vec3(400.0, 0.0, 0.0),
-                            RayTracing::Vec3(0.0, 225.0, 0.0),
-                            empty_material);
-    
-    double aspect_ratio = 16.0 / 9.0;
-    double vfov = 20.0;
-    double defocus_angle = 0.0;
-    double focus_dist = 10.0;
-    uint32_t image_width = 400;
-    uint32_t samples_per_pixel = 100;
-    uint32_t max_depth = 50;
-    RayTracing::Point3 look_from(13, 2, 3);
-    RayTracing::Point3 look_at(0, 0, 0);
-    RayTracing::Vec3 vup(0, 1, 0);
-
-    RayTracing::Camera cam(aspect_ratio, vfov, defocus_angle, focus_dist,
-                        image_width, samples_per_pixel, max_depth,
-                        look_from, look_at, vup);
+                RayTracing::Point3(0, 150, 145), 50,
+                std::make_shared<RayTracing::Metal>(
+                    RayTracing::Color(0.8, 0.8, 0.9), 1.0)));
 
-    cam.SetBackground(RayTracing::Color(0.70, 0.80, 1.00));
+    auto boundary = std::make_shared<RayTracing::Sphere>(
+                    RayTracing::Point3(360, 150, 145), 70,
+                    std::make_shared<RayTracing::Dielectric>(1.5));
+    world.Add(boundary);
+    world.Add(std::make_shared<RayTracing::ConstantMedium>(
+                boundary, 0.2,
+                RayTracing::Color(0.2, 0.4, 0.9)));
+    boundary = std::make_shared<RayTracing::Sphere>(
+                RayTracing::Point3(0, 0, 0), 5000,
+                std::make_shared<RayTracing::Dielectric>(1.5));
+    world.Add(std::make_shared<RayTracing::ConstantMedium>(
+                boundary, 0.0001,
+                RayTracing::Color(1, 1, 1)));
 
-    auto t1 = std::chrono::high_resolution_clock::now();
-    cam.Render(world, lights, true);
-    auto t2 = std::chrono::high_resolution_clock::now();
+    auto emat = std::make_shared<RayTracing::Lambertian>(
+                std::make_shared<RayTracing::ImageTexture>("earthmap.jpg"));
+    world.Add(std::make_shared<RayTracing::Sphere>(
+                RayTracing::Point3(400, 200, 400), 100, emat));
 
-    std::chrono::duration<double, std::milli> ms = t2 - t1;
+    auto pertext = std::make_shared<RayTracing::NoiseTexture>(0.2);
+    world.Add(std::make_shared<RayTracing::Sphere>(
+                RayTracing::Point3(220, 280, 300), 80,
+                std::make_shared<RayTracing::Lambertian>(pertext)));
 
-    std::clog << "parallel execution time: " << ms.count() << '\n';
-}
+    std::vector<RayTracing::Point3> boxes2_centers;
+    
+    auto white = std::make_shared<RayTracing::Lambertian>(
+                    RayTracing::Color(0.73, 0.73, 0.73));
+    uint32_t ns = 1000;
 
-void Quads() {
-    RayTracing::HittableList world;
+    for (uint32_t i = 0; i < ns; ++i) {
+        boxes2_centers.push_back(RayTracing::Point3::Random(0, 165));
+    }
 
-    // Materials
-    auto left_red = std::make_shared<RayTracing::Lambertian>(
-                    RayTracing::Color(1.0, 0.2, 0.2));
-    auto back_green = std::make_shared<RayTracing::Lambertian>(
-                    RayTracing::Color(0.2, 1.0, 0.2));
-    auto right_blue = std::make_shared<RayTracing::Lambertian>(
-                    RayTracing::Color(0.2, 0.2, 1.0));
-    auto upper_orange = std::make_shared<RayTracing::Lambertian>(
-                    RayTracing::Color(1.0, 0.5, 0.0));
-    auto lower_teal = std::make_shared<RayTracing::Lambertian>(
-                    RayTracing::Color(0.2, 0.8, 0.8));
-
-    // Quads
-    world.Add(std::make_shared<RayTracing::Disk>(
-            RayTracing::Point3(-3,-0.5, 2.5), 
-            RayTracing::Vec3(0, 0,-4), 
-            RayTracing::Vec3(0, 4, 0), left_red, 0.7));
-    world.Add(std::make_shared<RayTracing::Quad>(
-            RayTracing::Point3(-2,-2, 0), 
-            RayTracing::Vec3(4, 0, 0), 
-            RayTracing::Vec3(0, 4, 0), back_green));
-    world.Add(std::make_shared<RayTracing::Triangle>(
-            RayTracing::Point3( 3,-2, 1), 
-            RayTracing::Vec3(0, 0, 4), 
-            RayTracing::Vec3(0, 4, 0), right_blue));
-    world.Add(std::make_shared<RayTracing::Quad>(
-            RayTracing::Point3(-2, 3, 1), 
-            RayTracing::Vec3(4, 0, 0), 
-            RayTracing::Vec3(0, 0, 4), upper_orange));
-    world.Add(std::make_shared<RayTracing::Quad>(
-            RayTracing::Point3(-2,-3, 5), 
-            RayTracing::Vec3(4, 0, 0), 
-            RayTracing::Vec3(0, 0,-4), lower_teal));
+    auto boxes2 = std::make_shared<RayTracing::SphereSet>(boxes2_centers,
+                    std::vector<double>(ns, 10.0),
+                    std::vector<std::shared_ptr<RayTracing::Material>>(ns,
+                                                                    white));
+    LogBuildStats("boxes2", boxes2->GetBuildStats());
+    world.Add(std::make_shared<RayTracing::Instance>(boxes2, 
+                RayTracing::Transform::Translation(
+                    RayTracing::Vec3(-100, 270, 395)) *
+                RayTracing::Transform::RotationY(15.0)));
 
     // ligth sources
     auto empty_material = std::shared_ptr<RayTracing::Material>();
-    RayTracing::Quad lights(RayTracing::Point3(0.0, 0.0, 9.0), 
-                            RayTracing::Vec3(400.0, 0.0, 0.0),
-                            RayTracing::Vec3(0.0, 225.0, 0.0),
+    RayTracing::Quad lights(RayTracing::Point3(123, 554, 147),
+                            RayTracing::Vec3(300, 0, 0),
+                            RayTracing::Vec3(0, 0, 265),
                             empty_material);
 
     double aspect_ratio = 1.0;
-    double vfov = 80.0;
+    double vfov = 40.0;
     double defocus_angle = 0.0;
     double focus_dist = 10.0;
-    uint32_t image_width = 400;
-    uint32_t samples_per_pixel = 100;
-    uint32_t max_depth = 50;
-    RayTracing::Point3 look_from(0, 0, 9);
-    RayTracing::Point3 look_at(0, 0, 0);
+    RayTracing::Point3 look_from(478, 278, -600);
+    RayTracing::Point3 look_at(278, 278, 0);
     RayTracing::Vec3 vup(0, 1, 0);
 
     RayTracing::Camera cam(aspect_ratio, vfov, defocus_angle, focus_dist,
                         image_width, samples_per_pixel, max_depth,
                         look_from, look_at, vup);
 
-    cam.SetBackground(RayTracing::Color(0.70, 0.80, 1.00));
+    cam.SetOutputFile(g_output_file);
+    cam.SetIntegrator(g_integrator);
+    // long renders show up in passes of 16 spp, with a snapshot 
+    // (and checkpoint) every minute
+    cam.SetPassSamples(16);
+    cam.SetSnapshotInterval(60.0);
+    cam.SetTimeBudget(g_time_budget);
+    cam.SetCheckpointFile(checkpoint_file);
+    // flat walls and the sky converge long before the smoke and the 
+    // glass, samples per pixel end up in image_spp.ppm
+    cam.SetAdaptiveSampling(64, 0.03);
+    cam.SetSampleMapFile(SiblingFile(g_output_file, "_spp.ppm"));
 
     auto t1 = std::chrono::high_resolution_clock::now();
     cam.Render(world, lights, true);
@@ -394,67 +383,28 @@ void Quads() {
     std::clog << "parallel execution time: " << ms.count() << '\n';
 }
 
-void SimpleLight() {
-    RayTracing::HittableList world;
-
-    auto pertex = std::make_shared<RayTracing::NoiseTexture>(4.0);
-
-    world.Add(std::make_shared<RayTracing::Sphere>(
-            RayTracing::Point3(0, -1000, 0), 1000, 
-            std::make_shared<RayTracing::Lambertian>(pertex)));
-    world.Add(std::make_shared<RayTracing::Sphere>(
-            RayTracing::Point3(0, 2, 0), 2, 
-            std::make_shared<RayTracing::Lambertian>(pertex)));
-
-    auto difflight = std::make_shared<RayTracing::DiffuseLight>(
-                    RayTracing::Color(4, 4, 4));
-    world.Add(std::make_shared<RayTracing::Quad>(
-            RayTracing::Point3(3, 1, -2),
-            RayTracing::Vec3(2, 0, 0),
-            RayTracing::Vec3(0, 2, 0),
-            difflight));
-    world.Add(std::make_shared<RayTracing::Sphere>(
-            RayTracing::Point3(0, 7, 0), 2, difflight));
-
-    // ligth sources
-    auto empty_material = std::shared_ptr<RayTracing::Material>();
-    RayTracing::HittableList lights;
-    lights.Add(std::make_shared<RayTracing::Quad>(
-            RayTracing::Point3(3, 1, -2),
-            RayTracing::Vec3(2, 0, 0),
-            RayTracing::Vec3(0, 2, 0),
-            empty_material));
-    lights.Add(std::make_shared<RayTracing::Sphere>(
-            RayTracing::Point3(0, 7, 0), 2, empty_material));
-
-    double aspect_ratio = 16.0 / 9.0;
-    double vfov = 20.0;
-    double defocus_angle = 0.0;
-    double focus_dist = 10.0;
-    uint32_t image_width = 400;
-    uint32_t samples_per_pixel = 100;
-    uint32_t max_depth = 50;
-    RayTracing::Point3 look_from(26, 3, 6);
-    RayTracing::Point3 look_at(0, 2, 0);
-    RayTracing::Vec3 vup(0, 1, 0);
-
-    RayTracing::Camera cam(aspect_ratio, vfov, defocus_angle, focus_dist,
-                        image_width, samples_per_pixel, max_depth,
-                        look_from, look_at, vup);
-
+// filename without its extension, followed by suffix
+std::string SiblingFile(const std::string& filename, const std::string& suffix) {
+    size_t dot = filename.rfind('.');
+    size_t slash = filename.find_last_of("/\\");
 
-    auto t1 = std::chrono::high_resolution_clock::now();
-    cam.Render(world, lights, true);
-    auto t2 = std::chrono::high_resolution_clock::now();
-
-    std::chrono::duration<double, std::milli> ms = t2 - t1;
+    if ((dot == std::string::npos) || 
+        ((slash != std::string::npos) && (dot < slash))) {
+        return filename + suffix;
+    }
 
-    std::clog << "parallel execution time: " << ms.count() << '\n';
+    return filename.substr(0, dot) + suffix;
 }
 
-void CornellBox() {
-    RayTracing::HittableList world;
+void LogBuildStats(const char *name, const RayTracing::BVHBuildStats& stats) {
+    std::clog << name << " BVH: " << stats.build_ms << " ms, "
+            << stats.node_count << " nodes, "
+            << stats.leaf_count << " leaves, SAH cost "
+            << stats.sah_cost << '\n';
+}
 
+void CornellBoxScene(RayTracing::HittableList& world, 
+                    RayTracing::HittableList& lights) {
     auto red = std::make_shared<RayTracing::Lambertian>(
                 RayTracing::Color(0.65, 0.05, 0.05));
     auto white = std::make_shared<RayTracing::Lambertian>(
@@ -499,9 +449,10 @@ void CornellBox() {
                 RayTracing::Point3(0, 0, 0),
                 RayTracing::Point3(165, 330, 165),
                 white);
-    box1 = std::make_shared<RayTracing::RotateY>(box1, 15);
-    box1 = std::make_shared<RayTracing::Translate>(box1, 
-                            RayTracing::Vec3(265, 0, 295));
+    box1 = std::make_shared<RayTracing::Instance>(box1, 
+                RayTracing::Transform::Translation(
+                    RayTracing::Vec3(265, 0, 295)) *
+                RayTracing::Transform::RotationY(15.0));
 
     auto glass = std::make_shared<RayTracing::Dielectric>(1.5);
     auto sphere = std::make_shared<RayTracing::Sphere>(
@@ -514,7 +465,6 @@ void CornellBox() {
 
     // ligth sources
     auto empty_material = std::shared_ptr<RayTracing::Material>();
-    RayTracing::HittableList lights;
     auto quad_light = std::make_shared<RayTracing::Quad>(
                             RayTracing::Point3(343, 554, 332), 
                             RayTracing::Vec3(-130, 0, 0),
@@ -527,33 +477,90 @@ void CornellBox() {
 
     lights.Add(quad_light);
     lights.Add(sphere_light);
+}
 
-    double aspect_ratio = 1.0;
-    double vfov = 40.0;
-    double defocus_angle = 0.0;
-    double focus_dist = 10.0;
-    uint32_t image_width = 600;
-    uint32_t samples_per_pixel = 100;
-    uint32_t max_depth = 50;
-    RayTracing::Point3 look_from(278, 278, -800);
-    RayTracing::Point3 look_at(278, 278, 0);
-    RayTracing::Vec3 vup(0, 1, 0);
+// Renders a small Cornell box at 1 and at 16 samples per pixel and compares
+// the heap allocations of the two renders, with both integrators. Setup 
+// costs (threads, the framebuffer, wavefront buffers, log output) are the
+// same for both, so the difference is what the additional samples 
+// allocated and has to be 0.
+void AllocationBenchmark() {
+    RayTracing::HittableList world;
+    RayTracing::HittableList lights;
 
-    RayTracing::Camera cam(aspect_ratio, vfov, defocus_angle, focus_dist,
-                        image_width, samples_per_pixel, max_depth,
-                        look_from, look_at, vup);
+    CornellBoxScene(world, lights);
+
+    uint32_t image_width = 100;
+    uint32_t sample_counts[2] = {1, 16};
+    RayTracing::Camera::Integrator integrators[2] = {
+                                RayTracing::Camera::Integrator::PATH,
+                                RayTracing::Camera::Integrator::WAVEFRONT};
+    const char *integrator_names[2] = {"path", "wavefront"};
+
+    for (size_t k = 0; k < 2; ++k) {
+        uint64_t allocations[2];
+        double ms_per_sample[2];
+
+        for (size_t i = 0; i < 2; ++i) {
+            RayTracing::Camera cam(1.0, 40.0, 0.0, 10.0, 
+                                image_width, sample_counts[i], 50,
+                                RayTracing::Point3(278, 278, -800),
+                                RayTracing::Point3(278, 278, 0),
+                                RayTracing::Vec3(0, 1, 0));
+
+            // the image itself is not needed
+            cam.SetOutputFile("");
+            cam.SetIntegrator(integrators[k]);
+
+            uint64_t allocations_before = RayTracing::HeapAllocationCount();
+            auto t1 = std::chrono::high_resolution_clock::now();
+            cam.Render(world, lights, true);
+            auto t2 = std::chrono::high_resolution_clock::now();
+
+            std::chrono::duration<double, std::milli> ms = t2 - t1;
+            allocations[i] = RayTracing::HeapAllocationCount() - 
+                            allocations_before;
+            ms_per_sample[i] = ms.count() / 
+                            (image_width * image_width * sample_counts[i]);
+        }
+
+        uint64_t extra_samples = static_cast<uint64_t>(image_width) * 
+                            image_width * (sample_counts[1] - sample_counts[0]);
 
+        for (size_t i = 0; i < 2; ++i) {
+            std::clog << integrator_names[k] << ", " << sample_counts[i] 
+                    << " spp: " << allocations[i] << " heap allocations, " 
+                    << ms_per_sample[i] * 1000.0 << " us per sample\n";
+        }
+
+        std::clog << integrator_names[k] << ", heap allocations per sample: " 
+                << static_cast<double>(allocations[1] - allocations[0]) / 
+                    extra_samples << '\n';
+    }
+}
+
+// Cornell box around the mesh file named by the MESH environment variable
+// (mesh.obj by default), scaled to stand on the floor.
+void MeshCornellBox() {
+    const char *mesh_file = getenv("MESH");
+    RayTracing::MeshData mesh_data;
 
     auto t1 = std::chrono::high_resolution_clock::now();
-    cam.Render(world, lights, true);
+    bool loaded = RayTracing::MeshLoader::Load(
+                    (mesh_file != nullptr) ? mesh_file : "mesh.obj", mesh_data);
     auto t2 = std::chrono::high_resolution_clock::now();
 
-    std::chrono::duration<double, std::milli> ms = t2 - t1;
+    std::chrono::duration<double, std::milli> load_ms = t2 - t1;
 
-    std::clog << "parallel execution time: " << ms.count() << '\n';
-}
+    if (!loaded) {
+        return;
+    }
+
+    std::clog << "mesh: " << mesh_data.GetTriangleCount() << " triangles, "
+            << "loaded in " << load_ms.count() << " ms\n";
+
+    FitMesh(mesh_data, RayTracing::Point3(278, 0, 278), 350);
 
-void CornellSmoke() {
     RayTracing::HittableList world;
 
     auto red = std::make_shared<RayTracing::Lambertian>(
@@ -563,7 +570,7 @@ void CornellSmoke() {
     auto green = std::make_shared<RayTracing::Lambertian>(
                 RayTracing::Color(0.12, 0.45, 0.15));
     auto light = std::make_shared<RayTracing::DiffuseLight>(
-                RayTracing::Color(7, 7, 7));
+                RayTracing::Color(15, 15, 15));
 
     world.Add(std::make_shared<RayTracing::Quad>(
             RayTracing::Point3(555, 0, 0),
@@ -576,9 +583,9 @@ void CornellSmoke() {
             RayTracing::Vec3(0, 0, 555),
             red));
     world.Add(std::make_shared<RayTracing::Quad>(
-            RayTracing::Point3(113, 554, 127),
-            RayTracing::Vec3(330, 0, 0),
-            RayTracing::Vec3(0, 0, 305),
+            RayTracing::Point3(343, 554, 332),
+            RayTracing::Vec3(-130, 0, 0),
+            RayTracing::Vec3(0, 0, -105),
             light));
     world.Add(std::make_shared<RayTracing::Quad>(
             RayTracing::Point3(0, 0, 0),
@@ -595,27 +602,11 @@ void CornellSmoke() {
             RayTracing::Vec3(555, 0, 0),
             RayTracing::Vec3(0, 555, 0),
             white));
-    
-    std::shared_ptr<RayTracing::Hittable> box1 = RayTracing::Box(
-                RayTracing::Point3(0, 0, 0),
-                RayTracing::Point3(165, 330, 165),
-                white);
-    box1 = std::make_shared<RayTracing::RotateY>(box1, 15);
-    box1 = std::make_shared<RayTracing::Translate>(box1, 
-                            RayTracing::Vec3(265, 0, 295));
 
-    std::shared_ptr<RayTracing::Hittable> box2 = RayTracing::Box(
-                RayTracing::Point3(0, 0, 0),
-                RayTracing::Point3(165, 165, 165),
-                white);
-    box2 = std::make_shared<RayTracing::RotateY>(box2, -18);
-    box2 = std::make_shared<RayTracing::Translate>(box2, 
-                            RayTracing::Vec3(130, 0, 65));
-
-    world.Add(std::make_shared<RayTracing::ConstantMedium>(
-                box1, 0.01, RayTracing::Color(0, 0, 0)));
-    world.Add(std::make_shared<RayTracing::ConstantMedium>(
-                box2, 0.01, RayTracing::Color(1, 1, 1)));
+    auto mesh = std::make_shared<RayTracing::TriangleMesh>(
+                    std::move(mesh_data), white);
+    LogBuildStats("mesh", mesh->GetBuildStats());
+    world.Add(mesh);
 
     // ligth sources
     auto empty_material = std::shared_ptr<RayTracing::Material>();
@@ -629,7 +620,7 @@ void CornellSmoke() {
     double defocus_angle = 0.0;
     double focus_dist = 10.0;
     uint32_t image_width = 600;
-    uint32_t samples_per_pixel = 200;
+    uint32_t samples_per_pixel = 100;
     uint32_t max_depth = 50;
     RayTracing::Point3 look_from(278, 278, -800);
     RayTracing::Point3 look_at(278, 278, 0);
@@ -639,130 +630,125 @@ void CornellSmoke() {
                         image_width, samples_per_pixel, max_depth,
                         look_from, look_at, vup);
 
-    auto t1 = std::chrono::high_resolution_clock::now();
+    cam.SetOutputFile(g_output_file);
+    cam.SetIntegrator(g_integrator);
+
+    t1 = std::chrono::high_resolution_clock::now();
     cam.Render(world, lights, true);
-    auto t2 = std::chrono::high_resolution_clock::now();
+    t2 = std::chrono::high_resolution_clock::now();
 
     std::chrono::duration<double, std::milli> ms = t2 - t1;
 
     std::clog << "parallel execution time: " << ms.count() << '\n';
 }
 
-void FinalScene(uint32_t image_width, 
-                uint32_t samples_per_pixel, 
-                uint32_t max_depth) {
-    RayTracing::HittableList boxes1;
-    auto ground = std::make_shared<RayTracing::Lambertian>(
-                    RayTracing::Color(0.48, 0.83, 0.53));
+// Scales and moves the mesh so its largest extent is size and the center
+// of the bottom of its bounding box is at base.
+void FitMesh(RayTracing::MeshData& data, const RayTracing::Point3& base, 
+            double size) {
+    size_t num_values = data.positions.size();
+    float min[3] = {INFINITY, INFINITY, INFINITY};
+    float max[3] = {-INFINITY, -INFINITY, -INFINITY};
+
+    for (size_t i = 0; i < num_values; ++i) {
+        min[i % 3] = std::fmin(min[i % 3], data.positions[i]);
+        max[i % 3] = std::fmax(max[i % 3], data.positions[i]);
+    }
 
-    uint32_t boxes_per_side = 20;
-    for (uint32_t i = 0; i < boxes_per_side; ++i) {
-        for (uint32_t j = 0; j < boxes_per_side; ++j) {
-            double w = 100.0;
-            double x0 = -1000.0 + i * w;
-            double y0 = 0.0;
-            double z0 = -1000.0 + j * w;
-            double x1 = x0 + w;
-            double y1 = RayTracing::RandomDouble(1.0, 101.0);
-            double z1 = z0 + w;
+    double extent = std::fmax(max[0] - min[0], 
+                            std::fmax(max[1] - min[1], max[2] - min[2]));
+    double scale = (extent > 0.0) ? (size / extent) : 1.0;
+    double offset[3] = {
+        base.GetX() - scale * 0.5 * (min[0] + max[0]),
+        base.GetY() - scale * min[1],
+        base.GetZ() - scale * 0.5 * (min[2] + max[2])
+    };
+
+    for (size_t i = 0; i < num_values; ++i) {
+        data.positions[i] = static_cast<float>(scale * data.positions[i] + 
+                                                offset[i % 3]);
+    }
+}
 
-            boxes1.Add(RayTracing::Box(
-                        RayTracing::Point3(x0, y0, z0),
-                        RayTracing::Point3(x1, y1, z1),
-                        ground));
-        }
+// Renders a scene file, text or compiled, with the output file, time budget
+// and integrator of the command line.
+bool RenderSceneFile(const std::string& filename) {
+    RayTracing::SceneDescription desc;
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    if (!RayTracing::SceneLoader::Load(filename, desc)) {
+        return false;
     }
 
-    RayTracing::HittableList world;
-    world.Add(std::make_shared<RayTracing::BVHNode>(boxes1));
+    size_t slash = filename.find_last_of("/\\");
+    std::string base_dir = (slash == std::string::npos) ? 
+                            "" : filename.substr(0, slash);
+    RayTracing::Scene scene(desc, base_dir);
 
-    auto light = std::make_shared<RayTracing::DiffuseLight>(
-                RayTracing::Color(7, 7, 7));
-    world.Add(std::make_shared<RayTracing::Quad>(
-                RayTracing::Point3(123, 554, 147),
-                RayTracing::Vec3(300, 0, 0),
-                RayTracing::Vec3(0, 0, 265),
-                light));
+    if (!scene.IsValid()) {
+        return false;
+    }
 
-    RayTracing::Point3 center1(400, 400, 200);
-    RayTracing::Point3 center2(center1 + RayTracing::Vec3(30, 0, 0));
-    auto sphere_material = std::make_shared<RayTracing::Lambertian>(
-                            RayTracing::Color(0.7, 0.3, 0.1));
-    world.Add(std::make_shared<RayTracing::Sphere>(
-                center1, center2, 50.0, sphere_material));
+    auto t2 = std::chrono::high_resolution_clock::now();
 
-    world.Add(std::make_shared<RayTracing::Sphere>(
-                RayTracing::Point3(260, 150, 45), 50, 
-                std::make_shared<RayTracing::Dielectric>(1.5)));
-    world.Add(std::make_shared<RayTracing::Sphere>(
-                RayTracing::Point3(0, 150, 145), 50,
-                std::make_shared<RayTracing::Metal>(
-                    RayTracing::Color(0.8, 0.8, 0.9), 1.0)));
+    std::chrono::duration<double, std::milli> load_ms = t2 - t1;
 
-    auto boundary = std::make_shared<RayTracing::Sphere>(
-                    RayTracing::Point3(360, 150, 145), 70,
-                    std::make_shared<RayTracing::Dielectric>(1.5));
-    world.Add(boundary);
-    world.Add(std::make_shared<RayTracing::ConstantMedium>(
-                boundary, 0.2,
-                RayTracing::Color(0.2, 0.4, 0.9)));
-    boundary = std::make_shared<RayTracing::Sphere>(
-                RayTracing::Point3(0, 0, 0), 5000,
-                std::make_shared<RayTracing::Dielectric>(1.5));
-    world.Add(std::make_shared<RayTracing::ConstantMedium>(
-                boundary, 0.0001,
-                RayTracing::Color(1, 1, 1)));
+    std::clog << "scene: " << desc.shapes.size() << " shapes, " 
+            << desc.materials.size() << " materials, " 
+            << desc.textures.size() << " textures, built in " 
+            << load_ms.count() << " ms\n";
 
-    auto emat = std::make_shared<RayTracing::Lambertian>(
-                std::make_shared<RayTracing::ImageTexture>("earthmap.jpg"));
-    world.Add(std::make_shared<RayTracing::Sphere>(
-                RayTracing::Point3(400, 200, 400), 100, emat));
+    RayTracing::Camera cam = scene.CreateCamera();
 
-    auto pertext = std::make_shared<RayTracing::NoiseTexture>(0.2);
-    world.Add(std::make_shared<RayTracing::Sphere>(
-                RayTracing::Point3(220, 280, 300), 80,
-                std::make_shared<RayTracing::Lambertian>(pertext)));
+    cam.SetOutputFile(g_output_file);
+    cam.SetIntegrator(g_integrator);
+    cam.SetTimeBudget(g_time_budget);
 
-    RayTracing::HittableList boxes2;
-    
-    auto white = std::make_shared<RayTracing::Lambertian>(
-                    RayTracing::Color(0.73, 0.73, 0.73));
-    uint32_t ns = 1000;
+    t1 = std::chrono::high_resolution_clock::now();
+    cam.Render(scene.GetWorld(), scene.GetLights(), true);
+    t2 = std::chrono::high_resolution_clock::now();
 
-    for (uint32_t i = 0; i < ns; ++i) {
-        boxes2.Add(std::make_shared<RayTracing::Sphere>(
-                    RayTracing::Point3::Random(0, 165), 10, white));
-    }
+    std::chrono::duration<double, std::milli> ms = t2 - t1;
 
-    world.Add(std::make_shared<RayTracing::Translate>(
-                std::make_shared<RayTracing::RotateY>(
-                    std::make_shared<RayTracing::BVHNode>(boxes2), 15.0),
-                    RayTracing::Vec3(-100, 270, 395)));
+    std::clog << "parallel execution time: " << ms.count() << '\n';
 
-    // ligth sources
-    auto empty_material = std::shared_ptr<RayTracing::Material>();
-    RayTracing::Quad lights(RayTracing::Point3(123, 554, 147),
-                            RayTracing::Vec3(300, 0, 0),
-                            RayTracing::Vec3(0, 0, 265),
-                            empty_material);
+    return true;
+}
 
-    double aspect_ratio = 1.0;
-    double vfov = 40.0;
-    double defocus_angle = 0.0;
-    double focus_dist = 10.0;
-    RayTracing::Point3 look_from(478, 278, -600);
-    RayTracing::Point3 look_at(278, 278, 0);
-    RayTracing::Vec3 vup(0, 1, 0);
+bool CompileSceneFile(const std::string& filename, 
+                    const std::string& compiled_filename) {
+    RayTracing::SceneDescription desc;
 
-    RayTracing::Camera cam(aspect_ratio, vfov, defocus_angle, focus_dist,
-                        image_width, samples_per_pixel, max_depth,
-                        look_from, look_at, vup);
+    return (RayTracing::SceneLoader::Load(filename, desc) &&
+            RayTracing::SceneLoader::SaveCompiled(compiled_filename, desc));
+}
 
-    auto t1 = std::chrono::high_resolution_clock::now();
-    cam.Render(world, lights, true);
-    auto t2 = std::chrono::high_resolution_clock::now();
+// The scene files of the examples are looked up like image textures: in 
+// the SCENES directory, then in scenes/ and ../scenes/.
+std::string FindSceneFile(const std::string& filename) {
+    const char *scene_dir = getenv("SCENES");
+    std::vector<std::string> candidates;
+    uint64_t size = 0;
+    int64_t mtime = 0;
 
-    std::chrono::duration<double, std::milli> ms = t2 - t1;
+    if (scene_dir != nullptr) {
+        candidates.push_back(std::string(scene_dir) + '/' + filename);
+    }
 
-    std::clog << "parallel execution time: " << ms.count() << '\n';
-}
\ No newline at end of file
+    candidates.push_back("scenes/" + filename);
+    candidates.push_back("../scenes/" + filename);
+
+    for (const std::string& candidate : candidates) {
+        if (RayTracing::MappedFile::Stat(candidate, size, mtime)) {
+            return candidate;
+        }
+    }
+
+    return filename;
+}
+
+bool IsNumber(const std::string& str) {
+    return (!str.empty() && 
+            (str.find_first_not_of("0123456789") == std::string::npos));
+}
@@ -0,0 +1,109 @@
+#include <cstdio>
+#include <sys/stat.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RT_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "mapped_file.hpp"
+
+namespace RayTracing {
+
+bool MappedFile::Open(const std::string& filename) {
+    static const char empty[1] = {0};
+
+    Close();
+
+    uint64_t size = 0;
+    int64_t mtime = 0;
+
+    if (!Stat(filename, size, mtime)) {
+        return false;
+    }
+
+    if (size == 0) {
+        m_data = empty;
+        m_open = true;
+
+        return true;
+    }
+
+#ifdef RT_HAS_MMAP
+    int fd = open(filename.c_str(), O_RDONLY);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    void *data = mmap(nullptr, static_cast<size_t>(size), PROT_READ,
+                    MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data != MAP_FAILED) {
+        // parsed front to back
+        madvise(data, static_cast<size_t>(size), MADV_SEQUENTIAL);
+        m_data = static_cast<const char *>(data);
+        m_size = static_cast<size_t>(size);
+        m_mapped = true;
+        m_open = true;
+
+        return true;
+    }
+#endif
+
+    std::FILE *file = std::fopen(filename.c_str(), "rb");
+
+    if (file == nullptr) {
+        return false;
+    }
+
+    m_buffer.resize(static_cast<size_t>(size));
+    bool read = (std::fread(m_buffer.data(), 1, m_buffer.size(), file) ==
+                m_buffer.size());
+    std::fclose(file);
+
+    if (!read) {
+        std::vector<char>().swap(m_buffer);
+
+        return false;
+    }
+
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    m_open = true;
+
+    return true;
+}
+
+void MappedFile::Close() {
+#ifdef RT_HAS_MMAP
+    if (m_mapped) {
+        munmap(const_cast<char *>(m_data), m_size);
+    }
+#endif
+
+    std::vector<char>().swap(m_buffer);
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+    m_open = false;
+}
+
+bool MappedFile::Stat(const std::string& filename,
+                    uint64_t& size, int64_t& mtime) {
+    struct stat info;
+
+    if (stat(filename.c_str(), &info) != 0) {
+        return false;
+    }
+
+    size = static_cast<uint64_t>(info.st_size);
+    mtime = static_cast<int64_t>(info.st_mtime);
+
+    return true;
+}
+
+}
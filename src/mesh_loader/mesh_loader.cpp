@@ -0,0 +1,1167 @@
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <initializer_list>
+#include <unordered_map>
+#include <utility>
+
+#include "mesh_loader.hpp"
+#include "mapped_file.hpp"
+
+namespace RayTracing {
+
+constexpr const char *MeshLoader::CACHE_EXTENSION;
+constexpr char MeshLoader::MAGIC[8];
+
+namespace {
+
+constexpr uint32_t NO_INDEX = UINT32_MAX;
+
+bool IsDigit(char c) {
+    return ((c >= '0') && (c <= '9'));
+}
+
+// blanks within a line
+bool IsBlank(char c) {
+    return ((c == ' ') || (c == '\t') || (c == '\r'));
+}
+
+bool IsSpace(char c) {
+    return (IsBlank(c) || (c == '\n'));
+}
+
+void SkipBlanks(const char *&p, const char *end) {
+    while ((p < end) && IsBlank(*p)) {
+        ++p;
+    }
+}
+
+void SkipSpaces(const char *&p, const char *end) {
+    while ((p < end) && IsSpace(*p)) {
+        ++p;
+    }
+}
+
+// moves p past the end of the line
+void SkipLine(const char *&p, const char *end) {
+    const void *newline = std::memchr(p, '\n', static_cast<size_t>(end - p));
+
+    p = (newline == nullptr) ? end : (static_cast<const char *>(newline) + 1);
+}
+
+// Decimal number with optional fraction and exponent. The first 19
+// significant digits are kept, which is more than a double holds, and
+// scaled by an exact power of ten where there is one.
+bool ParseNumber(const char *&p, const char *end, double& value) {
+    static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    constexpr int max_digits = 19;
+    constexpr int max_power = 22;
+
+    const char *s = p;
+    bool negative = false;
+
+    if ((s < end) && ((*s == '-') || (*s == '+'))) {
+        negative = (*s == '-');
+        ++s;
+    }
+
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    int digits = 0;
+    bool any_digit = false;
+
+    for (; (s < end) && IsDigit(*s); ++s) {
+        any_digit = true;
+
+        if (digits < max_digits) {
+            mantissa = 10 * mantissa + static_cast<uint64_t>(*s - '0');
+            digits += (mantissa != 0);
+        }
+        else {
+            ++exponent;
+        }
+    }
+
+    if ((s < end) && (*s == '.')) {
+        for (++s; (s < end) && IsDigit(*s); ++s) {
+            any_digit = true;
+
+            if (digits < max_digits) {
+                mantissa = 10 * mantissa + static_cast<uint64_t>(*s - '0');
+                digits += (mantissa != 0);
+                --exponent;
+            }
+        }
+    }
+
+    if (!any_digit) {
+        return false;
+    }
+
+    if ((s < end) && ((*s == 'e') || (*s == 'E'))) {
+        const char *e = s + 1;
+        bool negative_exponent = false;
+        int exponent_value = 0;
+
+        if ((e < end) && ((*e == '-') || (*e == '+'))) {
+            negative_exponent = (*e == '-');
+            ++e;
+        }
+
+        if ((e < end) && IsDigit(*e)) {
+            for (; (e < end) && IsDigit(*e); ++e) {
+                if (exponent_value < 10000) {
+                    exponent_value = 10 * exponent_value + (*e - '0');
+                }
+            }
+
+            exponent += negative_exponent ? -exponent_value : exponent_value;
+            s = e;
+        }
+    }
+
+    double result = static_cast<double>(mantissa);
+
+    if ((exponent < 0) && (exponent >= -max_power)) {
+        result /= powers[-exponent];
+    }
+    else if ((exponent > 0) && (exponent <= max_power)) {
+        result *= powers[exponent];
+    }
+    else if (exponent != 0) {
+        result *= std::pow(10.0, exponent);
+    }
+
+    value = negative ? -result : result;
+    p = s;
+
+    return true;
+}
+
+bool ParseFloat(const char *&p, const char *end, float& value) {
+    double number = 0.0;
+
+    if (!ParseNumber(p, end, number)) {
+        return false;
+    }
+
+    value = static_cast<float>(number);
+
+    return true;
+}
+
+bool ParseInt(const char *&p, const char *end, int64_t& value) {
+    const char *s = p;
+    bool negative = false;
+
+    if ((s < end) && ((*s == '-') || (*s == '+'))) {
+        negative = (*s == '-');
+        ++s;
+    }
+
+    if ((s == end) || !IsDigit(*s)) {
+        return false;
+    }
+
+    int64_t result = 0;
+
+    for (; (s < end) && IsDigit(*s); ++s) {
+        if (result < (INT64_MAX / 10)) {
+            result = 10 * result + (*s - '0');
+        }
+    }
+
+    value = negative ? -result : result;
+    p = s;
+
+    return true;
+}
+
+// --- OBJ ---
+
+// OBJ indices are 1 based, negative ones count back from the last element
+// read so far.
+bool ResolveOBJIndex(int64_t index, size_t count, uint32_t& resolved) {
+    int64_t zero_based = (index > 0) ? (index - 1) :
+                        (static_cast<int64_t>(count) + index);
+
+    if ((index == 0) || (zero_based < 0) ||
+        (zero_based >= static_cast<int64_t>(count))) {
+        return false;
+    }
+
+    resolved = static_cast<uint32_t>(zero_based);
+
+    return true;
+}
+
+// Vertex of the mesh for a v/vt/vn corner of an OBJ face.
+struct OBJCorner {
+    uint32_t position;
+    uint32_t uv;
+    uint32_t normal;
+
+    bool operator==(const OBJCorner& other) const {
+        return ((position == other.position) && (uv == other.uv) &&
+                (normal == other.normal));
+    }
+};
+
+struct OBJCornerHash {
+    size_t operator()(const OBJCorner& corner) const {
+        uint64_t key = (static_cast<uint64_t>(corner.position) << 32) ^
+                    (static_cast<uint64_t>(corner.uv) << 16) ^ corner.normal;
+
+        return static_cast<size_t>(key * 0x9E3779B97F4A7C15ull);
+    }
+};
+
+// Turns the corners of OBJ faces into mesh vertices. OBJ indexes
+// positions, uvs and normals separately, a mesh vertex is one distinct
+// combination of them. Most positions are only used with one combination,
+// that one is kept per position and the others go into a hash map.
+class OBJVertexMap {
+public:
+    OBJVertexMap(const std::vector<float>& positions,
+                const std::vector<float>& uvs,
+                const std::vector<float>& normals,
+                MeshData& data);
+
+    uint32_t GetVertex(const OBJCorner& corner);
+    // Drops uvs and normals if some vertices lack them.
+    void Finish();
+
+private:
+    const std::vector<float>& m_positions;
+    const std::vector<float>& m_uvs;
+    const std::vector<float>& m_normals;
+    MeshData& m_data;
+    std::vector<uint32_t> m_first_vertex;       // per position
+    std::vector<OBJCorner> m_corners;           // per mesh vertex
+    std::unordered_map<OBJCorner, uint32_t, OBJCornerHash> m_other_vertices;
+    bool m_all_uvs;
+    bool m_all_normals;
+
+    uint32_t AddVertex(const OBJCorner& corner);
+};
+
+OBJVertexMap::OBJVertexMap(const std::vector<float>& positions,
+                        const std::vector<float>& uvs,
+                        const std::vector<float>& normals,
+                        MeshData& data) :
+m_positions(positions), m_uvs(uvs), m_normals(normals), m_data(data),
+m_all_uvs(true), m_all_normals(true)
+{}
+
+uint32_t OBJVertexMap::GetVertex(const OBJCorner& corner) {
+    if (m_first_vertex.size() <= corner.position) {
+        m_first_vertex.resize(m_positions.size() / 3, NO_INDEX);
+    }
+
+    uint32_t& first = m_first_vertex[corner.position];
+
+    if (first == NO_INDEX) {
+        first = AddVertex(corner);
+
+        return first;
+    }
+
+    if (m_corners[first] == corner) {
+        return first;
+    }
+
+    auto found = m_other_vertices.find(corner);
+
+    if (found != m_other_vertices.end()) {
+        return found->second;
+    }
+
+    uint32_t vertex = AddVertex(corner);
+    m_other_vertices.emplace(corner, vertex);
+
+    return vertex;
+}
+
+uint32_t OBJVertexMap::AddVertex(const OBJCorner& corner) {
+    const float *p = &m_positions[3 * static_cast<size_t>(corner.position)];
+
+    m_data.positions.insert(m_data.positions.end(), p, p + 3);
+
+    if (corner.uv != NO_INDEX) {
+        const float *uv = &m_uvs[2 * static_cast<size_t>(corner.uv)];
+        m_data.uvs.insert(m_data.uvs.end(), uv, uv + 2);
+    }
+    else {
+        m_data.uvs.insert(m_data.uvs.end(), 2, 0.0f);
+        m_all_uvs = false;
+    }
+
+    if (corner.normal != NO_INDEX) {
+        const float *n = &m_normals[3 * static_cast<size_t>(corner.normal)];
+        m_data.normals.insert(m_data.normals.end(), n, n + 3);
+    }
+    else {
+        m_data.normals.insert(m_data.normals.end(), 3, 0.0f);
+        m_all_normals = false;
+    }
+
+    m_corners.push_back(corner);
+
+    return static_cast<uint32_t>(m_corners.size() - 1);
+}
+
+void OBJVertexMap::Finish() {
+    if (!m_all_uvs || m_corners.empty()) {
+        std::vector<float>().swap(m_data.uvs);
+    }
+
+    if (!m_all_normals || m_corners.empty()) {
+        std::vector<float>().swap(m_data.normals);
+    }
+}
+
+// Reads the numbers of a v, vt or vn line into values: count of them, of
+// which the first required ones must be there and the others default to 0.
+bool ParseOBJValues(const char *&p, const char *end, std::vector<float>& values,
+                    size_t required, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        float value = 0.0f;
+
+        SkipBlanks(p, end);
+
+        if (!ParseFloat(p, end, value)) {
+            if (i < required) {
+                return false;
+            }
+
+            value = 0.0f;
+        }
+
+        values.push_back(value);
+    }
+
+    return true;
+}
+
+// v, v/vt, v//vn or v/vt/vn
+bool ParseOBJCorner(const char *&p, const char *end,
+                    const std::vector<float>& positions,
+                    const std::vector<float>& uvs,
+                    const std::vector<float>& normals,
+                    OBJCorner& corner) {
+    int64_t index = 0;
+
+    corner.uv = NO_INDEX;
+    corner.normal = NO_INDEX;
+
+    if (!ParseInt(p, end, index) ||
+        !ResolveOBJIndex(index, positions.size() / 3, corner.position)) {
+        return false;
+    }
+
+    if ((p == end) || (*p != '/')) {
+        return true;
+    }
+
+    ++p;
+
+    if ((p < end) && (*p != '/')) {
+        if (!ParseInt(p, end, index) ||
+            !ResolveOBJIndex(index, uvs.size() / 2, corner.uv)) {
+            return false;
+        }
+    }
+
+    if ((p == end) || (*p != '/')) {
+        return true;
+    }
+
+    ++p;
+
+    return (ParseInt(p, end, index) &&
+            ResolveOBJIndex(index, normals.size() / 3, corner.normal));
+}
+
+// --- PLY ---
+
+enum class PLYType {INT8, UINT8, INT16, UINT16, INT32, UINT32,
+                    FLOAT32, FLOAT64, INVALID};
+
+struct PLYProperty {
+    std::string name;
+    PLYType type;
+    PLYType count_type;     // of list properties
+    bool is_list;
+};
+
+struct PLYElement {
+    std::string name;
+    size_t count;
+    std::vector<PLYProperty> properties;
+};
+
+enum class PLYFormat {ASCII, BINARY_LITTLE_ENDIAN, BINARY_BIG_ENDIAN};
+
+PLYType ParsePLYType(const std::string& name) {
+    if ((name == "char") || (name == "int8")) {
+        return PLYType::INT8;
+    }
+    if ((name == "uchar") || (name == "uint8")) {
+        return PLYType::UINT8;
+    }
+    if ((name == "short") || (name == "int16")) {
+        return PLYType::INT16;
+    }
+    if ((name == "ushort") || (name == "uint16")) {
+        return PLYType::UINT16;
+    }
+    if ((name == "int") || (name == "int32")) {
+        return PLYType::INT32;
+    }
+    if ((name == "uint") || (name == "uint32")) {
+        return PLYType::UINT32;
+    }
+    if ((name == "float") || (name == "float32")) {
+        return PLYType::FLOAT32;
+    }
+    if ((name == "double") || (name == "float64")) {
+        return PLYType::FLOAT64;
+    }
+
+    return PLYType::INVALID;
+}
+
+size_t PLYTypeSize(PLYType type) {
+    switch (type) {
+        case PLYType::INT8:
+        case PLYType::UINT8:
+            return 1;
+        case PLYType::INT16:
+        case PLYType::UINT16:
+            return 2;
+        case PLYType::INT32:
+        case PLYType::UINT32:
+        case PLYType::FLOAT32:
+            return 4;
+        case PLYType::FLOAT64:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+bool IsHostLittleEndian() {
+    uint16_t value = 1;
+    uint8_t first_byte = 0;
+    std::memcpy(&first_byte, &value, 1);
+
+    return (first_byte == 1);
+}
+
+// Reads the values of a PLY body in either format.
+class PLYReader {
+public:
+    PLYReader(const char *begin, const char *end, PLYFormat format);
+
+    bool Read(PLYType type, double& value);
+    // Skips a property, including all items of a list.
+    bool Skip(const PLYProperty& property);
+    size_t GetOffset(const char *file) const;
+
+private:
+    const char *m_p;
+    const char *m_end;
+    bool m_ascii;
+    bool m_swap;
+
+    template <typename T>
+    bool ReadBinary(double& value);
+};
+
+PLYReader::PLYReader(const char *begin, const char *end, PLYFormat format) :
+m_p(begin), m_end(end), m_ascii(format == PLYFormat::ASCII),
+m_swap((format == PLYFormat::BINARY_LITTLE_ENDIAN) != IsHostLittleEndian())
+{}
+
+template <typename T>
+bool PLYReader::ReadBinary(double& value) {
+    if (static_cast<size_t>(m_end - m_p) < sizeof(T)) {
+        return false;
+    }
+
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, m_p, sizeof(T));
+    m_p += sizeof(T);
+
+    if (m_swap) {
+        for (size_t i = 0; i < (sizeof(T) / 2); ++i) {
+            std::swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+        }
+    }
+
+    T result;
+    std::memcpy(&result, bytes, sizeof(T));
+    value = static_cast<double>(result);
+
+    return true;
+}
+
+bool PLYReader::Read(PLYType type, double& value) {
+    if (m_ascii) {
+        SkipSpaces(m_p, m_end);
+
+        return ParseNumber(m_p, m_end, value);
+    }
+
+    switch (type) {
+        case PLYType::INT8:
+            return ReadBinary<int8_t>(value);
+        case PLYType::UINT8:
+            return ReadBinary<uint8_t>(value);
+        case PLYType::INT16:
+            return ReadBinary<int16_t>(value);
+        case PLYType::UINT16:
+            return ReadBinary<uint16_t>(value);
+        case PLYType::INT32:
+            return ReadBinary<int32_t>(value);
+        case PLYType::UINT32:
+            return ReadBinary<uint32_t>(value);
+        case PLYType::FLOAT32:
+            return ReadBinary<float>(value);
+        case PLYType::FLOAT64:
+            return ReadBinary<double>(value);
+        default:
+            return false;
+    }
+}
+
+bool PLYReader::Skip(const PLYProperty& property) {
+    double value = 0.0;
+
+    if (!property.is_list) {
+        return Read(property.type, value);
+    }
+
+    if (!Read(property.count_type, value) || (value < 0.0)) {
+        return false;
+    }
+
+    size_t count = static_cast<size_t>(value);
+
+    if (!m_ascii) {
+        size_t size = count * PLYTypeSize(property.type);
+
+        if (static_cast<size_t>(m_end - m_p) < size) {
+            return false;
+        }
+
+        m_p += size;
+
+        return true;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (!Read(property.type, value)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+size_t PLYReader::GetOffset(const char *file) const {
+    return static_cast<size_t>(m_p - file);
+}
+
+// Splits a header line into words.
+std::vector<std::string> SplitWords(const char *p, const char *end) {
+    std::vector<std::string> words;
+
+    for (;;) {
+        SkipBlanks(p, end);
+
+        if (p == end) {
+            break;
+        }
+
+        const char *word = p;
+
+        while ((p < end) && !IsBlank(*p)) {
+            ++p;
+        }
+
+        words.emplace_back(word, p);
+    }
+
+    return words;
+}
+
+bool ParsePLYHeader(const char *&p, const char *end, PLYFormat& format,
+                    std::vector<PLYElement>& elements) {
+    bool has_format = false;
+    bool first_line = true;
+
+    while (p < end) {
+        const char *line = p;
+        SkipLine(p, end);
+        const char *line_end = p;
+
+        while ((line_end > line) && IsSpace(line_end[-1])) {
+            --line_end;
+        }
+
+        std::vector<std::string> words = SplitWords(line, line_end);
+
+        if (first_line) {
+            if ((words.size() != 1) || (words[0] != "ply")) {
+                std::cerr << "ERROR: not a PLY file\n";
+
+                return false;
+            }
+
+            first_line = false;
+        }
+        else if (words.empty() || (words[0] == "comment") ||
+                (words[0] == "obj_info")) {
+        }
+        else if (words[0] == "end_header") {
+            if (!has_format) {
+                std::cerr << "ERROR: PLY header without a format\n";
+            }
+
+            return has_format;
+        }
+        else if ((words[0] == "format") && (words.size() == 3)) {
+            if (words[1] == "ascii") {
+                format = PLYFormat::ASCII;
+            }
+            else if (words[1] == "binary_little_endian") {
+                format = PLYFormat::BINARY_LITTLE_ENDIAN;
+            }
+            else if (words[1] == "binary_big_endian") {
+                format = PLYFormat::BINARY_BIG_ENDIAN;
+            }
+            else {
+                std::cerr << "ERROR: unknown PLY format '" << words[1] << "'\n";
+
+                return false;
+            }
+
+            has_format = true;
+        }
+        else if ((words[0] == "element") && (words.size() == 3)) {
+            const char *count = words[2].c_str();
+            int64_t value = 0;
+
+            if (!ParseInt(count, count + words[2].size(), value) ||
+                (value < 0)) {
+                std::cerr << "ERROR: bad PLY element count '" << words[2]
+                        << "'\n";
+
+                return false;
+            }
+
+            elements.push_back(PLYElement{words[1], static_cast<size_t>(value),
+                                        std::vector<PLYProperty>()});
+        }
+        else if ((words[0] == "property") && !elements.empty()) {
+            PLYProperty property{std::string(), PLYType::INVALID,
+                                PLYType::INVALID, false};
+
+            if ((words.size() == 5) && (words[1] == "list")) {
+                property.is_list = true;
+                property.count_type = ParsePLYType(words[2]);
+                property.type = ParsePLYType(words[3]);
+                property.name = words[4];
+            }
+            else if (words.size() == 3) {
+                property.type = ParsePLYType(words[1]);
+                property.name = words[2];
+            }
+
+            if ((property.type == PLYType::INVALID) ||
+                (property.is_list && (property.count_type == PLYType::INVALID))) {
+                std::cerr << "ERROR: bad PLY property '"
+                        << std::string(line, line_end) << "'\n";
+
+                return false;
+            }
+
+            elements.back().properties.push_back(property);
+        }
+        else {
+            std::cerr << "ERROR: bad PLY header line '"
+                    << std::string(line, line_end) << "'\n";
+
+            return false;
+        }
+    }
+
+    std::cerr << "ERROR: PLY header without end_header\n";
+
+    return false;
+}
+
+int FindPLYProperty(const PLYElement& element,
+                    std::initializer_list<const char *> names) {
+    for (size_t i = 0; i < element.properties.size(); ++i) {
+        for (const char *name : names) {
+            if (!element.properties[i].is_list &&
+                (element.properties[i].name == name)) {
+                return static_cast<int>(i);
+            }
+        }
+    }
+
+    return -1;
+}
+
+bool ReadPLYVertices(PLYReader& reader, const PLYElement& element,
+                    MeshData& data) {
+    int x = FindPLYProperty(element, {"x"});
+    int y = FindPLYProperty(element, {"y"});
+    int z = FindPLYProperty(element, {"z"});
+    int nx = FindPLYProperty(element, {"nx"});
+    int ny = FindPLYProperty(element, {"ny"});
+    int nz = FindPLYProperty(element, {"nz"});
+    int u = FindPLYProperty(element, {"u", "s", "texture_u", "texture_s"});
+    int v = FindPLYProperty(element, {"v", "t", "texture_v", "texture_t"});
+    bool has_normals = (nx >= 0) && (ny >= 0) && (nz >= 0);
+    bool has_uvs = (u >= 0) && (v >= 0);
+
+    if ((x < 0) || (y < 0) || (z < 0)) {
+        std::cerr << "ERROR: PLY vertices without x, y, z\n";
+
+        return false;
+    }
+
+    // destination of every property, nullptr for the ones not kept
+    size_t num_properties = element.properties.size();
+    std::vector<float *> targets(num_properties);
+    float position[3];
+    float normal[3];
+    float uv[2];
+
+    targets[x] = &position[0];
+    targets[y] = &position[1];
+    targets[z] = &position[2];
+
+    if (has_normals) {
+        targets[nx] = &normal[0];
+        targets[ny] = &normal[1];
+        targets[nz] = &normal[2];
+    }
+
+    if (has_uvs) {
+        targets[u] = &uv[0];
+        targets[v] = &uv[1];
+    }
+
+    data.positions.reserve(3 * element.count);
+    data.normals.reserve(has_normals ? (3 * element.count) : 0);
+    data.uvs.reserve(has_uvs ? (2 * element.count) : 0);
+
+    for (size_t i = 0; i < element.count; ++i) {
+        for (size_t prop = 0; prop < num_properties; ++prop) {
+            const PLYProperty& property = element.properties[prop];
+            double value = 0.0;
+
+            if (targets[prop] == nullptr) {
+                if (!reader.Skip(property)) {
+                    return false;
+                }
+            }
+            else if (reader.Read(property.type, value)) {
+                *targets[prop] = static_cast<float>(value);
+            }
+            else {
+                return false;
+            }
+        }
+
+        data.positions.insert(data.positions.end(), position, position + 3);
+
+        if (has_normals) {
+            data.normals.insert(data.normals.end(), normal, normal + 3);
+        }
+
+        if (has_uvs) {
+            data.uvs.insert(data.uvs.end(), uv, uv + 2);
+        }
+    }
+
+    return true;
+}
+
+bool ReadPLYFaces(PLYReader& reader, const PLYElement& element,
+                MeshData& data) {
+    int indices = -1;
+
+    for (size_t i = 0; i < element.properties.size(); ++i) {
+        const PLYProperty& property = element.properties[i];
+
+        if (property.is_list && ((property.name == "vertex_indices") ||
+                                (property.name == "vertex_index"))) {
+            indices = static_cast<int>(i);
+        }
+    }
+
+    if (indices < 0) {
+        std::cerr << "ERROR: PLY faces without vertex_indices\n";
+
+        return false;
+    }
+
+    const PLYProperty& index_property = element.properties[indices];
+    std::vector<uint32_t> polygon;
+
+    // mostly triangles
+    data.indices.reserve(data.indices.size() + 3 * element.count);
+
+    for (size_t i = 0; i < element.count; ++i) {
+        for (size_t prop = 0; prop < element.properties.size(); ++prop) {
+            if (static_cast<int>(prop) != indices) {
+                if (!reader.Skip(element.properties[prop])) {
+                    return false;
+                }
+
+                continue;
+            }
+
+            double value = 0.0;
+
+            if (!reader.Read(index_property.count_type, value) ||
+                (value < 0.0)) {
+                return false;
+            }
+
+            size_t count = static_cast<size_t>(value);
+            polygon.clear();
+
+            for (size_t k = 0; k < count; ++k) {
+                if (!reader.Read(index_property.type, value) ||
+                    (value < 0.0) || (value >= 4294967295.0)) {
+                    return false;
+                }
+
+                polygon.push_back(static_cast<uint32_t>(value));
+            }
+
+            for (size_t k = 2; k < count; ++k) {
+                data.indices.push_back(polygon[0]);
+                data.indices.push_back(polygon[k - 1]);
+                data.indices.push_back(polygon[k]);
+            }
+        }
+    }
+
+    return true;
+}
+
+// Copies a buffer of the cache out of the mapping, where it need not be
+// aligned. Returns the start of the next buffer.
+template <typename T>
+const char *ReadCacheBuffer(const char *p, std::vector<T>& buffer) {
+    if (!buffer.empty()) {
+        std::memcpy(buffer.data(), p, sizeof(T) * buffer.size());
+    }
+
+    return (p + sizeof(T) * buffer.size());
+}
+
+}
+
+bool MeshLoader::Load(const std::string& filename, MeshData& data,
+                    bool use_cache) {
+    uint64_t source_size = 0;
+    int64_t source_mtime = 0;
+
+    data = MeshData();
+
+    if (!MappedFile::Stat(filename, source_size, source_mtime)) {
+        std::cerr << "ERROR: could not open mesh file '" << filename << "'\n";
+
+        return false;
+    }
+
+    std::string cache_filename = filename + CACHE_EXTENSION;
+
+    if (use_cache &&
+        LoadCache(cache_filename, data, source_size, source_mtime)) {
+        return true;
+    }
+
+    size_t dot = filename.rfind('.');
+    std::string extension = (dot == std::string::npos) ?
+                            "" : filename.substr(dot + 1);
+
+    for (auto& c : extension) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+
+    MappedFile file;
+    bool parsed = false;
+
+    if ((extension != "obj") && (extension != "ply")) {
+        std::cerr << "ERROR: unknown mesh format '" << extension
+                << "' (valid formats: obj, ply)\n";
+    }
+    else if (!file.Open(filename)) {
+        std::cerr << "ERROR: could not open mesh file '" << filename << "'\n";
+    }
+    else if (extension == "obj") {
+        parsed = ParseOBJ(file.GetData(), file.GetSize(), data);
+    }
+    else {
+        parsed = ParsePLY(file.GetData(), file.GetSize(), data);
+    }
+
+    if (!parsed) {
+        std::cerr << "ERROR: could not load mesh '" << filename << "'\n";
+        data = MeshData();
+
+        return false;
+    }
+
+    if (use_cache &&
+        !SaveCache(cache_filename, data, source_size, source_mtime)) {
+        std::cerr << "ERROR: could not write mesh cache '" << cache_filename
+                << "'\n";
+    }
+
+    return true;
+}
+
+bool MeshLoader::ParseOBJ(const char *text, size_t size, MeshData& data) {
+    const char *p = text;
+    const char *end = text + size;
+    std::vector<float> positions;
+    std::vector<float> uvs;
+    std::vector<float> normals;
+    std::vector<uint32_t> polygon;
+    OBJVertexMap vertices(positions, uvs, normals, data);
+    size_t line = 0;
+
+    data = MeshData();
+
+    while (p < end) {
+        ++line;
+        SkipBlanks(p, end);
+
+        const char *keyword = p;
+
+        while ((p < end) && !IsSpace(*p)) {
+            ++p;
+        }
+
+        size_t keyword_size = static_cast<size_t>(p - keyword);
+        bool valid = true;
+
+        if ((keyword_size == 1) && (keyword[0] == 'v')) {
+            // w and vertex colors are ignored
+            valid = ParseOBJValues(p, end, positions, 3, 3);
+        }
+        else if ((keyword_size == 2) && (keyword[0] == 'v') &&
+                (keyword[1] == 't')) {
+            valid = ParseOBJValues(p, end, uvs, 1, 2);
+        }
+        else if ((keyword_size == 2) && (keyword[0] == 'v') &&
+                (keyword[1] == 'n')) {
+            valid = ParseOBJValues(p, end, normals, 3, 3);
+        }
+        else if ((keyword_size == 1) && (keyword[0] == 'f')) {
+            polygon.clear();
+
+            for (;;) {
+                SkipBlanks(p, end);
+
+                if ((p == end) || (*p == '\n') || (*p == '#')) {
+                    break;
+                }
+
+                OBJCorner corner;
+
+                if (!ParseOBJCorner(p, end, positions, uvs, normals, corner)) {
+                    valid = false;
+                    break;
+                }
+
+                polygon.push_back(vertices.GetVertex(corner));
+            }
+
+            valid = valid && (polygon.size() >= 3);
+
+            for (size_t k = 2; valid && (k < polygon.size()); ++k) {
+                data.indices.push_back(polygon[0]);
+                data.indices.push_back(polygon[k - 1]);
+                data.indices.push_back(polygon[k]);
+            }
+        }
+
+        if (!valid) {
+            std::cerr << "ERROR: bad OBJ statement '"
+                    << std::string(keyword, keyword_size) << "' on line "
+                    << line << '\n';
+            data = MeshData();
+
+            return false;
+        }
+
+        // comments, groups, materials, lines and points are skipped
+        SkipLine(p, end);
+    }
+
+    vertices.Finish();
+
+    return true;
+}
+
+bool MeshLoader::ParsePLY(const char *file, size_t size, MeshData& data) {
+    const char *p = file;
+    const char *end = file + size;
+    PLYFormat format = PLYFormat::ASCII;
+    std::vector<PLYElement> elements;
+
+    data = MeshData();
+
+    if (!ParsePLYHeader(p, end, format, elements)) {
+        return false;
+    }
+
+    PLYReader reader(p, end, format);
+    bool has_vertices = false;
+
+    for (const PLYElement& element : elements) {
+        bool valid = true;
+
+        if ((element.name == "vertex") && !has_vertices) {
+            valid = ReadPLYVertices(reader, element, data);
+            has_vertices = true;
+        }
+        else if (element.name == "face") {
+            valid = ReadPLYFaces(reader, element, data);
+        }
+        else {
+            for (size_t i = 0; valid && (i < element.count); ++i) {
+                for (const PLYProperty& property : element.properties) {
+                    if (!reader.Skip(property)) {
+                        valid = false;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (!valid) {
+            std::cerr << "ERROR: PLY " << element.name
+                    << " data ends early or is malformed (at byte "
+                    << reader.GetOffset(file) << ")\n";
+            data = MeshData();
+
+            return false;
+        }
+    }
+
+    size_t num_vertices = data.GetVertexCount();
+
+    for (uint32_t index : data.indices) {
+        if (index >= num_vertices) {
+            std::cerr << "ERROR: PLY face uses vertex " << index << " of "
+                    << num_vertices << '\n';
+            data = MeshData();
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Layout: MAGIC, source size, source modification time, the sizes of the
+// positions, normals, uvs and indices buffers, then the buffers.
+bool MeshLoader::SaveCache(const std::string& filename, const MeshData& data,
+                        uint64_t source_size, int64_t source_mtime) {
+    uint64_t header[6] = {
+        source_size, static_cast<uint64_t>(source_mtime),
+        data.positions.size(), data.normals.size(), data.uvs.size(),
+        data.indices.size()
+    };
+
+    std::string tmp_filename = filename + ".tmp";
+    std::FILE *file = std::fopen(tmp_filename.c_str(), "wb");
+
+    if (file == nullptr) {
+        return false;
+    }
+
+    bool written =
+        (std::fwrite(MAGIC, 1, sizeof(MAGIC), file) == sizeof(MAGIC)) &&
+        (std::fwrite(header, sizeof(header), 1, file) == 1) &&
+        (std::fwrite(data.positions.data(), sizeof(float),
+                    data.positions.size(), file) == data.positions.size()) &&
+        (std::fwrite(data.normals.data(), sizeof(float),
+                    data.normals.size(), file) == data.normals.size()) &&
+        (std::fwrite(data.uvs.data(), sizeof(float),
+                    data.uvs.size(), file) == data.uvs.size()) &&
+        (std::fwrite(data.indices.data(), sizeof(uint32_t),
+                    data.indices.size(), file) == data.indices.size());
+    written = (std::fclose(file) == 0) && written;
+
+    if (!written) {
+        std::remove(tmp_filename.c_str());
+
+        return false;
+    }
+
+    // rename does not replace an existing file everywhere
+    std::remove(filename.c_str());
+
+    return (std::rename(tmp_filename.c_str(), filename.c_str()) == 0);
+}
+
+bool MeshLoader::LoadCache(const std::string& filename, MeshData& data,
+                        uint64_t source_size, int64_t source_mtime) {
+    MappedFile file;
+    uint64_t header[6];
+    constexpr size_t header_size = sizeof(MAGIC) + sizeof(header);
+
+    if (!file.Open(filename) || (file.GetSize() < header_size) ||
+        (std::memcmp(file.GetData(), MAGIC, sizeof(MAGIC)) != 0)) {
+        return false;
+    }
+
+    std::memcpy(header, file.GetData() + sizeof(MAGIC), sizeof(header));
+
+    uint64_t num_values = header[2] + header[3] + header[4] + header[5];
+
+    if ((header[0] != source_size) ||
+        (header[1] != static_cast<uint64_t>(source_mtime)) ||
+        (num_values > (file.GetSize() - header_size) / 4) ||
+        ((header_size + 4 * num_values) != file.GetSize())) {
+        return false;
+    }
+
+    const char *p = file.GetData() + header_size;
+    MeshData cached;
+
+    cached.positions.resize(static_cast<size_t>(header[2]));
+    cached.normals.resize(static_cast<size_t>(header[3]));
+    cached.uvs.resize(static_cast<size_t>(header[4]));
+    cached.indices.resize(static_cast<size_t>(header[5]));
+
+    p = ReadCacheBuffer(p, cached.positions);
+    p = ReadCacheBuffer(p, cached.normals);
+    p = ReadCacheBuffer(p, cached.uvs);
+    ReadCacheBuffer(p, cached.indices);
+
+    data = std::move(cached);
+
+    return true;
+}
+
+}
@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "mipmap.hpp"
+
+namespace RayTracing {
+
+MipMap::MipMap(const float *rgb, size_t width, size_t height) {
+    if ((rgb == nullptr) || (width == 0) || (height == 0)) {
+        return;
+    }
+
+    Level level = {width, height,
+                std::vector<float>(rgb, rgb + 3 * width * height)};
+    m_levels.push_back(std::move(level));
+
+    while ((m_levels.back().width > 1) || (m_levels.back().height > 1)) {
+        Level next = Downsample(m_levels.back());
+        m_levels.push_back(std::move(next));
+    }
+}
+
+// Odd sizes repeat their last row or column, the border texels then
+// weigh a little more than the others.
+MipMap::Level MipMap::Downsample(const Level& level) {
+    Level next = {std::max<size_t>(1, (level.width + 1) / 2),
+                std::max<size_t>(1, (level.height + 1) / 2),
+                std::vector<float>()};
+    next.texels.resize(3 * next.width * next.height);
+
+    for (size_t y = 0; y < next.height; ++y) {
+        size_t y0 = std::min(2 * y, level.height - 1);
+        size_t y1 = std::min(2 * y + 1, level.height - 1);
+
+        for (size_t x = 0; x < next.width; ++x) {
+            size_t x0 = std::min(2 * x, level.width - 1);
+            size_t x1 = std::min(2 * x + 1, level.width - 1);
+            const float *t00 = Texel(level, x0, y0);
+            const float *t10 = Texel(level, x1, y0);
+            const float *t01 = Texel(level, x0, y1);
+            const float *t11 = Texel(level, x1, y1);
+            float *out = &next.texels[3 * (y * next.width + x)];
+
+            for (size_t c = 0; c < 3; ++c) {
+                out[c] = 0.25f * (t00[c] + t10[c] + t01[c] + t11[c]);
+            }
+        }
+    }
+
+    return next;
+}
+
+// Texel centers are at half integers, texels past the border repeat the
+// border.
+Color MipMap::Bilinear(size_t level, double u, double v) const {
+    if (m_levels.empty()) {
+        return Color();
+    }
+
+    const Level& image = m_levels[std::min(level, m_levels.size() - 1)];
+    double x = Interval(0.0, 1.0).Clamp(u) * image.width - 0.5;
+    double y = (1.0 - Interval(0.0, 1.0).Clamp(v)) * image.height - 0.5;
+    double x_floor = std::floor(x);
+    double y_floor = std::floor(y);
+    double fx = x - x_floor;
+    double fy = y - y_floor;
+    long max_x = static_cast<long>(image.width) - 1;
+    long max_y = static_cast<long>(image.height) - 1;
+    long xi = static_cast<long>(x_floor);
+    long yi = static_cast<long>(y_floor);
+    size_t x0 = static_cast<size_t>(std::min(std::max(xi, 0L), max_x));
+    size_t x1 = static_cast<size_t>(std::min(std::max(xi + 1, 0L), max_x));
+    size_t y0 = static_cast<size_t>(std::min(std::max(yi, 0L), max_y));
+    size_t y1 = static_cast<size_t>(std::min(std::max(yi + 1, 0L), max_y));
+    const float *t00 = Texel(image, x0, y0);
+    const float *t10 = Texel(image, x1, y0);
+    const float *t01 = Texel(image, x0, y1);
+    const float *t11 = Texel(image, x1, y1);
+    double rgb[3];
+
+    for (size_t c = 0; c < 3; ++c) {
+        double top = (1.0 - fx) * t00[c] + fx * t10[c];
+        double bottom = (1.0 - fx) * t01[c] + fx * t11[c];
+        rgb[c] = (1.0 - fy) * top + fy * bottom;
+    }
+
+    return Color(rgb[0], rgb[1], rgb[2]);
+}
+
+// The level whose texels are uv_width wide is log2(uv_width * size).
+// uv_width comes from areas (see HitRecord::uv_density), so size is the
+// side of a square image with as many texels.
+Color MipMap::Trilinear(double u, double v, double uv_width) const {
+    if (m_levels.empty()) {
+        return Color();
+    }
+
+    size_t last = m_levels.size() - 1;
+    double size = std::sqrt(static_cast<double>(m_levels[0].width) *
+                            m_levels[0].height);
+    double lod = (uv_width > 0.0) ? std::log2(uv_width * size) : 0.0;
+
+    if (!(lod > 0.0)) {
+        return Bilinear(0, u, v);
+    }
+
+    if (lod >= static_cast<double>(last)) {
+        return Bilinear(last, u, v);
+    }
+
+    size_t level = static_cast<size_t>(lod);
+    double t = lod - level;
+    Vec3 fine = static_cast<Vec3>(Bilinear(level, u, v));
+    Vec3 coarse = static_cast<Vec3>(Bilinear(level + 1, u, v));
+
+    return Color((1.0 - t) * fine + t * coarse);
+}
+
+}
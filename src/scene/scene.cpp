@@ -0,0 +1,371 @@
+#include <iostream>
+
+#include "scene.hpp"
+#include "solid_color.hpp"
+#include "checker_texture.hpp"
+#include "image_texture.hpp"
+#include "noise_texture.hpp"
+#include "lambertian.hpp"
+#include "metal.hpp"
+#include "dielectric.hpp"
+#include "diffuse_light.hpp"
+#include "isotropic.hpp"
+#include "sphere.hpp"
+#include "quad.hpp"
+#include "triangle.hpp"
+#include "disk.hpp"
+#include "triangle_mesh.hpp"
+#include "mesh_loader.hpp"
+#include "constant_medium.hpp"
+#include "wide_bvh.hpp"
+#include "instance_bvh.hpp"
+#include "sphere_set.hpp"
+#include "blue_noise_sampler.hpp"
+
+namespace RayTracing {
+
+constexpr size_t Scene::BVH_MIN_OBJECTS;
+
+namespace {
+
+Vec3 ToVec3(const double *v) {
+    return Vec3(v[0], v[1], v[2]);
+}
+
+Color ToColor(const double *c) {
+    return Color(c[0], c[1], c[2]);
+}
+
+}
+
+// Records only refer to records before them (see SceneLoader), so
+// everything is built in one pass: objects in order, then the world.
+Scene::Scene(const SceneDescription& desc, const std::string& base_dir) :
+m_desc(desc), m_base_dir(base_dir), m_valid(true)
+{
+    for (const SceneTexture& texture : desc.textures) {
+        m_textures.push_back(BuildTexture(texture));
+    }
+
+    for (const SceneMaterial& material : desc.materials) {
+        m_materials.push_back(BuildMaterial(material));
+    }
+
+    // shapes of every object, the world's at the end
+    size_t num_objects = desc.objects.size();
+    std::vector<std::vector<std::shared_ptr<Hittable>>> groups(num_objects + 1);
+    std::vector<std::vector<const SceneShape *>> group_shapes(num_objects + 1);
+
+    for (const SceneShape& shape : desc.shapes) {
+        size_t group = (shape.object == SCENE_NONE) ? num_objects : shape.object;
+        group_shapes[group].push_back(&shape);
+    }
+
+    std::vector<std::shared_ptr<Hittable>> lights;
+    std::vector<double> powers;
+
+    for (size_t group = 0; group <= num_objects; ++group) {
+        std::vector<Instance> instances;
+        std::vector<const SceneShape *> spheres;
+        std::vector<const SceneShape *> shapes;
+
+        // instances of an object share it and are gathered in a top level
+        // BVH, plain spheres in a sphere set
+        for (const SceneShape *shape : group_shapes[group]) {
+            if ((shape->type == SceneShape::INSTANCE) &&
+                ((shape->flags & SceneShape::MEDIUM) == 0)) {
+                instances.emplace_back(m_objects[shape->target],
+                                    ShapeTransform(*shape));
+            }
+            else if (IsPlainSphere(*shape)) {
+                spheres.push_back(shape);
+            }
+            else {
+                shapes.push_back(shape);
+            }
+        }
+
+        if (spheres.size() >= BVH_MIN_OBJECTS) {
+            std::vector<Point3> centers;
+            std::vector<double> radii;
+            std::vector<std::shared_ptr<Material>> materials;
+
+            for (const SceneShape *shape : spheres) {
+                centers.push_back(ToVec3(shape->a));
+                radii.push_back(shape->radius);
+                materials.push_back((shape->material == SCENE_NONE) ?
+                                    std::shared_ptr<Material>() :
+                                    m_materials[shape->material]);
+            }
+
+            groups[group].push_back(std::make_shared<SphereSet>(
+                                            centers, radii, materials));
+        }
+        else {
+            shapes.insert(shapes.end(), spheres.begin(), spheres.end());
+        }
+
+        for (const SceneShape *shape : shapes) {
+            std::shared_ptr<Hittable> hittable = BuildShape(*shape);
+
+            if (hittable == nullptr) {
+                m_valid = false;
+            }
+            else if ((shape->flags & SceneShape::LIGHT) != 0) {
+                lights.push_back(hittable);
+                powers.push_back(LightPower(*shape));
+            }
+            else {
+                groups[group].push_back(hittable);
+            }
+        }
+
+        if (instances.size() >= BVH_MIN_OBJECTS) {
+            groups[group].push_back(
+                    std::make_shared<InstanceBVH>(std::move(instances)));
+        }
+        else {
+            for (const Instance& instance : instances) {
+                groups[group].push_back(std::make_shared<Instance>(instance));
+            }
+        }
+
+        if (group < num_objects) {
+            m_objects.push_back(Group(groups[group]));
+        }
+    }
+
+    // the integrators sample a light at every diffuse bounce
+    m_lights = std::make_shared<LightSampler>(lights, powers,
+                    (desc.camera.light_sampling == SceneCamera::BVH) ?
+                    LightSampler::Strategy::SPATIAL :
+                    LightSampler::Strategy::POWER);
+
+    if (lights.empty()) {
+        std::cerr << "ERROR: scene has no light shapes\n";
+        m_valid = false;
+    }
+
+    std::vector<std::shared_ptr<Hittable>>& world = groups[num_objects];
+
+    if (world.size() >= BVH_MIN_OBJECTS) {
+        m_world.Add(Group(world));
+    }
+    else {
+        for (const auto& hittable : world) {
+            m_world.Add(hittable);
+        }
+    }
+}
+
+Camera Scene::CreateCamera() const {
+    const SceneCamera& desc = m_desc.camera;
+    Camera cam(desc.aspect_ratio, desc.vfov, desc.defocus_angle,
+            desc.focus_dist, desc.image_width, desc.samples_per_pixel,
+            desc.max_depth, ToVec3(desc.look_from), ToVec3(desc.look_at),
+            ToVec3(desc.vup));
+
+    cam.SetBackground(ToColor(desc.background));
+    cam.SetRouletteDepth(desc.roulette_depth);
+    cam.SetPassSamples(desc.pass_samples);
+    cam.SetAdaptiveSampling(desc.adaptive_min_samples,
+                            desc.adaptive_max_error);
+
+    if (desc.sampler == SceneCamera::BLUE_NOISE) {
+        cam.SetSampler(std::make_shared<BlueNoiseSampler>());
+    }
+    else if (desc.sampler == SceneCamera::INDEPENDENT) {
+        cam.SetSampler(std::make_shared<IndependentSampler>());
+    }
+
+    if (desc.checkpoint_file != SCENE_NONE) {
+        cam.SetCheckpointFile(m_desc.GetString(desc.checkpoint_file));
+    }
+
+    if (desc.sample_map_file != SCENE_NONE) {
+        cam.SetSampleMapFile(m_desc.GetString(desc.sample_map_file));
+    }
+
+    return cam;
+}
+
+std::shared_ptr<Texture> Scene::BuildTexture(const SceneTexture& texture) const {
+    switch (texture.type) {
+        case SceneTexture::CHECKER: {
+            std::shared_ptr<Texture> even = (texture.even == SCENE_NONE) ?
+                    std::make_shared<SolidColor>(ToColor(texture.color)) :
+                    m_textures[texture.even];
+            std::shared_ptr<Texture> odd = (texture.odd == SCENE_NONE) ?
+                    std::make_shared<SolidColor>(ToColor(texture.color2)) :
+                    m_textures[texture.odd];
+
+            return std::make_shared<CheckerTexture>(texture.scale, even, odd);
+        }
+        case SceneTexture::IMAGE:
+            return std::make_shared<ImageTexture>(
+                                        m_desc.GetString(texture.file));
+        case SceneTexture::NOISE:
+            return std::make_shared<NoiseTexture>(texture.scale);
+        default:
+            return std::make_shared<SolidColor>(ToColor(texture.color));
+    }
+}
+
+std::shared_ptr<Material> Scene::BuildMaterial(
+                                    const SceneMaterial& material) const {
+    bool textured = (material.texture != SCENE_NONE);
+    Color color = ToColor(material.color);
+
+    switch (material.type) {
+        case SceneMaterial::METAL:
+            return std::make_shared<Metal>(color, material.fuzz);
+        case SceneMaterial::DIELECTRIC:
+            return std::make_shared<Dielectric>(material.refraction_index);
+        case SceneMaterial::DIFFUSE_LIGHT:
+            return textured ?
+                std::make_shared<DiffuseLight>(m_textures[material.texture]) :
+                std::make_shared<DiffuseLight>(color);
+        case SceneMaterial::ISOTROPIC:
+            return textured ?
+                std::make_shared<Isotropic>(m_textures[material.texture]) :
+                std::make_shared<Isotropic>(color);
+        default:
+            return textured ?
+                std::make_shared<Lambertian>(m_textures[material.texture]) :
+                std::make_shared<Lambertian>(color);
+    }
+}
+
+std::shared_ptr<Hittable> Scene::BuildShape(const SceneShape& shape) const {
+    // lights and media have no material, lights are only sampled
+    std::shared_ptr<Material> mat = (shape.material == SCENE_NONE) ?
+                                    std::shared_ptr<Material>() :
+                                    m_materials[shape.material];
+    std::shared_ptr<Hittable> hittable;
+
+    switch (shape.type) {
+        case SceneShape::SPHERE:
+            if ((shape.flags & SceneShape::MOVING) != 0) {
+                hittable = std::make_shared<Sphere>(ToVec3(shape.a),
+                                                    ToVec3(shape.b),
+                                                    shape.radius, mat);
+            }
+            else {
+                hittable = std::make_shared<Sphere>(ToVec3(shape.a),
+                                                    shape.radius, mat);
+            }
+            break;
+        case SceneShape::QUAD:
+            hittable = std::make_shared<Quad>(ToVec3(shape.a), ToVec3(shape.b),
+                                            ToVec3(shape.c), mat);
+            break;
+        case SceneShape::TRIANGLE:
+            hittable = std::make_shared<Triangle>(ToVec3(shape.a),
+                                                ToVec3(shape.b),
+                                                ToVec3(shape.c), mat);
+            break;
+        case SceneShape::DISK:
+            hittable = std::make_shared<Disk>(ToVec3(shape.a), ToVec3(shape.b),
+                                            ToVec3(shape.c), mat,
+                                            shape.radius);
+            break;
+        case SceneShape::BOX:
+            hittable = Box(ToVec3(shape.a), ToVec3(shape.b), mat);
+            break;
+        case SceneShape::MESH: {
+            std::string file = m_desc.GetString(shape.target);
+            MeshData data;
+
+            if (!file.empty() && (file[0] != '/') && !m_base_dir.empty()) {
+                file = m_base_dir + '/' + file;
+            }
+
+            if (!MeshLoader::Load(file, data)) {
+                return nullptr;
+            }
+
+            hittable = std::make_shared<TriangleMesh>(std::move(data), mat);
+            break;
+        }
+        default:
+            hittable = m_objects[shape.target];
+            break;
+    }
+
+    Transform transform = ShapeTransform(shape);
+
+    if (!transform.IsIdentity()) {
+        hittable = std::make_shared<Instance>(hittable, transform);
+    }
+
+    if ((shape.flags & SceneShape::MEDIUM) != 0) {
+        hittable = (shape.albedo_texture == SCENE_NONE) ?
+            std::make_shared<ConstantMedium>(hittable, shape.density,
+                                            ToColor(shape.albedo)) :
+            std::make_shared<ConstantMedium>(hittable, shape.density,
+                                            m_textures[shape.albedo_texture]);
+    }
+
+    return hittable;
+}
+
+double Scene::LightPower(const SceneShape& shape) const {
+    if ((shape.material == SCENE_NONE) ||
+        (m_desc.materials[shape.material].type != 
+            SceneMaterial::DIFFUSE_LIGHT)) {
+        return 0.0;
+    }
+
+    const SceneMaterial& material = m_desc.materials[shape.material];
+    // textured lights count as white
+    double luminance = (material.texture != SCENE_NONE) ? 1.0 :
+                        (0.2126 * material.color[0] + 
+                        0.7152 * material.color[1] +
+                        0.0722 * material.color[2]);
+    double area = 0.0;
+
+    switch (shape.type) {
+        case SceneShape::SPHERE:
+            area = 4.0 * PI * shape.radius * shape.radius;
+            break;
+        case SceneShape::QUAD:
+            area = Cross(ToVec3(shape.b), ToVec3(shape.c)).Length();
+            break;
+        case SceneShape::TRIANGLE:
+            area = 0.5 * Cross(ToVec3(shape.b), ToVec3(shape.c)).Length();
+            break;
+        case SceneShape::DISK:
+            area = PI * shape.radius * shape.radius;
+            break;
+        default:
+            break;
+    }
+
+    return (luminance * area);
+}
+
+bool Scene::IsPlainSphere(const SceneShape& shape) {
+    return ((shape.type == SceneShape::SPHERE) && (shape.flags == 0) &&
+            ShapeTransform(shape).IsIdentity());
+}
+
+Transform Scene::ShapeTransform(const SceneShape& shape) {
+    Transform transform = Transform::Scaling(ToVec3(shape.scale));
+
+    if (shape.rotate_y != 0.0) {
+        transform = Transform::RotationY(shape.rotate_y) * transform;
+    }
+
+    return (Transform::Translation(ToVec3(shape.translate)) * transform);
+}
+
+std::shared_ptr<Hittable> Scene::Group(
+                const std::vector<std::shared_ptr<Hittable>>& shapes) {
+    if (shapes.size() >= BVH_MIN_OBJECTS) {
+        return std::make_shared<WideBVH>(shapes);
+    }
+
+    return std::make_shared<HittableList>(shapes);
+}
+
+}
@@ -0,0 +1,994 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <utility>
+
+#include "scene_description.hpp"
+#include "mapped_file.hpp"
+
+namespace RayTracing {
+
+constexpr const char *SceneLoader::COMPILED_EXTENSION;
+constexpr char SceneLoader::MAGIC[8];
+
+SceneDescription::SceneDescription() {
+    // the defaults of Camera
+    std::memset(&camera, 0, sizeof(camera));
+    camera.aspect_ratio = 1.0;
+    camera.vfov = 90.0;
+    camera.focus_dist = 10.0;
+    camera.look_at[2] = -1.0;
+    camera.vup[1] = 1.0;
+    camera.image_width = 100;
+    camera.samples_per_pixel = 10;
+    camera.max_depth = 10;
+    camera.roulette_depth = 3;
+    camera.adaptive_min_samples = 16;
+    camera.checkpoint_file = SCENE_NONE;
+    camera.sample_map_file = SCENE_NONE;
+}
+
+uint32_t SceneDescription::AddString(const std::string& str) {
+    uint32_t offset = static_cast<uint32_t>(strings.size());
+
+    strings.insert(strings.end(), str.begin(), str.end());
+    strings.push_back('\0');
+
+    return offset;
+}
+
+namespace {
+
+// One line of a scene file: the words up to the first key=value pair,
+// then the pairs.
+struct Statement {
+    size_t line;
+    std::vector<std::string> words;
+    std::vector<std::pair<std::string, std::string>> values;
+    std::vector<bool> used;
+};
+
+bool SplitStatement(const char *p, const char *end, Statement& statement) {
+    statement.words.clear();
+    statement.values.clear();
+
+    for (;;) {
+        while ((p < end) && ((*p == ' ') || (*p == '\t') || (*p == '\r'))) {
+            ++p;
+        }
+
+        if ((p == end) || (*p == '#')) {
+            break;
+        }
+
+        const char *word = p;
+
+        while ((p < end) && (*p != ' ') && (*p != '\t') && (*p != '\r') &&
+                (*p != '#')) {
+            ++p;
+        }
+
+        std::string token(word, p);
+        size_t equals = token.find('=');
+
+        if (equals == std::string::npos) {
+            if (!statement.values.empty()) {
+                std::cerr << "ERROR: scene line " << statement.line
+                        << ": '" << token << "' after key=value pairs\n";
+
+                return false;
+            }
+
+            statement.words.push_back(token);
+        }
+        else {
+            statement.values.emplace_back(token.substr(0, equals),
+                                        token.substr(equals + 1));
+        }
+    }
+
+    statement.used.assign(statement.values.size(), false);
+
+    return true;
+}
+
+bool ParseDouble(const std::string& str, double& value) {
+    if (str.empty()) {
+        return false;
+    }
+
+    char *end = nullptr;
+    value = std::strtod(str.c_str(), &end);
+
+    return (*end == '\0');
+}
+
+// Numbers separated by commas.
+bool ParseDoubles(const std::string& str, double *values, size_t count) {
+    size_t start = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        size_t comma = str.find(',', start);
+        bool last = (i + 1 == count);
+
+        if ((comma == std::string::npos) != last) {
+            return false;
+        }
+
+        if (!ParseDouble(str.substr(start, comma - start), values[i])) {
+            return false;
+        }
+
+        start = comma + 1;
+    }
+
+    return true;
+}
+
+class SceneParser {
+public:
+    explicit SceneParser(SceneDescription& desc);
+
+    bool ParseStatement(Statement& statement);
+    bool Finish(size_t line);
+
+private:
+    SceneDescription& m_desc;
+    std::unordered_map<std::string, uint32_t> m_texture_names;
+    std::unordered_map<std::string, uint32_t> m_material_names;
+    std::unordered_map<std::string, uint32_t> m_object_names;
+    // record bytes to index, for the deduplication
+    std::unordered_map<std::string, uint32_t> m_texture_records;
+    std::unordered_map<std::string, uint32_t> m_material_records;
+    // string to offset, equal strings are stored once so records that
+    // refer to them compare equal
+    std::unordered_map<std::string, uint32_t> m_strings;
+    uint32_t m_object;              // open object block, SCENE_NONE - none
+    Statement *m_statement;         // the one being parsed
+
+    bool Error(const std::string& message) const;
+    // Value of key, nullptr if the statement has none.
+    const std::string *Find(const char *key);
+    bool CheckAllUsed() const;
+
+    // These leave the value untouched if the key is missing and not
+    // required, and report bad values.
+    bool GetNumber(const char *key, double& value, bool required = false);
+    bool GetUInt(const char *key, uint32_t& value, bool required = false);
+    bool GetVector(const char *key, double *value, bool required = false);
+    bool GetString(const char *key, uint32_t& value, bool required = false);
+    bool GetName(const char *key,
+                const std::unordered_map<std::string, uint32_t>& names,
+                const char *kind, uint32_t& value, bool required = false);
+    // A color or the name of a texture.
+    bool GetColorOrTexture(const char *key, double *color, uint32_t& texture,
+                        bool required);
+
+    bool ParseCamera();
+    bool ParseTexture();
+    bool ParseMaterial();
+    bool ParseShape(size_t first_word);
+    bool ParseObject();
+    bool ParseEnd();
+
+    uint32_t InternString(const std::string& str);
+    bool DefineName(std::unordered_map<std::string, uint32_t>& names,
+                    const std::string& name, uint32_t index);
+    template <typename Record>
+    static uint32_t AddRecord(const Record& record,
+                            std::vector<Record>& records,
+                            std::unordered_map<std::string, uint32_t>& known);
+};
+
+SceneParser::SceneParser(SceneDescription& desc) :
+m_desc(desc), m_object(SCENE_NONE), m_statement(nullptr)
+{}
+
+bool SceneParser::ParseStatement(Statement& statement) {
+    m_statement = &statement;
+
+    if (statement.words.empty()) {
+        if (statement.values.empty()) {
+            return true;
+        }
+
+        return Error("statement without a keyword");
+    }
+
+    const std::string& keyword = statement.words[0];
+    bool parsed = false;
+
+    if (keyword == "camera") {
+        parsed = ParseCamera();
+    }
+    else if (keyword == "texture") {
+        parsed = ParseTexture();
+    }
+    else if (keyword == "material") {
+        parsed = ParseMaterial();
+    }
+    else if (keyword == "object") {
+        parsed = ParseObject();
+    }
+    else if (keyword == "end") {
+        parsed = ParseEnd();
+    }
+    else if (keyword == "light") {
+        parsed = ParseShape(1);
+    }
+    else {
+        parsed = ParseShape(0);
+    }
+
+    return (parsed && CheckAllUsed());
+}
+
+bool SceneParser::Finish(size_t line) {
+    if (m_object != SCENE_NONE) {
+        std::cerr << "ERROR: scene line " << line << ": object '"
+                << m_desc.GetString(m_desc.objects[m_object])
+                << "' is missing its end\n";
+
+        return false;
+    }
+
+    return true;
+}
+
+bool SceneParser::Error(const std::string& message) const {
+    std::cerr << "ERROR: scene line " << m_statement->line << ": "
+            << message << '\n';
+
+    return false;
+}
+
+const std::string *SceneParser::Find(const char *key) {
+    for (size_t i = 0; i < m_statement->values.size(); ++i) {
+        if (m_statement->values[i].first == key) {
+            m_statement->used[i] = true;
+
+            return &m_statement->values[i].second;
+        }
+    }
+
+    return nullptr;
+}
+
+bool SceneParser::CheckAllUsed() const {
+    for (size_t i = 0; i < m_statement->values.size(); ++i) {
+        if (!m_statement->used[i]) {
+            return Error("unknown key '" + m_statement->values[i].first +
+                        "' for " + m_statement->words[0]);
+        }
+    }
+
+    return true;
+}
+
+bool SceneParser::GetNumber(const char *key, double& value, bool required) {
+    const std::string *str = Find(key);
+
+    if (str == nullptr) {
+        return (!required || Error(std::string("missing ") + key));
+    }
+
+    if (!ParseDouble(*str, value)) {
+        return Error(std::string("bad number ") + key + "=" + *str);
+    }
+
+    return true;
+}
+
+bool SceneParser::GetUInt(const char *key, uint32_t& value, bool required) {
+    double number = value;
+
+    if (!GetNumber(key, number, required)) {
+        return false;
+    }
+
+    if ((number < 0.0) || (number > 4294967295.0) ||
+        (number != static_cast<double>(static_cast<uint32_t>(number)))) {
+        return Error(std::string(key) + " must be a whole number");
+    }
+
+    value = static_cast<uint32_t>(number);
+
+    return true;
+}
+
+bool SceneParser::GetVector(const char *key, double *value, bool required) {
+    const std::string *str = Find(key);
+
+    if (str == nullptr) {
+        return (!required || Error(std::string("missing ") + key));
+    }
+
+    if (!ParseDoubles(*str, value, 3)) {
+        return Error(std::string("bad vector ") + key + "=" + *str +
+                    " (expected x,y,z)");
+    }
+
+    return true;
+}
+
+bool SceneParser::GetString(const char *key, uint32_t& value, bool required) {
+    const std::string *str = Find(key);
+
+    if (str == nullptr) {
+        return (!required || Error(std::string("missing ") + key));
+    }
+
+    value = InternString(*str);
+
+    return true;
+}
+
+bool SceneParser::GetName(const char *key,
+                        const std::unordered_map<std::string, uint32_t>& names,
+                        const char *kind, uint32_t& value, bool required) {
+    const std::string *str = Find(key);
+
+    if (str == nullptr) {
+        return (!required || Error(std::string("missing ") + key));
+    }
+
+    auto found = names.find(*str);
+
+    if (found == names.end()) {
+        return Error(std::string("unknown ") + kind + " '" + *str + "'");
+    }
+
+    value = found->second;
+
+    return true;
+}
+
+bool SceneParser::GetColorOrTexture(const char *key, double *color,
+                                    uint32_t& texture, bool required) {
+    const std::string *str = Find(key);
+
+    if (str == nullptr) {
+        return (!required || Error(std::string("missing ") + key));
+    }
+
+    if (ParseDoubles(*str, color, 3)) {
+        texture = SCENE_NONE;
+
+        return true;
+    }
+
+    auto found = m_texture_names.find(*str);
+
+    if (found == m_texture_names.end()) {
+        return Error(std::string("bad ") + key + "=" + *str +
+                    " (expected r,g,b or a texture)");
+    }
+
+    texture = found->second;
+
+    return true;
+}
+
+bool SceneParser::ParseCamera() {
+    SceneCamera& camera = m_desc.camera;
+    const std::string *aspect = Find("aspect");
+
+    if (m_statement->words.size() != 1) {
+        return Error("camera takes key=value pairs only");
+    }
+
+    // either a number or width:height
+    if (aspect != nullptr) {
+        size_t colon = aspect->find(':');
+        double ratio[2] = {0.0, 1.0};
+        bool valid = (colon == std::string::npos) ?
+                    ParseDouble(*aspect, ratio[0]) :
+                    (ParseDouble(aspect->substr(0, colon), ratio[0]) &&
+                    ParseDouble(aspect->substr(colon + 1), ratio[1]));
+
+        if (!valid || (ratio[0] <= 0.0) || (ratio[1] <= 0.0)) {
+            return Error("bad aspect=" + *aspect);
+        }
+
+        camera.aspect_ratio = ratio[0] / ratio[1];
+    }
+
+    const std::string *light_sampling = Find("light_sampling");
+
+    if (light_sampling != nullptr) {
+        if (*light_sampling == "power") {
+            camera.light_sampling = SceneCamera::POWER;
+        }
+        else if (*light_sampling == "bvh") {
+            camera.light_sampling = SceneCamera::BVH;
+        }
+        else {
+            return Error("bad light_sampling=" + *light_sampling +
+                        " (power or bvh)");
+        }
+    }
+
+    const std::string *sampler = Find("sampler");
+
+    if (sampler != nullptr) {
+        if (*sampler == "sobol") {
+            camera.sampler = SceneCamera::SOBOL;
+        }
+        else if (*sampler == "blue_noise") {
+            camera.sampler = SceneCamera::BLUE_NOISE;
+        }
+        else if (*sampler == "independent") {
+            camera.sampler = SceneCamera::INDEPENDENT;
+        }
+        else {
+            return Error("bad sampler=" + *sampler +
+                        " (sobol, blue_noise or independent)");
+        }
+    }
+
+    return (GetNumber("vfov", camera.vfov) &&
+            GetNumber("defocus_angle", camera.defocus_angle) &&
+            GetNumber("focus_dist", camera.focus_dist) &&
+            GetVector("look_from", camera.look_from) &&
+            GetVector("look_at", camera.look_at) &&
+            GetVector("vup", camera.vup) &&
+            GetVector("background", camera.background) &&
+            GetUInt("width", camera.image_width) &&
+            GetUInt("spp", camera.samples_per_pixel) &&
+            GetUInt("max_depth", camera.max_depth) &&
+            GetUInt("roulette_depth", camera.roulette_depth) &&
+            GetUInt("pass_samples", camera.pass_samples) &&
+            GetUInt("adaptive_min_samples", camera.adaptive_min_samples) &&
+            GetNumber("adaptive_max_error", camera.adaptive_max_error) &&
+            GetString("checkpoint", camera.checkpoint_file) &&
+            GetString("sample_map", camera.sample_map_file));
+}
+
+bool SceneParser::ParseTexture() {
+    if (m_statement->words.size() != 3) {
+        return Error("expected: texture <name> solid|checker|image|noise");
+    }
+
+    const std::string& type = m_statement->words[2];
+    SceneTexture texture;
+    bool parsed = false;
+
+    std::memset(&texture, 0, sizeof(texture));
+    texture.even = SCENE_NONE;
+    texture.odd = SCENE_NONE;
+    texture.file = SCENE_NONE;
+    texture.scale = 1.0;
+
+    if (type == "solid") {
+        texture.type = SceneTexture::SOLID;
+        parsed = GetVector("color", texture.color, true);
+    }
+    else if (type == "checker") {
+        texture.type = SceneTexture::CHECKER;
+        parsed = GetNumber("scale", texture.scale, true) &&
+                GetColorOrTexture("even", texture.color, texture.even, true) &&
+                GetColorOrTexture("odd", texture.color2, texture.odd, true);
+    }
+    else if (type == "image") {
+        texture.type = SceneTexture::IMAGE;
+        parsed = GetString("file", texture.file, true);
+    }
+    else if (type == "noise") {
+        texture.type = SceneTexture::NOISE;
+        parsed = GetNumber("scale", texture.scale);
+    }
+    else {
+        return Error("unknown texture type '" + type + "'");
+    }
+
+    return (parsed &&
+            DefineName(m_texture_names, m_statement->words[1],
+                    AddRecord(texture, m_desc.textures, m_texture_records)));
+}
+
+bool SceneParser::ParseMaterial() {
+    if (m_statement->words.size() != 3) {
+        return Error("expected: material <name> lambertian|metal|dielectric|"
+                    "diffuse_light|isotropic");
+    }
+
+    const std::string& type = m_statement->words[2];
+    SceneMaterial material;
+    bool parsed = false;
+
+    std::memset(&material, 0, sizeof(material));
+    material.texture = SCENE_NONE;
+
+    if (type == "lambertian") {
+        material.type = SceneMaterial::LAMBERTIAN;
+        parsed = GetColorOrTexture("albedo", material.color, material.texture,
+                                true);
+    }
+    else if (type == "metal") {
+        material.type = SceneMaterial::METAL;
+        parsed = GetVector("albedo", material.color, true) &&
+                GetNumber("fuzz", material.fuzz);
+    }
+    else if (type == "dielectric") {
+        material.type = SceneMaterial::DIELECTRIC;
+        parsed = GetNumber("ior", material.refraction_index, true);
+    }
+    else if (type == "diffuse_light") {
+        material.type = SceneMaterial::DIFFUSE_LIGHT;
+        parsed = GetColorOrTexture("emit", material.color, material.texture,
+                                true);
+    }
+    else if (type == "isotropic") {
+        material.type = SceneMaterial::ISOTROPIC;
+        parsed = GetColorOrTexture("albedo", material.color, material.texture,
+                                true);
+    }
+    else {
+        return Error("unknown material type '" + type + "'");
+    }
+
+    return (parsed &&
+            DefineName(m_material_names, m_statement->words[1],
+                    AddRecord(material, m_desc.materials,
+                            m_material_records)));
+}
+
+bool SceneParser::ParseShape(size_t first_word) {
+    bool light = (first_word == 1);
+
+    if (m_statement->words.size() != first_word + 1) {
+        return Error("expected: " + std::string(light ? "light " : "") +
+                    "<shape> key=value...");
+    }
+
+    // lights are sampled in world space, they would not follow the
+    // instances of an object
+    if (light && (m_object != SCENE_NONE)) {
+        return Error("lights can not be part of an object");
+    }
+
+    const std::string& type = m_statement->words[first_word];
+    SceneShape shape;
+    bool parsed = false;
+
+    std::memset(&shape, 0, sizeof(shape));
+    shape.flags = light ? static_cast<uint32_t>(SceneShape::LIGHT) : 0;
+    shape.material = SCENE_NONE;
+    shape.object = m_object;
+    shape.target = SCENE_NONE;
+    shape.albedo_texture = SCENE_NONE;
+
+    if (type == "sphere") {
+        shape.type = SceneShape::SPHERE;
+        parsed = GetVector("center", shape.a, true) &&
+                GetNumber("radius", shape.radius, true);
+
+        if (parsed && (Find("center2") != nullptr)) {
+            shape.flags |= SceneShape::MOVING;
+            parsed = GetVector("center2", shape.b, true);
+        }
+    }
+    else if ((type == "quad") || (type == "triangle") || (type == "disk")) {
+        shape.type = (type == "quad") ? SceneShape::QUAD :
+                    ((type == "triangle") ? SceneShape::TRIANGLE :
+                    SceneShape::DISK);
+        parsed = GetVector("q", shape.a, true) &&
+                GetVector("u", shape.b, true) &&
+                GetVector("v", shape.c, true) &&
+                ((shape.type != SceneShape::DISK) ||
+                GetNumber("radius", shape.radius, true));
+    }
+    else if (type == "box") {
+        shape.type = SceneShape::BOX;
+        parsed = GetVector("min", shape.a, true) &&
+                GetVector("max", shape.b, true);
+    }
+    else if ((type == "mesh") && !light) {
+        shape.type = SceneShape::MESH;
+        parsed = GetString("file", shape.target, true);
+    }
+    else if ((type == "instance") && !light) {
+        shape.type = SceneShape::INSTANCE;
+        parsed = GetName("object", m_object_names, "object", shape.target,
+                        true);
+
+        if (parsed && (shape.target == m_object)) {
+            return Error("object instanced inside itself");
+        }
+    }
+    else {
+        return Error("unknown " + std::string(light ? "light " : "") +
+                    "shape '" + type + "'");
+    }
+
+    shape.scale[0] = shape.scale[1] = shape.scale[2] = 1.0;
+
+    if (!parsed || !GetVector("scale", shape.scale) ||
+        !GetNumber("rotate_y", shape.rotate_y) ||
+        !GetVector("translate", shape.translate)) {
+        return false;
+    }
+
+    if ((shape.scale[0] == 0.0) || (shape.scale[1] == 0.0) ||
+        (shape.scale[2] == 0.0)) {
+        return Error("scale can not be 0");
+    }
+
+    // lights are sampled in world space
+    if (light && ((Find("scale") != nullptr) || 
+                (Find("rotate_y") != nullptr) ||
+                (Find("translate") != nullptr))) {
+        return Error("lights can not be transformed");
+    }
+
+    if (Find("density") != nullptr) {
+        if (light) {
+            return Error("lights can not be media");
+        }
+
+        shape.flags |= SceneShape::MEDIUM;
+
+        if (!GetNumber("density", shape.density, true) ||
+            !GetColorOrTexture("albedo", shape.albedo, shape.albedo_texture,
+                            true)) {
+            return false;
+        }
+    }
+
+    // lights only sample the shape, media scatter with their albedo
+    bool needs_material = !light && (shape.type != SceneShape::INSTANCE) &&
+                        ((shape.flags & SceneShape::MEDIUM) == 0);
+
+    if (!GetName("material", m_material_names, "material", shape.material,
+                needs_material)) {
+        return false;
+    }
+
+    m_desc.shapes.push_back(shape);
+
+    return true;
+}
+
+bool SceneParser::ParseObject() {
+    if (m_statement->words.size() != 2) {
+        return Error("expected: object <name>");
+    }
+
+    if (m_object != SCENE_NONE) {
+        return Error("object blocks can not be nested");
+    }
+
+    m_object = static_cast<uint32_t>(m_desc.objects.size());
+    m_desc.objects.push_back(InternString(m_statement->words[1]));
+
+    return DefineName(m_object_names, m_statement->words[1], m_object);
+}
+
+bool SceneParser::ParseEnd() {
+    if ((m_statement->words.size() != 1) || (m_object == SCENE_NONE)) {
+        return Error("end without an object");
+    }
+
+    m_object = SCENE_NONE;
+
+    return true;
+}
+
+bool SceneParser::DefineName(std::unordered_map<std::string, uint32_t>& names,
+                            const std::string& name, uint32_t index) {
+    if (!names.emplace(name, index).second) {
+        return Error("'" + name + "' is already defined");
+    }
+
+    return true;
+}
+
+uint32_t SceneParser::InternString(const std::string& str) {
+    auto found = m_strings.find(str);
+
+    if (found != m_strings.end()) {
+        return found->second;
+    }
+
+    uint32_t offset = m_desc.AddString(str);
+    m_strings.emplace(str, offset);
+
+    return offset;
+}
+
+// Records are compared byte by byte, they are zeroed before being filled
+// in so padding does not differ.
+template <typename Record>
+uint32_t SceneParser::AddRecord(const Record& record,
+                                std::vector<Record>& records,
+                                std::unordered_map<std::string, uint32_t>& known) {
+    std::string bytes(reinterpret_cast<const char *>(&record), sizeof(record));
+    auto found = known.find(bytes);
+
+    if (found != known.end()) {
+        return found->second;
+    }
+
+    uint32_t index = static_cast<uint32_t>(records.size());
+    records.push_back(record);
+    known.emplace(bytes, index);
+
+    return index;
+}
+
+bool IsString(const SceneDescription& desc, uint32_t offset, bool required) {
+    return (offset == SCENE_NONE) ? !required : (offset < desc.strings.size());
+}
+
+bool IsIndex(uint32_t index, size_t count) {
+    return ((index == SCENE_NONE) || (index < count));
+}
+
+// Checks that the records of a compiled scene only refer to records
+// before them, as the parser writes them, so Scene can build them in order,
+// and that shapes have the references the parser requires.
+bool CheckReferences(const SceneDescription& desc) {
+    if (!desc.strings.empty() && (desc.strings.back() != '\0')) {
+        return false;
+    }
+
+    if (!IsString(desc, desc.camera.checkpoint_file, false) ||
+        !IsString(desc, desc.camera.sample_map_file, false) ||
+        (desc.camera.light_sampling > SceneCamera::BVH) ||
+        (desc.camera.sampler > SceneCamera::INDEPENDENT)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < desc.textures.size(); ++i) {
+        const SceneTexture& texture = desc.textures[i];
+
+        if ((texture.type > SceneTexture::NOISE) ||
+            !IsIndex(texture.even, i) || !IsIndex(texture.odd, i) ||
+            !IsString(desc, texture.file, texture.type == SceneTexture::IMAGE)) {
+            return false;
+        }
+    }
+
+    for (const SceneMaterial& material : desc.materials) {
+        if ((material.type > SceneMaterial::ISOTROPIC) ||
+            !IsIndex(material.texture, desc.textures.size())) {
+            return false;
+        }
+    }
+
+    for (uint32_t name : desc.objects) {
+        if (!IsString(desc, name, true)) {
+            return false;
+        }
+    }
+
+    for (const SceneShape& shape : desc.shapes) {
+        // the parser's rule: lights only sample the shape, media scatter
+        // with their albedo
+        bool needs_material = ((shape.flags & (SceneShape::LIGHT |
+                                            SceneShape::MEDIUM)) == 0) &&
+                            (shape.type != SceneShape::INSTANCE);
+        bool valid = (shape.type <= SceneShape::INSTANCE) &&
+                    (!needs_material || (shape.material != SCENE_NONE)) &&
+                    IsIndex(shape.material, desc.materials.size()) &&
+                    IsIndex(shape.object, desc.objects.size()) &&
+                    IsIndex(shape.albedo_texture, desc.textures.size()) &&
+                    (((shape.flags & SceneShape::LIGHT) == 0) ||
+                    (shape.object == SCENE_NONE));
+
+        if (shape.type == SceneShape::MESH) {
+            valid = valid && IsString(desc, shape.target, true);
+        }
+        else if (shape.type == SceneShape::INSTANCE) {
+            valid = valid && (shape.target < desc.objects.size()) &&
+                    ((shape.object == SCENE_NONE) ||
+                    (shape.target < shape.object));
+        }
+
+        if (!valid) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Layout of a compiled scene after MAGIC.
+struct CompiledHeader {
+    uint32_t record_sizes[4];       // camera, texture, material, shape
+    uint32_t num_textures;
+    uint32_t num_materials;
+    uint32_t num_shapes;
+    uint32_t num_objects;
+    uint32_t num_chars;
+};
+
+void SetRecordSizes(CompiledHeader& header) {
+    header.record_sizes[0] = sizeof(SceneCamera);
+    header.record_sizes[1] = sizeof(SceneTexture);
+    header.record_sizes[2] = sizeof(SceneMaterial);
+    header.record_sizes[3] = sizeof(SceneShape);
+}
+
+template <typename T>
+void AppendRecords(std::vector<char>& out, const T *records, size_t count) {
+    const char *bytes = reinterpret_cast<const char *>(records);
+
+    out.insert(out.end(), bytes, bytes + sizeof(T) * count);
+}
+
+// Returns the start of the next array.
+template <typename T>
+const char *ReadRecords(const char *p, std::vector<T>& records, size_t count) {
+    records.resize(count);
+
+    if (count > 0) {
+        std::memcpy(records.data(), p, sizeof(T) * count);
+    }
+
+    return (p + sizeof(T) * count);
+}
+
+}
+
+bool SceneLoader::Load(const std::string& filename, SceneDescription& desc) {
+    MappedFile file;
+
+    if (!file.Open(filename)) {
+        std::cerr << "ERROR: could not open scene file '" << filename << "'\n";
+
+        return false;
+    }
+
+    bool compiled = (file.GetSize() >= sizeof(MAGIC)) &&
+                    (std::memcmp(file.GetData(), MAGIC, sizeof(MAGIC)) == 0);
+    bool loaded = compiled ?
+                LoadCompiled(file.GetData(), file.GetSize(), desc) :
+                Parse(file.GetData(), file.GetSize(), desc);
+
+    if (!loaded) {
+        std::cerr << "ERROR: could not load scene '" << filename << "'\n";
+    }
+
+    return loaded;
+}
+
+bool SceneLoader::Parse(const char *text, size_t size, SceneDescription& desc) {
+    const char *p = text;
+    const char *end = text + size;
+    Statement statement;
+    SceneParser parser(desc);
+
+    desc = SceneDescription();
+    statement.line = 0;
+
+    while (p < end) {
+        const void *newline = std::memchr(p, '\n', static_cast<size_t>(end - p));
+        const char *line_end = (newline == nullptr) ?
+                            end : static_cast<const char *>(newline);
+
+        ++statement.line;
+
+        if (!SplitStatement(p, line_end, statement) ||
+            !parser.ParseStatement(statement)) {
+            desc = SceneDescription();
+
+            return false;
+        }
+
+        p = (line_end == end) ? end : (line_end + 1);
+    }
+
+    if (!parser.Finish(statement.line)) {
+        desc = SceneDescription();
+
+        return false;
+    }
+
+    return true;
+}
+
+bool SceneLoader::SaveCompiled(const std::string& filename,
+                            const SceneDescription& desc) {
+    CompiledHeader header;
+    std::vector<char> data(MAGIC, MAGIC + sizeof(MAGIC));
+
+    SetRecordSizes(header);
+    header.num_textures = static_cast<uint32_t>(desc.textures.size());
+    header.num_materials = static_cast<uint32_t>(desc.materials.size());
+    header.num_shapes = static_cast<uint32_t>(desc.shapes.size());
+    header.num_objects = static_cast<uint32_t>(desc.objects.size());
+    header.num_chars = static_cast<uint32_t>(desc.strings.size());
+
+    AppendRecords(data, &header, 1);
+    AppendRecords(data, &desc.camera, 1);
+    AppendRecords(data, desc.textures.data(), desc.textures.size());
+    AppendRecords(data, desc.materials.data(), desc.materials.size());
+    AppendRecords(data, desc.shapes.data(), desc.shapes.size());
+    AppendRecords(data, desc.objects.data(), desc.objects.size());
+    AppendRecords(data, desc.strings.data(), desc.strings.size());
+
+    std::FILE *file = std::fopen(filename.c_str(), "wb");
+
+    if (file == nullptr) {
+        std::cerr << "ERROR: could not write compiled scene '" << filename
+                << "'\n";
+
+        return false;
+    }
+
+    bool written = (std::fwrite(data.data(), 1, data.size(), file) ==
+                    data.size());
+    written = (std::fclose(file) == 0) && written;
+
+    if (!written) {
+        std::cerr << "ERROR: could not write compiled scene '" << filename
+                << "'\n";
+    }
+
+    return written;
+}
+
+bool SceneLoader::LoadCompiled(const char *data, size_t size,
+                            SceneDescription& desc) {
+    CompiledHeader header;
+    CompiledHeader expected;
+    constexpr size_t header_size = sizeof(MAGIC) + sizeof(CompiledHeader);
+
+    desc = SceneDescription();
+
+    if ((size < header_size) ||
+        (std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0)) {
+        std::cerr << "ERROR: not a compiled scene\n";
+
+        return false;
+    }
+
+    std::memcpy(&header, data + sizeof(MAGIC), sizeof(header));
+    SetRecordSizes(expected);
+
+    uint64_t total = header_size + sizeof(SceneCamera) +
+        static_cast<uint64_t>(header.num_textures) * sizeof(SceneTexture) +
+        static_cast<uint64_t>(header.num_materials) * sizeof(SceneMaterial) +
+        static_cast<uint64_t>(header.num_shapes) * sizeof(SceneShape) +
+        static_cast<uint64_t>(header.num_objects) * sizeof(uint32_t) +
+        header.num_chars;
+
+    if (std::memcmp(header.record_sizes, expected.record_sizes,
+                    sizeof(expected.record_sizes)) != 0) {
+        std::cerr << "ERROR: compiled scene was written by a build with "
+                "another record layout, compile it again\n";
+
+        return false;
+    }
+
+    if (total != size) {
+        std::cerr << "ERROR: compiled scene is truncated\n";
+
+        return false;
+    }
+
+    const char *p = data + header_size;
+
+    std::memcpy(&desc.camera, p, sizeof(SceneCamera));
+    p += sizeof(SceneCamera);
+    p = ReadRecords(p, desc.textures, header.num_textures);
+    p = ReadRecords(p, desc.materials, header.num_materials);
+    p = ReadRecords(p, desc.shapes, header.num_shapes);
+    p = ReadRecords(p, desc.objects, header.num_objects);
+    ReadRecords(p, desc.strings, header.num_chars);
+
+    if (!CheckReferences(desc)) {
+        std::cerr << "ERROR: compiled scene refers to records it does not "
+                "have\n";
+        desc = SceneDescription();
+
+        return false;
+    }
+
+    return true;
+}
+
+}
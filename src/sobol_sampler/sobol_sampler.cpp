@@ -0,0 +1,32 @@
+#include "sobol_sampler.hpp"
+
+namespace RayTracing {
+
+const SobolSampler::SecondDimensionTable SobolSampler::SECOND_DIMENSION;
+
+// Direction numbers of the second dimension follow v_(k+1) = v_k ^ (v_k >> 1).
+SobolSampler::SecondDimensionTable::SecondDimensionTable() {
+    uint32_t directions[32];
+    uint32_t v = 1u << 31;
+
+    for (uint32_t bit = 0; bit < 32; ++bit) {
+        directions[bit] = v;
+        v ^= (v >> 1);
+    }
+
+    for (uint32_t byte = 0; byte < 4; ++byte) {
+        for (uint32_t value = 0; value < 256; ++value) {
+            uint32_t result = 0;
+
+            for (uint32_t bit = 0; bit < 8; ++bit) {
+                if (value & (1u << bit)) {
+                    result ^= directions[8 * byte + bit];
+                }
+            }
+
+            bytes[byte][value] = ReverseBits(result);
+        }
+    }
+}
+
+}
@@ -1,17 +1,51 @@
 
 #include "sphere.hpp"
+#include "simd_vec3.hpp"
 
 namespace RayTracing {
 
 bool Sphere::Hit(const Ray& ray,
             const Interval& ray_t,
             HitRecord& rec) const {
-    Point3 center = m_is_moving ? SphereCenter(ray.GetTime()) : m_center;
-    RayTracing::Vec3 oc = center - ray.GetOrigin();
-    RayTracing::Vec3 d = ray.GetDirection();
-    double a = d.LengthSquared();
-    double h = RayTracing::Dot(d, oc);
-    double c = oc.LengthSquared() - m_radius * m_radius;
+    Point3 center = m_is_moving ? SphereCenter(ray.GetTime()) : 
+                                    Point3(m_center);
+    double root = 0.0;
+
+    if (!HitRoot(ray, ray_t, center, m_radius, root)) {
+        return false;
+    }
+
+    rec.point = ray.At(root);
+    rec.t = root;
+    Vec3 outward_normal = (rec.point - center) / m_radius;
+    rec.SetFaceNormal(ray, outward_normal);
+    rec.mat = m_mat.get();
+    auto uv = GetSphereUV(outward_normal);
+    rec.u = uv.first;
+    rec.v = uv.second;
+    rec.uv_density = UVDensity(m_radius);
+
+    return true;
+}
+
+bool Sphere::Occluded(const Ray& ray, const Interval& ray_t) const {
+    Point3 center = m_is_moving ? SphereCenter(ray.GetTime()) : 
+                                    Point3(m_center);
+    double root = 0.0;
+
+    return HitRoot(ray, ray_t, center, m_radius, root);
+}
+
+bool Sphere::HitRoot(const Ray& ray, 
+                    const Interval& ray_t, 
+                    const Point3& center, 
+                    double radius,
+                    double& root) {
+    SimdVec3 oc = SimdVec3(center) - SimdVec3(ray.GetOrigin());
+    SimdVec3 d(ray.GetDirection());
+    double a = Dot(d, d);
+    double h = Dot(d, oc);
+    double c = Dot(oc, oc) - radius * radius;
     double discriminant = h * h - a * c;
 
     if (discriminant < 0) {
@@ -20,7 +54,7 @@ bool Sphere::Hit(const Ray& ray,
 
     double sqrtd = std::sqrt(discriminant);
 
-    double root = (h - sqrtd) / a;
+    root = (h - sqrtd) / a;
     if (!ray_t.Surrounds(root)) {
         root = (h + sqrtd) / a;
         if (!ray_t.Surrounds(root)) {
@@ -28,20 +62,11 @@ bool Sphere::Hit(const Ray& ray,
         }
     }
 
-    rec.point = ray.At(root);
-    rec.t = root;
-    Vec3 outward_normal = (rec.point - center) / m_radius;
-    rec.SetFaceNormal(ray, outward_normal);
-    rec.mat = m_mat;
-    auto uv = GetSphereUV(outward_normal);
-    rec.u = uv.first;
-    rec.v = uv.second;
-
     return true;
 }
 
-inline Point3 Sphere::SphereCenter(double time) const {
-    return (m_center + time * m_center_vec);
+Point3 Sphere::SphereCenter(double time) const {
+    return (Point3(m_center) + time * Vec3(m_center_vec));
 }
 
 }
\ No newline at end of file
@@ -0,0 +1,495 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+
+#include "sphere_set.hpp"
+#include "sphere.hpp"
+
+#ifdef WIDE_BVH_X86
+#include <immintrin.h>
+#endif
+
+namespace RayTracing {
+
+constexpr size_t SphereSet::MAX_DEPTH;
+
+namespace {
+
+// Radii are widened by this much of the distances involved (about 128
+// float ulps), far more than the rounding errors of the float test and
+// of the double precision root, so the cull never drops a sphere that
+// Sphere::HitRoot would hit.
+constexpr float CULL_EPSILON = 1.0f / 65536.0f;
+
+// The ray may hit a sphere when the distance of its center to the ray's
+// line is at most the radius, and the closest point of the line, at tc,
+// is less than a radius (along the ray) outside [t_min, t_max].
+// NaN distances never pass.
+uint32_t CullScalar(const SphereBlock& block,
+                    uint32_t count,
+                    const SphereSetRay& ray,
+                    float t_max) {
+    uint32_t mask = 0;
+
+    for (uint32_t slot = 0; slot < count; ++slot) {
+        float oc[3];
+        float h = 0.0f;
+        float error = ray.origin_l1;
+
+        for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+            oc[axis] = block.center[axis][slot] - ray.origin[axis];
+            h += ray.direction[axis] * oc[axis];
+            error += std::fabs(oc[axis]);
+        }
+
+        float tc = h * ray.inv_a;
+        float distance_squared = 0.0f;
+
+        for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+            float p = oc[axis] - tc * ray.direction[axis];
+
+            distance_squared += p * p;
+        }
+
+        float radius = block.radius[slot] + CULL_EPSILON * error;
+        float half = radius * ray.inv_sqrt_a;
+
+        if ((distance_squared <= radius * radius) &&
+            ((tc - half) <= t_max) && ((tc + half) >= ray.t_min)) {
+            mask |= (1u << slot);
+        }
+    }
+
+    return mask;
+}
+
+#ifdef WIDE_BVH_X86
+
+// Same test as CullScalar, two registers of 4 spheres.
+__attribute__((target("sse2")))
+uint32_t CullSSE(const SphereBlock& block,
+                uint32_t count,
+                const SphereSetRay& ray,
+                float t_max) {
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    uint32_t mask = 0;
+
+    for (uint32_t first = 0; first < count; first += 4) {
+        __m128 oc[3];
+        __m128 h = _mm_setzero_ps();
+        __m128 error = _mm_set1_ps(ray.origin_l1);
+
+        for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+            oc[axis] = _mm_sub_ps(_mm_loadu_ps(block.center[axis] + first),
+                                _mm_set1_ps(ray.origin[axis]));
+            h = _mm_add_ps(h, _mm_mul_ps(_mm_set1_ps(ray.direction[axis]),
+                                        oc[axis]));
+            error = _mm_add_ps(error, _mm_andnot_ps(sign, oc[axis]));
+        }
+
+        __m128 tc = _mm_mul_ps(h, _mm_set1_ps(ray.inv_a));
+        __m128 distance_squared = _mm_setzero_ps();
+
+        for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+            __m128 p = _mm_sub_ps(oc[axis], _mm_mul_ps(tc,
+                                        _mm_set1_ps(ray.direction[axis])));
+
+            distance_squared = _mm_add_ps(distance_squared, _mm_mul_ps(p, p));
+        }
+
+        __m128 radius = _mm_add_ps(_mm_loadu_ps(block.radius + first),
+                            _mm_mul_ps(_mm_set1_ps(CULL_EPSILON), error));
+        __m128 half = _mm_mul_ps(radius, _mm_set1_ps(ray.inv_sqrt_a));
+        __m128 hit = _mm_and_ps(
+                    _mm_cmple_ps(distance_squared, _mm_mul_ps(radius, radius)),
+                    _mm_and_ps(
+                        _mm_cmple_ps(_mm_sub_ps(tc, half), _mm_set1_ps(t_max)),
+                        _mm_cmpge_ps(_mm_add_ps(tc, half),
+                                    _mm_set1_ps(ray.t_min))));
+
+        mask |= static_cast<uint32_t>(_mm_movemask_ps(hit)) << first;
+    }
+
+    return (mask & ((1u << count) - 1));
+}
+
+__attribute__((target("avx2")))
+uint32_t CullAVX2(const SphereBlock& block,
+                uint32_t count,
+                const SphereSetRay& ray,
+                float t_max) {
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 oc[3];
+    __m256 h = _mm256_setzero_ps();
+    __m256 error = _mm256_set1_ps(ray.origin_l1);
+
+    for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+        oc[axis] = _mm256_sub_ps(_mm256_loadu_ps(block.center[axis]),
+                                _mm256_set1_ps(ray.origin[axis]));
+        h = _mm256_add_ps(h, _mm256_mul_ps(_mm256_set1_ps(ray.direction[axis]),
+                                            oc[axis]));
+        error = _mm256_add_ps(error, _mm256_andnot_ps(sign, oc[axis]));
+    }
+
+    __m256 tc = _mm256_mul_ps(h, _mm256_set1_ps(ray.inv_a));
+    __m256 distance_squared = _mm256_setzero_ps();
+
+    for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+        __m256 p = _mm256_sub_ps(oc[axis], _mm256_mul_ps(tc,
+                                    _mm256_set1_ps(ray.direction[axis])));
+
+        distance_squared = _mm256_add_ps(distance_squared,
+                                        _mm256_mul_ps(p, p));
+    }
+
+    __m256 radius = _mm256_add_ps(_mm256_loadu_ps(block.radius),
+                        _mm256_mul_ps(_mm256_set1_ps(CULL_EPSILON), error));
+    __m256 half = _mm256_mul_ps(radius, _mm256_set1_ps(ray.inv_sqrt_a));
+    __m256 hit = _mm256_and_ps(
+                _mm256_cmp_ps(distance_squared, _mm256_mul_ps(radius, radius),
+                            _CMP_LE_OQ),
+                _mm256_and_ps(
+                    _mm256_cmp_ps(_mm256_sub_ps(tc, half),
+                                _mm256_set1_ps(t_max), _CMP_LE_OQ),
+                    _mm256_cmp_ps(_mm256_add_ps(tc, half),
+                                _mm256_set1_ps(ray.t_min), _CMP_GE_OQ)));
+    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(hit));
+
+    return (mask & ((1u << count) - 1));
+}
+
+#endif // WIDE_BVH_X86
+
+// Entry of the traversal stack: a node or a leaf's block and the distance
+// at which the ray enters its box.
+struct StackEntry {
+    uint32_t offset;
+    uint32_t prim_count;
+    float t_near;
+};
+
+}
+
+SphereSet::SphereSet(const std::vector<Point3>& centers,
+                    const std::vector<double>& radii,
+                    const std::vector<std::shared_ptr<Material>>& materials,
+                    SplitMethod method,
+                    WideBVH::ISA isa) :
+m_isa(std::min(isa, WideBVH::DetectISA())), m_bbox(AABB::EMPTY),
+m_build_stats(), m_size(0)
+{
+    size_t num_spheres = centers.size();
+
+    if ((radii.size() != num_spheres) || (materials.size() != num_spheres)) {
+        std::cerr << "ERROR: sphere set with " << num_spheres
+                << " centers, " << radii.size() << " radii and "
+                << materials.size()
+                << " materials is malformed, it is left empty\n";
+
+        return;
+    }
+
+    // boxes of the spheres as they are stored, with float centers and radii
+    std::vector<Vec3f> stored_centers(num_spheres);
+    std::vector<float> stored_radii(num_spheres);
+    std::vector<BVHPrimitive> prims(num_spheres);
+
+    for (size_t sphere = 0; sphere < num_spheres; ++sphere) {
+        stored_centers[sphere] = Vec3f(centers[sphere]);
+        stored_radii[sphere] = static_cast<float>(
+                                        std::fmax(0.0, radii[sphere]));
+
+        Point3 center(stored_centers[sphere]);
+        double radius = stored_radii[sphere];
+        Vec3 rvec(radius, radius, radius);
+        BVHPrimitive& prim = prims[sphere];
+
+        prim.bbox = AABB(center - rvec, center + rvec);
+        prim.centroid = center;
+        prim.index = sphere;
+        prim.morton_code = 0;
+    }
+
+    std::vector<BVHBuildNode> build_nodes =
+                    BVHBuilder::Build(prims, method, &m_build_stats);
+
+    if (build_nodes.empty()) {
+        return;
+    }
+
+    m_bbox = build_nodes[0].bbox;
+    m_size = num_spheres;
+
+    // children follow their parents, so the spheres under every node are
+    // counted in one backward pass
+    size_t num_build_nodes = build_nodes.size();
+    std::vector<size_t> first_prims(num_build_nodes);
+    std::vector<size_t> prim_counts(num_build_nodes);
+
+    for (size_t i = num_build_nodes; i-- > 0;) {
+        const BVHBuildNode& node = build_nodes[i];
+
+        if (node.prim_count > 0) {
+            first_prims[i] = node.first_prim;
+            prim_counts[i] = node.prim_count;
+        }
+        else {
+            first_prims[i] = first_prims[i + 1];
+            prim_counts[i] = prim_counts[i + 1] +
+                            prim_counts[node.second_child];
+        }
+    }
+
+    std::vector<BVHBuildNode> nodes;
+    nodes.reserve(num_build_nodes);
+    Regroup(build_nodes, first_prims, prim_counts, 0, nodes);
+
+    // one block per leaf, which takes the place of the leaf's first
+    // primitive in the wide nodes
+    std::map<const Material *, uint32_t> material_ids;
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].prim_count == 0) {
+            continue;
+        }
+
+        SphereBlock block = SphereBlock();
+
+        for (size_t slot = 0; slot < nodes[i].prim_count; ++slot) {
+            size_t sphere = prims[nodes[i].first_prim + slot].index;
+            const Material *mat = materials[sphere].get();
+            auto found = material_ids.find(mat);
+
+            if (found == material_ids.end()) {
+                found = material_ids.insert(std::make_pair(mat,
+                        static_cast<uint32_t>(m_materials.size()))).first;
+                m_materials.push_back(materials[sphere]);
+            }
+
+            block.center[0][slot] = stored_centers[sphere].GetX();
+            block.center[1][slot] = stored_centers[sphere].GetY();
+            block.center[2][slot] = stored_centers[sphere].GetZ();
+            block.radius[slot] = stored_radii[sphere];
+            block.material[slot] = found->second;
+        }
+
+        nodes[i].first_prim = m_blocks.size();
+        m_blocks.push_back(block);
+    }
+
+    if (m_isa == WideBVH::ISA::AVX2) {
+        WideBVH::Collapse(nodes, 0, m_nodes8);
+    }
+    else {
+        WideBVH::Collapse(nodes, 0, m_nodes4);
+    }
+}
+
+bool SphereSet::Hit(const Ray& ray,
+                    const Interval& ray_t,
+                    HitRecord& rec) const {
+    switch (m_isa) {
+#ifdef WIDE_BVH_X86
+        case WideBVH::ISA::AVX2:
+            return Traverse<8, false, WideBVH::IntersectAVX2, CullAVX2>(
+                                                m_nodes8, ray, ray_t, &rec);
+        case WideBVH::ISA::SSE:
+            return Traverse<4, false, WideBVH::IntersectSSE, CullSSE>(
+                                                m_nodes4, ray, ray_t, &rec);
+#endif
+        default:
+            return Traverse<4, false, WideBVH::IntersectScalar<4>,
+                            CullScalar>(m_nodes4, ray, ray_t, &rec);
+    }
+}
+
+bool SphereSet::Occluded(const Ray& ray, const Interval& ray_t) const {
+    switch (m_isa) {
+#ifdef WIDE_BVH_X86
+        case WideBVH::ISA::AVX2:
+            return Traverse<8, true, WideBVH::IntersectAVX2, CullAVX2>(
+                                                m_nodes8, ray, ray_t, nullptr);
+        case WideBVH::ISA::SSE:
+            return Traverse<4, true, WideBVH::IntersectSSE, CullSSE>(
+                                                m_nodes4, ray, ray_t, nullptr);
+#endif
+        default:
+            return Traverse<4, true, WideBVH::IntersectScalar<4>,
+                            CullScalar>(m_nodes4, ray, ray_t, nullptr);
+    }
+}
+
+void SphereSet::Regroup(const std::vector<BVHBuildNode>& build_nodes,
+                        const std::vector<size_t>& first_prims,
+                        const std::vector<size_t>& prim_counts,
+                        size_t build_index,
+                        std::vector<BVHBuildNode>& nodes) {
+    BVHBuildNode node = build_nodes[build_index];
+
+    if (prim_counts[build_index] <= SPHERE_BLOCK_SIZE) {
+        node.second_child = 0;
+        node.first_prim = first_prims[build_index];
+        node.prim_count = prim_counts[build_index];
+        nodes.push_back(node);
+
+        return;
+    }
+
+    size_t index = nodes.size();
+
+    nodes.push_back(node);
+    Regroup(build_nodes, first_prims, prim_counts, build_index + 1, nodes);
+    nodes[index].second_child = nodes.size();
+    Regroup(build_nodes, first_prims, prim_counts, node.second_child, nodes);
+}
+
+template <size_t WIDTH, bool ANY_HIT,
+        WideBVH::IntersectFunc<WIDTH> INTERSECT, SphereSet::CullFunc CULL>
+bool SphereSet::Traverse(const std::vector<WideBVHNode<WIDTH>>& nodes,
+                        const Ray& ray,
+                        const Interval& ray_t,
+                        HitRecord *rec) const {
+    if (nodes.empty()) {
+        return false;
+    }
+
+    const Vec3f origin(ray.GetOrigin());
+    const Vec3 direction = ray.GetDirection();
+    const Vec3f direction_f(direction);
+    double a = direction.LengthSquared();
+    WideBVHRay wide_ray;
+    SphereSetRay cull_ray;
+
+    for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+        Vec3::Cord cord = static_cast<Vec3::Cord>(axis);
+
+        wide_ray.origin[axis] = origin[cord];
+        wide_ray.inv_dir[axis] = static_cast<float>(1.0 / direction[cord]);
+        cull_ray.origin[axis] = origin[cord];
+        cull_ray.direction[axis] = direction_f[cord];
+    }
+
+    cull_ray.origin_l1 = std::fabs(cull_ray.origin[0]) +
+                        std::fabs(cull_ray.origin[1]) +
+                        std::fabs(cull_ray.origin[2]);
+    cull_ray.inv_a = static_cast<float>(1.0 / a);
+    cull_ray.inv_sqrt_a = static_cast<float>(1.0 / std::sqrt(a));
+    cull_ray.t_min = FloatRoundDown(ray_t.GetMin());
+
+    StackEntry stack[MAX_DEPTH * WIDTH];
+    size_t stack_top = 0;
+    double closest_so_far = ray_t.GetMax();
+    float t_max = FloatRoundUp(closest_so_far);
+    uint32_t closest_block = 0;
+    uint32_t closest_slot = 0;
+    bool hit_anything = false;
+
+    stack[stack_top++] = StackEntry{0, 0, cull_ray.t_min};
+
+    while (stack_top > 0) {
+        const StackEntry entry = stack[--stack_top];
+
+        // the closest hit may have moved in front of the box since the
+        // entry was pushed
+        if (!ANY_HIT && (entry.t_near > t_max)) {
+            continue;
+        }
+
+        if (entry.prim_count > 0) {
+            const SphereBlock& block = m_blocks[entry.offset];
+            uint32_t mask = CULL(block, entry.prim_count, cull_ray, t_max);
+
+            for (uint32_t slot = 0; mask != 0; ++slot, mask >>= 1) {
+                if ((mask & 1u) == 0) {
+                    continue;
+                }
+
+                Interval sphere_t(ray_t.GetMin(), closest_so_far);
+                double root = 0.0;
+
+                if (!Sphere::HitRoot(ray, sphere_t, Center(block, slot),
+                                    block.radius[slot], root)) {
+                    continue;
+                }
+
+                if (ANY_HIT) {
+                    return true;
+                }
+
+                hit_anything = true;
+                closest_so_far = root;
+                t_max = FloatRoundUp(closest_so_far);
+                closest_block = entry.offset;
+                closest_slot = slot;
+            }
+
+            continue;
+        }
+
+        const WideBVHNode<WIDTH>& node = nodes[entry.offset];
+        float t_near[WIDTH];
+        uint32_t mask = INTERSECT(node, wide_ray, cull_ray.t_min, t_max,
+                                t_near);
+
+        if (ANY_HIT) {
+            for (uint32_t child = 0; mask != 0; ++child, mask >>= 1) {
+                if (mask & 1u) {
+                    stack[stack_top++] = StackEntry{node.offset[child],
+                                                    node.prim_count[child],
+                                                    t_near[child]};
+                }
+            }
+
+            continue;
+        }
+
+        // Push the children hit from far to near, so the nearest one is
+        // popped first and shrinks t_max for the others.
+        StackEntry hits[WIDTH];
+        size_t num_hits = 0;
+
+        for (uint32_t child = 0; mask != 0; ++child, mask >>= 1) {
+            if (!(mask & 1u)) {
+                continue;
+            }
+
+            StackEntry hit_entry = StackEntry{node.offset[child],
+                                            node.prim_count[child],
+                                            t_near[child]};
+            size_t i = num_hits++;
+
+            for (; (i > 0) && (hits[i - 1].t_near < hit_entry.t_near); --i) {
+                hits[i] = hits[i - 1];
+            }
+
+            hits[i] = hit_entry;
+        }
+
+        for (size_t i = 0; i < num_hits; ++i) {
+            stack[stack_top++] = hits[i];
+        }
+    }
+
+    // the record is only filled in once, for the closest sphere, like
+    // Sphere::Hit does
+    if (hit_anything) {
+        const SphereBlock& block = m_blocks[closest_block];
+        Point3 center = Center(block, closest_slot);
+        double radius = block.radius[closest_slot];
+
+        rec->point = ray.At(closest_so_far);
+        rec->t = closest_so_far;
+        Vec3 outward_normal = (rec->point - center) / radius;
+        rec->SetFaceNormal(ray, outward_normal);
+        rec->mat = m_materials[block.material[closest_slot]].get();
+        auto uv = Sphere::GetSphereUV(outward_normal);
+        rec->u = uv.first;
+        rec->v = uv.second;
+        rec->uv_density = Sphere::UVDensity(radius);
+    }
+
+    return hit_anything;
+}
+
+}
@@ -0,0 +1,130 @@
+#include "thread_pool.hpp"
+
+namespace RayTracing {
+
+ThreadPool::ThreadPool(uint32_t num_threads) :
+m_task(nullptr), m_generation(0), m_busy_workers(0), m_stop(false)
+{
+    if (num_threads == 0) {
+        num_threads = HardwareThreads();
+    }
+
+    for (uint32_t i = 0; i < num_threads; ++i) {
+        m_queues.emplace_back(new WorkQueue);
+    }
+
+    for (uint32_t i = 0; i < num_threads; ++i) {
+        m_threads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stop = true;
+    }
+
+    m_work_cv.notify_all();
+
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::ParallelFor(size_t num_tasks, const Task& func) {
+    if (num_tasks == 0) {
+        return;
+    }
+
+    size_t num_queues = m_queues.size();
+
+    // Hand every worker a contiguous block of tasks, neighbouring tasks
+    // (e.g. image tiles) tend to touch the same data.
+    for (size_t worker = 0; worker < num_queues; ++worker) {
+        size_t begin = (worker * num_tasks) / num_queues;
+        size_t end = ((worker + 1) * num_tasks) / num_queues;
+        WorkQueue& queue = *m_queues[worker];
+        std::lock_guard<std::mutex> guard(queue.lock);
+
+        for (size_t task = begin; task < end; ++task) {
+            queue.tasks.push_back(task);
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_task = &func;
+    m_busy_workers = static_cast<uint32_t>(m_threads.size());
+    ++m_generation;
+    m_work_cv.notify_all();
+
+    m_done_cv.wait(lock, [this]() { return (m_busy_workers == 0); });
+    m_task = nullptr;
+}
+
+void ThreadPool::WorkerLoop(uint32_t worker) {
+    uint64_t seen_generation = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_work_cv.wait(lock, [this, seen_generation]() {
+                return (m_stop || (m_generation != seen_generation));
+            });
+
+            if (m_stop) {
+                return;
+            }
+
+            seen_generation = m_generation;
+        }
+
+        RunTasks(worker);
+
+        std::lock_guard<std::mutex> guard(m_lock);
+        if (--m_busy_workers == 0) {
+            m_done_cv.notify_one();
+        }
+    }
+}
+
+void ThreadPool::RunTasks(uint32_t worker) {
+    size_t task = 0;
+
+    while (PopTask(worker, task) || StealTask(worker, task)) {
+        (*m_task)(task, worker);
+    }
+}
+
+bool ThreadPool::PopTask(uint32_t worker, size_t& task) {
+    WorkQueue& queue = *m_queues[worker];
+    std::lock_guard<std::mutex> guard(queue.lock);
+
+    if (queue.tasks.empty()) {
+        return false;
+    }
+
+    task = queue.tasks.front();
+    queue.tasks.pop_front();
+
+    return true;
+}
+
+bool ThreadPool::StealTask(uint32_t thief, size_t& task) {
+    size_t num_queues = m_queues.size();
+
+    for (size_t i = 1; i < num_queues; ++i) {
+        WorkQueue& victim = *m_queues[(thief + i) % num_queues];
+        std::lock_guard<std::mutex> guard(victim.lock);
+
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+}
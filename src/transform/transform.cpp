@@ -0,0 +1,167 @@
+#include <cmath>
+
+#include "transform.hpp"
+#include "utils.hpp"
+
+namespace RayTracing {
+
+Transform::Transform(const double (&m)[3][4]) {
+    for (unsigned int row = 0; row < 3; ++row) {
+        for (unsigned int col = 0; col < 4; ++col) {
+            m_m[row][col] = m[row][col];
+        }
+    }
+}
+
+Transform Transform::Translation(const Vec3& offset) {
+    Transform transform;
+
+    transform.m_m[0][3] = offset.GetX();
+    transform.m_m[1][3] = offset.GetY();
+    transform.m_m[2][3] = offset.GetZ();
+
+    return transform;
+}
+
+Transform Transform::Scaling(const Vec3& factors) {
+    Transform transform;
+
+    transform.m_m[0][0] = factors.GetX();
+    transform.m_m[1][1] = factors.GetY();
+    transform.m_m[2][2] = factors.GetZ();
+
+    return transform;
+}
+
+// Rodrigues' rotation formula.
+Transform Transform::Rotation(const Vec3& axis, double angle) {
+    Vec3 a = UnitVector(axis);
+    double sin_theta = std::sin(DegreesToRadians(angle));
+    double cos_theta = std::cos(DegreesToRadians(angle));
+    double x = a.GetX();
+    double y = a.GetY();
+    double z = a.GetZ();
+    double c = 1.0 - cos_theta;
+    const double m[3][4] = {
+        {x * x * c + cos_theta, x * y * c - z * sin_theta,
+            x * z * c + y * sin_theta, 0.0},
+        {y * x * c + z * sin_theta, y * y * c + cos_theta,
+            y * z * c - x * sin_theta, 0.0},
+        {z * x * c - y * sin_theta, z * y * c + x * sin_theta,
+            z * z * c + cos_theta, 0.0}
+    };
+
+    return Transform(m);
+}
+
+// Same rotation as RotateY.
+Transform Transform::RotationY(double angle) {
+    Transform transform;
+    double sin_theta = std::sin(DegreesToRadians(angle));
+    double cos_theta = std::cos(DegreesToRadians(angle));
+
+    transform.m_m[0][0] = cos_theta;
+    transform.m_m[0][2] = sin_theta;
+    transform.m_m[2][0] = -sin_theta;
+    transform.m_m[2][2] = cos_theta;
+
+    return transform;
+}
+
+// Arvo's method: every output interval is the translation plus the sum of
+// the smaller and the larger of m[row][col] * min and m[row][col] * max.
+AABB Transform::TransformBox(const AABB& box) const {
+    Interval in[3] = {box.AxisInterval(AABB::Axis::X),
+                    box.AxisInterval(AABB::Axis::Y),
+                    box.AxisInterval(AABB::Axis::Z)};
+    Interval out[3];
+
+    for (unsigned int col = 0; col < 3; ++col) {
+        if (in[col].GetMin() > in[col].GetMax()) {
+            return AABB::EMPTY;
+        }
+    }
+
+    for (unsigned int row = 0; row < 3; ++row) {
+        double min = m_m[row][3];
+        double max = m_m[row][3];
+
+        for (unsigned int col = 0; col < 3; ++col) {
+            double a = m_m[row][col] * in[col].GetMin();
+            double b = m_m[row][col] * in[col].GetMax();
+
+            min += std::fmin(a, b);
+            max += std::fmax(a, b);
+        }
+
+        out[row] = Interval(min, max);
+    }
+
+    return AABB(out[0], out[1], out[2]);
+}
+
+// Inverse of the linear part by its adjugate, the translation is
+// moved back through it.
+Transform Transform::Inverse() const {
+    double det = Determinant();
+
+    if (det == 0.0) {
+        return Transform();
+    }
+
+    double inv_det = 1.0 / det;
+    double m[3][4];
+
+    m[0][0] = (m_m[1][1] * m_m[2][2] - m_m[1][2] * m_m[2][1]) * inv_det;
+    m[0][1] = (m_m[0][2] * m_m[2][1] - m_m[0][1] * m_m[2][2]) * inv_det;
+    m[0][2] = (m_m[0][1] * m_m[1][2] - m_m[0][2] * m_m[1][1]) * inv_det;
+    m[1][0] = (m_m[1][2] * m_m[2][0] - m_m[1][0] * m_m[2][2]) * inv_det;
+    m[1][1] = (m_m[0][0] * m_m[2][2] - m_m[0][2] * m_m[2][0]) * inv_det;
+    m[1][2] = (m_m[0][2] * m_m[1][0] - m_m[0][0] * m_m[1][2]) * inv_det;
+    m[2][0] = (m_m[1][0] * m_m[2][1] - m_m[1][1] * m_m[2][0]) * inv_det;
+    m[2][1] = (m_m[0][1] * m_m[2][0] - m_m[0][0] * m_m[2][1]) * inv_det;
+    m[2][2] = (m_m[0][0] * m_m[1][1] - m_m[0][1] * m_m[1][0]) * inv_det;
+
+    for (unsigned int row = 0; row < 3; ++row) {
+        m[row][3] = -(m[row][0] * m_m[0][3] + m[row][1] * m_m[1][3] +
+                    m[row][2] * m_m[2][3]);
+    }
+
+    return Transform(m);
+}
+
+double Transform::Determinant() const {
+    return (m_m[0][0] * (m_m[1][1] * m_m[2][2] - m_m[1][2] * m_m[2][1]) -
+            m_m[0][1] * (m_m[1][0] * m_m[2][2] - m_m[1][2] * m_m[2][0]) +
+            m_m[0][2] * (m_m[1][0] * m_m[2][1] - m_m[1][1] * m_m[2][0]));
+}
+
+bool Transform::IsIdentity() const {
+    for (unsigned int row = 0; row < 3; ++row) {
+        for (unsigned int col = 0; col < 4; ++col) {
+            if (m_m[row][col] != ((row == col) ? 1.0 : 0.0)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+Transform operator*(const Transform& a, const Transform& b) {
+    double m[3][4];
+
+    for (unsigned int row = 0; row < 3; ++row) {
+        for (unsigned int col = 0; col < 4; ++col) {
+            m[row][col] = a.m_m[row][0] * b.m_m[0][col] +
+                        a.m_m[row][1] * b.m_m[1][col] +
+                        a.m_m[row][2] * b.m_m[2][col];
+        }
+
+        m[row][3] += a.m_m[row][3];
+    }
+
+    return Transform(m);
+}
+
+}
@@ -0,0 +1,271 @@
+#include <cmath>
+#include <iostream>
+
+#include "triangle_mesh.hpp"
+
+namespace RayTracing {
+
+constexpr size_t TriangleMesh::STACK_SIZE;
+
+TriangleMesh::TriangleMesh(MeshData data,
+                        std::shared_ptr<Material> mat,
+                        SplitMethod method) :
+m_data(std::move(data)), m_mat(mat), m_bbox(AABB::EMPTY), m_build_stats()
+{
+    size_t num_vertices = m_data.GetVertexCount();
+    bool valid = ((m_data.positions.size() % 3) == 0) &&
+                ((m_data.indices.size() % 3) == 0);
+
+    for (size_t i = 0; valid && (i < m_data.indices.size()); ++i) {
+        valid = (m_data.indices[i] < num_vertices);
+    }
+
+    if (!valid) {
+        std::cerr << "ERROR: triangle mesh with " << m_data.positions.size()
+                << " position values and " << m_data.indices.size()
+                << " indices is malformed, it is left empty\n";
+        m_data = MeshData();
+
+        return;
+    }
+
+    if (!m_data.normals.empty() &&
+        (m_data.normals.size() != m_data.positions.size())) {
+        std::cerr << "ERROR: triangle mesh has " << m_data.normals.size()
+                << " normal values for " << num_vertices
+                << " vertices, normals are ignored\n";
+        m_data.normals.clear();
+    }
+
+    if (!m_data.uvs.empty() && (m_data.uvs.size() != 2 * num_vertices)) {
+        std::cerr << "ERROR: triangle mesh has " << m_data.uvs.size()
+                << " uv values for " << num_vertices
+                << " vertices, uvs are ignored\n";
+        m_data.uvs.clear();
+    }
+
+    size_t num_triangles = m_data.GetTriangleCount();
+    std::vector<BVHPrimitive> prims(num_triangles);
+
+    for (size_t tri = 0; tri < num_triangles; ++tri) {
+        const uint32_t *v = &m_data.indices[3 * tri];
+        BVHPrimitive& prim = prims[tri];
+
+        prim.bbox = AABB(AABB(Position(v[0]), Position(v[1])),
+                        AABB(Position(v[2]), Position(v[2])));
+        prim.centroid = prim.bbox.Centroid();
+        prim.index = tri;
+        prim.morton_code = 0;
+    }
+
+    std::vector<BVHBuildNode> build_nodes =
+                    BVHBuilder::Build(prims, method, &m_build_stats);
+
+    if (build_nodes.empty()) {
+        return;
+    }
+
+    m_bbox = build_nodes[0].bbox;
+    m_nodes = LinearBVH::MakeNodes(build_nodes);
+
+    // triangles in leaf order, so a leaf's triangles are consecutive
+    std::vector<uint32_t> indices(m_data.indices.size());
+
+    for (size_t i = 0; i < num_triangles; ++i) {
+        const uint32_t *v = &m_data.indices[3 * prims[i].index];
+
+        indices[3 * i] = v[0];
+        indices[3 * i + 1] = v[1];
+        indices[3 * i + 2] = v[2];
+    }
+
+    m_data.indices.swap(indices);
+}
+
+bool TriangleMesh::Hit(const Ray& ray,
+                    const Interval& ray_t,
+                    HitRecord& rec) const {
+    return Traverse<false>(ray, ray_t, &rec);
+}
+
+bool TriangleMesh::Occluded(const Ray& ray, const Interval& ray_t) const {
+    return Traverse<true>(ray, ray_t, nullptr);
+}
+
+// Moller-Trumbore: solves origin + t * direction =
+// (1 - b1 - b2) * p0 + b1 * p1 + b2 * p2 with Cramer's rule.
+// Both sides of a triangle are hit.
+bool TriangleMesh::IntersectTriangle(const Ray& ray,
+                                    uint32_t tri,
+                                    const Interval& ray_t,
+                                    double& t, double& b1, double& b2) const {
+    const uint32_t *v = &m_data.indices[3 * static_cast<size_t>(tri)];
+    const Point3 p0 = Position(v[0]);
+    const Vec3 e1 = Position(v[1]) - p0;
+    const Vec3 e2 = Position(v[2]) - p0;
+    const Vec3 direction = ray.GetDirection();
+
+    Vec3 p = Cross(direction, e2);
+    double det = Dot(e1, p);
+
+    // ray parallel to the triangle, or a degenerate triangle
+    if (det == 0.0) {
+        return false;
+    }
+
+    double inv_det = 1.0 / det;
+    Vec3 s = ray.GetOrigin() - p0;
+
+    b1 = Dot(s, p) * inv_det;
+    if ((b1 < 0.0) || (b1 > 1.0)) {
+        return false;
+    }
+
+    Vec3 q = Cross(s, e1);
+
+    b2 = Dot(direction, q) * inv_det;
+    if ((b2 < 0.0) || ((b1 + b2) > 1.0)) {
+        return false;
+    }
+
+    t = Dot(e2, q) * inv_det;
+
+    return ray_t.Surrounds(t);
+}
+
+// The face side follows the geometric normal, an interpolated normal is
+// flipped to that side.
+void TriangleMesh::FillHitRecord(const Ray& ray,
+                                uint32_t tri,
+                                double t, double b1, double b2,
+                                HitRecord& rec) const {
+    const uint32_t *v = &m_data.indices[3 * static_cast<size_t>(tri)];
+    const Point3 p0 = Position(v[0]);
+    const Vec3 cross = Cross(Position(v[1]) - p0, Position(v[2]) - p0);
+    double b0 = 1.0 - b1 - b2;
+    double world_area = cross.Length();
+
+    rec.t = t;
+    rec.point = ray.At(t);
+    rec.mat = m_mat.get();
+    rec.SetFaceNormal(ray, UnitVector(cross));
+
+    if (!m_data.normals.empty()) {
+        const float *n0 = &m_data.normals[3 * static_cast<size_t>(v[0])];
+        const float *n1 = &m_data.normals[3 * static_cast<size_t>(v[1])];
+        const float *n2 = &m_data.normals[3 * static_cast<size_t>(v[2])];
+        Vec3 normal(b0 * n0[0] + b1 * n1[0] + b2 * n2[0],
+                    b0 * n0[1] + b1 * n1[1] + b2 * n2[1],
+                    b0 * n0[2] + b1 * n1[2] + b2 * n2[2]);
+
+        if (normal.LengthSquared() > 0.0) {
+            normal = UnitVector(normal);
+            rec.normal = (Dot(normal, rec.normal) < 0.0) ?
+                        (-1.0 * normal) : normal;
+        }
+    }
+
+    if (!m_data.uvs.empty()) {
+        const float *uv0 = &m_data.uvs[2 * static_cast<size_t>(v[0])];
+        const float *uv1 = &m_data.uvs[2 * static_cast<size_t>(v[1])];
+        const float *uv2 = &m_data.uvs[2 * static_cast<size_t>(v[2])];
+
+        // both areas are doubled
+        double uv_area = std::fabs((uv1[0] - uv0[0]) * (uv2[1] - uv0[1]) -
+                                (uv2[0] - uv0[0]) * (uv1[1] - uv0[1]));
+
+        rec.u = b0 * uv0[0] + b1 * uv1[0] + b2 * uv2[0];
+        rec.v = b0 * uv0[1] + b1 * uv1[1] + b2 * uv2[1];
+        rec.uv_density = std::sqrt(uv_area / world_area);
+    }
+    else {
+        rec.u = b1;
+        rec.v = b2;
+        rec.uv_density = 1.0 / std::sqrt(world_area);
+    }
+}
+
+template <bool ANY_HIT>
+bool TriangleMesh::Traverse(const Ray& ray,
+                            const Interval& ray_t,
+                            HitRecord *rec) const {
+    if (m_nodes.empty()) {
+        return false;
+    }
+
+    const SimdVec3 origin(ray.GetOrigin());
+    const Vec3 direction = ray.GetDirection();
+    const SimdVec3 inv_dir = SimdVec3::Broadcast(1) / SimdVec3(direction);
+    const bool dir_is_neg[AABB::Axis::NUM_OF_AXIS] = {
+        (direction.GetX() < 0.0),
+        (direction.GetY() < 0.0),
+        (direction.GetZ() < 0.0)
+    };
+
+    uint32_t stack[STACK_SIZE];
+    size_t stack_top = 0;
+    uint32_t node_index = 0;
+    double closest_so_far = ray_t.GetMax();
+    uint32_t closest_tri = 0;
+    double closest_b1 = 0.0;
+    double closest_b2 = 0.0;
+    bool hit_anything = false;
+
+    for (;;) {
+        const LinearBVHNode& node = m_nodes[node_index];
+
+        if (LinearBVH::HitNode(node, origin, inv_dir,
+                            ray_t.GetMin(), closest_so_far)) {
+            if (node.prim_count == 0) {
+                if (dir_is_neg[node.axis]) {
+                    stack[stack_top++] = node_index + 1;
+                    node_index = node.offset;
+                }
+                else {
+                    stack[stack_top++] = node.offset;
+                    node_index = node_index + 1;
+                }
+
+                continue;
+            }
+
+            for (uint32_t i = 0; i < node.prim_count; ++i) {
+                uint32_t tri = node.offset + i;
+                Interval tri_t(ray_t.GetMin(), closest_so_far);
+                double t = 0.0;
+                double b1 = 0.0;
+                double b2 = 0.0;
+
+                if (!IntersectTriangle(ray, tri, tri_t, t, b1, b2)) {
+                    continue;
+                }
+
+                if (ANY_HIT) {
+                    return true;
+                }
+
+                hit_anything = true;
+                closest_so_far = t;
+                closest_tri = tri;
+                closest_b1 = b1;
+                closest_b2 = b2;
+            }
+        }
+
+        if (stack_top == 0) {
+            break;
+        }
+
+        node_index = stack[--stack_top];
+    }
+
+    // the record is only filled in once, for the closest triangle
+    if (hit_anything) {
+        FillHitRecord(ray, closest_tri, closest_so_far,
+                    closest_b1, closest_b2, *rec);
+    }
+
+    return hit_anything;
+}
+
+}
@@ -0,0 +1,342 @@
+#include <algorithm>
+#include <utility>
+
+#include "wavefront_integrator.hpp"
+#include "path_vertex.hpp"
+
+namespace RayTracing {
+
+constexpr size_t WavefrontIntegrator::RESERVED_MATERIAL_TYPES;
+
+void RayQueue::Reserve(size_t capacity) {
+    capacity = std::max<size_t>(capacity, 1024);
+
+    if (capacity <= path.size()) {
+        return;
+    }
+
+    path.resize(capacity);
+
+    for (size_t axis = 0; axis < 3; ++axis) {
+        origin[axis].resize(capacity);
+        direction[axis].resize(capacity);
+    }
+
+    time.resize(capacity);
+}
+
+void HitQueue::Reserve(size_t capacity) {
+    capacity = std::max<size_t>(capacity, 1024);
+
+    if (capacity <= ray.size()) {
+        return;
+    }
+
+    ray.resize(capacity);
+
+    for (size_t axis = 0; axis < 3; ++axis) {
+        point[axis].resize(capacity);
+        normal[axis].resize(capacity);
+    }
+
+    t.resize(capacity);
+    u.resize(capacity);
+    v.resize(capacity);
+    uv_density.resize(capacity);
+    front_face.resize(capacity);
+    mat.resize(capacity);
+    material_type.resize(capacity);
+}
+
+WavefrontIntegrator::WavefrontIntegrator(const Sampler& sampler,
+                                        const Hittable& world,
+                                        const Hittable& lights,
+                                        const Color& background,
+                                        uint32_t max_depth,
+                                        uint32_t roulette_depth,
+                                        double cone_spread) :
+m_sampler(sampler), m_world(world), m_lights(lights),
+m_background(background), m_max_depth(max_depth),
+m_roulette_depth(roulette_depth), m_cone_spread(cone_spread)
+{}
+
+void WavefrontIntegrator::Reserve(size_t num_paths) {
+    m_samples.reserve(num_paths);
+    m_dimensions.reserve(num_paths);
+    m_rngs.reserve(num_paths);
+    m_bsdf_pdf.reserve(num_paths);
+    m_light_pdf.reserve(num_paths);
+    m_cone_width.reserve(num_paths);
+
+    for (size_t c = 0; c < 3; ++c) {
+        m_throughput[c].reserve(num_paths);
+        m_radiance[c].reserve(num_paths);
+        m_shadow_weight[c].reserve(num_paths);
+    }
+
+    m_rays.Reserve(num_paths);
+    m_next_rays.Reserve(num_paths);
+    m_shadow_rays.Reserve(num_paths);
+    m_hits.Reserve(num_paths);
+    m_shading_order.reserve(num_paths);
+    m_hit_buckets.reserve(num_paths);
+    m_material_types.reserve(RESERVED_MATERIAL_TYPES);
+    m_bucket_offsets.reserve(RESERVED_MATERIAL_TYPES + 1);
+}
+
+void WavefrontIntegrator::Clear() {
+    m_samples.clear();
+    m_dimensions.clear();
+    m_rngs.clear();
+    m_bsdf_pdf.clear();
+    m_light_pdf.clear();
+    m_cone_width.clear();
+
+    for (size_t c = 0; c < 3; ++c) {
+        m_throughput[c].clear();
+        m_radiance[c].clear();
+    }
+
+    m_rays.Clear();
+}
+
+size_t WavefrontIntegrator::AddPath(const Ray& ray,
+                                    const SampleSequence& sequence,
+                                    const RNG& rng) {
+    size_t path = m_samples.size();
+
+    m_samples.push_back(sequence.GetSample());
+    m_dimensions.push_back(sequence.GetDimension());
+    m_rngs.push_back(rng);
+    m_bsdf_pdf.push_back(1.0);
+    m_light_pdf.push_back(0.0);
+    m_cone_width.push_back(0.0);
+
+    for (size_t c = 0; c < 3; ++c) {
+        m_throughput[c].push_back(1.0);
+        m_radiance[c].push_back(0.0);
+    }
+
+    m_rays.Push(static_cast<uint32_t>(path), ray);
+
+    return path;
+}
+
+// Every iteration is one bounce of all paths still alive: the intersect
+// stage (in packets for the camera rays) ends the paths that miss, the
+// shade stage queues the rays of the paths that go on and the light
+// samples, which the shadow stage traces.
+void WavefrontIntegrator::Trace() {
+    for (uint32_t depth = 0; (depth < m_max_depth) && (m_rays.Size() > 0);
+        ++depth) {
+        if (depth == 0) {
+            IntersectPackets();
+        }
+        else {
+            Intersect();
+        }
+
+        SortHits();
+        Shade(depth);
+        TraceShadowRays();
+
+        std::swap(m_rays, m_next_rays);
+    }
+
+    m_rays.Clear();
+}
+
+// Intersects the ray queue with the world and adds the background to the
+// paths that miss. Media draw their scattering distance from the thread's
+// generator, which holds the path's one during the query.
+void WavefrontIntegrator::Intersect() {
+    RNG& thread_rng = ThreadRNG();
+    m_hits.Clear();
+
+    for (size_t r = 0; r < m_rays.Size(); ++r) {
+        uint32_t path = m_rays.path[r];
+        HitRecord rec;
+
+        thread_rng = m_rngs[path];
+        // Interval min = 0.001 - Fixing shadow acne
+        bool hit = m_world.Hit(m_rays.Get(r), Interval(0.001, RayTracing::INF),
+                            rec);
+        m_rngs[path] = thread_rng;
+
+        AddHit(r, hit, rec);
+    }
+}
+
+// Same as Intersect with the rays traced in packets of consecutive rays,
+// for the coherent camera rays of the first bounce.
+void WavefrontIntegrator::IntersectPackets() {
+    RayPacket packet;
+    HitRecord recs[RayPacket::MAX_SIZE];
+    size_t num_rays = m_rays.Size();
+    m_hits.Clear();
+
+    packet.t_min = 0.001;
+
+    for (size_t first = 0; first < num_rays; first += RayPacket::MAX_SIZE) {
+        packet.size = static_cast<uint32_t>(
+                        std::min<size_t>(num_rays - first, RayPacket::MAX_SIZE));
+
+        for (uint32_t k = 0; k < packet.size; ++k) {
+            packet.rays[k] = m_rays.Get(first + k);
+            packet.t_max[k] = RayTracing::INF;
+            packet.rngs[k] = &m_rngs[m_rays.path[first + k]];
+        }
+
+        uint32_t mask = m_world.HitPacket(packet, recs);
+
+        for (uint32_t k = 0; k < packet.size; ++k) {
+            AddHit(first + k, (mask & (1u << k)) != 0, recs[k]);
+        }
+    }
+}
+
+// Queues the hit of ray r, or ends its path with the background.
+void WavefrontIntegrator::AddHit(size_t r, bool hit, const HitRecord& rec) {
+    if (hit) {
+        m_hits.Push(static_cast<uint32_t>(r), rec);
+
+        return;
+    }
+
+    uint32_t path = m_rays.path[r];
+    Vec3 background = static_cast<Vec3>(m_background);
+    double weight = PowerHeuristic(m_bsdf_pdf[path], m_light_pdf[path]);
+
+    for (size_t c = 0; c < 3; ++c) {
+        m_radiance[c][path] += weight * m_throughput[c][path] *
+                            background[static_cast<Vec3::Cord>(c)];
+    }
+}
+
+// Orders the hits by material class with a counting sort, the shade stage
+// runs every class's queue as one block. Hits of a class keep the order
+// of their rays.
+void WavefrontIntegrator::SortHits() {
+    size_t num_hits = m_hits.Size();
+    m_hit_buckets.resize(num_hits);
+
+    for (size_t h = 0; h < num_hits; ++h) {
+        m_hit_buckets[h] = MaterialBucket(m_hits.material_type[h]);
+    }
+
+    m_bucket_offsets.assign(m_material_types.size() + 1, 0);
+
+    for (size_t h = 0; h < num_hits; ++h) {
+        ++m_bucket_offsets[m_hit_buckets[h] + 1];
+    }
+
+    for (size_t b = 1; b < m_bucket_offsets.size(); ++b) {
+        m_bucket_offsets[b] += m_bucket_offsets[b - 1];
+    }
+
+    m_shading_order.resize(num_hits);
+
+    for (size_t h = 0; h < num_hits; ++h) {
+        m_shading_order[m_bucket_offsets[m_hit_buckets[h]]++] = 
+                                                static_cast<uint32_t>(h);
+    }
+}
+
+// Scenes use a handful of material classes, a linear search is the
+// fastest way to find them.
+uint32_t WavefrontIntegrator::MaterialBucket(const std::type_info *type) {
+    size_t num_types = m_material_types.size();
+
+    for (size_t b = 0; b < num_types; ++b) {
+        if (m_material_types[b] == type) {
+            return static_cast<uint32_t>(b);
+        }
+    }
+
+    m_material_types.push_back(type);
+
+    return static_cast<uint32_t>(num_types);
+}
+
+// Emission, scattering and roulette of every hit in material order.
+// The rays of the surviving paths form the next queue.
+void WavefrontIntegrator::Shade(uint32_t depth) {
+    m_next_rays.Clear();
+    m_shadow_rays.Clear();
+
+    for (size_t c = 0; c < 3; ++c) {
+        m_shadow_weight[c].clear();
+    }
+
+    for (uint32_t h : m_shading_order) {
+        uint32_t r = m_hits.ray[h];
+        uint32_t path = m_rays.path[r];
+        Ray ray = m_rays.Get(r);
+        HitRecord rec = m_hits.Get(h);
+        SampleSequence sequence(m_sampler, m_samples[path],
+                                m_dimensions[path]);
+        Vec3 radiance(m_radiance[0][path], m_radiance[1][path],
+                    m_radiance[2][path]);
+        Vec3 throughput(m_throughput[0][path], m_throughput[1][path],
+                        m_throughput[2][path]);
+        PathState state = {m_bsdf_pdf[path], m_light_pdf[path],
+                        m_cone_width[path], m_cone_spread};
+        Ray next_ray;
+        ShadowRay shadow;
+        bool has_shadow = false;
+
+        if (ShadePathVertex(ray, rec, m_lights, depth, m_roulette_depth,
+                            sequence, m_rngs[path],
+                            radiance, throughput, state, next_ray,
+                            shadow, has_shadow)) {
+            m_next_rays.Push(path, next_ray);
+        }
+
+        if (has_shadow) {
+            m_shadow_rays.Push(path, shadow.ray);
+
+            for (size_t c = 0; c < 3; ++c) {
+                m_shadow_weight[c].push_back(
+                                shadow.weight[static_cast<Vec3::Cord>(c)]);
+            }
+        }
+
+        m_bsdf_pdf[path] = state.bsdf_pdf;
+        m_light_pdf[path] = state.light_pdf;
+        m_cone_width[path] = state.cone_width;
+
+        m_dimensions[path] = sequence.GetDimension();
+
+        for (size_t c = 0; c < 3; ++c) {
+            auto cord = static_cast<Vec3::Cord>(c);
+            m_radiance[c][path] = radiance[cord];
+            m_throughput[c][path] = throughput[cord];
+        }
+    }
+}
+
+// Adds what the light samples of the shade stage see to their paths, in
+// the order they were queued. Media draw from the path's generator as in
+// Intersect.
+void WavefrontIntegrator::TraceShadowRays() {
+    RNG& thread_rng = ThreadRNG();
+
+    for (size_t s = 0; s < m_shadow_rays.Size(); ++s) {
+        uint32_t path = m_shadow_rays.path[s];
+        ShadowRay shadow = {m_shadow_rays.Get(s),
+                            Vec3(m_shadow_weight[0][s], m_shadow_weight[1][s],
+                                m_shadow_weight[2][s])};
+        Vec3 radiance(m_radiance[0][path], m_radiance[1][path],
+                    m_radiance[2][path]);
+
+        thread_rng = m_rngs[path];
+        TraceShadowRay(m_world, m_background, shadow, radiance);
+        m_rngs[path] = thread_rng;
+
+        for (size_t c = 0; c < 3; ++c) {
+            m_radiance[c][path] = radiance[static_cast<Vec3::Cord>(c)];
+        }
+    }
+}
+
+}
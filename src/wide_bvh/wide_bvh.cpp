@@ -0,0 +1,722 @@
+#include <algorithm>
+#include <limits>
+
+#include "wide_bvh.hpp"
+
+#ifdef WIDE_BVH_X86
+#include <immintrin.h>
+#endif
+
+namespace RayTracing {
+
+namespace {
+
+// Float slab tests are widened by 2 * gamma(3) (pbrt's bound on the
+// rounding error of the distances), so they never miss a box the
+// double precision test would hit.
+constexpr float T_FAR_SCALE = 1.0f + 2.0f * 3.0f *
+                                (std::numeric_limits<float>::epsilon() * 0.5f) /
+                                (1.0f - 3.0f *
+                                (std::numeric_limits<float>::epsilon() * 0.5f));
+
+
+// Same slab test as IntersectScalar, of one child against every ray of
+// a packet. Unused rays have t_max = -inf and never hit.
+template <size_t WIDTH>
+uint32_t IntersectPacketScalar(const WideBVHNode<WIDTH>& node,
+                            uint32_t child,
+                            const WideBVHPacket& packet,
+                            float t_min,
+                            float *t_near) {
+    uint32_t mask = 0;
+
+    for (uint32_t k = 0; k < RayPacket::MAX_SIZE; ++k) {
+        float t_enter = t_min;
+        float t_exit = packet.t_max[k];
+
+        for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+            float t0 = (node.bounds_min[axis][child] - packet.origin[axis][k]) *
+                        packet.inv_dir[axis][k];
+            float t1 = (node.bounds_max[axis][child] - packet.origin[axis][k]) *
+                        packet.inv_dir[axis][k];
+            float t_lo = (t0 < t1) ? t0 : t1;
+            float t_hi = (t0 > t1) ? t0 : t1;
+
+            t_enter = (t_lo > t_enter) ? t_lo : t_enter;
+            t_exit = (t_hi < t_exit) ? t_hi : t_exit;
+        }
+
+        t_near[k] = t_enter;
+
+        if (t_enter <= t_exit * T_FAR_SCALE) {
+            mask |= (1u << k);
+        }
+    }
+
+    return mask;
+}
+
+#ifdef WIDE_BVH_X86
+
+// Packets take two registers of 4 rays.
+__attribute__((target("sse2")))
+uint32_t IntersectPacketSSE(const WideBVHNode<4>& node,
+                            uint32_t child,
+                            const WideBVHPacket& packet,
+                            float t_min,
+                            float *t_near) {
+    uint32_t mask = 0;
+
+    for (uint32_t first = 0; first < RayPacket::MAX_SIZE; first += 4) {
+        __m128 t_enter = _mm_set1_ps(t_min);
+        __m128 t_exit = _mm_loadu_ps(packet.t_max + first);
+
+        for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+            __m128 origin = _mm_loadu_ps(packet.origin[axis] + first);
+            __m128 inv_dir = _mm_loadu_ps(packet.inv_dir[axis] + first);
+            __m128 t0 = _mm_mul_ps(_mm_sub_ps(
+                    _mm_set1_ps(node.bounds_min[axis][child]), origin), inv_dir);
+            __m128 t1 = _mm_mul_ps(_mm_sub_ps(
+                    _mm_set1_ps(node.bounds_max[axis][child]), origin), inv_dir);
+
+            t_enter = _mm_max_ps(_mm_min_ps(t0, t1), t_enter);
+            t_exit = _mm_min_ps(_mm_max_ps(t0, t1), t_exit);
+        }
+
+        t_exit = _mm_mul_ps(t_exit, _mm_set1_ps(T_FAR_SCALE));
+        _mm_storeu_ps(t_near + first, t_enter);
+
+        mask |= static_cast<uint32_t>(
+                _mm_movemask_ps(_mm_cmple_ps(t_enter, t_exit))) << first;
+    }
+
+    return mask;
+}
+
+__attribute__((target("avx2")))
+uint32_t IntersectPacketAVX2(const WideBVHNode<8>& node,
+                            uint32_t child,
+                            const WideBVHPacket& packet,
+                            float t_min,
+                            float *t_near) {
+    __m256 t_enter = _mm256_set1_ps(t_min);
+    __m256 t_exit = _mm256_loadu_ps(packet.t_max);
+
+    for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+        __m256 origin = _mm256_loadu_ps(packet.origin[axis]);
+        __m256 inv_dir = _mm256_loadu_ps(packet.inv_dir[axis]);
+        __m256 t0 = _mm256_mul_ps(_mm256_sub_ps(
+                _mm256_set1_ps(node.bounds_min[axis][child]), origin), inv_dir);
+        __m256 t1 = _mm256_mul_ps(_mm256_sub_ps(
+                _mm256_set1_ps(node.bounds_max[axis][child]), origin), inv_dir);
+
+        t_enter = _mm256_max_ps(_mm256_min_ps(t0, t1), t_enter);
+        t_exit = _mm256_min_ps(_mm256_max_ps(t0, t1), t_exit);
+    }
+
+    t_exit = _mm256_mul_ps(t_exit, _mm256_set1_ps(T_FAR_SCALE));
+    _mm256_storeu_ps(t_near, t_enter);
+
+    return static_cast<uint32_t>(_mm256_movemask_ps(
+                        _mm256_cmp_ps(t_enter, t_exit, _CMP_LE_OQ)));
+}
+
+#endif // WIDE_BVH_X86
+
+// Entry of the traversal stack: a node or a leaf child and the distance
+// at which the ray enters its box.
+struct StackEntry {
+    uint32_t offset;
+    uint32_t prim_count;
+    float t_near;
+};
+
+// Entry of the packet traversal stack: the rays of the packet that enter
+// the box and the nearest distance one of them does so at.
+struct PacketStackEntry {
+    uint32_t offset;
+    uint32_t prim_count;
+    uint32_t rays;
+    float t_near;
+};
+
+}
+
+// Comparisons are ordered so that a NaN distance (ray origin on a slab of
+// an axis the ray is parallel to) leaves the interval unchanged,
+// like the SSE min/max instructions do.
+template <size_t WIDTH>
+uint32_t WideBVH::IntersectScalar(const WideBVHNode<WIDTH>& node,
+                                const WideBVHRay& ray,
+                                float t_min, float t_max,
+                                float *t_near) {
+    uint32_t mask = 0;
+
+    for (uint32_t child = 0; child < node.num_children; ++child) {
+        float t_enter = t_min;
+        float t_exit = t_max;
+
+        for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+            float t0 = (node.bounds_min[axis][child] - ray.origin[axis]) *
+                        ray.inv_dir[axis];
+            float t1 = (node.bounds_max[axis][child] - ray.origin[axis]) *
+                        ray.inv_dir[axis];
+            float t_lo = (t0 < t1) ? t0 : t1;
+            float t_hi = (t0 > t1) ? t0 : t1;
+
+            t_enter = (t_lo > t_enter) ? t_lo : t_enter;
+            t_exit = (t_hi < t_exit) ? t_hi : t_exit;
+        }
+
+        t_near[child] = t_enter;
+
+        if (t_enter <= t_exit * T_FAR_SCALE) {
+            mask |= (1u << child);
+        }
+    }
+
+    return mask;
+}
+
+template uint32_t WideBVH::IntersectScalar<4>(const WideBVHNode<4>& node,
+                                            const WideBVHRay& ray,
+                                            float t_min, float t_max,
+                                            float *t_near);
+
+#ifdef WIDE_BVH_X86
+
+__attribute__((target("sse2")))
+uint32_t WideBVH::IntersectSSE(const WideBVHNode<4>& node,
+                            const WideBVHRay& ray,
+                            float t_min, float t_max,
+                            float *t_near) {
+    __m128 t_enter = _mm_set1_ps(t_min);
+    __m128 t_exit = _mm_set1_ps(t_max);
+
+    for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+        __m128 origin = _mm_set1_ps(ray.origin[axis]);
+        __m128 inv_dir = _mm_set1_ps(ray.inv_dir[axis]);
+        __m128 t0 = _mm_mul_ps(_mm_sub_ps(
+                        _mm_loadu_ps(node.bounds_min[axis]), origin), inv_dir);
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(
+                        _mm_loadu_ps(node.bounds_max[axis]), origin), inv_dir);
+
+        t_enter = _mm_max_ps(_mm_min_ps(t0, t1), t_enter);
+        t_exit = _mm_min_ps(_mm_max_ps(t0, t1), t_exit);
+    }
+
+    t_exit = _mm_mul_ps(t_exit, _mm_set1_ps(T_FAR_SCALE));
+    _mm_storeu_ps(t_near, t_enter);
+
+    uint32_t mask = static_cast<uint32_t>(
+                        _mm_movemask_ps(_mm_cmple_ps(t_enter, t_exit)));
+
+    return (mask & ((1u << node.num_children) - 1));
+}
+
+__attribute__((target("avx2")))
+uint32_t WideBVH::IntersectAVX2(const WideBVHNode<8>& node,
+                            const WideBVHRay& ray,
+                            float t_min, float t_max,
+                            float *t_near) {
+    __m256 t_enter = _mm256_set1_ps(t_min);
+    __m256 t_exit = _mm256_set1_ps(t_max);
+
+    for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+        __m256 origin = _mm256_set1_ps(ray.origin[axis]);
+        __m256 inv_dir = _mm256_set1_ps(ray.inv_dir[axis]);
+        __m256 t0 = _mm256_mul_ps(_mm256_sub_ps(
+                    _mm256_loadu_ps(node.bounds_min[axis]), origin), inv_dir);
+        __m256 t1 = _mm256_mul_ps(_mm256_sub_ps(
+                    _mm256_loadu_ps(node.bounds_max[axis]), origin), inv_dir);
+
+        t_enter = _mm256_max_ps(_mm256_min_ps(t0, t1), t_enter);
+        t_exit = _mm256_min_ps(_mm256_max_ps(t0, t1), t_exit);
+    }
+
+    t_exit = _mm256_mul_ps(t_exit, _mm256_set1_ps(T_FAR_SCALE));
+    _mm256_storeu_ps(t_near, t_enter);
+
+    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(
+                        _mm256_cmp_ps(t_enter, t_exit, _CMP_LE_OQ)));
+
+    return (mask & ((1u << node.num_children) - 1));
+}
+
+#endif // WIDE_BVH_X86
+
+WideBVH::WideBVH(const std::vector<std::shared_ptr<Hittable>>& objects,
+                SplitMethod method,
+                ISA isa) :
+m_isa(std::min(isa, DetectISA()))
+{
+    std::vector<BVHPrimitive> prims =
+                    BVHBuilder::MakePrimitives(objects, 0, objects.size());
+    std::vector<BVHBuildNode> build_nodes =
+                    BVHBuilder::Build(prims, method, &m_build_stats);
+
+    m_bbox = build_nodes.empty() ? AABB::EMPTY : build_nodes[0].bbox;
+
+    m_primitives.reserve(prims.size());
+    for (const auto& prim : prims) {
+        m_primitives.push_back(objects[prim.index]);
+    }
+
+    if (build_nodes.empty()) {
+        return;
+    }
+
+    if (m_isa == ISA::AVX2) {
+        Collapse(build_nodes, 0, m_nodes8);
+    }
+    else {
+        Collapse(build_nodes, 0, m_nodes4);
+    }
+}
+
+bool WideBVH::Hit(const Ray& ray,
+                const Interval& ray_t,
+                HitRecord& rec) const {
+    switch (m_isa) {
+#ifdef WIDE_BVH_X86
+        case ISA::AVX2:
+            return Traverse<8, false, IntersectAVX2>(m_nodes8, 0, 
+                                                    ray, ray_t, &rec);
+        case ISA::SSE:
+            return Traverse<4, false, IntersectSSE>(m_nodes4, 0, 
+                                                    ray, ray_t, &rec);
+#endif
+        default:
+            return Traverse<4, false, IntersectScalar<4>>(m_nodes4, 0,
+                                                        ray, ray_t, &rec);
+    }
+}
+
+bool WideBVH::Occluded(const Ray& ray, const Interval& ray_t) const {
+    switch (m_isa) {
+#ifdef WIDE_BVH_X86
+        case ISA::AVX2:
+            return Traverse<8, true, IntersectAVX2>(m_nodes8, 0,
+                                                    ray, ray_t, nullptr);
+        case ISA::SSE:
+            return Traverse<4, true, IntersectSSE>(m_nodes4, 0,
+                                                ray, ray_t, nullptr);
+#endif
+        default:
+            return Traverse<4, true, IntersectScalar<4>>(m_nodes4, 0,
+                                                        ray, ray_t, nullptr);
+    }
+}
+
+uint32_t WideBVH::HitPacket(RayPacket& packet, HitRecord *recs) const {
+    switch (m_isa) {
+#ifdef WIDE_BVH_X86
+        case ISA::AVX2:
+            return TraversePacket<8, false, IntersectAVX2, 
+                                IntersectPacketAVX2>(m_nodes8, packet, recs);
+        case ISA::SSE:
+            return TraversePacket<4, false, IntersectSSE, 
+                                IntersectPacketSSE>(m_nodes4, packet, recs);
+#endif
+        default:
+            return TraversePacket<4, false, IntersectScalar<4>,
+                                IntersectPacketScalar<4>>(m_nodes4, 
+                                                        packet, recs);
+    }
+}
+
+uint32_t WideBVH::OccludedPacket(const RayPacket& packet) const {
+    RayPacket rays = packet;
+
+    switch (m_isa) {
+#ifdef WIDE_BVH_X86
+        case ISA::AVX2:
+            return TraversePacket<8, true, IntersectAVX2, 
+                                IntersectPacketAVX2>(m_nodes8, rays, nullptr);
+        case ISA::SSE:
+            return TraversePacket<4, true, IntersectSSE, 
+                                IntersectPacketSSE>(m_nodes4, rays, nullptr);
+#endif
+        default:
+            return TraversePacket<4, true, IntersectScalar<4>,
+                                IntersectPacketScalar<4>>(m_nodes4, 
+                                                        rays, nullptr);
+    }
+}
+
+WideBVH::ISA WideBVH::DetectISA() {
+#ifdef WIDE_BVH_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        return ISA::AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return ISA::SSE;
+    }
+#endif
+
+    return ISA::SCALAR;
+}
+
+// Every wide node starts with the two children of a binary node, the
+// interior child with the largest surface area is repeatedly replaced by
+// its own two children until WIDTH children are collected or only leaves
+// are left.
+template <size_t WIDTH>
+uint32_t WideBVH::Collapse(const std::vector<BVHBuildNode>& build_nodes,
+                        size_t build_index,
+                        std::vector<WideBVHNode<WIDTH>>& nodes) {
+    size_t children[WIDTH];
+    size_t num_children = 0;
+    const BVHBuildNode& root = build_nodes[build_index];
+
+    if (root.prim_count > 0) {
+        children[num_children++] = build_index;
+    }
+    else {
+        children[num_children++] = build_index + 1;
+        children[num_children++] = root.second_child;
+    }
+
+    while (num_children < WIDTH) {
+        size_t best = WIDTH;
+        double best_area = -1.0;
+
+        for (size_t i = 0; i < num_children; ++i) {
+            const BVHBuildNode& child = build_nodes[children[i]];
+            double area = child.bbox.SurfaceArea();
+
+            if ((child.prim_count == 0) && (area > best_area)) {
+                best = i;
+                best_area = area;
+            }
+        }
+
+        if (best == WIDTH) {
+            break;
+        }
+
+        size_t opened = children[best];
+        children[best] = opened + 1;
+        children[num_children++] = build_nodes[opened].second_child;
+    }
+
+    uint32_t node_index = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(WideBVHNode<WIDTH>());
+
+    uint32_t offsets[WIDTH];
+    for (size_t i = 0; i < num_children; ++i) {
+        const BVHBuildNode& child = build_nodes[children[i]];
+
+        offsets[i] = ((child.prim_count > 0) ?
+                    static_cast<uint32_t>(child.first_prim) :
+                    Collapse(build_nodes, children[i], nodes));
+    }
+
+    // nodes may have been reallocated by the recursion
+    WideBVHNode<WIDTH>& node = nodes[node_index];
+    node.num_children = static_cast<uint32_t>(num_children);
+
+    for (size_t i = 0; i < WIDTH; ++i) {
+        bool used = (i < num_children);
+
+        for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+            if (used) {
+                Interval inter = build_nodes[children[i]].bbox.AxisInterval(
+                                            static_cast<AABB::Axis>(axis));
+                node.bounds_min[axis][i] = FloatRoundDown(inter.GetMin());
+                node.bounds_max[axis][i] = FloatRoundUp(inter.GetMax());
+            }
+            else {
+                node.bounds_min[axis][i] =
+                                std::numeric_limits<float>::infinity();
+                node.bounds_max[axis][i] =
+                                -std::numeric_limits<float>::infinity();
+            }
+        }
+
+        node.offset[i] = used ? offsets[i] : 0;
+        node.prim_count[i] = static_cast<uint16_t>(used ?
+                                build_nodes[children[i]].prim_count : 0);
+    }
+
+    return node_index;
+}
+
+template uint32_t WideBVH::Collapse<4>(
+                            const std::vector<BVHBuildNode>& build_nodes,
+                            size_t build_index,
+                            std::vector<WideBVHNode<4>>& nodes);
+template uint32_t WideBVH::Collapse<8>(
+                            const std::vector<BVHBuildNode>& build_nodes,
+                            size_t build_index,
+                            std::vector<WideBVHNode<8>>& nodes);
+
+template <size_t WIDTH, bool ANY_HIT, WideBVH::IntersectFunc<WIDTH> INTERSECT>
+bool WideBVH::Traverse(const std::vector<WideBVHNode<WIDTH>>& nodes,
+                    uint32_t root,
+                    const Ray& ray,
+                    const Interval& ray_t,
+                    HitRecord *rec) const {
+    if (nodes.empty()) {
+        return false;
+    }
+
+    const Point3 origin = ray.GetOrigin();
+    const Vec3 direction = ray.GetDirection();
+    WideBVHRay wide_ray;
+
+    for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+        Vec3::Cord cord = static_cast<Vec3::Cord>(axis);
+
+        wide_ray.origin[axis] = static_cast<float>(origin[cord]);
+        wide_ray.inv_dir[axis] = static_cast<float>(1.0 / direction[cord]);
+    }
+
+    StackEntry stack[MAX_DEPTH * WIDTH];
+    size_t stack_top = 0;
+    double closest_so_far = ray_t.GetMax();
+    const float t_min = FloatRoundDown(ray_t.GetMin());
+    float t_max = FloatRoundUp(closest_so_far);
+    bool hit_anything = false;
+
+    stack[stack_top++] = StackEntry{root, 0, t_min};
+
+    while (stack_top > 0) {
+        const StackEntry entry = stack[--stack_top];
+
+        // the closest hit may have moved in front of the box since the
+        // entry was pushed
+        if (!ANY_HIT && (entry.t_near > t_max)) {
+            continue;
+        }
+
+        if (entry.prim_count > 0) {
+            for (uint32_t i = 0; i < entry.prim_count; ++i) {
+                const Hittable& prim = *m_primitives[entry.offset + i];
+                Interval prim_t(ray_t.GetMin(), closest_so_far);
+
+                if (ANY_HIT) {
+                    if (prim.Occluded(ray, prim_t)) {
+                        return true;
+                    }
+                }
+                else if (prim.Hit(ray, prim_t, *rec)) {
+                    hit_anything = true;
+                    closest_so_far = rec->t;
+                    t_max = FloatRoundUp(closest_so_far);
+                }
+            }
+
+            continue;
+        }
+
+        const WideBVHNode<WIDTH>& node = nodes[entry.offset];
+        float t_near[WIDTH];
+        uint32_t mask = INTERSECT(node, wide_ray, t_min, t_max, t_near);
+
+        if (ANY_HIT) {
+            for (uint32_t child = 0; mask != 0; ++child, mask >>= 1) {
+                if (mask & 1u) {
+                    stack[stack_top++] = StackEntry{node.offset[child],
+                                                    node.prim_count[child],
+                                                    t_near[child]};
+                }
+            }
+
+            continue;
+        }
+
+        // Push the children hit from far to near, so the nearest one is
+        // popped first and shrinks t_max for the others.
+        StackEntry hits[WIDTH];
+        size_t num_hits = 0;
+
+        for (uint32_t child = 0; mask != 0; ++child, mask >>= 1) {
+            if (!(mask & 1u)) {
+                continue;
+            }
+
+            StackEntry hit_entry = StackEntry{node.offset[child],
+                                            node.prim_count[child],
+                                            t_near[child]};
+            size_t i = num_hits++;
+
+            for (; (i > 0) && (hits[i - 1].t_near < hit_entry.t_near); --i) {
+                hits[i] = hits[i - 1];
+            }
+
+            hits[i] = hit_entry;
+        }
+
+        for (size_t i = 0; i < num_hits; ++i) {
+            stack[stack_top++] = hits[i];
+        }
+    }
+
+    return hit_anything;
+}
+
+template <size_t WIDTH, bool ANY_HIT, WideBVH::IntersectFunc<WIDTH> INTERSECT,
+        WideBVH::PacketIntersectFunc<WIDTH> PACKET_INTERSECT>
+uint32_t WideBVH::TraversePacket(const std::vector<WideBVHNode<WIDTH>>& nodes,
+                                RayPacket& packet,
+                                HitRecord *recs) const {
+    if (nodes.empty() || (packet.size == 0)) {
+        return 0;
+    }
+
+    WideBVHPacket wide_packet;
+
+    for (uint32_t k = 0; k < RayPacket::MAX_SIZE; ++k) {
+        bool used = (k < packet.size);
+        const Point3 origin = used ? packet.rays[k].GetOrigin() : Point3();
+        const Vec3 direction = used ? packet.rays[k].GetDirection() : Vec3();
+
+        for (unsigned int axis = 0; axis < AABB::Axis::NUM_OF_AXIS; ++axis) {
+            Vec3::Cord cord = static_cast<Vec3::Cord>(axis);
+
+            wide_packet.origin[axis][k] = static_cast<float>(origin[cord]);
+            wide_packet.inv_dir[axis][k] = used ? 
+                            static_cast<float>(1.0 / direction[cord]) : 0.0f;
+        }
+
+        wide_packet.t_max[k] = used ? FloatRoundUp(packet.t_max[k]) : 
+                                    -std::numeric_limits<float>::infinity();
+    }
+
+    PacketStackEntry stack[MAX_DEPTH * WIDTH];
+    size_t stack_top = 0;
+    const float t_min = FloatRoundDown(packet.t_min);
+    // rays still looking for a hit, any-hit queries drop the occluded ones
+    uint32_t active = (1u << packet.size) - 1;
+    uint32_t result = 0;
+
+    stack[stack_top++] = PacketStackEntry{0, 0, active, t_min};
+
+    while ((stack_top > 0) && (active != 0)) {
+        const PacketStackEntry entry = stack[--stack_top];
+        uint32_t rays = entry.rays & active;
+
+        // drop the rays whose closest hit moved in front of the box
+        if (!ANY_HIT) {
+            for (uint32_t k = 0; k < packet.size; ++k) {
+                if (wide_packet.t_max[k] < entry.t_near) {
+                    rays &= ~(1u << k);
+                }
+            }
+        }
+
+        if (rays == 0) {
+            continue;
+        }
+
+        if (entry.prim_count > 0) {
+            for (uint32_t k = 0; k < packet.size; ++k) {
+                if (!(rays & (1u << k))) {
+                    continue;
+                }
+
+                for (uint32_t i = 0; i < entry.prim_count; ++i) {
+                    const Hittable& prim = *m_primitives[entry.offset + i];
+
+                    if (ANY_HIT) {
+                        if (packet.Occluded(prim, k)) {
+                            result |= (1u << k);
+                            active &= ~(1u << k);
+                            break;
+                        }
+                    }
+                    else if (packet.Hit(prim, k, recs[k])) {
+                        result |= (1u << k);
+                        wide_packet.t_max[k] = FloatRoundUp(packet.t_max[k]);
+                    }
+                }
+            }
+
+            continue;
+        }
+
+        // the packet has diverged, the remaining rays finish the subtree
+        // on their own
+        if (static_cast<uint32_t>(__builtin_popcount(rays)) < PACKET_MIN_RAYS) {
+            for (uint32_t k = 0; k < packet.size; ++k) {
+                if (!(rays & (1u << k))) {
+                    continue;
+                }
+
+                Interval ray_t(packet.t_min, packet.t_max[k]);
+                HitRecord rec;
+
+                packet.SwapRNG(k);
+                bool hit = Traverse<WIDTH, ANY_HIT, INTERSECT>(nodes, 
+                                            entry.offset, packet.rays[k],
+                                            ray_t, ANY_HIT ? nullptr : &rec);
+                packet.SwapRNG(k);
+
+                if (!hit) {
+                    continue;
+                }
+
+                result |= (1u << k);
+
+                if (ANY_HIT) {
+                    active &= ~(1u << k);
+                }
+                else {
+                    recs[k] = rec;
+                    packet.t_max[k] = rec.t;
+                    wide_packet.t_max[k] = FloatRoundUp(rec.t);
+                }
+            }
+
+            continue;
+        }
+
+        // Push the children hit from far to near like Traverse, ordered by
+        // the nearest entry of any ray.
+        const WideBVHNode<WIDTH>& node = nodes[entry.offset];
+        PacketStackEntry hits[WIDTH];
+        size_t num_hits = 0;
+
+        for (uint32_t child = 0; child < node.num_children; ++child) {
+            float t_near[RayPacket::MAX_SIZE];
+            uint32_t child_rays = rays & PACKET_INTERSECT(node, child, 
+                                                        wide_packet, t_min,
+                                                        t_near);
+
+            if (child_rays == 0) {
+                continue;
+            }
+
+            float child_t_near = std::numeric_limits<float>::infinity();
+
+            for (uint32_t k = 0; k < packet.size; ++k) {
+                if ((child_rays & (1u << k)) && (t_near[k] < child_t_near)) {
+                    child_t_near = t_near[k];
+                }
+            }
+
+            PacketStackEntry hit_entry = PacketStackEntry{node.offset[child],
+                                                        node.prim_count[child],
+                                                        child_rays,
+                                                        child_t_near};
+            size_t i = num_hits++;
+
+            for (; (i > 0) && (hits[i - 1].t_near < hit_entry.t_near); --i) {
+                hits[i] = hits[i - 1];
+            }
+
+            hits[i] = hit_entry;
+        }
+
+        for (size_t i = 0; i < num_hits; ++i) {
+            stack[stack_top++] = hits[i];
+        }
+    }
+
+    return result;
+}
+
+}